@@ -0,0 +1,384 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <nlohmann/json.hpp>
+
+#include "GestorAuditoria.hpp"
+#include "GestorCifrado.hpp"
+#include "GestorBaseDatos.hpp"
+#include "GeneradorCodigo.hpp"
+#include "GeneradorDatos.hpp"
+#include "GestorPlantillas.hpp"
+
+namespace po = boost::program_options;
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+constexpr char CLAVE_BENCHMARK[] = "a1b2c3d4e5f60718293a4b5c6d7e8f90a1b2c3d4e5f60718293a4b5c6d7e8f90";
+
+struct ConfiguracionBenchmark {
+    std::vector<std::size_t> escalas;
+    std::vector<std::size_t> escalas_tablas;
+    std::vector<std::size_t> escalas_grafo;
+    unsigned int hilos_esquema = 4;
+    std::size_t repeticiones = 5;
+    std::uint64_t semilla = 134;
+    std::string filtro;
+    fs::path dir_trabajo;
+};
+
+struct Motor {
+    std::string nombre;
+    GestorAuditoria::MotorDB motor;
+    std::string info_conexion;
+};
+
+class Medidor {
+public:
+    explicit Medidor(const ConfiguracionBenchmark& configuracion) : configuracion(configuracion) {}
+
+    bool activo(const std::string& nombre) const {
+        return configuracion.filtro.empty() || nombre.find(configuracion.filtro) != std::string::npos;
+    }
+
+    void medir(const std::string& nombre, const std::string& motor, std::size_t escala, std::size_t unidades,
+        const std::function<void()>& preparar, const std::function<void()>& ejecutar, std::size_t bytes = 0) {
+        std::vector<double> muestras;
+        muestras.reserve(configuracion.repeticiones);
+        for (std::size_t i = 0; i < configuracion.repeticiones; ++i) {
+            if (preparar) preparar();
+            const auto inicio = std::chrono::steady_clock::now();
+            ejecutar();
+            const auto fin = std::chrono::steady_clock::now();
+            muestras.push_back(std::chrono::duration<double, std::nano>(fin - inicio).count());
+        }
+        std::sort(muestras.begin(), muestras.end());
+
+        double suma = 0;
+        for (double m : muestras) suma += m;
+        const double mediana = muestras[muestras.size() / 2];
+
+        json resultado = {
+            {"nombre", nombre},
+            {"motor", motor},
+            {"escala", escala},
+            {"unidades", unidades},
+            {"repeticiones", muestras.size()},
+            {"ns_min", muestras.front()},
+            {"ns_mediana", mediana},
+            {"ns_media", suma / muestras.size()},
+            {"ns_max", muestras.back()},
+            {"unidades_por_segundo", mediana > 0 ? unidades * 1e9 / mediana : 0.0}
+        };
+        if (bytes > 0) {
+            resultado["bytes"] = bytes;
+            resultado["gb_por_segundo"] = mediana > 0 ? bytes / mediana : 0.0;
+        }
+        std::cerr << nombre << " [" << motor << ", " << escala << "]: " << mediana / 1e6 << " ms (mediana)";
+        if (bytes > 0 && mediana > 0) std::cerr << ", " << bytes / mediana << " GB/s";
+        std::cerr << std::endl;
+        resultados.push_back(std::move(resultado));
+    }
+
+    const json& obtenerResultados() const { return resultados; }
+
+private:
+    const ConfiguracionBenchmark& configuracion;
+    json resultados = json::array();
+};
+
+std::vector<std::size_t> leerEscalas(const std::string& texto) {
+    std::vector<std::string> partes;
+    boost::split(partes, texto, boost::is_any_of(","), boost::token_compress_on);
+    std::vector<std::size_t> escalas;
+    for (const auto& parte : partes) {
+        if (!parte.empty()) escalas.push_back(std::stoul(parte));
+    }
+    if (escalas.empty()) throw std::runtime_error("La lista de escalas esta vacia: " + texto);
+    return escalas;
+}
+
+void ejecutarLote(GestorAuditoria& conexion, const std::vector<std::string>& sentencias) {
+    for (const auto& sentencia : sentencias) conexion.ejecutarSentencia(sentencia);
+}
+
+void eliminarTablasBenchmark(GestorAuditoria& conexion) {
+    auto tablas = conexion.obtenerNombresDeTablas(true);
+    std::sort(tablas.rbegin(), tablas.rend());
+    const bool es_postgres = conexion.getMotor() == GestorAuditoria::MotorDB::PostgreSQL;
+    for (const auto& tabla : tablas) {
+        if (!boost::starts_with(tabla, "bench_") && !boost::starts_with(tabla, "aud_bench_")) continue;
+        conexion.ejecutarSentencia("DROP TABLE IF EXISTS " + tabla + (es_postgres ? " CASCADE" : ""));
+    }
+}
+
+void prepararTablas(GestorAuditoria& conexion, std::size_t num_tablas, std::size_t filas, std::uint64_t semilla) {
+    eliminarTablasBenchmark(conexion);
+    ejecutarLote(conexion, sentenciasCrearTablas(conexion.getMotor(), num_tablas));
+    if (filas > 0) {
+        GeneradorDatos generador(semilla);
+        ejecutarLote(conexion, sentenciasPoblarTabla(conexion.getMotor(), nombreTablaBenchmark(0), filas, generador));
+    }
+}
+
+void medirCifrado(Medidor& medidor, const ConfiguracionBenchmark& configuracion) {
+    GestorCifrado gestor_cifrado(nullptr, CLAVE_BENCHMARK);
+    for (std::size_t longitud : { 16, 256, 4096 }) {
+        for (std::size_t escala : configuracion.escalas) {
+            GeneradorDatos generador(configuracion.semilla);
+            std::vector<std::string> textos;
+            textos.reserve(escala);
+            for (std::size_t i = 0; i < escala; ++i) textos.push_back(generador.texto(longitud));
+
+            std::vector<std::string> cifrados(escala);
+            if (medidor.activo("cifrado.cifrarValor")) {
+                medidor.medir("cifrado.cifrarValor." + std::to_string(longitud), "ninguno", escala, escala, nullptr, [&] {
+                    for (std::size_t i = 0; i < escala; ++i) cifrados[i] = gestor_cifrado.cifrarValor(textos[i]);
+                    });
+            }
+            if (medidor.activo("cifrado.descifrarValor")) {
+                for (std::size_t i = 0; i < escala; ++i) cifrados[i] = gestor_cifrado.cifrarValor(textos[i]);
+                medidor.medir("cifrado.descifrarValor." + std::to_string(longitud), "ninguno", escala, escala, nullptr, [&] {
+                    for (std::size_t i = 0; i < escala; ++i) textos[i] = gestor_cifrado.descifrarValor(cifrados[i]);
+                    });
+            }
+
+            const std::size_t bytes = escala * longitud;
+            for (const char* nombre_formato : { "cbc", "gcm" }) {
+                gestor_cifrado.setFormatoCifrado(GestorCifrado::interpretarFormatoCifrado(nombre_formato));
+                const std::string sufijo = std::string(".") + nombre_formato + "." + std::to_string(longitud);
+                if (medidor.activo("cifrado.cifrarValores")) {
+                    medidor.medir("cifrado.cifrarValores" + sufijo, "ninguno", escala, escala, nullptr, [&] {
+                        cifrados = gestor_cifrado.cifrarValores(textos);
+                        }, bytes);
+                }
+                if (medidor.activo("cifrado.descifrarCeldas")) {
+                    cifrados = gestor_cifrado.cifrarValores(textos);
+                    std::vector<ValorCelda> celdas;
+                    medidor.medir("cifrado.descifrarCeldas" + sufijo, "ninguno", escala, escala, [&] {
+                        celdas.assign(cifrados.begin(), cifrados.end());
+                        }, [&] {
+                        gestor_cifrado.descifrarCeldas(celdas);
+                        }, bytes);
+                }
+            }
+            gestor_cifrado.setFormatoCifrado(GestorCifrado::FormatoCifrado::Cbc);
+        }
+    }
+}
+
+void medirGrafo(Medidor& medidor, const ConfiguracionBenchmark& configuracion) {
+    for (std::size_t num_tablas : configuracion.escalas_grafo) {
+        GeneradorDatos generador(configuracion.semilla);
+        Esquema esquema = esquemaSintetico(num_tablas, generador);
+
+        if (medidor.activo("esquema.indexar")) {
+            medidor.medir("esquema.indexar", "ninguno", num_tablas, num_tablas, nullptr, [&] {
+                esquema.indexar();
+                });
+        }
+        if (medidor.activo("esquema.analizarDependenciasParaJwt")) {
+            medidor.medir("esquema.analizarDependenciasParaJwt", "ninguno", num_tablas, num_tablas, nullptr, [&] {
+                GestorBaseDatos::analizarDependenciasParaJwt(esquema);
+                });
+        }
+        if (medidor.activo("esquema.ordenarPorDependencias")) {
+            medidor.medir("esquema.ordenarPorDependencias", "ninguno", num_tablas, num_tablas, nullptr, [&] {
+                esquema.grafo.ordenarPorDependencias();
+                });
+        }
+        if (medidor.activo("esquema.componentesCiclicas")) {
+            medidor.medir("esquema.componentesCiclicas", "ninguno", num_tablas, num_tablas, nullptr, [&] {
+                esquema.grafo.componentesCiclicas();
+                });
+        }
+    }
+}
+
+void medirMotor(Medidor& medidor, const ConfiguracionBenchmark& configuracion, const Motor& motor) {
+    auto conexion = std::make_shared<GestorAuditoria>(motor.motor, motor.info_conexion);
+    if (!conexion->estaConectado()) throw std::runtime_error("No se pudo conectar al motor " + motor.nombre);
+
+    if (medidor.activo("consulta.ejecutarConsultaConResultado")) {
+        for (std::size_t escala : configuracion.escalas) {
+            prepararTablas(*conexion, 1, escala, configuracion.semilla);
+            const std::string consulta = "SELECT * FROM " + nombreTablaBenchmark(0);
+            medidor.medir("consulta.ejecutarConsultaConResultado", motor.nombre, escala, escala, nullptr, [&] {
+                conexion->ejecutarConsultaConResultado(consulta);
+                });
+        }
+    }
+
+    // Reescritura de filas al cifrar una tabla aud_ con datos: cifrado por lotes
+    // con CifradorCeldas y sentencias INSERT de varias filas. Se mide en todos los
+    // motores, incluido SQLite, donde cifrarTablasDeAuditoria no reescribe filas.
+    if (medidor.activo("cifrado.reescribirFilasCifradas")) {
+        const std::string destino = "bench_cifrado";
+        GestorCifrado gestor_cifrado(conexion, CLAVE_BENCHMARK);
+        for (std::size_t escala : configuracion.escalas) {
+            prepararTablas(*conexion, 1, escala, configuracion.semilla);
+            const ResultadoConsulta datos = conexion->ejecutarConsultaConResultado("SELECT * FROM " + nombreTablaBenchmark(0));
+            std::string crear_destino = "CREATE TABLE " + destino + " (";
+            for (std::size_t i = 0; i < datos.columnas.size(); ++i) {
+                if (i > 0) crear_destino += ", ";
+                crear_destino += datos.columnas[i] + " TEXT";
+            }
+            crear_destino += ")";
+            medidor.medir("cifrado.reescribirFilasCifradas", motor.nombre, escala, escala,
+                [&] {
+                    conexion->ejecutarSentencia("DROP TABLE IF EXISTS " + destino);
+                    conexion->ejecutarSentencia(crear_destino);
+                },
+                [&] {
+                    gestor_cifrado.reescribirFilasCifradas(destino, datos);
+                });
+        }
+    }
+
+    if (motor.motor != GestorAuditoria::MotorDB::SQLite && medidor.activo("auditoria.cifrarTablasDeAuditoria")) {
+        for (std::size_t escala : configuracion.escalas) {
+            medidor.medir("auditoria.cifrarTablasDeAuditoria", motor.nombre, escala, escala,
+                [&] {
+                    prepararTablas(*conexion, 1, 0, configuracion.semilla);
+                    conexion->generarAuditoriaParaTabla(nombreTablaBenchmark(0));
+                    GeneradorDatos generador(configuracion.semilla);
+                    ejecutarLote(*conexion, sentenciasPoblarTabla(motor.motor, nombreTablaBenchmark(0), escala, generador));
+                },
+                [&] {
+                    GestorCifrado gestor_cifrado(conexion, CLAVE_BENCHMARK);
+                    gestor_cifrado.cifrarTablasDeAuditoria();
+                });
+        }
+    }
+
+    const bool medir_esquema = medidor.activo("esquema.obtenerEsquemaTablas");
+    const bool medir_generacion = medidor.activo("generacion.generarProyectoCompleto");
+    if (medir_esquema || medir_generacion) {
+        for (std::size_t num_tablas : configuracion.escalas_tablas) {
+            prepararTablas(*conexion, num_tablas, 0, configuracion.semilla);
+            GestorBaseDatos gestor_esquema(motor.motor, motor.info_conexion, "");
+            Esquema esquema = gestor_esquema.obtenerEsquemaTablas();
+            if (medir_esquema) {
+                medidor.medir("esquema.obtenerEsquemaTablas", motor.nombre, num_tablas, num_tablas, nullptr, [&] {
+                    esquema = gestor_esquema.obtenerEsquemaTablas();
+                    });
+                if (configuracion.hilos_esquema > 1) {
+                    gestor_esquema.establecerHilosEsquema(configuracion.hilos_esquema);
+                    medidor.medir("esquema.obtenerEsquemaTablas.paralelo", motor.nombre, num_tablas, num_tablas, nullptr, [&] {
+                        esquema = gestor_esquema.obtenerEsquemaTablas();
+                        });
+                    gestor_esquema.establecerHilosEsquema(1);
+                }
+            }
+            if (medir_generacion) {
+                const fs::path dir_salida = configuracion.dir_trabajo / ("proyecto_" + motor.nombre);
+                medidor.medir("generacion.generarProyectoCompleto", motor.nombre, num_tablas, num_tablas,
+                    [&] { fs::remove_all(dir_salida); },
+                    [&] {
+                        GeneradorCodigo generador(dir_salida.string());
+                        generador.generarProyectoCompleto(esquema, motor.nombre, "localhost", "0", "bench", "bench", "bench", "secreto");
+                    });
+                fs::remove_all(dir_salida);
+            }
+        }
+    }
+
+    eliminarTablasBenchmark(*conexion);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        po::options_description desc("Opciones del benchmark");
+        desc.add_options()
+            ("help,h", "Muestra esta ayuda")
+            ("sqlite", po::value<std::string>()->default_value("shc134_benchmark.sqlite"),
+                "Archivo SQLite usado por el benchmark (se recrea en cada ejecucion)")
+            ("sqlite-driver", po::value<std::string>()->default_value("SQLite3"),
+                "Nombre del driver ODBC de SQLite")
+            ("pg", po::value<std::string>(),
+                "Cadena de conexion libpq de una base PostgreSQL dedicada (opcional)")
+            ("escalas", po::value<std::string>()->default_value("1000,10000,100000"),
+                "Numero de filas o valores por caso")
+            ("escalas-tablas", po::value<std::string>()->default_value("10,100,500"),
+                "Numero de tablas para esquema y generacion")
+            ("escalas-grafo", po::value<std::string>()->default_value("1000,20000"),
+                "Numero de tablas del esquema sintetico en memoria")
+            ("hilos-esquema", po::value<unsigned int>()->default_value(4),
+                "Conexiones del caso esquema.obtenerEsquemaTablas.paralelo (1 lo omite)")
+            ("repeticiones", po::value<std::size_t>()->default_value(5),
+                "Repeticiones medidas por caso")
+            ("semilla", po::value<std::uint64_t>()->default_value(134),
+                "Semilla de los generadores de datos")
+            ("filtro", po::value<std::string>()->default_value(""),
+                "Ejecuta solo los casos cuyo nombre contiene este texto")
+            ("plantillas", po::value<std::string>(),
+                "Directorio con plantillas .tpl que reemplazan a las embebidas")
+            ("out", po::value<std::string>()->default_value("resultados_benchmark.json"),
+                "Archivo JSON de resultados");
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help")) {
+            std::cout << desc << std::endl;
+            return 0;
+        }
+        po::notify(vm);
+
+        ConfiguracionBenchmark configuracion;
+        configuracion.escalas = leerEscalas(vm["escalas"].as<std::string>());
+        configuracion.escalas_tablas = leerEscalas(vm["escalas-tablas"].as<std::string>());
+        configuracion.escalas_grafo = leerEscalas(vm["escalas-grafo"].as<std::string>());
+        configuracion.hilos_esquema = vm["hilos-esquema"].as<unsigned int>();
+        configuracion.repeticiones = std::max<std::size_t>(1, vm["repeticiones"].as<std::size_t>());
+        configuracion.semilla = vm["semilla"].as<std::uint64_t>();
+        configuracion.filtro = vm["filtro"].as<std::string>();
+
+        const fs::path ruta_salida = fs::absolute(vm["out"].as<std::string>());
+        const fs::path ruta_sqlite = fs::absolute(vm["sqlite"].as<std::string>());
+        configuracion.dir_trabajo = fs::temp_directory_path() / "shc134_benchmark";
+        fs::create_directories(configuracion.dir_trabajo);
+        if (vm.count("plantillas")) {
+            GestorPlantillas::instancia().establecerDirectorioPersonalizado(vm["plantillas"].as<std::string>());
+        }
+
+        std::vector<Motor> motores;
+        fs::remove(ruta_sqlite);
+        motores.push_back({ "sqlite", GestorAuditoria::MotorDB::SQLite,
+            "DRIVER={" + vm["sqlite-driver"].as<std::string>() + "};DATABASE=" + ruta_sqlite.string() + ";" });
+        if (vm.count("pg")) {
+            motores.push_back({ "postgres", GestorAuditoria::MotorDB::PostgreSQL, vm["pg"].as<std::string>() });
+        }
+
+        Medidor medidor(configuracion);
+        medirCifrado(medidor, configuracion);
+        medirGrafo(medidor, configuracion);
+        for (const auto& motor : motores) medirMotor(medidor, configuracion, motor);
+
+        json informe = {
+            {"version", 1},
+            {"semilla", configuracion.semilla},
+            {"repeticiones", configuracion.repeticiones},
+            {"compilador", __VERSION__},
+            {"resultados", medidor.obtenerResultados()}
+        };
+        std::ofstream salida(ruta_salida);
+        salida << informe.dump(2) << std::endl;
+        std::cerr << "Resultados escritos en " << ruta_salida.string() << std::endl;
+
+        fs::remove_all(configuracion.dir_trabajo);
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
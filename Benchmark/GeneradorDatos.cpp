@@ -0,0 +1,158 @@
+#include "GeneradorDatos.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include "DialectoSql.hpp"
+
+namespace {
+
+constexpr char ALFABETO[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+constexpr const char* NOMBRES[] = { "Ana", "Luis", "Carla", "Jorge", "Elena", "Mario", "Sofia", "Pablo", "Lucia", "Diego" };
+constexpr const char* APELLIDOS[] = { "Quispe", "Mamani", "Rojas", "Flores", "Vargas", "Choque", "Gutierrez", "Lopez" };
+
+}
+
+GeneradorDatos::GeneradorDatos(std::uint64_t semilla) : estado(semilla) {
+}
+
+std::uint64_t GeneradorDatos::siguiente() {
+    std::uint64_t z = (estado += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+std::int64_t GeneradorDatos::entero(std::int64_t minimo, std::int64_t maximo) {
+    const std::uint64_t rango = static_cast<std::uint64_t>(maximo - minimo) + 1;
+    return minimo + static_cast<std::int64_t>(siguiente() % rango);
+}
+
+std::string GeneradorDatos::texto(std::size_t longitud) {
+    std::string salida(longitud, ' ');
+    for (auto& c : salida) c = ALFABETO[siguiente() % (sizeof(ALFABETO) - 1)];
+    return salida;
+}
+
+std::string GeneradorDatos::nombre() {
+    std::string salida = NOMBRES[siguiente() % std::size(NOMBRES)];
+    salida += " ";
+    salida += APELLIDOS[siguiente() % std::size(APELLIDOS)];
+    return salida;
+}
+
+std::string GeneradorDatos::correo() {
+    return texto(10).replace(4, 1, ".") + "@ejemplo.com";
+}
+
+std::string GeneradorDatos::fecha() {
+    const int anio = static_cast<int>(entero(2015, 2025));
+    const int mes = static_cast<int>(entero(1, 12));
+    const int dia = static_cast<int>(entero(1, 28));
+    const int hora = static_cast<int>(entero(0, 23));
+    const int minuto = static_cast<int>(entero(0, 59));
+    const int segundo = static_cast<int>(entero(0, 59));
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d", anio, mes, dia, hora, minuto, segundo);
+    return buffer;
+}
+
+std::string nombreTablaBenchmark(std::size_t indice) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "bench_t%05zu", indice);
+    return buffer;
+}
+
+std::vector<std::string> sentenciasCrearTablas(GestorAuditoria::MotorDB motor, std::size_t num_tablas) {
+    std::vector<std::string> sentencias;
+    sentencias.reserve(num_tablas);
+    despacharDialecto(motor, [&](auto dialecto) {
+        using D = decltype(dialecto);
+        for (std::size_t i = 0; i < num_tablas; ++i) {
+            std::string sql = "CREATE TABLE " + D::tablaCalificada(nombreTablaBenchmark(i)) + " (" +
+                D::citar("id") + " INTEGER PRIMARY KEY, " +
+                D::citar("padre_id") + " INTEGER NULL";
+            if (i > 0) sql += " REFERENCES " + D::tablaCalificada(nombreTablaBenchmark(i - 1)) + "(" + D::citar("id") + ")";
+            sql += ", " + D::citar("nombre") + " VARCHAR(100), " +
+                D::citar("correo") + " VARCHAR(150), " +
+                D::citar("saldo") + " NUMERIC(12,2), " +
+                D::citar("creado") + " VARCHAR(30))";
+            sentencias.push_back(std::move(sql));
+        }
+        });
+    return sentencias;
+}
+
+std::vector<std::string> sentenciasPoblarTabla(GestorAuditoria::MotorDB motor, const std::string& tabla, std::size_t filas, GeneradorDatos& generador) {
+    std::vector<std::string> sentencias;
+    despacharDialecto(motor, [&](auto dialecto) {
+        using D = decltype(dialecto);
+        std::string cabecera = D::sentenciaInsercion(tabla);
+        cabecera += D::citar("id") + ", " + D::citar("nombre") + ", " + D::citar("correo") + ", " +
+            D::citar("saldo") + ", " + D::citar("creado") + ") VALUES ";
+
+        std::string sql;
+        std::size_t en_lote = 0;
+        for (std::size_t fila = 0; fila < filas; ++fila) {
+            if (en_lote == 0) sql = cabecera;
+            else sql += ", ";
+            sql += "(" + std::to_string(fila + 1) + ", ";
+            D::literal(sql, generador.nombre());
+            sql += ", ";
+            D::literal(sql, generador.correo());
+            const std::int64_t saldo = generador.entero(0, 99999999);
+            sql += ", " + std::to_string(saldo / 100) + "." + std::to_string(10 + saldo % 90) + ", ";
+            D::literal(sql, generador.fecha());
+            sql += ")";
+            if (++en_lote == D::filas_por_insercion) {
+                sentencias.push_back(std::move(sql));
+                en_lote = 0;
+            }
+        }
+        if (en_lote > 0) sentencias.push_back(std::move(sql));
+        });
+    return sentencias;
+}
+
+// Esquema en memoria, sin base de datos: la tabla 0 es la de usuarios y cada
+// tabla referencia entre una y tres tablas anteriores, cercanas o al azar.
+// Algunas referencias apuntan a la propia tabla o a una tabla cercana
+// posterior, lo que produce ciclos cortos.
+Esquema esquemaSintetico(std::size_t num_tablas, GeneradorDatos& generador) {
+    Esquema esquema;
+    esquema.tablas.reserve(num_tablas);
+    const IdNombre id = esquema.nombres.internar("id");
+    const IdNombre nombre = esquema.nombres.internar("nombre");
+    const IdNombre creado = esquema.nombres.internar("creado");
+
+    for (std::size_t i = 0; i < num_tablas; ++i) {
+        Tabla tabla;
+        tabla.nombre = esquema.nombres.internar(i == 0 ? std::string("bench_usuarios") : nombreTablaBenchmark(i));
+        tabla.columnas.push_back({ id, "integer", "number", false, true, false });
+        tabla.columnas.push_back({ nombre, "varchar", "string", true, false, false });
+        tabla.columnas.push_back({ creado, "timestamp", "Date", true, false, false });
+        if (i == 0) {
+            tabla.columnas.push_back({ esquema.nombres.internar("correo"), "varchar", "string", false, false, false });
+            tabla.columnas.push_back({ esquema.nombres.internar("contrasena"), "varchar", "string", false, false, false });
+        }
+        tabla.clave_primaria = tabla.columnas.front();
+
+        const std::size_t num_fk = i == 0 ? 0 : static_cast<std::size_t>(generador.entero(1, 3));
+        for (std::size_t k = 0; k < num_fk; ++k) {
+            const std::int64_t tipo = generador.entero(0, 99);
+            std::size_t destino;
+            if (tipo < 2) destino = std::min(num_tablas - 1, i + static_cast<std::size_t>(generador.entero(1, 4)));
+            else if (tipo < 7) destino = i;
+            else if (tipo < 50) destino = i - static_cast<std::size_t>(generador.entero(1, static_cast<std::int64_t>(std::min<std::size_t>(i, 4))));
+            else destino = static_cast<std::size_t>(generador.entero(0, static_cast<std::int64_t>(i) - 1));
+
+            const IdNombre columna = esquema.nombres.internar("ref_" + std::to_string(k) + "_id");
+            tabla.columnas.push_back({ columna, "integer", "number", true, false, true });
+            tabla.dependencias_fk.push_back({ columna, NOMBRE_NULO });
+            tabla.dependencias_fk.back().tabla_referenciada =
+                esquema.nombres.internar(destino == 0 ? std::string("bench_usuarios") : nombreTablaBenchmark(destino));
+        }
+        esquema.tablas.push_back(std::move(tabla));
+    }
+    esquema.indexar();
+    return esquema;
+}
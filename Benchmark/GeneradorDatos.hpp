@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GestorAuditoria.hpp"
+#include "Modelos.hpp"
+
+class GeneradorDatos {
+public:
+    explicit GeneradorDatos(std::uint64_t semilla);
+
+    std::uint64_t siguiente();
+    std::int64_t entero(std::int64_t minimo, std::int64_t maximo);
+    std::string texto(std::size_t longitud);
+    std::string nombre();
+    std::string correo();
+    std::string fecha();
+
+private:
+    std::uint64_t estado;
+};
+
+std::string nombreTablaBenchmark(std::size_t indice);
+std::vector<std::string> sentenciasCrearTablas(GestorAuditoria::MotorDB motor, std::size_t num_tablas);
+Esquema esquemaSintetico(std::size_t num_tablas, GeneradorDatos& generador);
+std::vector<std::string> sentenciasPoblarTabla(GestorAuditoria::MotorDB motor, const std::string& tabla, std::size_t filas, GeneradorDatos& generador);
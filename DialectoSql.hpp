@@ -0,0 +1,811 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "GestorAuditoria.hpp"
+
+inline constexpr std::string_view COLUMNA_SECUENCIA_AUDITORIA = "IdAuditoria";
+inline constexpr std::string_view COLUMNA_CLAVE_AUDITORIA = "Clave";
+inline constexpr std::string_view COLUMNA_CAMBIOS_AUDITORIA = "Cambios";
+inline constexpr std::string_view TABLA_CHECKPOINT_CAPTURA = "shc134_captura";
+
+// Par nombre/valor de un objeto JSON armado dentro de un trigger. Si condicion
+// no esta vacia, el par solo se incluye cuando la condicion es verdadera.
+struct CampoJsonAuditoria {
+    std::string nombre;
+    std::string valor;
+    std::string condicion;
+};
+
+// Cambios de esquema de una tabla: columnas a convertir a tipo_destino (con su
+// tipo actual; vacio es tipo_texto), columnas a agregar (con su tipo) y
+// renombrados (de, a).
+struct CambioEsquema {
+    std::string tipo_destino;
+    std::vector<std::pair<std::string, std::string>> tipos;
+    std::vector<std::pair<std::string, std::string>> columnas_nuevas;
+    std::vector<std::pair<std::string, std::string>> renombrados;
+};
+
+// Sentencias que aplican un CambioEsquema. reescrituras cuenta las sentencias
+// que cambian tipos y reescriben la tabla, y reescrituras_evitadas las que se
+// ahorran frente a un ALTER por columna o porque la conversion no reescribe.
+struct PlanEsquema {
+    std::vector<std::string> sentencias;
+    std::size_t reescrituras = 0;
+    std::size_t reescrituras_evitadas = 0;
+};
+
+template <typename Derivado>
+struct DialectoBase {
+    static constexpr std::string_view tipo_indice_ciego = "CHAR(32)";
+    static constexpr std::string_view inicio_transaccion = "BEGIN";
+
+    static void citar(std::string& salida, std::string_view identificador) {
+        salida += Derivado::comilla_abre;
+        salida += identificador;
+        salida += Derivado::comilla_cierra;
+    }
+
+    static std::string citar(std::string_view identificador) {
+        std::string salida;
+        salida.reserve(identificador.size() + 2);
+        citar(salida, identificador);
+        return salida;
+    }
+
+    static void tablaCalificada(std::string& salida, std::string_view tabla) {
+        salida += Derivado::esquema;
+        citar(salida, tabla);
+    }
+
+    static std::string tablaCalificada(std::string_view tabla) {
+        std::string salida;
+        salida.reserve(Derivado::esquema.size() + tabla.size() + 2);
+        tablaCalificada(salida, tabla);
+        return salida;
+    }
+
+    static void literal(std::string& salida, std::string_view valor) {
+        salida += Derivado::prefijo_literal;
+        for (char c : valor) {
+            if (c == '\'') salida += '\'';
+            salida += c;
+        }
+        salida += '\'';
+    }
+
+    static void literalBinario(std::string& salida, const unsigned char* datos, std::size_t longitud) {
+        static const char digitos_hex[] = "0123456789ABCDEF";
+        salida += Derivado::prefijo_binario;
+        for (std::size_t i = 0; i < longitud; ++i) {
+            salida += digitos_hex[datos[i] >> 4];
+            salida += digitos_hex[datos[i] & 0x0F];
+        }
+        salida += Derivado::sufijo_binario;
+    }
+
+    static void literalFechaHora(std::string& salida, std::string_view texto) {
+        Derivado::literal(salida, texto);
+    }
+
+    // Celda cifrada (hexadecimal, o "v2:" y hexadecimal) como literal de texto o,
+    // con almacenamiento binario, como literal binario de los mismos bytes.
+    static void literalCifrado(std::string& salida, std::string_view celda, bool binario) {
+        if (!binario) {
+            Derivado::literal(salida, celda);
+            return;
+        }
+        if (celda == "NULL") {
+            salida += "NULL";
+            return;
+        }
+        salida += Derivado::prefijo_binario;
+        if (celda.substr(0, 3) == "v2:") {
+            salida += "76323a";
+            celda.remove_prefix(3);
+        }
+        salida += celda;
+        salida += Derivado::sufijo_binario;
+    }
+
+    static std::string sentenciaInsercion(std::string_view tabla) {
+        std::string salida = "INSERT INTO ";
+        tablaCalificada(salida, tabla);
+        salida += " (";
+        return salida;
+    }
+
+    static bool columnaAuditable(std::string_view) {
+        return true;
+    }
+
+    static std::string sentenciaAgregarColumna(std::string_view tabla, std::string_view columna, std::string_view tipo) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " ADD COLUMN " + citar(columna) + " " + std::string(tipo);
+    }
+
+    static std::string sentenciaCrearIndice(std::string_view tabla, std::string_view indice, std::string_view columna) {
+        return "CREATE INDEX IF NOT EXISTS " + citar(indice) + " ON " + tablaCalificada(tabla) + " (" + citar(columna) + ")";
+    }
+
+    static std::string sentenciaCrearIndiceEnLinea(std::string_view tabla, std::string_view indice, std::string_view columna) {
+        return Derivado::sentenciaCrearIndice(tabla, indice, columna);
+    }
+
+    static std::string sentenciaEliminarIndice(std::string_view, std::string_view indice) {
+        return "DROP INDEX IF EXISTS " + tablaCalificada(indice);
+    }
+
+    static std::string sentenciaRenombrarTabla(std::string_view de, std::string_view a) {
+        return "ALTER TABLE " + tablaCalificada(de) + " RENAME TO " + citar(a);
+    }
+
+    static std::string tipoDestino(const CambioEsquema& cambio) {
+        return cambio.tipo_destino.empty() ? std::string(Derivado::tipo_texto) : cambio.tipo_destino;
+    }
+
+    // Cambios de tipo que el motor aplica sin reescribir la tabla.
+    static bool conversionSinReescritura(std::string_view, std::string_view) {
+        return false;
+    }
+
+    static bool esTipo(std::string_view tipo, std::string_view destino) {
+        if (tipo.size() != destino.size()) return false;
+        for (std::size_t i = 0; i < tipo.size(); ++i) {
+            const char a = tipo[i] >= 'a' && tipo[i] <= 'z' ? static_cast<char>(tipo[i] - 'a' + 'A') : tipo[i];
+            if (a != destino[i]) return false;
+        }
+        return true;
+    }
+
+    // Todos los cambios de tipo y columnas nuevas van en un solo ALTER TABLE (una
+    // reescritura, salvo que todos sean conversiones sin reescritura); RENAME
+    // COLUMN no admite otras acciones y va por separado.
+    static PlanEsquema planificarCambioEsquema(const std::string& tabla, const CambioEsquema& cambio) {
+        PlanEsquema plan;
+        const std::string destino = tipoDestino(cambio);
+        std::string acciones;
+        std::size_t cambios_tipo = 0;
+        for (const auto& [columna, tipo] : cambio.tipos) {
+            if (esTipo(tipo, destino)) continue;
+            if (!acciones.empty()) acciones += ", ";
+            acciones += "ALTER COLUMN " + citar(columna) + " TYPE " + destino;
+            if (destino != Derivado::tipo_texto) acciones += " USING " + citar(columna) + "::TEXT::" + destino;
+            if (!Derivado::conversionSinReescritura(tipo, destino)) ++cambios_tipo;
+        }
+        for (const auto& [columna, tipo] : cambio.columnas_nuevas) {
+            if (!acciones.empty()) acciones += ", ";
+            acciones += "ADD COLUMN " + citar(columna) + " " + tipo;
+        }
+        if (!acciones.empty()) plan.sentencias.push_back("ALTER TABLE " + tablaCalificada(tabla) + " " + acciones);
+        plan.reescrituras = cambios_tipo > 0 ? 1 : 0;
+        plan.reescrituras_evitadas = cambio.tipos.size() - plan.reescrituras;
+        for (const auto& [de, a] : cambio.renombrados) plan.sentencias.push_back(Derivado::sentenciaRenombrarColumna(tabla, de, a));
+        return plan;
+    }
+    // UPDATE de varias filas en una sola sentencia. Cada fila trae literales ya
+    // formateados: primero el valor de la clave y luego uno por columna.
+    static std::string sentenciaActualizarLote(std::string_view tabla, std::string_view clave, const std::vector<std::string>& columnas,
+        const std::vector<std::vector<std::string>>& filas) {
+        std::string salida = "UPDATE " + tablaCalificada(tabla) + " AS t SET ";
+        for (size_t i = 0; i < columnas.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += citar(columnas[i]) + " = v." + citar(columnas[i]);
+        }
+        salida += " FROM (VALUES ";
+        anexarFilasValues(salida, filas);
+        salida += ") AS v(" + citar(clave);
+        for (const auto& columna : columnas) salida += ", " + citar(columna);
+        return salida + ") WHERE t." + citar(clave) + " = v." + citar(clave);
+    }
+
+    static void anexarFilasValues(std::string& salida, const std::vector<std::vector<std::string>>& filas) {
+        for (size_t i = 0; i < filas.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += '(';
+            for (size_t j = 0; j < filas[i].size(); ++j) {
+                if (j > 0) salida += ", ";
+                salida += filas[i][j];
+            }
+            salida += ')';
+        }
+    }
+};
+
+template <GestorAuditoria::MotorDB Motor>
+struct DialectoSql;
+
+template <>
+struct DialectoSql<GestorAuditoria::MotorDB::PostgreSQL> : DialectoBase<DialectoSql<GestorAuditoria::MotorDB::PostgreSQL>> {
+    static constexpr GestorAuditoria::MotorDB motor = GestorAuditoria::MotorDB::PostgreSQL;
+    static constexpr std::string_view comilla_abre = "\"";
+    static constexpr std::string_view comilla_cierra = "\"";
+    static constexpr std::string_view esquema = "public.";
+    static constexpr std::string_view prefijo_literal = "'";
+    static constexpr std::string_view tipo_texto = "TEXT";
+    static constexpr std::string_view tipo_binario = "BYTEA";
+    static constexpr std::string_view expresion_usuario = "SESSION_USER";
+    static constexpr std::string_view expresion_fecha = "NOW()";
+    static constexpr std::string_view plantilla_cifrado = "PostgresAuditCifrado.tpl";
+    static constexpr std::string_view plantilla_auditoria_delta = "PostgresAuditDelta.tpl";
+    static constexpr std::string_view plantilla_migracion = "PostgresAuditMigracion.tpl";
+    static constexpr std::string_view registro_nuevo = "NEW.";
+    static constexpr std::string_view registro_viejo = "OLD.";
+    static constexpr std::string_view prefijo_binario = "'\\x";
+    static constexpr std::string_view sufijo_binario = "'::bytea";
+
+    // varchar y text son binariamente compatibles: ALTER ... TYPE TEXT solo
+    // cambia el catalogo.
+    static bool conversionSinReescritura(std::string_view tipo, std::string_view destino) {
+        return esTipo(tipo, "CHARACTER VARYING") && esTipo(destino, tipo_texto);
+    }
+    static constexpr bool soporta_cambio_tipo = true;
+    static constexpr std::size_t filas_por_insercion = 1000;
+
+    static std::string expresionCifrado(std::string_view expresion) {
+        return "encrypt_val(" + std::string(expresion) + "::TEXT)";
+    }
+    static std::string expresionIndiceCiego(std::string_view expresion) {
+        return "blind_idx(" + std::string(expresion) + "::TEXT)";
+    }
+    static std::string sentenciaCambiarTipoTexto(const std::string& tabla, const std::string& columna) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " ALTER COLUMN " + citar(columna) + " TYPE TEXT";
+    }
+    static std::string sentenciaRenombrarColumna(const std::string& tabla, const std::string& de, const std::string& a) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " RENAME COLUMN " + citar(de) + " TO " + citar(a);
+    }
+    static std::string sentenciaVaciar(const std::string& tabla) {
+        return "TRUNCATE TABLE " + tablaCalificada(tabla);
+    }
+    static std::string sentenciaCrearTablaSombra(const std::string& origen, const std::string& sombra) {
+        return "CREATE TABLE " + tablaCalificada(sombra) + " (LIKE " + tablaCalificada(origen) + " INCLUDING ALL)";
+    }
+    static std::string sentenciaBloquearEscrituras(const std::string& tabla) {
+        return "LOCK TABLE " + tablaCalificada(tabla) + " IN SHARE ROW EXCLUSIVE MODE";
+    }
+    static std::string paginar(const std::string& consulta_select, std::size_t filas) {
+        return consulta_select + " LIMIT " + std::to_string(filas);
+    }
+    static std::string expresionTexto(std::string_view expresion, std::string_view = {}) {
+        return "(" + std::string(expresion) + ")::TEXT";
+    }
+    static std::string expresionValorJson(std::string_view json, std::string_view campo) {
+        std::string salida = "((" + std::string(json) + ")::JSON ->> ";
+        literal(salida, campo);
+        return salida + ")";
+    }
+    static std::string expresionDistinta(std::string_view a, std::string_view b) {
+        return std::string(a) + " IS DISTINCT FROM " + std::string(b);
+    }
+    static std::string objetoJsonAuditoria(const std::vector<CampoJsonAuditoria>& campos) {
+        std::string salida = "(SELECT COALESCE(jsonb_object_agg(c.k, c.v), '{}')::TEXT FROM (VALUES ";
+        for (size_t i = 0; i < campos.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += '(';
+            literal(salida, campos[i].nombre);
+            salida += ", " + campos[i].valor + ", " + (campos[i].condicion.empty() ? "TRUE" : campos[i].condicion) + ')';
+        }
+        return salida + ") AS c(k, v, m) WHERE c.m)";
+    }
+    static std::string consultaClavePrimaria(const std::string& tabla) {
+        return "SELECT a.attname FROM pg_catalog.pg_index i JOIN pg_catalog.pg_attribute a ON a.attrelid = i.indrelid AND a.attnum = ANY(i.indkey) "
+            "WHERE i.indrelid = 'public.\"" + tabla + "\"'::regclass AND i.indisprimary ORDER BY array_position(i.indkey::int2[], a.attnum);";
+    }
+    static std::string consultaNombresTablas() {
+        return "SELECT tablename FROM pg_catalog.pg_tables WHERE schemaname = 'public' ORDER BY tablename;";
+    }
+    static std::string sentenciaCrearIndiceEnLinea(std::string_view tabla, std::string_view indice, std::string_view columna) {
+        return "CREATE INDEX CONCURRENTLY IF NOT EXISTS " + citar(indice) + " ON " + tablaCalificada(tabla) + " (" + citar(columna) + ")";
+    }
+    // Corte de transacciones: el xmax de la instantanea. Las transacciones que
+    // siguen abiertas desde antes de un corte son las de xid menor.
+    static std::string consultaCorteTransacciones() {
+        return "SELECT pg_snapshot_xmax(pg_current_snapshot())";
+    }
+    static std::string consultaAbiertasAntesDeCorte(const std::string& corte) {
+        std::string consulta = "SELECT CASE WHEN pg_snapshot_xmin(pg_current_snapshot()) < ";
+        literal(consulta, corte);
+        return consulta + "::xid8 THEN 1 ELSE 0 END";
+    }
+    // Indices cuya primera columna es la indicada.
+    static std::string consultaIndicesColumna(const std::string& tabla, std::string_view columna) {
+        return "SELECT i.relname FROM pg_catalog.pg_index x JOIN pg_catalog.pg_class i ON i.oid = x.indexrelid "
+            "JOIN pg_catalog.pg_attribute a ON a.attrelid = x.indrelid AND a.attnum = x.indkey[0] "
+            "WHERE x.indrelid = 'public.\"" + tabla + "\"'::regclass AND a.attname = '" + std::string(columna) + "'";
+    }
+    static std::string consultaColumnas(const std::string& tabla) {
+        return "SELECT c.column_name, c.data_type, c.is_nullable, "
+            "CASE WHEN EXISTS (SELECT 1 FROM information_schema.table_constraints tc JOIN information_schema.key_column_usage kcu ON tc.constraint_name = kcu.constraint_name "
+            "WHERE tc.constraint_type = 'PRIMARY KEY' AND tc.table_name = c.table_name AND kcu.column_name = c.column_name AND kcu.ordinal_position = 1) THEN 1 ELSE 0 END "
+            "FROM information_schema.columns c WHERE c.table_name = '" + tabla + "' ORDER BY c.ordinal_position;";
+    }
+    static std::string consultaTiposColumnas(const std::string& tabla) {
+        return "SELECT column_name, data_type FROM information_schema.columns WHERE table_schema = 'public' AND table_name = '" + tabla + "' ORDER BY ordinal_position";
+    }
+    static std::string consultaClavesForaneas(const std::string& tabla) {
+        return "SELECT kcu.column_name, ccu.table_name FROM information_schema.table_constraints tc JOIN information_schema.key_column_usage kcu ON tc.constraint_name = kcu.constraint_name JOIN information_schema.constraint_column_usage ccu ON ccu.constraint_name = tc.constraint_name WHERE tc.constraint_type = 'FOREIGN KEY' AND tc.table_name = '" + tabla + "';";
+    }
+};
+
+template <>
+struct DialectoSql<GestorAuditoria::MotorDB::MySQL> : DialectoBase<DialectoSql<GestorAuditoria::MotorDB::MySQL>> {
+    static constexpr GestorAuditoria::MotorDB motor = GestorAuditoria::MotorDB::MySQL;
+    static constexpr std::string_view comilla_abre = "`";
+    static constexpr std::string_view comilla_cierra = "`";
+    static constexpr std::string_view esquema = "";
+    static constexpr std::string_view prefijo_literal = "'";
+    static constexpr std::string_view tipo_texto = "TEXT";
+    static constexpr std::string_view tipo_binario = "LONGBLOB";
+    static constexpr std::string_view expresion_usuario = "SUBSTRING_INDEX(CURRENT_USER(),'@',1)";
+    static constexpr std::string_view expresion_fecha = "CAST(NOW() AS CHAR)";
+    static constexpr std::string_view plantilla_cifrado = "MySqlAuditCifrado.tpl";
+    static constexpr std::string_view plantilla_auditoria_delta = "MySqlAuditDelta.tpl";
+    static constexpr std::string_view plantilla_migracion = "MySqlAuditMigracion.tpl";
+    static constexpr std::string_view registro_nuevo = "NEW.";
+    static constexpr std::string_view registro_viejo = "OLD.";
+    static constexpr std::string_view prefijo_binario = "X'";
+    static constexpr std::string_view sufijo_binario = "'";
+    static constexpr bool soporta_cambio_tipo = true;
+    static constexpr std::size_t filas_por_insercion = 500;
+    static constexpr std::string_view inicio_transaccion = "START TRANSACTION";
+
+    static std::string expresionCifrado(std::string_view expresion) {
+        return "encrypt_val(" + std::string(expresion) + ")";
+    }
+    static std::string expresionIndiceCiego(std::string_view expresion) {
+        return "blind_idx(" + std::string(expresion) + ")";
+    }
+    static std::string sentenciaCrearIndice(std::string_view tabla, std::string_view indice, std::string_view columna) {
+        return "CREATE INDEX " + citar(indice) + " ON " + tablaCalificada(tabla) + " (" + citar(columna) + ")";
+    }
+    static std::string sentenciaActualizarLote(std::string_view tabla, std::string_view clave, const std::vector<std::string>& columnas,
+        const std::vector<std::vector<std::string>>& filas) {
+        std::string salida = "UPDATE " + tablaCalificada(tabla) + " AS t JOIN (";
+        for (size_t i = 0; i < filas.size(); ++i) {
+            salida += i > 0 ? " UNION ALL SELECT " : "SELECT ";
+            for (size_t j = 0; j < filas[i].size(); ++j) {
+                if (j > 0) salida += ", ";
+                salida += filas[i][j];
+                if (i == 0) salida += " AS " + citar(j == 0 ? clave : std::string_view(columnas[j - 1]));
+            }
+        }
+        salida += ") AS v ON t." + citar(clave) + " = v." + citar(clave) + " SET ";
+        for (size_t i = 0; i < columnas.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += "t." + citar(columnas[i]) + " = v." + citar(columnas[i]);
+        }
+        return salida;
+    }
+    static std::string sentenciaCambiarTipoTexto(const std::string& tabla, const std::string& columna) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " MODIFY COLUMN " + citar(columna) + " TEXT";
+    }
+    static std::string sentenciaRenombrarColumna(const std::string& tabla, const std::string& de, const std::string& a) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " RENAME COLUMN " + citar(de) + " TO " + citar(a);
+    }
+    static std::string sentenciaVaciar(const std::string& tabla) {
+        return "DELETE FROM " + tablaCalificada(tabla);
+    }
+    static std::string sentenciaCrearTablaSombra(const std::string& origen, const std::string& sombra) {
+        return "CREATE TABLE " + tablaCalificada(sombra) + " LIKE " + tablaCalificada(origen);
+    }
+    static std::string sentenciaRenombrarTabla(std::string_view de, std::string_view a) {
+        return "RENAME TABLE " + tablaCalificada(de) + " TO " + citar(a);
+    }
+    // Un unico ALTER TABLE: CHANGE COLUMN cambia tipo y nombre a la vez, y los
+    // renombrados sin cambio de tipo van como RENAME COLUMN en la misma sentencia.
+    static PlanEsquema planificarCambioEsquema(const std::string& tabla, const CambioEsquema& cambio) {
+        PlanEsquema plan;
+        const std::string destino = tipoDestino(cambio);
+        std::string acciones;
+        std::size_t cambios_tipo = 0;
+        const auto anexar = [&](const std::string& accion) {
+            if (!acciones.empty()) acciones += ", ";
+            acciones += accion;
+        };
+        std::vector<bool> renombrado_aplicado(cambio.renombrados.size(), false);
+        for (const auto& [columna, tipo] : cambio.tipos) {
+            if (esTipo(tipo, destino)) continue;
+            std::string nombre_final = columna;
+            for (std::size_t i = 0; i < cambio.renombrados.size(); ++i) {
+                if (cambio.renombrados[i].first != columna) continue;
+                nombre_final = cambio.renombrados[i].second;
+                renombrado_aplicado[i] = true;
+                break;
+            }
+            anexar("CHANGE COLUMN " + citar(columna) + " " + citar(nombre_final) + " " + destino);
+            ++cambios_tipo;
+        }
+        for (std::size_t i = 0; i < cambio.renombrados.size(); ++i) {
+            if (!renombrado_aplicado[i]) anexar("RENAME COLUMN " + citar(cambio.renombrados[i].first) + " TO " + citar(cambio.renombrados[i].second));
+        }
+        for (const auto& [columna, tipo] : cambio.columnas_nuevas) anexar("ADD COLUMN " + citar(columna) + " " + tipo);
+        if (!acciones.empty()) plan.sentencias.push_back("ALTER TABLE " + tablaCalificada(tabla) + " " + acciones);
+        plan.reescrituras = cambios_tipo > 0 ? 1 : 0;
+        plan.reescrituras_evitadas = cambio.tipos.size() - plan.reescrituras;
+        return plan;
+    }
+    static std::string paginar(const std::string& consulta_select, std::size_t filas) {
+        return consulta_select + " LIMIT " + std::to_string(filas);
+    }
+    static std::string expresionTexto(std::string_view expresion, std::string_view = {}) {
+        return "CAST(" + std::string(expresion) + " AS CHAR)";
+    }
+    static std::string expresionValorJson(std::string_view json, std::string_view campo) {
+        std::string salida = "JSON_UNQUOTE(JSON_EXTRACT(" + std::string(json) + ", ";
+        literal(salida, "$.\"" + std::string(campo) + "\"");
+        return salida + "))";
+    }
+    static std::string expresionDistinta(std::string_view a, std::string_view b) {
+        return "NOT (" + std::string(a) + " <=> " + std::string(b) + ")";
+    }
+    static std::string objetoJsonAuditoria(const std::vector<CampoJsonAuditoria>& campos) {
+        std::string salida = "(SELECT COALESCE(JSON_OBJECTAGG(c.k, c.v), JSON_OBJECT()) FROM (";
+        for (size_t i = 0; i < campos.size(); ++i) {
+            if (i > 0) salida += " UNION ALL ";
+            salida += "SELECT ";
+            literal(salida, campos[i].nombre);
+            salida += " AS k, " + campos[i].valor + " AS v, " + (campos[i].condicion.empty() ? "TRUE" : campos[i].condicion) + " AS m";
+        }
+        return salida + ") AS c WHERE c.m)";
+    }
+    static std::string consultaClavePrimaria(const std::string& tabla) {
+        return "SELECT column_name FROM information_schema.key_column_usage WHERE table_schema = DATABASE() AND table_name = '" + tabla + "' AND constraint_name = 'PRIMARY' ORDER BY ordinal_position;";
+    }
+    static std::string consultaNombresTablas() {
+        return "SELECT table_name FROM information_schema.tables WHERE table_schema = DATABASE() ORDER BY table_name;";
+    }
+    static std::string consultaCorteTransacciones() {
+        return "SELECT CAST(NOW(6) AS CHAR)";
+    }
+    static std::string consultaAbiertasAntesDeCorte(const std::string& corte) {
+        std::string consulta = "SELECT COUNT(*) FROM information_schema.INNODB_TRX WHERE trx_started <= ";
+        literal(consulta, corte);
+        return consulta;
+    }
+    static std::string consultaIndicesColumna(const std::string& tabla, std::string_view columna) {
+        return "SELECT INDEX_NAME FROM INFORMATION_SCHEMA.STATISTICS WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = '" + tabla +
+            "' AND COLUMN_NAME = '" + std::string(columna) + "' AND SEQ_IN_INDEX = 1";
+    }
+    static std::string sentenciaEliminarIndice(std::string_view tabla, std::string_view indice) {
+        return "DROP INDEX " + citar(indice) + " ON " + tablaCalificada(tabla);
+    }
+    static std::string consultaColumnas(const std::string& tabla) {
+        return "SELECT column_name, data_type, is_nullable, IF(column_key = 'PRI', 1, 0) FROM information_schema.columns WHERE table_name = '" + tabla + "' AND table_schema = DATABASE() ORDER BY ordinal_position;";
+    }
+    static std::string consultaTiposColumnas(const std::string& tabla) {
+        return "SELECT column_name, data_type FROM information_schema.columns WHERE table_name = '" + tabla + "' AND table_schema = DATABASE() ORDER BY ordinal_position";
+    }
+    static std::string consultaClavesForaneas(const std::string& tabla) {
+        return "SELECT kcu.column_name, kcu.referenced_table_name FROM information_schema.key_column_usage kcu WHERE kcu.table_name = '" + tabla + "' AND kcu.table_schema = DATABASE() AND kcu.referenced_table_name IS NOT NULL;";
+    }
+};
+
+template <>
+struct DialectoSql<GestorAuditoria::MotorDB::SQLServer> : DialectoBase<DialectoSql<GestorAuditoria::MotorDB::SQLServer>> {
+    static constexpr GestorAuditoria::MotorDB motor = GestorAuditoria::MotorDB::SQLServer;
+    static constexpr std::string_view comilla_abre = "[";
+    static constexpr std::string_view comilla_cierra = "]";
+    static constexpr std::string_view esquema = "dbo.";
+    static constexpr std::string_view prefijo_literal = "N'";
+    static constexpr std::string_view tipo_texto = "NVARCHAR(MAX)";
+    static constexpr std::string_view tipo_binario = "VARBINARY(MAX)";
+    static constexpr std::string_view expresion_usuario = "SUSER_SNAME()";
+    static constexpr std::string_view expresion_fecha = "GETDATE()";
+    static constexpr std::string_view plantilla_cifrado = "SqlServerAuditCifrado.tpl";
+    static constexpr std::string_view plantilla_auditoria_delta = "SqlServerAuditDelta.tpl";
+    static constexpr std::string_view plantilla_migracion = "SqlServerAuditMigracion.tpl";
+    static constexpr std::string_view registro_nuevo = "i.";
+    static constexpr std::string_view registro_viejo = "d.";
+    static constexpr std::string_view prefijo_binario = "0x";
+    static constexpr std::string_view sufijo_binario = "";
+    static constexpr bool soporta_cambio_tipo = true;
+    static constexpr std::size_t filas_por_insercion = 1000;
+    static constexpr std::string_view inicio_transaccion = "BEGIN TRANSACTION";
+
+    static std::string expresionCifrado(std::string_view expresion) {
+        return "EncryptByKey(Key_GUID('AuditoriaKey'), CAST(" + std::string(expresion) + " AS NVARCHAR(MAX)))";
+    }
+    static std::string expresionIndiceCiego(std::string_view expresion) {
+        return "dbo.blind_idx(CAST(" + std::string(expresion) + " AS NVARCHAR(MAX)))";
+    }
+    static std::string sentenciaAgregarColumna(std::string_view tabla, std::string_view columna, std::string_view tipo) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " ADD " + citar(columna) + " " + std::string(tipo);
+    }
+    static std::string sentenciaActualizarLote(std::string_view tabla, std::string_view clave, const std::vector<std::string>& columnas,
+        const std::vector<std::vector<std::string>>& filas) {
+        std::string salida = "UPDATE t SET ";
+        for (size_t i = 0; i < columnas.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += "t." + citar(columnas[i]) + " = v." + citar(columnas[i]);
+        }
+        salida += " FROM " + tablaCalificada(tabla) + " AS t JOIN (VALUES ";
+        anexarFilasValues(salida, filas);
+        salida += ") AS v(" + citar(clave);
+        for (const auto& columna : columnas) salida += ", " + citar(columna);
+        return salida + ") ON t." + citar(clave) + " = v." + citar(clave);
+    }
+    static std::string sentenciaCrearIndice(std::string_view tabla, std::string_view indice, std::string_view columna) {
+        return "IF NOT EXISTS (SELECT 1 FROM sys.indexes WHERE name = '" + std::string(indice) + "' AND object_id = OBJECT_ID('" + tablaCalificada(tabla) + "')) "
+            "CREATE INDEX " + citar(indice) + " ON " + tablaCalificada(tabla) + " (" + citar(columna) + ")";
+    }
+    static void literalFechaHora(std::string& salida, std::string_view texto) {
+        salida += "CAST(";
+        literal(salida, texto);
+        salida += " AS DATETIME2)";
+    }
+    static std::string sentenciaCambiarTipoTexto(const std::string& tabla, const std::string& columna) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " ALTER COLUMN " + citar(columna) + " NVARCHAR(MAX)";
+    }
+    static std::string sentenciaRenombrarColumna(const std::string& tabla, const std::string& de, const std::string& a) {
+        return "EXEC sp_rename '" + tabla + "." + de + "', '" + a + "', 'COLUMN'";
+    }
+    static std::string sentenciaVaciar(const std::string& tabla) {
+        return "TRUNCATE TABLE " + tablaCalificada(tabla);
+    }
+    static std::string sentenciaCrearTablaSombra(const std::string& origen, const std::string& sombra) {
+        return "SELECT TOP 0 * INTO " + tablaCalificada(sombra) + " FROM " + tablaCalificada(origen);
+    }
+    static std::string sentenciaRenombrarTabla(std::string_view de, std::string_view a) {
+        return "EXEC sp_rename '" + std::string(esquema) + std::string(de) + "', '" + std::string(a) + "'";
+    }
+    // ALTER COLUMN admite una sola columna por sentencia; solo se agrupan las
+    // columnas nuevas y se omiten las que ya tienen el tipo de destino. NVARCHAR
+    // no se convierte implicitamente a VARBINARY, asi que el paso a binario (que
+    // solo se pide con la tabla vacia) quita y vuelve a agregar las columnas.
+    static PlanEsquema planificarCambioEsquema(const std::string& tabla, const CambioEsquema& cambio) {
+        PlanEsquema plan;
+        const std::string destino = tipoDestino(cambio);
+        if (destino == tipo_binario) {
+            std::string quitar, agregar;
+            for (const auto& [columna, tipo] : cambio.tipos) {
+                if (esTipo(tipo, destino)) continue;
+                quitar += quitar.empty() ? "ALTER TABLE " + tablaCalificada(tabla) + " DROP COLUMN " : ", ";
+                quitar += citar(columna);
+                agregar += agregar.empty() ? "ALTER TABLE " + tablaCalificada(tabla) + " ADD " : ", ";
+                agregar += citar(columna) + " " + destino;
+            }
+            if (!quitar.empty()) {
+                plan.sentencias.push_back(quitar);
+                plan.sentencias.push_back(agregar);
+                plan.reescrituras = 1;
+            }
+        }
+        else {
+            for (const auto& [columna, tipo] : cambio.tipos) {
+                if (esTipo(tipo, destino)) continue;
+                plan.sentencias.push_back("ALTER TABLE " + tablaCalificada(tabla) + " ALTER COLUMN " + citar(columna) + " " + destino);
+                ++plan.reescrituras;
+            }
+        }
+        plan.reescrituras_evitadas = cambio.tipos.size() - plan.reescrituras;
+        std::string nuevas;
+        for (const auto& [columna, tipo] : cambio.columnas_nuevas) {
+            nuevas += nuevas.empty() ? "ALTER TABLE " + tablaCalificada(tabla) + " ADD " : ", ";
+            nuevas += citar(columna) + " " + tipo;
+        }
+        if (!nuevas.empty()) plan.sentencias.push_back(nuevas);
+        for (const auto& [de, a] : cambio.renombrados) plan.sentencias.push_back(sentenciaRenombrarColumna(tabla, de, a));
+        return plan;
+    }
+    static std::string sentenciaBloquearEscrituras(const std::string& tabla) {
+        return "SELECT TOP 1 1 FROM " + tablaCalificada(tabla) + " WITH (TABLOCK, UPDLOCK, HOLDLOCK)";
+    }
+    static std::string paginar(const std::string& consulta_select, std::size_t filas) {
+        std::string resultado = consulta_select;
+        size_t select_pos = resultado.find("SELECT");
+        if (select_pos != std::string::npos) {
+            resultado.insert(select_pos + 6, " TOP " + std::to_string(filas));
+        }
+        return resultado;
+    }
+    static bool columnaAuditable(std::string_view tipo) {
+        return tipo != "text" && tipo != "ntext" && tipo != "image";
+    }
+    // El estilo 0 de CONVERT recorta fechas al minuto y float/real a 6 digitos:
+    // 126 da ISO 8601 con fracciones y 3 los 17 digitos significativos.
+    static std::string expresionTexto(std::string_view expresion, std::string_view tipo = {}) {
+        std::string estilo;
+        if (tipo == "date" || tipo == "time" || tipo == "datetime" || tipo == "datetime2" ||
+            tipo == "smalldatetime" || tipo == "datetimeoffset") estilo = ", 126";
+        else if (tipo == "float" || tipo == "real") estilo = ", 3";
+        return "CONVERT(NVARCHAR(MAX), " + std::string(expresion) + estilo + ")";
+    }
+    static std::string expresionValorJson(std::string_view json, std::string_view campo) {
+        std::string salida = "JSON_VALUE(" + std::string(json) + ", ";
+        literal(salida, "$.\"" + std::string(campo) + "\"");
+        return salida + ")";
+    }
+    static std::string expresionDistinta(std::string_view a, std::string_view b) {
+        const std::string x(a), y(b);
+        return "(" + x + " <> " + y + " OR (" + x + " IS NULL AND " + y + " IS NOT NULL) OR (" + x + " IS NOT NULL AND " + y + " IS NULL))";
+    }
+    static std::string objetoJsonAuditoria(const std::vector<CampoJsonAuditoria>& campos) {
+        std::string salida = "COALESCE((SELECT N'{' + STRING_AGG(CAST(N'\"' + STRING_ESCAPE(c.k, 'json') + N'\":' + "
+            "COALESCE(N'\"' + STRING_ESCAPE(c.v, 'json') + N'\"', N'null') AS NVARCHAR(MAX)), N',') + N'}' FROM (VALUES ";
+        for (size_t i = 0; i < campos.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += '(';
+            literal(salida, campos[i].nombre);
+            salida += ", " + campos[i].valor + ", " + (campos[i].condicion.empty() ? "1" : "CASE WHEN " + campos[i].condicion + " THEN 1 ELSE 0 END") + ')';
+        }
+        return salida + ") AS c(k, v, m) WHERE c.m = 1), N'{}')";
+    }
+    static std::string consultaClavePrimaria(const std::string& tabla) {
+        return "SELECT c.name FROM sys.indexes i JOIN sys.index_columns ic ON ic.object_id = i.object_id AND ic.index_id = i.index_id "
+            "JOIN sys.columns c ON c.object_id = ic.object_id AND c.column_id = ic.column_id "
+            "WHERE i.is_primary_key = 1 AND i.object_id = OBJECT_ID('" + tabla + "') ORDER BY ic.key_ordinal;";
+    }
+    static std::string consultaNombresTablas() {
+        return "SELECT name FROM sys.tables ORDER BY name;";
+    }
+    static std::string consultaCorteTransacciones() {
+        return "SELECT CONVERT(VARCHAR(27), SYSDATETIME(), 121)";
+    }
+    static std::string consultaAbiertasAntesDeCorte(const std::string& corte) {
+        std::string consulta = "SELECT COUNT(*) FROM sys.dm_tran_database_transactions WHERE database_id = DB_ID() AND database_transaction_begin_time <= ";
+        literal(consulta, corte);
+        return consulta;
+    }
+    static std::string consultaIndicesColumna(const std::string& tabla, std::string_view columna) {
+        return "SELECT i.name FROM sys.indexes i JOIN sys.index_columns ic ON ic.object_id = i.object_id AND ic.index_id = i.index_id AND ic.key_ordinal = 1 "
+            "JOIN sys.columns c ON c.object_id = ic.object_id AND c.column_id = ic.column_id "
+            "WHERE i.object_id = OBJECT_ID('" + tablaCalificada(tabla) + "') AND c.name = '" + std::string(columna) + "'";
+    }
+    static std::string sentenciaEliminarIndice(std::string_view tabla, std::string_view indice) {
+        return "DROP INDEX IF EXISTS " + citar(indice) + " ON " + tablaCalificada(tabla);
+    }
+    static std::string consultaColumnas(const std::string& tabla) {
+        return "SELECT c.name, t.name, CASE WHEN c.is_nullable = 1 THEN 'YES' ELSE 'NO' END, ISNULL(i.is_primary_key, 0) FROM sys.columns c INNER JOIN sys.types t ON c.user_type_id = t.user_type_id LEFT JOIN sys.index_columns ic ON ic.object_id = c.object_id AND ic.column_id = c.column_id LEFT JOIN sys.indexes i ON i.object_id = ic.object_id AND i.index_id = ic.index_id AND i.is_primary_key = 1 WHERE c.object_id = OBJECT_ID('" + tabla + "') ORDER BY c.column_id;";
+    }
+    static std::string consultaTiposColumnas(const std::string& tabla) {
+        return "SELECT c.name, CASE WHEN c.max_length = -1 THEN t.name + '(max)' ELSE t.name END FROM sys.columns c INNER JOIN sys.types t ON c.user_type_id = t.user_type_id "
+            "WHERE c.object_id = OBJECT_ID('dbo." + tabla + "') ORDER BY c.column_id";
+    }
+    static std::string consultaClavesForaneas(const std::string& tabla) {
+        return "SELECT col.name, ref_tab.name FROM sys.foreign_key_columns fk INNER JOIN sys.columns col ON fk.parent_object_id = col.object_id AND fk.parent_column_id = col.column_id INNER JOIN sys.tables tab ON fk.parent_object_id = tab.object_id INNER JOIN sys.tables ref_tab ON fk.referenced_object_id = ref_tab.object_id WHERE tab.name = '" + tabla + "';";
+    }
+};
+
+template <>
+struct DialectoSql<GestorAuditoria::MotorDB::SQLite> : DialectoBase<DialectoSql<GestorAuditoria::MotorDB::SQLite>> {
+    static constexpr GestorAuditoria::MotorDB motor = GestorAuditoria::MotorDB::SQLite;
+    static constexpr std::string_view comilla_abre = "\"";
+    static constexpr std::string_view comilla_cierra = "\"";
+    static constexpr std::string_view esquema = "";
+    static constexpr std::string_view prefijo_literal = "'";
+    static constexpr std::string_view tipo_texto = "TEXT";
+    static constexpr std::string_view tipo_binario = "BLOB";
+    static constexpr std::string_view expresion_usuario = "'SYSTEM'";
+    static constexpr std::string_view expresion_fecha = "datetime('now')";
+    static constexpr std::string_view plantilla_cifrado = "";
+    static constexpr std::string_view plantilla_auditoria_delta = "SqliteAuditDelta.tpl";
+    static constexpr std::string_view plantilla_migracion = "";
+    static constexpr std::string_view registro_nuevo = "NEW.";
+    static constexpr std::string_view registro_viejo = "OLD.";
+    static constexpr std::string_view prefijo_binario = "X'";
+    static constexpr std::string_view sufijo_binario = "'";
+    static constexpr bool soporta_cambio_tipo = false;
+    static constexpr std::size_t filas_por_insercion = 500;
+
+    static constexpr std::string_view tipo_indice_ciego = "TEXT";
+
+    static std::string expresionCifrado(std::string_view expresion) {
+        return std::string(expresion);
+    }
+    static std::string expresionIndiceCiego(std::string_view) {
+        return "NULL";
+    }
+    static std::string sentenciaActualizarLote(std::string_view tabla, std::string_view clave, const std::vector<std::string>& columnas,
+        const std::vector<std::vector<std::string>>& filas) {
+        std::string salida = "UPDATE " + tablaCalificada(tabla) + " SET ";
+        for (size_t i = 0; i < columnas.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += citar(columnas[i]) + " = v.column" + std::to_string(i + 2);
+        }
+        salida += " FROM (VALUES ";
+        anexarFilasValues(salida, filas);
+        return salida + ") AS v WHERE " + tablaCalificada(tabla) + "." + citar(clave) + " = v.column1";
+    }
+    static std::string sentenciaCambiarTipoTexto(const std::string&, const std::string&) {
+        return "";
+    }
+    static std::string sentenciaRenombrarColumna(const std::string& tabla, const std::string& de, const std::string& a) {
+        return "ALTER TABLE " + tablaCalificada(tabla) + " RENAME COLUMN " + citar(de) + " TO " + citar(a);
+    }
+    static std::string sentenciaVaciar(const std::string& tabla) {
+        return "DELETE FROM " + tablaCalificada(tabla);
+    }
+    // SQLite no cambia tipos y admite una sola accion por ALTER TABLE.
+    static PlanEsquema planificarCambioEsquema(const std::string& tabla, const CambioEsquema& cambio) {
+        PlanEsquema plan;
+        for (const auto& [columna, tipo] : cambio.columnas_nuevas) plan.sentencias.push_back(sentenciaAgregarColumna(tabla, columna, tipo));
+        for (const auto& [de, a] : cambio.renombrados) plan.sentencias.push_back(sentenciaRenombrarColumna(tabla, de, a));
+        return plan;
+    }
+    static std::string paginar(const std::string& consulta_select, std::size_t filas) {
+        return consulta_select + " LIMIT " + std::to_string(filas);
+    }
+    static std::string expresionTexto(std::string_view expresion, std::string_view = {}) {
+        return "CAST(" + std::string(expresion) + " AS TEXT)";
+    }
+    static std::string expresionValorJson(std::string_view json, std::string_view campo) {
+        std::string salida = "json_extract(" + std::string(json) + ", ";
+        literal(salida, "$.\"" + std::string(campo) + "\"");
+        return salida + ")";
+    }
+    static std::string expresionDistinta(std::string_view a, std::string_view b) {
+        return std::string(a) + " IS NOT " + std::string(b);
+    }
+    static std::string objetoJsonAuditoria(const std::vector<CampoJsonAuditoria>& campos) {
+        std::string salida = "(SELECT json_group_object(column1, column2) FROM (VALUES ";
+        for (size_t i = 0; i < campos.size(); ++i) {
+            if (i > 0) salida += ", ";
+            salida += '(';
+            literal(salida, campos[i].nombre);
+            salida += ", " + campos[i].valor + ", " + (campos[i].condicion.empty() ? "1" : campos[i].condicion) + ')';
+        }
+        return salida + ") WHERE column3)";
+    }
+    static std::string consultaClavePrimaria(const std::string& tabla) {
+        return "SELECT name FROM pragma_table_info('" + tabla + "') WHERE pk > 0 ORDER BY pk;";
+    }
+    static std::string consultaNombresTablas() {
+        return "SELECT name FROM sqlite_master WHERE type='table' ORDER BY name;";
+    }
+    // Con un solo escritor, los ids se confirman en orden y un hueco es definitivo.
+    static std::string consultaCorteTransacciones() {
+        return "";
+    }
+    static std::string consultaAbiertasAntesDeCorte(const std::string&) {
+        return "";
+    }
+    // Una columna INTEGER PRIMARY KEY es el rowid y no aparece en pragma_index_list.
+    static std::string consultaIndicesColumna(const std::string& tabla, std::string_view columna) {
+        return "SELECT 'rowid' FROM pragma_table_info('" + tabla + "') WHERE name = '" + std::string(columna) + "' AND pk = 1 AND upper(type) = 'INTEGER' "
+            "UNION ALL SELECT il.name FROM pragma_index_list('" + tabla + "') il, pragma_index_info(il.name) ii WHERE ii.seqno = 0 AND ii.name = '" + std::string(columna) + "'";
+    }
+    static std::string consultaColumnas(const std::string& tabla) {
+        return "SELECT name, type, CASE WHEN \"notnull\" = 0 THEN 'YES' ELSE 'NO' END, CASE WHEN pk = 1 THEN 1 ELSE 0 END FROM pragma_table_info('" + tabla + "') ORDER BY cid;";
+    }
+    static std::string consultaTiposColumnas(const std::string& tabla) {
+        return "SELECT name, type FROM pragma_table_info('" + tabla + "') ORDER BY cid";
+    }
+    static std::string consultaClavesForaneas(const std::string&) {
+        return "";
+    }
+};
+
+template <typename Funcion>
+decltype(auto) despacharDialecto(GestorAuditoria::MotorDB motor, Funcion&& funcion) {
+    switch (motor) {
+    case GestorAuditoria::MotorDB::PostgreSQL: return funcion(DialectoSql<GestorAuditoria::MotorDB::PostgreSQL>{});
+    case GestorAuditoria::MotorDB::MySQL: return funcion(DialectoSql<GestorAuditoria::MotorDB::MySQL>{});
+    case GestorAuditoria::MotorDB::SQLServer: return funcion(DialectoSql<GestorAuditoria::MotorDB::SQLServer>{});
+    case GestorAuditoria::MotorDB::SQLite: return funcion(DialectoSql<GestorAuditoria::MotorDB::SQLite>{});
+    }
+    throw std::runtime_error("Motor de base de datos no soportado.");
+}
+
+// Crea un indice sobre IdAuditoria si la tabla no tiene ninguno que empiece por
+// esa columna, para recorrerla por rangos sin leerla entera en cada bloque.
+// Devuelve el nombre del indice temporal (vacio si ya habia otro), que el
+// llamador elimina al terminar con sentenciaEliminarIndice. Un indice temporal
+// que quedo de una ejecucion interrumpida se reutiliza. Con en_linea, el indice
+// se crea sin bloquear las escrituras donde el motor lo permite.
+template <typename Dialecto>
+std::string asegurarIndiceSecuencia(GestorAuditoria& conexion, const std::string& tabla, bool en_linea = false) {
+    const std::string indice = "ix_" + tabla + "_" + std::string(COLUMNA_SECUENCIA_AUDITORIA);
+    bool existe = false;
+    for (const auto& fila : conexion.ejecutarConsultaConResultado(Dialecto::consultaIndicesColumna(tabla, COLUMNA_SECUENCIA_AUDITORIA)).filas) {
+        if (fila[0] != indice) return "";
+        existe = true;
+    }
+    if (!existe) {
+        conexion.ejecutarComando(en_linea ? Dialecto::sentenciaCrearIndiceEnLinea(tabla, indice, COLUMNA_SECUENCIA_AUDITORIA)
+                                          : Dialecto::sentenciaCrearIndice(tabla, indice, COLUMNA_SECUENCIA_AUDITORIA));
+    }
+    return indice;
+}
@@ -0,0 +1,131 @@
+#include "EjecutorAsincrono.hpp"
+#include <exception>
+#include <stdexcept>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#ifdef _WIN32
+#include <boost/asio/ip/tcp.hpp>
+#else
+#include <boost/asio/posix/stream_descriptor.hpp>
+#endif
+
+namespace asio = boost::asio;
+
+namespace {
+
+// Envuelve el socket de libpq sin tomar su propiedad: al destruirse lo suelta
+// en lugar de cerrarlo.
+class SocketPg {
+public:
+    SocketPg(const asio::any_io_executor& ejecutor, PGconn* conexion)
+#ifdef _WIN32
+        : socket(ejecutor, asio::ip::tcp::v4(), PQsocket(conexion)) {}
+#else
+        : socket(ejecutor, PQsocket(conexion)) {}
+#endif
+    ~SocketPg() {
+        socket.release();
+    }
+    SocketPg(const SocketPg&) = delete;
+    SocketPg& operator=(const SocketPg&) = delete;
+
+    asio::awaitable<void> esperarLectura() {
+#ifdef _WIN32
+        co_await socket.async_wait(asio::socket_base::wait_read, asio::use_awaitable);
+#else
+        co_await socket.async_wait(asio::posix::descriptor_base::wait_read, asio::use_awaitable);
+#endif
+    }
+
+    asio::awaitable<void> esperarEscritura() {
+#ifdef _WIN32
+        co_await socket.async_wait(asio::socket_base::wait_write, asio::use_awaitable);
+#else
+        co_await socket.async_wait(asio::posix::descriptor_base::wait_write, asio::use_awaitable);
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    asio::ip::tcp::socket socket;
+#else
+    asio::posix::stream_descriptor socket;
+#endif
+};
+
+class ModoNoBloqueante {
+public:
+    explicit ModoNoBloqueante(PGconn* conexion) : conexion(conexion) {
+        if (PQsetnonblocking(conexion, 1) != 0) throw std::runtime_error(PQerrorMessage(conexion));
+    }
+    ~ModoNoBloqueante() {
+        PQsetnonblocking(conexion, 0);
+    }
+    ModoNoBloqueante(const ModoNoBloqueante&) = delete;
+    ModoNoBloqueante& operator=(const ModoNoBloqueante&) = delete;
+
+private:
+    PGconn* conexion;
+};
+
+struct EstadoReparto {
+    std::size_t num_tareas;
+    std::size_t siguiente = 0;
+    std::exception_ptr error;
+    const std::function<asio::awaitable<void>(std::size_t, std::size_t)>& ejecutar_tarea;
+};
+
+asio::awaitable<void> recorrerTareas(std::size_t canal, EstadoReparto& estado) {
+    while (!estado.error && estado.siguiente < estado.num_tareas) {
+        const std::size_t tarea = estado.siguiente++;
+        co_await estado.ejecutar_tarea(canal, tarea);
+    }
+}
+
+}
+
+asio::awaitable<ResultadoPg> consultarPgAsincrono(PGconn* conexion, std::string consulta) {
+    ModoNoBloqueante modo(conexion);
+    if (!PQsendQuery(conexion, consulta.c_str())) throw std::runtime_error(PQerrorMessage(conexion));
+
+    SocketPg socket(co_await asio::this_coro::executor, conexion);
+    int pendiente;
+    while ((pendiente = PQflush(conexion)) == 1) {
+        co_await socket.esperarEscritura();
+        if (!PQconsumeInput(conexion)) throw std::runtime_error(PQerrorMessage(conexion));
+    }
+    if (pendiente < 0) throw std::runtime_error(PQerrorMessage(conexion));
+
+    ResultadoPg ultimo(nullptr, &PQclear);
+    std::string error;
+    while (true) {
+        while (PQisBusy(conexion)) {
+            co_await socket.esperarLectura();
+            if (!PQconsumeInput(conexion)) throw std::runtime_error(PQerrorMessage(conexion));
+        }
+        PGresult* resultado = PQgetResult(conexion);
+        if (!resultado) break;
+        const ExecStatusType estado = PQresultStatus(resultado);
+        if (error.empty() && estado != PGRES_COMMAND_OK && estado != PGRES_TUPLES_OK && estado != PGRES_EMPTY_QUERY) {
+            error = PQresultErrorMessage(resultado);
+        }
+        ultimo.reset(resultado);
+    }
+    if (!error.empty()) throw std::runtime_error(error);
+    co_return ultimo;
+}
+
+void ejecutarEnCorrutinas(std::size_t num_canales, std::size_t num_tareas,
+    const std::function<asio::awaitable<void>(std::size_t canal, std::size_t tarea)>& ejecutar_tarea) {
+    asio::io_context contexto(1);
+    EstadoReparto estado{ num_tareas, 0, nullptr, ejecutar_tarea };
+    for (std::size_t canal = 0; canal < num_canales; ++canal) {
+        asio::co_spawn(contexto, recorrerTareas(canal, estado), [&estado](std::exception_ptr error) {
+            if (error && !estado.error) estado.error = error;
+            });
+    }
+    contexto.run();
+    if (estado.error) std::rethrow_exception(estado.error);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <utility>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <boost/asio/awaitable.hpp>
+#include <libpq-fe.h>
+
+using ResultadoPg = std::unique_ptr<PGresult, decltype(&PQclear)>;
+
+// Envia la consulta con PQsendQuery y suspende la corrutina mientras el socket
+// de la conexion no este listo. Devuelve el ultimo resultado y lanza el primer
+// error recibido. No admite COPY.
+boost::asio::awaitable<ResultadoPg> consultarPgAsincrono(PGconn* conexion, std::string consulta);
+
+// Reparte num_tareas entre num_canales corrutinas que se ejecutan en el hilo
+// llamador; cada canal toma la siguiente tarea al terminar la anterior. El
+// primer error detiene el reparto y se relanza cuando todos los canales terminan.
+void ejecutarEnCorrutinas(std::size_t num_canales, std::size_t num_tareas,
+    const std::function<boost::asio::awaitable<void>(std::size_t canal, std::size_t tarea)>& ejecutar_tarea);
@@ -0,0 +1,395 @@
+#include "EscritorSalida.hpp"
+#include <stdexcept>
+#include <iostream>
+#include <cmath>
+#include <optional>
+#include <algorithm>
+#include "FormatoColumnar.hpp"
+
+namespace {
+
+void anexarCadenaJson(std::string& salida, std::string_view texto) {
+    static const char digitos_hex[] = "0123456789abcdef";
+    salida += '"';
+    for (char c : texto) {
+        switch (c) {
+        case '"': salida += "\\\""; break;
+        case '\\': salida += "\\\\"; break;
+        case '\n': salida += "\\n"; break;
+        case '\r': salida += "\\r"; break;
+        case '\t': salida += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                salida += "\\u00";
+                salida += digitos_hex[(c >> 4) & 0x0F];
+                salida += digitos_hex[c & 0x0F];
+            }
+            else {
+                salida += c;
+            }
+        }
+    }
+    salida += '"';
+}
+
+bool esNumeroJson(std::string_view digitos) {
+    std::size_t i = (!digitos.empty() && digitos[0] == '-') ? 1 : 0;
+    return i < digitos.size() && digitos[i] >= '0' && digitos[i] <= '9';
+}
+
+void anexarValorJson(std::string& salida, const ValorCelda& valor, std::string& temporal) {
+    switch (valor.index()) {
+    case 0:
+        salida += "null";
+        break;
+    case 1:
+        salida += std::get<bool>(valor) ? "true" : "false";
+        break;
+    case 2:
+        anexarValorTexto(salida, valor);
+        break;
+    case 3:
+        if (std::isfinite(std::get<double>(valor))) anexarValorTexto(salida, valor);
+        else salida += "null";
+        break;
+    case 4:
+        anexarCadenaJson(salida, std::get<std::string>(valor));
+        break;
+    case 8:
+        if (esNumeroJson(std::get<Numerico>(valor).digitos)) {
+            salida += std::get<Numerico>(valor).digitos;
+            break;
+        }
+        [[fallthrough]];
+    default:
+        temporal.clear();
+        anexarValorTexto(temporal, valor);
+        anexarCadenaJson(salida, temporal);
+        break;
+    }
+}
+
+void anexarCampoDelimitado(std::string& salida, std::string_view texto, char separador) {
+    const char especiales[] = { separador, '"', '\n', '\r' };
+    if (texto.find_first_of(std::string_view(especiales, sizeof(especiales))) == std::string_view::npos) {
+        salida += texto;
+        return;
+    }
+    salida += '"';
+    for (char c : texto) {
+        if (c == '"') salida += '"';
+        salida += c;
+    }
+    salida += '"';
+}
+
+class EscritorCsv : public EscritorSalida {
+public:
+    template <typename Destino>
+    explicit EscritorCsv(Destino destino) : salida(destino) {}
+
+    void escribirEncabezado(const std::vector<std::string>& columnas) override {
+        std::string& datos = salida.datos();
+        for (std::size_t i = 0; i < columnas.size(); ++i) {
+            if (i > 0) datos += ',';
+            anexarCampoDelimitado(datos, columnas[i], ',');
+        }
+        datos += '\n';
+    }
+
+    void escribirFila(const std::vector<ValorCelda>& fila) override {
+        std::string& datos = salida.datos();
+        for (std::size_t i = 0; i < fila.size(); ++i) {
+            if (i > 0) datos += ',';
+            if (esNulo(fila[i])) continue;
+            if (const std::string* texto = std::get_if<std::string>(&fila[i])) {
+                anexarCampoDelimitado(datos, *texto, ',');
+            }
+            else {
+                temporal.clear();
+                anexarValorTexto(temporal, fila[i]);
+                anexarCampoDelimitado(datos, temporal, ',');
+            }
+        }
+        datos += '\n';
+        salida.volcarSiLleno();
+    }
+
+    void finalizar() override {
+        salida.volcar();
+    }
+
+private:
+    SalidaBuffer salida;
+    std::string temporal;
+};
+
+void anexarCampoTsv(std::string& salida, std::string_view texto) {
+    if (texto.find_first_of("\t\n\r\\") == std::string_view::npos) {
+        salida += texto;
+        return;
+    }
+    for (char c : texto) {
+        switch (c) {
+        case '\t': salida += "\\t"; break;
+        case '\n': salida += "\\n"; break;
+        case '\r': salida += "\\r"; break;
+        case '\\': salida += "\\\\"; break;
+        default: salida += c;
+        }
+    }
+}
+
+class EscritorTsv : public EscritorSalida {
+public:
+    template <typename Destino>
+    explicit EscritorTsv(Destino destino) : salida(destino) {}
+
+    void escribirEncabezado(const std::vector<std::string>& columnas) override {
+        std::string& datos = salida.datos();
+        for (std::size_t i = 0; i < columnas.size(); ++i) {
+            if (i > 0) datos += '\t';
+            anexarCampoTsv(datos, columnas[i]);
+        }
+        datos += '\n';
+    }
+
+    void escribirFila(const std::vector<ValorCelda>& fila) override {
+        std::string& datos = salida.datos();
+        for (std::size_t i = 0; i < fila.size(); ++i) {
+            if (i > 0) datos += '\t';
+            if (esNulo(fila[i])) continue;
+            if (const std::string* texto = std::get_if<std::string>(&fila[i])) {
+                anexarCampoTsv(datos, *texto);
+            }
+            else {
+                temporal.clear();
+                anexarValorTexto(temporal, fila[i]);
+                anexarCampoTsv(datos, temporal);
+            }
+        }
+        datos += '\n';
+        salida.volcarSiLleno();
+    }
+
+    void finalizar() override {
+        salida.volcar();
+    }
+
+private:
+    SalidaBuffer salida;
+    std::string temporal;
+};
+
+class EscritorTabla : public EscritorSalida {
+public:
+    template <typename Destino>
+    explicit EscritorTabla(Destino destino) : salida(destino) {}
+
+    void escribirEncabezado(const std::vector<std::string>& columnas) override {
+        encabezado = columnas;
+        anchos.assign(columnas.size(), 0);
+        for (std::size_t i = 0; i < columnas.size(); ++i) anchos[i] = columnas[i].size();
+    }
+
+    void escribirFila(const std::vector<ValorCelda>& fila) override {
+        ++filas;
+        if (anchos_fijados) {
+            anexarFila(fila);
+            salida.volcarSiLleno();
+            return;
+        }
+        std::vector<std::string> textos;
+        textos.reserve(fila.size());
+        for (std::size_t i = 0; i < fila.size(); ++i) {
+            textos.push_back(valorATexto(fila[i]));
+            anchos[i] = std::max(anchos[i], textos.back().size());
+        }
+        pendientes.push_back(std::move(textos));
+        if (pendientes.size() >= FILAS_PARA_ANCHOS) fijarAnchos();
+    }
+
+    void finalizar() override {
+        if (!anchos_fijados) fijarAnchos();
+        salida.datos() += "(" + std::to_string(filas) + (filas == 1 ? " fila)\n" : " filas)\n");
+        salida.volcar();
+    }
+
+private:
+    static constexpr std::size_t FILAS_PARA_ANCHOS = 1000;
+    static constexpr std::size_t ANCHO_MAXIMO = 60;
+
+    SalidaBuffer salida;
+    std::vector<std::string> encabezado;
+    std::vector<std::size_t> anchos;
+    std::vector<std::vector<std::string>> pendientes;
+    std::string temporal;
+    std::size_t filas = 0;
+    bool anchos_fijados = false;
+
+    void anexarCelda(std::string& datos, std::size_t columna, std::string_view texto) {
+        if (columna > 0) datos += " | ";
+        datos += texto;
+        if (columna + 1 < anchos.size() && texto.size() < anchos[columna]) datos.append(anchos[columna] - texto.size(), ' ');
+    }
+
+    void anexarFila(const std::vector<ValorCelda>& fila) {
+        std::string& datos = salida.datos();
+        for (std::size_t i = 0; i < fila.size(); ++i) {
+            temporal.clear();
+            anexarValorTexto(temporal, fila[i]);
+            anexarCelda(datos, i, temporal);
+        }
+        datos += '\n';
+    }
+
+    void fijarAnchos() {
+        for (auto& ancho : anchos) ancho = std::min(ancho, ANCHO_MAXIMO);
+        std::string& datos = salida.datos();
+        for (std::size_t i = 0; i < encabezado.size(); ++i) anexarCelda(datos, i, encabezado[i]);
+        datos += '\n';
+        for (std::size_t i = 0; i < anchos.size(); ++i) {
+            if (i > 0) datos += "-+-";
+            datos.append(anchos[i], '-');
+        }
+        datos += '\n';
+        for (const auto& textos : pendientes) {
+            for (std::size_t i = 0; i < textos.size(); ++i) anexarCelda(datos, i, textos[i]);
+            datos += '\n';
+        }
+        pendientes.clear();
+        pendientes.shrink_to_fit();
+        anchos_fijados = true;
+        salida.volcarSiLleno();
+    }
+};
+
+class EscritorNdjson : public EscritorSalida {
+public:
+    template <typename Destino>
+    explicit EscritorNdjson(Destino destino) : salida(destino) {}
+
+    void escribirEncabezado(const std::vector<std::string>& columnas) override {
+        claves.clear();
+        for (const auto& columna : columnas) {
+            std::string clave;
+            anexarCadenaJson(clave, columna);
+            clave += ':';
+            claves.push_back(std::move(clave));
+        }
+    }
+
+    void escribirFila(const std::vector<ValorCelda>& fila) override {
+        std::string& datos = salida.datos();
+        datos += '{';
+        for (std::size_t i = 0; i < fila.size(); ++i) {
+            if (i > 0) datos += ',';
+            datos += claves[i];
+            anexarValorJson(datos, fila[i], temporal);
+        }
+        datos += "}\n";
+        salida.volcarSiLleno();
+    }
+
+    void finalizar() override {
+        salida.volcar();
+    }
+
+private:
+    SalidaBuffer salida;
+    std::vector<std::string> claves;
+    std::string temporal;
+};
+
+class EscritorBinario : public EscritorSalida {
+public:
+    explicit EscritorBinario(const std::string& ruta) : ruta(ruta) {}
+
+    void escribirEncabezado(const std::vector<std::string>& columnas) override {
+        escritor.emplace(ruta, FormatoValores::ValorEtiquetado, columnas);
+    }
+
+    void escribirFila(const std::vector<ValorCelda>& fila) override {
+        for (std::size_t i = 0; i < fila.size(); ++i) escritor->agregarValor(i, fila[i]);
+        escritor->finalizarFila();
+    }
+
+    void finalizar() override {
+        if (!escritor) escritor.emplace(ruta, FormatoValores::ValorEtiquetado, std::vector<std::string>{});
+        escritor->cerrar();
+    }
+
+private:
+    std::string ruta;
+    std::optional<EscritorColumnar> escritor;
+};
+
+template <typename Destino>
+std::unique_ptr<EscritorSalida> crearEscritorTexto(const std::string& formato, Destino destino) {
+    if (formato == "tabla") return std::make_unique<EscritorTabla>(destino);
+    if (formato == "csv") return std::make_unique<EscritorCsv>(destino);
+    if (formato == "tsv") return std::make_unique<EscritorTsv>(destino);
+    if (formato == "ndjson") return std::make_unique<EscritorNdjson>(destino);
+    throw std::runtime_error("Formato de salida no soportado: " + formato);
+}
+
+}
+
+SalidaBuffer::SalidaBuffer(const std::string& ruta, std::size_t capacidad) : capacidad(capacidad) {
+    if (ruta.empty() || ruta == "-") {
+        std::cout.flush();
+        archivo = stdout;
+    }
+    else {
+        archivo = std::fopen(ruta.c_str(), "wb");
+        if (!archivo) throw std::runtime_error("No se pudo crear el archivo de salida: " + ruta);
+        archivo_propio = true;
+        std::setvbuf(archivo, nullptr, _IONBF, 0);
+    }
+    buffer.reserve(capacidad + capacidad / 4);
+}
+
+SalidaBuffer::SalidaBuffer(std::string* destino_memoria, std::size_t capacidad) : destino_memoria(destino_memoria), capacidad(capacidad) {
+}
+
+SalidaBuffer::~SalidaBuffer() {
+    try {
+        volcar();
+    }
+    catch (...) {
+    }
+    if (archivo_propio) std::fclose(archivo);
+}
+
+void SalidaBuffer::volcar() {
+    if (buffer.empty()) return;
+    if (destino_memoria) {
+        destino_memoria->append(buffer);
+        buffer.clear();
+        return;
+    }
+    if (std::fwrite(buffer.data(), 1, buffer.size(), archivo) != buffer.size()) {
+        throw std::runtime_error("Error de escritura en la salida.");
+    }
+    if (!archivo_propio) std::fflush(archivo);
+    buffer.clear();
+}
+
+std::unique_ptr<EscritorSalida> crearEscritorSalida(const std::string& formato, const std::string& ruta) {
+    if (formato == "binario") {
+        if (ruta.empty() || ruta == "-") throw std::runtime_error("El formato binario requiere un archivo de salida.");
+        return std::make_unique<EscritorBinario>(ruta);
+    }
+    return crearEscritorTexto(formato, ruta);
+}
+
+std::unique_ptr<EscritorSalida> crearEscritorEnMemoria(const std::string& formato, std::string& destino) {
+    if (formato == "binario") throw std::runtime_error("El formato binario requiere un archivo de salida.");
+    return crearEscritorTexto(formato, &destino);
+}
+
+std::string extensionFormatoSalida(const std::string& formato) {
+    if (formato == "binario") return ".shcb";
+    if (formato == "tabla") return ".txt";
+    return "." + formato;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include "ValorCelda.hpp"
+
+class SalidaBuffer {
+public:
+    explicit SalidaBuffer(const std::string& ruta, std::size_t capacidad = 4 * 1024 * 1024);
+    explicit SalidaBuffer(std::string* destino_memoria, std::size_t capacidad = 4 * 1024 * 1024);
+    ~SalidaBuffer();
+
+    std::string& datos() { return buffer; }
+    void volcarSiLleno() {
+        if (buffer.size() >= capacidad) volcar();
+    }
+    void volcar();
+
+private:
+    std::FILE* archivo = nullptr;
+    std::string* destino_memoria = nullptr;
+    bool archivo_propio = false;
+    std::string buffer;
+    std::size_t capacidad;
+};
+
+class EscritorSalida {
+public:
+    virtual ~EscritorSalida() = default;
+    virtual void escribirEncabezado(const std::vector<std::string>& columnas) = 0;
+    virtual void escribirFila(const std::vector<ValorCelda>& fila) = 0;
+    virtual void finalizar() = 0;
+};
+
+std::unique_ptr<EscritorSalida> crearEscritorSalida(const std::string& formato, const std::string& ruta);
+std::unique_ptr<EscritorSalida> crearEscritorEnMemoria(const std::string& formato, std::string& destino);
+std::string extensionFormatoSalida(const std::string& formato);
@@ -0,0 +1,290 @@
+#include "FormatoColumnar.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <limits>
+#include <zstd.h>
+
+namespace {
+
+constexpr char FIRMA[4] = { 'S', 'H', 'C', 'B' };
+constexpr std::uint8_t VERSION_FORMATO = 1;
+constexpr std::uint8_t CODEC_PLANO = 0;
+constexpr std::uint8_t CODEC_ZSTD = 1;
+constexpr int NIVEL_ZSTD = 1;
+constexpr std::size_t LIMITE_BYTES_GRUPO = 64u * 1024u * 1024u;
+
+template <typename Entero>
+void anexarEntero(std::string& salida, Entero valor) {
+    for (std::size_t i = 0; i < sizeof(Entero); ++i) {
+        salida += static_cast<char>((static_cast<std::uint64_t>(valor) >> (8 * i)) & 0xFF);
+    }
+}
+
+template <typename Entero>
+Entero leerEntero(const char* datos) {
+    std::uint64_t valor = 0;
+    for (std::size_t i = 0; i < sizeof(Entero); ++i) {
+        valor |= static_cast<std::uint64_t>(static_cast<unsigned char>(datos[i])) << (8 * i);
+    }
+    return static_cast<Entero>(valor);
+}
+
+template <typename Entero>
+Entero leerEntero(std::ifstream& archivo) {
+    char buffer[sizeof(Entero)];
+    if (!archivo.read(buffer, sizeof(buffer))) throw std::runtime_error("Archivo columnar truncado.");
+    return leerEntero<Entero>(buffer);
+}
+
+void anexarCadena(std::string& salida, std::string_view texto) {
+    if (texto.size() > std::numeric_limits<std::uint32_t>::max()) throw std::runtime_error("Valor demasiado grande para el archivo columnar (mas de 4 GB).");
+    anexarEntero<std::uint32_t>(salida, static_cast<std::uint32_t>(texto.size()));
+    salida.append(texto.data(), texto.size());
+}
+
+// Etiqueta de un timestamptz, que se lee como FechaHora en UTC.
+constexpr std::uint8_t ETIQUETA_FECHA_HORA_UTC = 9;
+
+void serializarValor(std::string& salida, const ValorCelda& valor) {
+    const FechaHora* fecha_hora = std::get_if<FechaHora>(&valor);
+    salida += static_cast<char>(fecha_hora && fecha_hora->utc ? ETIQUETA_FECHA_HORA_UTC : valor.index());
+    switch (valor.index()) {
+    case 0: break;
+    case 1: salida += static_cast<char>(std::get<bool>(valor) ? 1 : 0); break;
+    case 2: anexarEntero<std::int64_t>(salida, std::get<std::int64_t>(valor)); break;
+    case 3: {
+        std::uint64_t bits;
+        double real = std::get<double>(valor);
+        std::memcpy(&bits, &real, sizeof(bits));
+        anexarEntero<std::uint64_t>(salida, bits);
+        break;
+    }
+    case 4: anexarCadena(salida, std::get<std::string>(valor)); break;
+    case 5: {
+        const Bytes& bytes = std::get<Bytes>(valor);
+        anexarCadena(salida, std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size()));
+        break;
+    }
+    case 6: anexarEntero<std::int32_t>(salida, std::get<Fecha>(valor).dias_desde_epoch); break;
+    case 7: anexarEntero<std::int64_t>(salida, std::get<FechaHora>(valor).microsegundos_desde_epoch); break;
+    case 8: anexarCadena(salida, std::get<Numerico>(valor).digitos); break;
+    }
+}
+
+ValorCelda deserializarValor(const std::string& datos, std::size_t& pos) {
+    auto requerir = [&](std::size_t n) {
+        if (pos + n > datos.size()) throw std::runtime_error("Bloque columnar corrupto.");
+        };
+    auto leerCadena = [&]() {
+        requerir(4);
+        std::uint32_t longitud = leerEntero<std::uint32_t>(datos.data() + pos);
+        pos += 4;
+        requerir(longitud);
+        std::string texto = datos.substr(pos, longitud);
+        pos += longitud;
+        return texto;
+        };
+
+    requerir(1);
+    const std::uint8_t etiqueta = static_cast<std::uint8_t>(datos[pos++]);
+    switch (etiqueta) {
+    case 0: return {};
+    case 1: requerir(1); return datos[pos++] != 0;
+    case 2: { requerir(8); auto v = leerEntero<std::int64_t>(datos.data() + pos); pos += 8; return v; }
+    case 3: {
+        requerir(8);
+        std::uint64_t bits = leerEntero<std::uint64_t>(datos.data() + pos);
+        pos += 8;
+        double real;
+        std::memcpy(&real, &bits, sizeof(real));
+        return real;
+    }
+    case 4: return leerCadena();
+    case 5: { std::string texto = leerCadena(); return Bytes(texto.begin(), texto.end()); }
+    case 6: { requerir(4); auto v = leerEntero<std::int32_t>(datos.data() + pos); pos += 4; return Fecha{ v }; }
+    case 7: { requerir(8); auto v = leerEntero<std::int64_t>(datos.data() + pos); pos += 8; return FechaHora{ v }; }
+    case ETIQUETA_FECHA_HORA_UTC: { requerir(8); auto v = leerEntero<std::int64_t>(datos.data() + pos); pos += 8; return FechaHora{ v, true }; }
+    case 8: return Numerico{ leerCadena() };
+    default: throw std::runtime_error("Etiqueta de valor desconocida en archivo columnar.");
+    }
+}
+
+}
+
+EscritorColumnar::EscritorColumnar(const std::string& ruta, FormatoValores formato, const std::vector<std::string>& columnas, std::size_t filas_por_grupo)
+    : archivo(ruta, std::ios::binary | std::ios::trunc), buffers_columnas(columnas.size()), filas_por_grupo(filas_por_grupo) {
+    if (!archivo) throw std::runtime_error("No se pudo crear el archivo de respaldo: " + ruta);
+
+    std::string cabecera(FIRMA, sizeof(FIRMA));
+    cabecera += static_cast<char>(VERSION_FORMATO);
+    cabecera += static_cast<char>(formato);
+    anexarEntero<std::uint16_t>(cabecera, 0);
+    anexarEntero<std::uint32_t>(cabecera, static_cast<std::uint32_t>(columnas.size()));
+    for (const auto& columna : columnas) anexarCadena(cabecera, columna);
+    archivo.write(cabecera.data(), cabecera.size());
+    bytes_escritos += cabecera.size();
+}
+
+EscritorColumnar::~EscritorColumnar() {
+    try {
+        cerrar();
+    }
+    catch (...) {
+    }
+}
+
+void EscritorColumnar::agregarCampoCopia(std::size_t columna, const char* datos, std::int32_t longitud) {
+    std::string& buffer = buffers_columnas[columna];
+    anexarEntero<std::int32_t>(buffer, longitud);
+    if (longitud > 0) buffer.append(datos, longitud);
+}
+
+void EscritorColumnar::agregarValor(std::size_t columna, const ValorCelda& valor) {
+    serializarValor(buffers_columnas[columna], valor);
+}
+
+void EscritorColumnar::finalizarFila() {
+    ++filas_en_grupo;
+    ++filas_escritas;
+    if (filas_en_grupo >= filas_por_grupo) {
+        escribirGrupo();
+        return;
+    }
+    // Se comprueba en cada fila: unas pocas filas con valores grandes bastan para
+    // llevar un buffer mas alla de lo que cabe en su longitud de 32 bits.
+    std::size_t total = 0;
+    for (const auto& buffer : buffers_columnas) total += buffer.size();
+    if (total >= LIMITE_BYTES_GRUPO) escribirGrupo();
+}
+
+void EscritorColumnar::escribirGrupo() {
+    if (filas_en_grupo == 0) return;
+
+    std::string cabecera_grupo;
+    anexarEntero<std::uint32_t>(cabecera_grupo, filas_en_grupo);
+    archivo.write(cabecera_grupo.data(), cabecera_grupo.size());
+    bytes_escritos += cabecera_grupo.size();
+
+    for (const auto& buffer : buffers_columnas) {
+        if (buffer.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::runtime_error("Un grupo de filas supera los 4 GB en una columna; el archivo columnar no puede representarlo.");
+        }
+    }
+    for (auto& buffer : buffers_columnas) {
+        buffer_comprimido.resize(ZSTD_compressBound(buffer.size()));
+        std::size_t tamano = ZSTD_compress(buffer_comprimido.data(), buffer_comprimido.size(), buffer.data(), buffer.size(), NIVEL_ZSTD);
+        const bool comprimir = !ZSTD_isError(tamano) && tamano < buffer.size();
+
+        std::string cabecera_columna;
+        cabecera_columna += static_cast<char>(comprimir ? CODEC_ZSTD : CODEC_PLANO);
+        anexarEntero<std::uint32_t>(cabecera_columna, static_cast<std::uint32_t>(buffer.size()));
+        anexarEntero<std::uint32_t>(cabecera_columna, static_cast<std::uint32_t>(comprimir ? tamano : buffer.size()));
+        archivo.write(cabecera_columna.data(), cabecera_columna.size());
+        if (comprimir) archivo.write(buffer_comprimido.data(), tamano);
+        else archivo.write(buffer.data(), buffer.size());
+        bytes_escritos += cabecera_columna.size() + (comprimir ? tamano : buffer.size());
+        buffer.clear();
+    }
+    filas_en_grupo = 0;
+    if (!archivo) throw std::runtime_error("Error de escritura en el archivo de respaldo.");
+}
+
+void EscritorColumnar::cerrar() {
+    if (cerrado) return;
+    escribirGrupo();
+    std::string fin;
+    anexarEntero<std::uint32_t>(fin, 0);
+    archivo.write(fin.data(), fin.size());
+    bytes_escritos += fin.size();
+    archivo.close();
+    cerrado = true;
+}
+
+LectorColumnar::LectorColumnar(const std::string& ruta) : archivo(ruta, std::ios::binary) {
+    if (!archivo) throw std::runtime_error("No se pudo abrir el archivo de respaldo: " + ruta);
+
+    char firma[4];
+    if (!archivo.read(firma, sizeof(firma)) || std::memcmp(firma, FIRMA, sizeof(FIRMA)) != 0) {
+        throw std::runtime_error("El archivo no es un respaldo columnar valido: " + ruta);
+    }
+    const std::uint8_t version = leerEntero<std::uint8_t>(archivo);
+    if (version != VERSION_FORMATO) throw std::runtime_error("Version de respaldo columnar no soportada.");
+    formato_valores = static_cast<FormatoValores>(leerEntero<std::uint8_t>(archivo));
+    leerEntero<std::uint16_t>(archivo);
+
+    const std::uint32_t num_columnas = leerEntero<std::uint32_t>(archivo);
+    nombres_columnas.reserve(num_columnas);
+    for (std::uint32_t i = 0; i < num_columnas; ++i) {
+        const std::uint32_t longitud = leerEntero<std::uint32_t>(archivo);
+        std::string nombre(longitud, '\0');
+        if (!archivo.read(nombre.data(), longitud)) throw std::runtime_error("Archivo columnar truncado.");
+        nombres_columnas.push_back(std::move(nombre));
+    }
+    datos_columnas.resize(num_columnas);
+    campos_columnas.resize(num_columnas);
+    valores_columnas.resize(num_columnas);
+}
+
+bool LectorColumnar::leerGrupo() {
+    filas_en_grupo = leerEntero<std::uint32_t>(archivo);
+    if (filas_en_grupo == 0) return false;
+
+    for (std::size_t c = 0; c < nombres_columnas.size(); ++c) {
+        const std::uint8_t codec = leerEntero<std::uint8_t>(archivo);
+        const std::uint32_t tamano_original = leerEntero<std::uint32_t>(archivo);
+        const std::uint32_t tamano_guardado = leerEntero<std::uint32_t>(archivo);
+
+        std::string& datos = datos_columnas[c];
+        if (codec != CODEC_ZSTD && (codec != CODEC_PLANO || tamano_guardado != tamano_original)) {
+            throw std::runtime_error("Bloque columnar corrupto.");
+        }
+        datos.resize(tamano_original);
+        if (codec == CODEC_ZSTD) {
+            buffer_comprimido.resize(tamano_guardado);
+            if (!archivo.read(buffer_comprimido.data(), tamano_guardado)) throw std::runtime_error("Archivo columnar truncado.");
+            std::size_t tamano = ZSTD_decompress(datos.data(), datos.size(), buffer_comprimido.data(), buffer_comprimido.size());
+            if (ZSTD_isError(tamano) || tamano != tamano_original) throw std::runtime_error("Bloque columnar corrupto.");
+        }
+        else if (!archivo.read(datos.data(), tamano_guardado)) {
+            throw std::runtime_error("Archivo columnar truncado.");
+        }
+
+        std::size_t pos = 0;
+        if (formato_valores == FormatoValores::CopiaBinariaPostgreSQL) {
+            auto& campos = campos_columnas[c];
+            campos.clear();
+            campos.reserve(filas_en_grupo);
+            for (std::uint32_t f = 0; f < filas_en_grupo; ++f) {
+                if (pos + 4 > datos.size()) throw std::runtime_error("Bloque columnar corrupto.");
+                const std::int32_t longitud = leerEntero<std::int32_t>(datos.data() + pos);
+                pos += 4;
+                if (longitud < -1 || (longitud > 0 && static_cast<std::size_t>(longitud) > datos.size() - pos)) {
+                    throw std::runtime_error("Bloque columnar corrupto.");
+                }
+                campos.push_back({ static_cast<std::uint32_t>(pos), longitud });
+                if (longitud > 0) pos += longitud;
+            }
+        }
+        else {
+            auto& valores = valores_columnas[c];
+            valores.clear();
+            valores.reserve(filas_en_grupo);
+            for (std::uint32_t f = 0; f < filas_en_grupo; ++f) {
+                valores.push_back(deserializarValor(datos, pos));
+            }
+        }
+        if (pos != datos.size()) throw std::runtime_error("Bloque columnar corrupto.");
+    }
+    return true;
+}
+
+std::string_view LectorColumnar::campoCopia(std::size_t columna, std::size_t fila, bool& es_nulo) const {
+    const Campo& campo = campos_columnas[columna][fila];
+    es_nulo = campo.longitud < 0;
+    if (es_nulo) return {};
+    return std::string_view(datos_columnas[columna].data() + campo.desplazamiento, campo.longitud);
+}
+
+const ValorCelda& LectorColumnar::valor(std::size_t columna, std::size_t fila) const {
+    return valores_columnas[columna][fila];
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "ValorCelda.hpp"
+
+enum class FormatoValores : std::uint8_t {
+    CopiaBinariaPostgreSQL = 0,
+    ValorEtiquetado = 1
+};
+
+class EscritorColumnar {
+public:
+    EscritorColumnar(const std::string& ruta, FormatoValores formato, const std::vector<std::string>& columnas, std::size_t filas_por_grupo = 65536);
+    ~EscritorColumnar();
+
+    void agregarCampoCopia(std::size_t columna, const char* datos, std::int32_t longitud);
+    void agregarValor(std::size_t columna, const ValorCelda& valor);
+    void finalizarFila();
+    void cerrar();
+
+    std::uint64_t filasEscritas() const { return filas_escritas; }
+    std::uint64_t bytesEscritos() const { return bytes_escritos; }
+
+private:
+    std::ofstream archivo;
+    std::vector<std::string> buffers_columnas;
+    std::string buffer_comprimido;
+    std::size_t filas_por_grupo;
+    std::uint32_t filas_en_grupo = 0;
+    std::uint64_t filas_escritas = 0;
+    std::uint64_t bytes_escritos = 0;
+    bool cerrado = false;
+
+    void escribirGrupo();
+};
+
+class LectorColumnar {
+public:
+    explicit LectorColumnar(const std::string& ruta);
+
+    const std::vector<std::string>& columnas() const { return nombres_columnas; }
+    FormatoValores formato() const { return formato_valores; }
+    bool leerGrupo();
+    std::uint32_t filasEnGrupo() const { return filas_en_grupo; }
+
+    std::string_view campoCopia(std::size_t columna, std::size_t fila, bool& es_nulo) const;
+    const ValorCelda& valor(std::size_t columna, std::size_t fila) const;
+
+private:
+    struct Campo {
+        std::uint32_t desplazamiento;
+        std::int32_t longitud;
+    };
+
+    std::ifstream archivo;
+    std::vector<std::string> nombres_columnas;
+    FormatoValores formato_valores = FormatoValores::ValorEtiquetado;
+    std::uint32_t filas_en_grupo = 0;
+    std::vector<std::string> datos_columnas;
+    std::vector<std::vector<Campo>> campos_columnas;
+    std::vector<std::vector<ValorCelda>> valores_columnas;
+    std::string buffer_comprimido;
+};
@@ -1,11 +1,12 @@
 #include "GeneradorCodigo.hpp"
 #include "Utils.hpp"
-#include <inja/inja.hpp>
+#include "Perfilador.hpp"
+#include "GestorPlantillas.hpp"
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
-#include <set>
 #include <map>
 
 using json = nlohmann::json;
@@ -15,6 +16,8 @@ GeneradorCodigo::GeneradorCodigo(const std::string& dir_salida) : dir_salida(dir
 }
 
 void GeneradorCodigo::escribirArchivo(const std::string& ruta, const std::string& contenido) {
+    MedicionFase medicion("generacion.escribirArchivo");
+    Perfilador::sumar(ContadorPerfil::Bytes, contenido.size());
     fs::path ruta_archivo(ruta);
     if (!ruta_archivo.parent_path().empty()) {
         fs::create_directories(ruta_archivo.parent_path());
@@ -24,9 +27,9 @@ void GeneradorCodigo::escribirArchivo(const std::string& ruta, const std::string
 }
 
 std::string GeneradorCodigo::renderizarPlantilla(const std::string& ruta_plantilla, const json& datos) {
-    inja::Environment env;
+    MedicionFase medicion("generacion.renderizarPlantilla");
     try {
-        return env.render_file(ruta_plantilla, datos);
+        return GestorPlantillas::instancia().renderizar(ruta_plantilla, datos);
     }
     catch (const std::exception& e) {
         std::cerr << "Error Critico al renderizar la plantilla " << ruta_plantilla << ": " << e.what() << std::endl;
@@ -152,111 +155,135 @@ bootstrap();
     escribirArchivo(dir_salida + "/.gitignore", "node_modules\n.env\ndist\n");
 }
 
-void GeneradorCodigo::generarModuloAutenticacion(const Tabla& tabla_usuario) {
-    std::cout << "Generando modulo de autenticacion para la tabla: " << tabla_usuario.nombre << std::endl;
+void GeneradorCodigo::generarModuloAutenticacion(const Tabla& tabla_usuario, const InternadorNombres& nombres) {
+    std::cout << "Generando modulo de autenticacion para la tabla: " << nombres.original(tabla_usuario.nombre) << std::endl;
     fs::create_directories(dir_salida + "/src/autenticacion/dto");
     fs::create_directories(dir_salida + "/src/autenticacion/estrategias");
     fs::create_directories(dir_salida + "/src/autenticacion/guardianes");
+    const std::string nombre_clase(nombres.pascal(tabla_usuario.nombre));
+    const std::string_view nombre_archivo = nombres.kebab(tabla_usuario.nombre);
+    const std::string_view campo_email = nombres.original(tabla_usuario.campo_email_encontrado);
+    const std::string_view campo_contrasena = nombres.original(tabla_usuario.campo_contrasena_encontrado);
     json datos;
-    datos["moduloUsuario"]["nombreClaseModulo"] = tabla_usuario.nombre_clase + "Module";
-    datos["moduloUsuario"]["nombreClaseServicio"] = tabla_usuario.nombre_clase + "Service";
-    datos["moduloUsuario"]["nombreClaseEntidad"] = tabla_usuario.nombre_clase;
-    datos["moduloUsuario"]["nombreCarpeta"] = tabla_usuario.nombre_archivo;
-    datos["moduloUsuario"]["nombreArchivo"] = tabla_usuario.nombre_archivo;
-    datos["moduloUsuario"]["campo_email"] = tabla_usuario.campo_email_encontrado;
-    datos["moduloUsuario"]["campo_contrasena"] = tabla_usuario.campo_contrasena_encontrado;
-    datos["moduloUsuario"]["clave_primaria"]["nombre"] = tabla_usuario.clave_primaria.nombre;
+    datos["moduloUsuario"]["nombreClaseModulo"] = nombre_clase + "Module";
+    datos["moduloUsuario"]["nombreClaseServicio"] = nombre_clase + "Service";
+    datos["moduloUsuario"]["nombreClaseEntidad"] = nombre_clase;
+    datos["moduloUsuario"]["nombreCarpeta"] = nombre_archivo;
+    datos["moduloUsuario"]["nombreArchivo"] = nombre_archivo;
+    datos["moduloUsuario"]["campo_email"] = campo_email;
+    datos["moduloUsuario"]["campo_contrasena"] = campo_contrasena;
+    datos["moduloUsuario"]["clave_primaria"]["nombre"] = nombres.original(tabla_usuario.clave_primaria.nombre);
     escribirArchivo(dir_salida + "/src/autenticacion/auth.module.ts", renderizarPlantilla("AuthModule.tpl", datos));
     escribirArchivo(dir_salida + "/src/autenticacion/auth.controller.ts", renderizarPlantilla("AuthController.tpl", datos));
     escribirArchivo(dir_salida + "/src/autenticacion/auth.service.ts", renderizarPlantilla("AuthService.tpl", datos));
     escribirArchivo(dir_salida + "/src/autenticacion/estrategias/jwt.strategy.ts", renderizarPlantilla("JwtStrategy.tpl", {}));
-    escribirArchivo(dir_salida + "/src/autenticacion/dto/login.dto.ts", "export class LoginDto {\n  " + tabla_usuario.campo_email_encontrado + ": string;\n  " + tabla_usuario.campo_contrasena_encontrado + ": string;\n}");
+    escribirArchivo(dir_salida + "/src/autenticacion/dto/login.dto.ts", "export class LoginDto {\n  " + std::string(campo_email) + ": string;\n  " + std::string(campo_contrasena) + ": string;\n}");
     escribirArchivo(dir_salida + "/src/autenticacion/guardianes/jwt-auth.guard.ts", "import { Injectable } from '@nestjs/common';\nimport { AuthGuard } from '@nestjs/passport';\n\n@Injectable()\nexport class JwtAuthGuard extends AuthGuard('jwt') {}");
 }
 
-void GeneradorCodigo::generarModuloCrud(const Tabla& tabla, const std::vector<Tabla>& todas_las_tablas) {
-    std::cout << "Generando CRUD para la tabla: " << tabla.nombre << std::endl;
-    std::string ruta_modulo = dir_salida + "/src/" + tabla.nombre_archivo;
+void GeneradorCodigo::generarModuloCrud(const Tabla& tabla, const Esquema& esquema) {
+    MedicionFase medicion("generacion.generarModuloCrud");
+    const InternadorNombres& nombres = esquema.nombres;
+    const std::string_view nombre_archivo = nombres.kebab(tabla.nombre);
+    std::cout << "Generando CRUD para la tabla: " << nombres.original(tabla.nombre) << std::endl;
+    std::string ruta_modulo = dir_salida + "/src/";
+    ruta_modulo += nombre_archivo;
     fs::create_directories(ruta_modulo + "/entidades");
     fs::create_directories(ruta_modulo + "/dto");
 
     json datos_plantilla;
     json& datos_tabla = datos_plantilla["tabla"];
-    datos_tabla["nombre"] = tabla.nombre;
-    datos_tabla["nombre_clase"] = tabla.nombre_clase;
-    datos_tabla["nombre_variable"] = tabla.nombre_variable;
-    datos_tabla["nombre_archivo"] = tabla.nombre_archivo;
+    datos_tabla["nombre"] = nombres.original(tabla.nombre);
+    datos_tabla["nombre_clase"] = nombres.pascal(tabla.nombre);
+    datos_tabla["nombre_variable"] = nombres.camel(tabla.nombre);
+    datos_tabla["nombre_archivo"] = nombre_archivo;
     datos_tabla["es_tabla_usuario"] = tabla.es_tabla_usuario;
     datos_tabla["es_protegida"] = tabla.es_protegida;
-    datos_tabla["clave_primaria"]["nombre"] = tabla.clave_primaria.nombre;
-    datos_tabla["campo_email"] = tabla.campo_email_encontrado;
-    datos_tabla["campo_contrasena"] = tabla.campo_contrasena_encontrado;
+    datos_tabla["clave_primaria"]["nombre"] = nombres.original(tabla.clave_primaria.nombre);
+    datos_tabla["campo_email"] = nombres.original(tabla.campo_email_encontrado);
+    datos_tabla["campo_contrasena"] = nombres.original(tabla.campo_contrasena_encontrado);
 
+    json& columnas = datos_tabla["columnas"];
     for (const auto& col : tabla.columnas) {
         json col_data;
-        col_data["nombre"] = col.nombre;
+        col_data["nombre"] = nombres.original(col.nombre);
         col_data["tipo_ts"] = col.tipo_ts;
         col_data["es_nulo"] = col.es_nulo;
         col_data["es_pk"] = col.es_pk;
         col_data["es_fk"] = col.es_fk;
         col_data["tipo_db"] = col.tipo_db;
         col_data["decorador_tipo"] = (col.tipo_ts == "string") ? "@IsString()" : (col.tipo_ts == "number") ? "@IsNumber()" : (col.tipo_ts == "boolean") ? "@IsBoolean()" : (col.tipo_ts == "Date") ? "@IsDate()" : "";
-        datos_tabla["columnas"].push_back(col_data);
+        columnas.push_back(std::move(col_data));
     }
 
     json dependencias_imports = json::array();
     json dependencias_relaciones = json::array();
-    std::set<std::string> clases_importadas;
-    std::set<std::string> columnas_fk_procesadas;
+    std::vector<IdNombre> columnas_fk_procesadas;
+    std::vector<IdNombre> clases_importadas;
 
     for (const auto& fk : tabla.dependencias_fk) {
-        if (columnas_fk_procesadas.find(fk.columna_local) != columnas_fk_procesadas.end()) {
+        if (std::find(columnas_fk_procesadas.begin(), columnas_fk_procesadas.end(), fk.columna_local) != columnas_fk_procesadas.end()) {
             continue;
         }
-        columnas_fk_procesadas.insert(fk.columna_local);
+        columnas_fk_procesadas.push_back(fk.columna_local);
 
-        for (const auto& tabla_ref : todas_las_tablas) {
-            if (tabla_ref.nombre == fk.tabla_referenciada) {
-                json fk_data;
-                fk_data["columna_local"] = fk.columna_local;
-                fk_data["clase_tabla_referenciada"] = tabla_ref.nombre_clase;
-                fk_data["variable_tabla_referenciada"] = aCamelCase(fk.columna_local);
-                fk_data["archivo_tabla_referenciada"] = tabla_ref.nombre_archivo;
+        const Tabla* tabla_ref = esquema.buscarTabla(fk.tabla_referenciada);
+        if (!tabla_ref) continue;
 
-                dependencias_relaciones.push_back(fk_data);
+        json fk_data;
+        fk_data["columna_local"] = nombres.original(fk.columna_local);
+        fk_data["clase_tabla_referenciada"] = nombres.pascal(tabla_ref->nombre);
+        fk_data["variable_tabla_referenciada"] = nombres.camel(fk.columna_local);
+        fk_data["archivo_tabla_referenciada"] = nombres.kebab(tabla_ref->nombre);
 
-                if (clases_importadas.find(tabla_ref.nombre_clase) == clases_importadas.end()) {
-                    dependencias_imports.push_back(fk_data);
-                    clases_importadas.insert(tabla_ref.nombre_clase);
-                }
-                break;
-            }
+        if (std::find(clases_importadas.begin(), clases_importadas.end(), tabla_ref->nombre) == clases_importadas.end()) {
+            dependencias_imports.push_back(fk_data);
+            clases_importadas.push_back(tabla_ref->nombre);
         }
+        dependencias_relaciones.push_back(std::move(fk_data));
     }
 
-    datos_tabla["dependencias_imports"] = dependencias_imports;
-    datos_tabla["dependencias_relaciones"] = dependencias_relaciones;
+    datos_tabla["dependencias_imports"] = std::move(dependencias_imports);
+    datos_tabla["dependencias_relaciones"] = std::move(dependencias_relaciones);
 
-    escribirArchivo(ruta_modulo + "/entidades/" + tabla.nombre_archivo + ".entity.ts", renderizarPlantilla("Entity.tpl", datos_plantilla));
-    escribirArchivo(ruta_modulo + "/dto/crear-" + tabla.nombre_archivo + ".dto.ts", renderizarPlantilla("CreateDto.tpl", datos_plantilla));
-    escribirArchivo(ruta_modulo + "/dto/actualizar-" + tabla.nombre_archivo + ".dto.ts", renderizarPlantilla("UpdateDto.tpl", datos_plantilla));
-    escribirArchivo(ruta_modulo + "/" + tabla.nombre_archivo + ".service.ts", renderizarPlantilla("Service.tpl", datos_plantilla));
-    escribirArchivo(ruta_modulo + "/" + tabla.nombre_archivo + ".controller.ts", renderizarPlantilla("Controller.tpl", datos_plantilla));
-    escribirArchivo(ruta_modulo + "/" + tabla.nombre_archivo + ".module.ts", renderizarPlantilla("Module.tpl", datos_plantilla));
+    const std::string archivo(nombre_archivo);
+    escribirArchivo(ruta_modulo + "/entidades/" + archivo + ".entity.ts", renderizarPlantilla("Entity.tpl", datos_plantilla));
+    escribirArchivo(ruta_modulo + "/dto/crear-" + archivo + ".dto.ts", renderizarPlantilla("CreateDto.tpl", datos_plantilla));
+    escribirArchivo(ruta_modulo + "/dto/actualizar-" + archivo + ".dto.ts", renderizarPlantilla("UpdateDto.tpl", datos_plantilla));
+    escribirArchivo(ruta_modulo + "/" + archivo + ".service.ts", renderizarPlantilla("Service.tpl", datos_plantilla));
+    escribirArchivo(ruta_modulo + "/" + archivo + ".controller.ts", renderizarPlantilla("Controller.tpl", datos_plantilla));
+    escribirArchivo(ruta_modulo + "/" + archivo + ".module.ts", renderizarPlantilla("Module.tpl", datos_plantilla));
 }
 
-void GeneradorCodigo::generarProyectoCompleto(const std::vector<Tabla>& tablas, const std::string& motor_db, const std::string& host, const std::string& puerto, const std::string& usuario, const std::string& contrasena, const std::string& base_datos, const std::string& jwt_secret) {
+void GeneradorCodigo::generarProyectoCompleto(const Esquema& esquema, const std::string& motor_db, const std::string& host, const std::string& puerto, const std::string& usuario, const std::string& contrasena, const std::string& base_datos, const std::string& jwt_secret) {
+    MedicionFase medicion("generacion.generarProyectoCompleto");
+    const InternadorNombres& nombres = esquema.nombres;
     const Tabla* ptr_tabla_usuario = nullptr;
     json datos_modulos;
+    json& modulos = datos_modulos["modulos"];
     std::cout << "=== INICIANDO GENERACION DE PROYECTO ===" << std::endl;
-    std::cout << "Tablas encontradas: " << tablas.size() << std::endl;
-    for (const auto& tabla : tablas) {
-        std::cout << "Procesando tabla: " << tabla.nombre << " (Usuario: " << (tabla.es_tabla_usuario ? "SI" : "NO") << ", Protegida: " << (tabla.es_protegida ? "SI" : "NO") << ")" << std::endl;
+    std::cout << "Tablas encontradas: " << esquema.tablas.size() << std::endl;
+
+    OrdenDependencias orden = esquema.grafo.ordenarPorDependencias();
+    if (!orden.bloqueadas.empty()) {
+        for (const auto& componente : esquema.grafo.componentesCiclicas()) {
+            std::cout << "ADVERTENCIA: Dependencias circulares entre las tablas:";
+            for (std::uint32_t indice : componente) std::cout << " " << nombres.original(esquema.tablas[indice].nombre);
+            std::cout << std::endl;
+        }
+        orden.orden.insert(orden.orden.end(), orden.bloqueadas.begin(), orden.bloqueadas.end());
+    }
+
+    for (std::uint32_t indice : orden.orden) {
+        const Tabla& tabla = esquema.tablas[indice];
+        std::cout << "Procesando tabla: " << nombres.original(tabla.nombre) << " (Usuario: " << (tabla.es_tabla_usuario ? "SI" : "NO") << ", Protegida: " << (tabla.es_protegida ? "SI" : "NO") << ")" << std::endl;
+        std::string nombre_clase_modulo(nombres.pascal(tabla.nombre));
+        nombre_clase_modulo += "Module";
         json mod;
-        mod["nombreClaseModulo"] = tabla.nombre_clase + "Module";
-        mod["nombreCarpeta"] = tabla.nombre_archivo;
-        mod["nombreArchivo"] = tabla.nombre_archivo;
-        datos_modulos["modulos"].push_back(mod);
+        mod["nombreClaseModulo"] = std::move(nombre_clase_modulo);
+        mod["nombreCarpeta"] = nombres.kebab(tabla.nombre);
+        mod["nombreArchivo"] = nombres.kebab(tabla.nombre);
+        modulos.push_back(std::move(mod));
         if (tabla.es_tabla_usuario) ptr_tabla_usuario = &tabla;
     }
     if (ptr_tabla_usuario) {
@@ -265,17 +292,17 @@ void GeneradorCodigo::generarProyectoCompleto(const std::vector<Tabla>& tablas,
         mod_auth["nombreClaseModulo"] = "AuthModule";
         mod_auth["nombreCarpeta"] = "autenticacion";
         mod_auth["nombreArchivo"] = "auth";
-        datos_modulos["modulos"].push_back(mod_auth);
+        modulos.push_back(std::move(mod_auth));
     }
     else {
         std::cout << "ADVERTENCIA: No se generara autenticacion - no hay tabla de usuario valida" << std::endl;
     }
     generarArchivosBase(datos_modulos, motor_db);
     if (ptr_tabla_usuario) {
-        generarModuloAutenticacion(*ptr_tabla_usuario);
+        generarModuloAutenticacion(*ptr_tabla_usuario, nombres);
     }
-    for (const auto& tabla : tablas) {
-        generarModuloCrud(tabla, tablas);
+    for (std::uint32_t indice : orden.orden) {
+        generarModuloCrud(esquema.tablas[indice], esquema);
     }
     generarArchivoEnv(motor_db, host, puerto, usuario, contrasena, base_datos, jwt_secret);
 }
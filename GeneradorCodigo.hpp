@@ -7,13 +7,13 @@
 class GeneradorCodigo {
 public:
     GeneradorCodigo(const std::string& dir_salida);
-    void generarProyectoCompleto(const std::vector<Tabla>& tablas, const std::string& motor_db, const std::string& host, const std::string& puerto, const std::string& usuario, const std::string& contrasena, const std::string& base_datos, const std::string& jwt_secret);
+    void generarProyectoCompleto(const Esquema& esquema, const std::string& motor_db, const std::string& host, const std::string& puerto, const std::string& usuario, const std::string& contrasena, const std::string& base_datos, const std::string& jwt_secret);
 
 private:
     std::string dir_salida;
     void generarArchivosBase(const nlohmann::json& datos_modulos, const std::string& motor_db);
-    void generarModuloAutenticacion(const Tabla& tabla_usuario);
-    void generarModuloCrud(const Tabla& tabla, const std::vector<Tabla>& todas_las_tablas);
+    void generarModuloAutenticacion(const Tabla& tabla_usuario, const InternadorNombres& nombres);
+    void generarModuloCrud(const Tabla& tabla, const Esquema& esquema);
     void generarArchivoEnv(const std::string& motor_db, const std::string& host, const std::string& puerto, const std::string& usuario, const std::string& contrasena, const std::string& base_datos, const std::string& jwt_secret);
     void generarPackageJson(const std::string& motor_db);
     void escribirArchivo(const std::string& ruta, const std::string& contenido);
@@ -2,9 +2,184 @@
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 #include <boost/algorithm/string.hpp>
 #include <vector>
 #include "GestorCifrado.hpp"
+#include "DialectoSql.hpp"
+#include "Perfilador.hpp"
+#include "GestorPlantillas.hpp"
+#include "EjecutorAsincrono.hpp"
+
+namespace {
+
+constexpr int SQL_TIPO_WLONGVARCHAR = -10;
+constexpr int SQL_TIPO_BIT = -7;
+constexpr int SQL_TIPO_TINYINT = -6;
+constexpr int SQL_TIPO_BIGINT = -5;
+constexpr int SQL_TIPO_LONGVARBINARY = -4;
+constexpr int SQL_TIPO_VARBINARY = -3;
+constexpr int SQL_TIPO_BINARY = -2;
+constexpr int SQL_TIPO_LONGVARCHAR = -1;
+constexpr int SQL_TIPO_NUMERIC = 2;
+constexpr int SQL_TIPO_DECIMAL = 3;
+constexpr int SQL_TIPO_INTEGER = 4;
+constexpr int SQL_TIPO_SMALLINT = 5;
+constexpr int SQL_TIPO_FLOAT = 6;
+constexpr int SQL_TIPO_REAL = 7;
+constexpr int SQL_TIPO_DOUBLE = 8;
+constexpr int SQL_TIPO_DATE = 91;
+constexpr int SQL_TIPO_TIMESTAMP = 93;
+
+void registrarSentencia(std::size_t bytes_enviados) {
+    if (!Perfilador::activo()) return;
+    Perfilador::sumar(ContadorPerfil::Sentencias);
+    Perfilador::sumar(ContadorPerfil::IdasYVueltas);
+    Perfilador::sumar(ContadorPerfil::Bytes, bytes_enviados);
+}
+
+std::int64_t diasDesdeCivil(std::int64_t anio, unsigned mes, unsigned dia) {
+    anio -= mes <= 2;
+    const std::int64_t era = (anio >= 0 ? anio : anio - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(anio - era * 400);
+    const unsigned doy = (153 * (mes > 2 ? mes - 3 : mes + 9) + 2) / 5 + dia - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+ResultadoConsulta leerResultadoPostgreSQL(PGresult* res) {
+    ResultadoConsulta resultado;
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) return resultado;
+    const int num_columnas = PQnfields(res);
+    const int num_filas = PQntuples(res);
+    resultado.columnas.reserve(num_columnas);
+    for (int j = 0; j < num_columnas; ++j) {
+        resultado.columnas.push_back(PQfname(res, j));
+    }
+    resultado.filas.reserve(num_filas);
+    for (int i = 0; i < num_filas; ++i) {
+        std::vector<std::string> fila;
+        fila.reserve(num_columnas);
+        for (int j = 0; j < num_columnas; ++j) {
+            if (PQgetisnull(res, i, j)) fila.emplace_back("NULL");
+            else fila.emplace_back(PQgetvalue(res, i, j), PQgetlength(res, i, j));
+        }
+        resultado.filas.push_back(std::move(fila));
+    }
+    return resultado;
+}
+
+std::string consultaColumnasAuditoriaPostgreSQL(const std::string& nombre_tabla) {
+    return "SELECT a.attname, format_type(a.atttypid, a.atttypmod) FROM pg_catalog.pg_attribute a "
+        "JOIN pg_catalog.pg_class c ON c.oid = a.attrelid JOIN pg_catalog.pg_namespace n ON n.oid = c.relnamespace "
+        "WHERE c.relname = '" + nombre_tabla + "' AND n.nspname = 'public' AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attnum;";
+}
+
+std::string renderizarAuditoriaPostgreSQL(const std::string& nombre_tabla, const ResultadoConsulta& columnas_info_res) {
+    std::ostringstream definicion_columnas;
+    for (size_t i = 0; i < columnas_info_res.filas.size(); ++i) {
+        definicion_columnas << "\"" << columnas_info_res.filas[i][0] << "\" " << columnas_info_res.filas[i][1];
+        if (i < columnas_info_res.filas.size() - 1) {
+            definicion_columnas << ", ";
+        }
+    }
+    nlohmann::json datos;
+    datos["tabla"] = nombre_tabla;
+    datos["definicion_columnas"] = definicion_columnas.str();
+    return GestorPlantillas::instancia().renderizar("PostgresAudit.tpl", datos);
+}
+
+// columnas_res trae nombre y tipo de cada columna (consultaColumnas) y clave_res
+// las columnas de la clave primaria en orden. Cada fila de auditoria guarda la
+// clave como objeto JSON y, en Cambios, la fila completa al insertar o eliminar
+// y solo los valores anteriores de las columnas modificadas al actualizar.
+template <typename Dialecto>
+std::string renderizarAuditoriaDelta(const std::string& nombre_tabla, const ResultadoConsulta& columnas_res, const ResultadoConsulta& clave_res) {
+    std::vector<CampoJsonAuditoria> clave_nueva, clave_vieja, fila_nueva, fila_vieja, cambios;
+    std::unordered_map<std::string, std::string> tipos;
+    for (const auto& fila : columnas_res.filas) tipos.emplace(fila[0], fila[1]);
+    std::string union_clave, clave_cambiada;
+    for (const auto& fila : clave_res.filas) {
+        const std::string columna_citada = Dialecto::citar(fila[0]);
+        const std::string nuevo = std::string(Dialecto::registro_nuevo) + columna_citada;
+        const std::string viejo = std::string(Dialecto::registro_viejo) + columna_citada;
+        clave_nueva.push_back({ fila[0], Dialecto::expresionTexto(nuevo, tipos[fila[0]]), "" });
+        clave_vieja.push_back({ fila[0], Dialecto::expresionTexto(viejo, tipos[fila[0]]), "" });
+        if (!union_clave.empty()) {
+            union_clave += " AND ";
+            clave_cambiada += " OR ";
+        }
+        union_clave += viejo + " = " + nuevo;
+        clave_cambiada += Dialecto::expresionDistinta(viejo, nuevo);
+    }
+    for (const auto& fila : columnas_res.filas) {
+        if (!Dialecto::columnaAuditable(fila[1])) continue;
+        const std::string columna_citada = Dialecto::citar(fila[0]);
+        const std::string nuevo = std::string(Dialecto::registro_nuevo) + columna_citada;
+        const std::string viejo = std::string(Dialecto::registro_viejo) + columna_citada;
+        fila_nueva.push_back({ fila[0], Dialecto::expresionTexto(nuevo, fila[1]), "" });
+        fila_vieja.push_back({ fila[0], Dialecto::expresionTexto(viejo, fila[1]), "" });
+        cambios.push_back({ fila[0], Dialecto::expresionTexto(viejo, fila[1]), Dialecto::expresionDistinta(viejo, nuevo) });
+    }
+
+    nlohmann::json datos;
+    datos["tabla"] = nombre_tabla;
+    datos["clave_nueva"] = Dialecto::objetoJsonAuditoria(clave_nueva);
+    datos["clave_vieja"] = Dialecto::objetoJsonAuditoria(clave_vieja);
+    datos["fila_nueva"] = Dialecto::objetoJsonAuditoria(fila_nueva);
+    datos["fila_vieja"] = Dialecto::objetoJsonAuditoria(fila_vieja);
+    datos["cambios"] = Dialecto::objetoJsonAuditoria(cambios);
+    datos["union_clave"] = union_clave;
+    datos["clave_cambiada"] = clave_cambiada;
+    return GestorPlantillas::instancia().renderizar(std::string(Dialecto::plantilla_auditoria_delta), datos);
+}
+
+ValorCelda decodificarCeldaPostgreSQL(PGresult* res, int fila, int columna, Oid tipo) {
+    if (PQgetisnull(res, fila, columna)) return {};
+    if (PQfformat(res, columna) == 1) {
+        return decodificarBinarioPostgreSQL(tipo, PQgetvalue(res, fila, columna), PQgetlength(res, fila, columna));
+    }
+    return std::string(PQgetvalue(res, fila, columna), PQgetlength(res, fila, columna));
+}
+
+ValorCelda leerValorOdbc(nanodbc::result& res, short columna, int tipo) {
+    if (res.is_null(columna)) return {};
+    switch (tipo) {
+    case SQL_TIPO_BIT:
+        return res.get<int>(columna) != 0;
+    case SQL_TIPO_TINYINT:
+    case SQL_TIPO_SMALLINT:
+    case SQL_TIPO_INTEGER:
+    case SQL_TIPO_BIGINT:
+        return static_cast<std::int64_t>(res.get<long long>(columna));
+    case SQL_TIPO_FLOAT:
+    case SQL_TIPO_REAL:
+    case SQL_TIPO_DOUBLE:
+        return res.get<double>(columna);
+    case SQL_TIPO_NUMERIC:
+    case SQL_TIPO_DECIMAL:
+        return Numerico{ res.get<std::string>(columna) };
+    case SQL_TIPO_BINARY:
+    case SQL_TIPO_VARBINARY:
+    case SQL_TIPO_LONGVARBINARY: {
+        auto bytes = res.get<std::vector<std::uint8_t>>(columna);
+        return Bytes(bytes.begin(), bytes.end());
+    }
+    case SQL_TIPO_DATE: {
+        auto fecha = res.get<nanodbc::date>(columna);
+        return Fecha{ static_cast<std::int32_t>(diasDesdeCivil(fecha.year, fecha.month, fecha.day)) };
+    }
+    case SQL_TIPO_TIMESTAMP: {
+        auto marca = res.get<nanodbc::timestamp>(columna);
+        std::int64_t segundos = diasDesdeCivil(marca.year, marca.month, marca.day) * 86400LL + marca.hour * 3600LL + marca.min * 60LL + marca.sec;
+        return FechaHora{ segundos * 1000000LL + marca.fract / 1000 };
+    }
+    default:
+        return res.get<std::string>(columna);
+    }
+}
+
+}
 
 GestorAuditoria::GestorAuditoria(MotorDB motor, const std::string& connection_string, const std::string& db)
     : motor_actual(motor), db_name(db) {
@@ -19,17 +194,44 @@ void GestorAuditoria::setGestorCifrado(std::shared_ptr<GestorCifrado> gestor) {
     gestor_cifrado = gestor;
 }
 
+void GestorAuditoria::setModoAuditoria(ModoAuditoria modo) {
+    modo_auditoria = modo;
+}
+
+GestorAuditoria::ModoAuditoria GestorAuditoria::interpretarModoAuditoria(const std::string& texto) {
+    const std::string modo = boost::to_lower_copy(texto);
+    if (modo == "completo") return ModoAuditoria::Completo;
+    if (modo == "delta") return ModoAuditoria::Delta;
+    throw std::runtime_error("Modo de auditoria no valido: " + texto + ". Use completo o delta.");
+}
+
 void GestorAuditoria::conectar(const std::string& connection_string, const std::string& db) {
     try {
         switch (motor_actual) {
         case MotorDB::PostgreSQL:
             conn_pg = PQconnectdb(connection_string.c_str());
             if (PQstatus(conn_pg) != CONNECTION_OK) throw std::runtime_error(PQerrorMessage(conn_pg));
+            ejecutor_consulta = &GestorAuditoria::consultarPostgreSQL;
+            ejecutor_comando = &GestorAuditoria::ejecutarComandoPostgreSQL;
+            ejecutor_consulta_tipada = &GestorAuditoria::consultarTipadoPostgreSQL;
             break;
         case MotorDB::MySQL:
+            conn_odbc = std::make_unique<nanodbc::connection>(NANODBC_TEXT(connection_string));
+            ejecutor_consulta = &GestorAuditoria::consultarOdbc;
+            ejecutor_comando = &GestorAuditoria::ejecutarComandoPorLotesMySQL;
+            ejecutor_consulta_tipada = &GestorAuditoria::consultarTipadoOdbc;
+            break;
         case MotorDB::SQLServer:
+            conn_odbc = std::make_unique<nanodbc::connection>(NANODBC_TEXT(connection_string));
+            ejecutor_consulta = &GestorAuditoria::consultarSQLServer;
+            ejecutor_comando = &GestorAuditoria::ejecutarComandoPorLotesSQLServer;
+            ejecutor_consulta_tipada = &GestorAuditoria::consultarTipadoOdbc;
+            break;
         case MotorDB::SQLite:
             conn_odbc = std::make_unique<nanodbc::connection>(NANODBC_TEXT(connection_string));
+            ejecutor_consulta = &GestorAuditoria::consultarOdbc;
+            ejecutor_comando = &GestorAuditoria::ejecutarComandoOdbc;
+            ejecutor_consulta_tipada = &GestorAuditoria::consultarTipadoOdbc;
             break;
         }
     }
@@ -57,55 +259,9 @@ GestorAuditoria::MotorDB GestorAuditoria::getMotor() const {
 }
 
 void GestorAuditoria::ejecutarComando(const std::string& consulta) {
+    MedicionFase medicion("sql.ejecutarComando");
     try {
-        if (motor_actual == MotorDB::PostgreSQL || motor_actual == MotorDB::SQLite) {
-            if (motor_actual == MotorDB::PostgreSQL) {
-                PGresult* res = PQexec(conn_pg, consulta.c_str());
-                if (PQresultStatus(res) != PGRES_COMMAND_OK && PQresultStatus(res) != PGRES_TUPLES_OK) {
-                    throw std::runtime_error(PQerrorMessage(conn_pg));
-                }
-                PQclear(res);
-            }
-            else {
-                nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(consulta));
-            }
-        }
-        else {
-            std::string temp_consulta = consulta;
-            std::string delimitador = (motor_actual == MotorDB::SQLServer) ? "\nGO" : "$$";
-
-            boost::erase_all(temp_consulta, "DELIMITER $$");
-            boost::erase_all(temp_consulta, "DELIMITER ;");
-
-            std::vector<std::string> statements;
-            if (motor_actual == MotorDB::SQLServer) {
-                boost::split(statements, temp_consulta, boost::is_any_of("\n"), boost::token_compress_on);
-                std::string current_batch;
-                for (const auto& line : statements) {
-                    if (boost::trim_copy(line) == "GO") {
-                        if (!current_batch.empty()) {
-                            nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(current_batch));
-                            current_batch = "";
-                        }
-                    }
-                    else {
-                        current_batch += line + "\n";
-                    }
-                }
-                if (!current_batch.empty()) {
-                    nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(current_batch));
-                }
-
-            }
-            else {
-                boost::split(statements, temp_consulta, boost::is_any_of(delimitador), boost::token_compress_on);
-                for (std::string& stmt : statements) {
-                    boost::algorithm::trim(stmt);
-                    if (stmt.empty()) continue;
-                    nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(stmt));
-                }
-            }
-        }
+        (this->*ejecutor_comando)(consulta);
     }
     catch (const nanodbc::database_error& e) {
         std::string error_msg = "Error de Nanodbc: " + std::string(e.what());
@@ -117,101 +273,433 @@ void GestorAuditoria::ejecutarComando(const std::string& consulta) {
     }
 }
 
-std::vector<std::string> GestorAuditoria::obtenerNombresDeTablas(bool incluir_auditoria) {
-    std::vector<std::string> tablas;
-    std::string consulta;
-
-    switch (motor_actual) {
-    case MotorDB::PostgreSQL:
-        consulta = "SELECT tablename FROM pg_catalog.pg_tables WHERE schemaname = 'public';";
-        break;
-    case MotorDB::MySQL:
-        consulta = "SELECT table_name FROM information_schema.tables WHERE table_schema = DATABASE();";
-        break;
-    case MotorDB::SQLServer:
-        consulta = "SELECT name FROM sys.tables;";
-        break;
-    case MotorDB::SQLite:
-        consulta = "SELECT name FROM sqlite_master WHERE type='table';";
-        break;
+void GestorAuditoria::ejecutarSentencia(const std::string& sentencia) {
+    MedicionFase medicion("sql.ejecutarSentencia");
+    try {
+        if (motor_actual == MotorDB::PostgreSQL) ejecutarComandoPostgreSQL(sentencia);
+        else ejecutarComandoOdbc(sentencia);
+    }
+    catch (const nanodbc::database_error& e) {
+        throw std::runtime_error("Error de Nanodbc: " + std::string(e.what()));
     }
+}
 
-    if (motor_actual == MotorDB::PostgreSQL) {
-        PGresult* res = PQexec(conn_pg, consulta.c_str());
-        for (int i = 0; i < PQntuples(res); ++i) tablas.push_back(PQgetvalue(res, i, 0));
+void GestorAuditoria::ejecutarComandoPostgreSQL(const std::string& consulta) {
+    registrarSentencia(consulta.size());
+    PGresult* res = PQexec(conn_pg, consulta.c_str());
+    if (PQresultStatus(res) != PGRES_COMMAND_OK && PQresultStatus(res) != PGRES_TUPLES_OK) {
         PQclear(res);
+        throw std::runtime_error(PQerrorMessage(conn_pg));
     }
-    else {
-        nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
-        while (res.next()) tablas.push_back(res.get<std::string>(0));
+    PQclear(res);
+}
+
+void GestorAuditoria::ejecutarComandoOdbc(const std::string& consulta) {
+    registrarSentencia(consulta.size());
+    nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(consulta));
+}
+
+void GestorAuditoria::ejecutarComandoPorLotesMySQL(const std::string& consulta) {
+    std::string temp_consulta = consulta;
+    boost::erase_all(temp_consulta, "DELIMITER $$");
+    boost::erase_all(temp_consulta, "DELIMITER ;");
+
+    std::vector<std::string> statements;
+    boost::split(statements, temp_consulta, boost::is_any_of("$$"), boost::token_compress_on);
+    for (std::string& stmt : statements) {
+        boost::algorithm::trim(stmt);
+        if (stmt.empty()) continue;
+        registrarSentencia(stmt.size());
+        nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(stmt));
+    }
+}
+
+void GestorAuditoria::ejecutarComandoPorLotesSQLServer(const std::string& consulta) {
+    std::string temp_consulta = consulta;
+    boost::erase_all(temp_consulta, "DELIMITER $$");
+    boost::erase_all(temp_consulta, "DELIMITER ;");
+
+    std::vector<std::string> statements;
+    boost::split(statements, temp_consulta, boost::is_any_of("\n"), boost::token_compress_on);
+    std::string current_batch;
+    for (const auto& line : statements) {
+        if (boost::trim_copy(line) == "GO") {
+            if (!current_batch.empty()) {
+                registrarSentencia(current_batch.size());
+                nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(current_batch));
+                current_batch = "";
+            }
+        }
+        else {
+            current_batch += line + "\n";
+        }
+    }
+    if (!current_batch.empty()) {
+        registrarSentencia(current_batch.size());
+        nanodbc::just_execute(*conn_odbc, NANODBC_TEXT(current_batch));
     }
+}
+
+std::vector<std::string> GestorAuditoria::obtenerNombresDeTablas(bool incluir_auditoria) {
+    std::vector<std::string> tablas;
+    std::string consulta = despacharDialecto(motor_actual, [](auto dialecto) {
+        return decltype(dialecto)::consultaNombresTablas();
+        });
+
+    auto resultado = ejecutarConsultaConResultado(consulta);
+    tablas.reserve(resultado.filas.size());
+    for (auto& fila : resultado.filas) tablas.push_back(std::move(fila[0]));
 
     if (!incluir_auditoria) {
         tablas.erase(std::remove_if(tablas.begin(), tablas.end(), [](const std::string& s) {
-            return s.rfind("aud_", 0) == 0 || s.rfind("Aud", 0) == 0 || s == "sysdiagrams" || s.rfind("sqlite_", 0) == 0;
+            return s.rfind("aud_", 0) == 0 || s.rfind("Aud", 0) == 0 || s == "sysdiagrams" || s.rfind("sqlite_", 0) == 0 || s == TABLA_CHECKPOINT_CAPTURA;
             }), tablas.end());
     }
     return tablas;
 }
 
 ResultadoConsulta GestorAuditoria::ejecutarConsultaConResultado(const std::string& consulta) {
+    MedicionFase medicion("sql.ejecutarConsultaConResultado");
+    ResultadoConsulta resultado = (this->*ejecutor_consulta)(consulta);
+    if (Perfilador::activo()) {
+        std::uint64_t bytes = 0;
+        for (const auto& fila : resultado.filas) {
+            for (const auto& celda : fila) bytes += celda.size();
+        }
+        Perfilador::sumar(ContadorPerfil::Filas, resultado.filas.size());
+        Perfilador::sumar(ContadorPerfil::Bytes, bytes);
+    }
+    return resultado;
+}
+
+ResultadoConsulta GestorAuditoria::consultarPostgreSQL(const std::string& consulta) {
+    registrarSentencia(consulta.size());
+    PGresult* res = PQexec(conn_pg, consulta.c_str());
+    ResultadoConsulta resultado = leerResultadoPostgreSQL(res);
+    PQclear(res);
+    return resultado;
+}
+
+// Con PostgreSQL la conexion se usa sin bloquear y la corrutina cede el hilo
+// mientras espera al servidor. Los motores ODBC no tienen interfaz asincrona y
+// se ejecutan de forma bloqueante dentro de la corrutina.
+boost::asio::awaitable<ResultadoConsulta> GestorAuditoria::ejecutarConsultaAsincrona(std::string consulta) {
+    if (motor_actual != MotorDB::PostgreSQL) co_return ejecutarConsultaConResultado(consulta);
+    registrarSentencia(consulta.size());
+    ResultadoPg res = co_await consultarPgAsincrono(conn_pg, std::move(consulta));
+    ResultadoConsulta resultado = leerResultadoPostgreSQL(res.get());
+    Perfilador::sumar(ContadorPerfil::Filas, resultado.filas.size());
+    co_return resultado;
+}
+
+boost::asio::awaitable<void> GestorAuditoria::ejecutarSentenciaAsincrona(std::string sentencia) {
+    if (motor_actual != MotorDB::PostgreSQL) {
+        ejecutarSentencia(sentencia);
+        co_return;
+    }
+    registrarSentencia(sentencia.size());
+    co_await consultarPgAsincrono(conn_pg, std::move(sentencia));
+}
+
+ResultadoConsulta GestorAuditoria::consultarOdbc(const std::string& consulta) {
     ResultadoConsulta resultado;
+    registrarSentencia(consulta.size());
+    nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
+    const short num_columnas = res.columns();
+    resultado.columnas.reserve(num_columnas);
+    for (short i = 0; i < num_columnas; ++i) {
+        resultado.columnas.push_back(res.column_name(i));
+    }
+    while (res.next()) {
+        std::vector<std::string> fila;
+        fila.reserve(num_columnas);
+        for (short j = 0; j < num_columnas; ++j) {
+            fila.push_back(res.is_null(j) ? "NULL" : res.get<std::string>(j, "NULL"));
+        }
+        resultado.filas.push_back(std::move(fila));
+    }
+    return resultado;
+}
+
+ResultadoConsulta GestorAuditoria::consultarSQLServer(const std::string& consulta) {
+    if (consulta.find("LIMIT 1") == std::string::npos) {
+        return consultarOdbc(consulta);
+    }
     std::string consulta_modificada = consulta;
+    boost::erase_last(consulta_modificada, "LIMIT 1");
+    return consultarOdbc(DialectoSql<MotorDB::SQLServer>::paginar(consulta_modificada, 1));
+}
+
+ResultadoTipado GestorAuditoria::ejecutarConsultaTipada(const std::string& consulta) {
+    MedicionFase medicion("sql.ejecutarConsultaTipada");
+    ResultadoTipado resultado = (this->*ejecutor_consulta_tipada)(consulta);
+    if (!resultado.columnas.empty()) Perfilador::sumar(ContadorPerfil::Filas, resultado.celdas.size() / resultado.columnas.size());
+    return resultado;
+}
 
-    if (motor_actual == MotorDB::SQLServer && consulta.find("LIMIT 1") != std::string::npos) {
-        size_t select_pos = consulta_modificada.find("SELECT");
-        if (select_pos != std::string::npos) {
-            consulta_modificada.insert(select_pos + 6, " TOP 1 ");
+int GestorAuditoria::prepararFormatoPostgreSQL(const std::string& consulta) {
+    Perfilador::sumar(ContadorPerfil::IdasYVueltas, 2);
+    PGresult* preparada = PQprepare(conn_pg, "", consulta.c_str(), 0, nullptr);
+    const bool se_puede_preparar = PQresultStatus(preparada) == PGRES_COMMAND_OK;
+    PQclear(preparada);
+    if (!se_puede_preparar) return -1;
+
+    PGresult* descripcion = PQdescribePrepared(conn_pg, "");
+    int formato_resultado = 1;
+    for (int j = 0; j < PQnfields(descripcion); ++j) {
+        if (!esTipoBinarioSoportadoPostgreSQL(PQftype(descripcion, j))) {
+            formato_resultado = 0;
+            break;
         }
-        boost::erase_last(consulta_modificada, "LIMIT 1");
     }
+    PQclear(descripcion);
+    return formato_resultado;
+}
 
-    switch (motor_actual) {
-    case MotorDB::PostgreSQL: {
-        PGresult* res = PQexec(conn_pg, consulta_modificada.c_str());
-        if (PQresultStatus(res) == PGRES_TUPLES_OK) {
-            for (int j = 0; j < PQnfields(res); ++j) {
-                resultado.columnas.push_back(PQfname(res, j));
+ResultadoTipado GestorAuditoria::consultarTipadoPostgreSQL(const std::string& consulta) {
+    ResultadoTipado resultado;
+    const int formato_resultado = prepararFormatoPostgreSQL(consulta);
+    registrarSentencia(consulta.size());
+    PGresult* res = formato_resultado < 0
+        ? PQexec(conn_pg, consulta.c_str())
+        : PQexecPrepared(conn_pg, "", 0, nullptr, nullptr, nullptr, formato_resultado);
+
+    if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+        const int num_columnas = PQnfields(res);
+        const int num_filas = PQntuples(res);
+        std::vector<Oid> tipos(num_columnas);
+        resultado.columnas.reserve(num_columnas);
+        for (int j = 0; j < num_columnas; ++j) {
+            resultado.columnas.push_back(PQfname(res, j));
+            tipos[j] = PQftype(res, j);
+        }
+        resultado.celdas.reserve(static_cast<size_t>(num_filas) * num_columnas);
+        for (int i = 0; i < num_filas; ++i) {
+            for (int j = 0; j < num_columnas; ++j) {
+                resultado.celdas.push_back(decodificarCeldaPostgreSQL(res, i, j, tipos[j]));
             }
+        }
+    }
+    else if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        std::string error = PQerrorMessage(conn_pg);
+        PQclear(res);
+        throw std::runtime_error(error);
+    }
+    PQclear(res);
+    return resultado;
+}
+
+ResultadoTipado GestorAuditoria::consultarTipadoOdbc(const std::string& consulta) {
+    ResultadoTipado resultado;
+    registrarSentencia(consulta.size());
+    nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
+    const short num_columnas = res.columns();
+    std::vector<int> tipos(num_columnas);
+    resultado.columnas.reserve(num_columnas);
+    for (short i = 0; i < num_columnas; ++i) {
+        resultado.columnas.push_back(res.column_name(i));
+        tipos[i] = res.column_datatype(i);
+    }
+    while (res.next()) {
+        for (short j = 0; j < num_columnas; ++j) {
+            resultado.celdas.push_back(leerValorOdbc(res, j, tipos[j]));
+        }
+    }
+    return resultado;
+}
+
+void GestorAuditoria::procesarConsultaPorFilas(const std::string& consulta,
+    const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+    const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila,
+    long filas_por_bloque) {
+    MedicionFase medicion("sql.procesarConsultaPorFilas");
+    if (motor_actual == MotorDB::PostgreSQL) {
+        recorrerPostgreSQL(consulta, al_recibir_columnas, al_recibir_fila);
+    }
+    else {
+        recorrerOdbc(consulta, al_recibir_columnas, al_recibir_fila, filas_por_bloque);
+    }
+}
+
+void GestorAuditoria::recorrerPostgreSQL(const std::string& consulta,
+    const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+    const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila) {
+    const int formato_resultado = prepararFormatoPostgreSQL(consulta);
+    registrarSentencia(consulta.size());
+    const int enviada = formato_resultado < 0
+        ? PQsendQuery(conn_pg, consulta.c_str())
+        : PQsendQueryPrepared(conn_pg, "", 0, nullptr, nullptr, nullptr, formato_resultado);
+    if (!enviada) throw std::runtime_error(PQerrorMessage(conn_pg));
+#ifdef LIBPQ_HAS_CHUNK_MODE
+    PQsetChunkedRowsMode(conn_pg, 1024);
+#else
+    PQsetSingleRowMode(conn_pg);
+#endif
+
+    std::string error;
+    bool columnas_enviadas = false;
+    std::vector<Oid> tipos;
+    std::vector<ValorCelda> fila;
+    while (PGresult* res = PQgetResult(conn_pg)) {
+        const ExecStatusType estado = PQresultStatus(res);
+        if (error.empty() && (estado == PGRES_SINGLE_TUPLE || estado == PGRES_TUPLES_OK
+#ifdef LIBPQ_HAS_CHUNK_MODE
+            || estado == PGRES_TUPLES_CHUNK
+#endif
+            )) {
+            const int num_columnas = PQnfields(res);
+            if (!columnas_enviadas) {
+                std::vector<std::string> columnas;
+                columnas.reserve(num_columnas);
+                tipos.resize(num_columnas);
+                for (int j = 0; j < num_columnas; ++j) {
+                    columnas.push_back(PQfname(res, j));
+                    tipos[j] = PQftype(res, j);
+                }
+                al_recibir_columnas(columnas);
+                columnas_enviadas = true;
+            }
+            Perfilador::sumar(ContadorPerfil::Filas, PQntuples(res));
             for (int i = 0; i < PQntuples(res); ++i) {
-                std::vector<std::string> fila;
-                for (int j = 0; j < PQnfields(res); ++j) {
-                    fila.push_back(PQgetisnull(res, i, j) ? "NULL" : PQgetvalue(res, i, j));
+                fila.clear();
+                for (int j = 0; j < num_columnas; ++j) {
+                    fila.push_back(decodificarCeldaPostgreSQL(res, i, j, tipos[j]));
                 }
-                resultado.filas.push_back(fila);
+                al_recibir_fila(fila);
             }
         }
+        else if (error.empty() && estado != PGRES_COMMAND_OK) {
+            error = PQerrorMessage(conn_pg);
+        }
         PQclear(res);
-        break;
     }
-    default: {
-        nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta_modificada));
-        for (short i = 0; i < res.columns(); ++i) {
-            resultado.columnas.push_back(res.column_name(i));
+    if (!error.empty()) throw std::runtime_error(error);
+}
+
+void GestorAuditoria::recorrerOdbc(const std::string& consulta,
+    const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+    const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila,
+    long filas_por_bloque) {
+    registrarSentencia(consulta.size());
+    nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta), filas_por_bloque);
+    const short num_columnas = res.columns();
+    std::vector<std::string> columnas;
+    std::vector<int> tipos(num_columnas);
+    columnas.reserve(num_columnas);
+    for (short i = 0; i < num_columnas; ++i) {
+        columnas.push_back(res.column_name(i));
+        tipos[i] = res.column_datatype(i);
+    }
+    al_recibir_columnas(columnas);
+    if (num_columnas == 0) return;
+
+    std::vector<ValorCelda> fila;
+    fila.reserve(num_columnas);
+    while (res.next()) {
+        Perfilador::sumar(ContadorPerfil::Filas);
+        fila.clear();
+        for (short j = 0; j < num_columnas; ++j) {
+            fila.push_back(leerValorOdbc(res, j, tipos[j]));
+        }
+        al_recibir_fila(fila);
+    }
+}
+
+bool GestorAuditoria::admiteLecturaPorBloques(const std::string& consulta_muestra) {
+    if (motor_actual == MotorDB::PostgreSQL) return true;
+    nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta_muestra));
+    for (short i = 0; i < res.columns(); ++i) {
+        const int tipo = res.column_datatype(i);
+        const long tamano = res.column_size(i);
+        if (tipo == SQL_TIPO_LONGVARCHAR || tipo == SQL_TIPO_WLONGVARCHAR || tipo == SQL_TIPO_LONGVARBINARY ||
+            tamano <= 0 || tamano > 8000) {
+            return false;
         }
-        while (res.next()) {
-            std::vector<std::string> fila;
-            for (short j = 0; j < res.columns(); ++j) {
-                fila.push_back(res.is_null(j) ? "NULL" : res.get<std::string>(j, "NULL"));
+    }
+    return true;
+}
+
+void GestorAuditoria::exportarCopiaPostgreSQL(const std::string& sentencia_copy, const std::function<void(const char*, int)>& al_recibir_datos) {
+    if (motor_actual != MotorDB::PostgreSQL) throw std::runtime_error("COPY solo esta disponible en PostgreSQL.");
+
+    MedicionFase medicion("sql.exportarCopia");
+    registrarSentencia(sentencia_copy.size());
+    PGresult* res = PQexec(conn_pg, sentencia_copy.c_str());
+    if (PQresultStatus(res) != PGRES_COPY_OUT) {
+        std::string error = PQerrorMessage(conn_pg);
+        PQclear(res);
+        throw std::runtime_error(error);
+    }
+    PQclear(res);
+
+    char* buffer = nullptr;
+    int longitud = 0;
+    while ((longitud = PQgetCopyData(conn_pg, &buffer, 0)) > 0) {
+        Perfilador::sumar(ContadorPerfil::Bytes, longitud);
+        al_recibir_datos(buffer, longitud);
+        PQfreemem(buffer);
+    }
+    if (longitud == -2) throw std::runtime_error(PQerrorMessage(conn_pg));
+
+    std::string error;
+    while (PGresult* final = PQgetResult(conn_pg)) {
+        if (PQresultStatus(final) != PGRES_COMMAND_OK && error.empty()) error = PQerrorMessage(conn_pg);
+        PQclear(final);
+    }
+    if (!error.empty()) throw std::runtime_error(error);
+}
+
+void GestorAuditoria::importarCopiaPostgreSQL(const std::string& sentencia_copy, const std::function<bool(std::string&)>& siguiente_bloque) {
+    if (motor_actual != MotorDB::PostgreSQL) throw std::runtime_error("COPY solo esta disponible en PostgreSQL.");
+
+    MedicionFase medicion("sql.importarCopia");
+    registrarSentencia(sentencia_copy.size());
+    PGresult* res = PQexec(conn_pg, sentencia_copy.c_str());
+    if (PQresultStatus(res) != PGRES_COPY_IN) {
+        std::string error = PQerrorMessage(conn_pg);
+        PQclear(res);
+        throw std::runtime_error(error);
+    }
+    PQclear(res);
+
+    std::string bloque;
+    std::string error_cliente;
+    try {
+        while (siguiente_bloque(bloque)) {
+            if (bloque.empty()) continue;
+            Perfilador::sumar(ContadorPerfil::Bytes, bloque.size());
+            if (PQputCopyData(conn_pg, bloque.data(), static_cast<int>(bloque.size())) != 1) {
+                throw std::runtime_error(PQerrorMessage(conn_pg));
             }
-            resultado.filas.push_back(fila);
         }
-        break;
     }
+    catch (const std::exception& e) {
+        error_cliente = e.what();
+    }
+    PQputCopyEnd(conn_pg, error_cliente.empty() ? nullptr : error_cliente.c_str());
+
+    std::string error = error_cliente;
+    while (PGresult* final = PQgetResult(conn_pg)) {
+        if (PQresultStatus(final) != PGRES_COMMAND_OK && error.empty()) error = PQerrorMessage(conn_pg);
+        PQclear(final);
     }
-    return resultado;
+    if (!error.empty()) throw std::runtime_error(error);
 }
 
 void GestorAuditoria::crearFuncionesAuditoria() {
     if (motor_actual == MotorDB::MySQL) {
-        ejecutarComando(env_plantillas.render_file("MySqlAuditFunctions.tpl", {}));
+        ejecutarComando(GestorPlantillas::instancia().renderizar("MySqlAuditFunctions.tpl", {}));
     }
     else if (motor_actual == MotorDB::SQLServer) {
-        ejecutarComando(env_plantillas.render_file("SqlServerAuditFunctions.tpl", {}));
+        ejecutarComando(GestorPlantillas::instancia().renderizar("SqlServerAuditFunctions.tpl", {}));
     }
 }
 
 void GestorAuditoria::generarAuditoriaParaTabla(const std::string& nombre_tabla) {
+    MedicionFase medicion("auditoria.generarAuditoriaParaTabla");
+    if (modo_auditoria == ModoAuditoria::Delta && !gestor_cifrado && generarAuditoriaDelta(nombre_tabla)) {
+        return;
+    }
     crearFuncionesAuditoria();
 
     switch (motor_actual) {
@@ -222,20 +710,142 @@ void GestorAuditoria::generarAuditoriaParaTabla(const std::string& nombre_tabla)
     }
 }
 
-void GestorAuditoria::generarAuditoriaPostgreSQL(const std::string& nombre_tabla) {
-    auto columnas_info_res = ejecutarConsultaConResultado("SELECT column_name FROM information_schema.columns WHERE table_name = '" + nombre_tabla + "' AND table_schema = 'public' ORDER BY ordinal_position;");
-
-    std::ostringstream definicion_columnas;
-    for (size_t i = 0; i < columnas_info_res.filas.size(); ++i) {
-        definicion_columnas << "\"" << columnas_info_res.filas[i][0] << "\" TEXT";
-        if (i < columnas_info_res.filas.size() - 1) {
-            definicion_columnas << ", ";
+boost::asio::awaitable<void> GestorAuditoria::generarAuditoriaParaTablaAsincrona(std::string nombre_tabla) {
+    if (motor_actual != MotorDB::PostgreSQL) {
+        generarAuditoriaParaTabla(nombre_tabla);
+        co_return;
+    }
+    if (modo_auditoria == ModoAuditoria::Delta) {
+        using Dialecto = DialectoSql<MotorDB::PostgreSQL>;
+        ResultadoConsulta clave_res = co_await ejecutarConsultaAsincrona(Dialecto::consultaClavePrimaria(nombre_tabla));
+        if (!clave_res.filas.empty()) {
+            ResultadoConsulta columnas_res = co_await ejecutarConsultaAsincrona(Dialecto::consultaColumnas(nombre_tabla));
+            co_await ejecutarSentenciaAsincrona(renderizarAuditoriaDelta<Dialecto>(nombre_tabla, columnas_res, clave_res));
+            co_return;
         }
+        std::cerr << "Advertencia: " << nombre_tabla << " no tiene clave primaria; se audita con filas completas." << std::endl;
     }
-    nlohmann::json datos;
-    datos["tabla"] = nombre_tabla;
-    datos["definicion_columnas"] = definicion_columnas.str();
-    ejecutarComando(env_plantillas.render_file("PostgresAudit.tpl", datos));
+    ResultadoConsulta columnas_info_res = co_await ejecutarConsultaAsincrona(consultaColumnasAuditoriaPostgreSQL(nombre_tabla));
+    co_await ejecutarSentenciaAsincrona(renderizarAuditoriaPostgreSQL(nombre_tabla, columnas_info_res));
+}
+
+bool GestorAuditoria::generarAuditoriaDelta(const std::string& nombre_tabla) {
+    const bool generada = despacharDialecto(motor_actual, [&](auto dialecto) {
+        using Dialecto = decltype(dialecto);
+        auto clave_res = ejecutarConsultaConResultado(Dialecto::consultaClavePrimaria(nombre_tabla));
+        if (clave_res.filas.empty()) return false;
+        auto columnas_res = ejecutarConsultaConResultado(Dialecto::consultaColumnas(nombre_tabla));
+        ejecutarComando(renderizarAuditoriaDelta<Dialecto>(nombre_tabla, columnas_res, clave_res));
+        return true;
+        });
+    if (!generada) {
+        std::cerr << "Advertencia: " << nombre_tabla << " no tiene clave primaria; se audita con filas completas." << std::endl;
+    }
+    return generada;
+}
+
+// Recorre los registros de cada clave desde el mas reciente hacia atras partiendo
+// de la fila vigente: un registro 'Modificado' repone los valores anteriores de
+// las columnas que cambio, y 'Insertado' o 'Eliminado' traen la fila completa.
+// La auditoria se lee en streaming ordenada por clave e IdAuditoria descendente,
+// con la fila vigente unida por la clave, asi que solo se guarda en memoria el
+// historial de una clave. Las filas salen agrupadas por clave y, dentro de cada
+// una, en orden de IdAuditoria; las columnas que ya no existen en la tabla se
+// omiten. Devuelve el numero de versiones emitidas.
+std::size_t GestorAuditoria::reconstruirAuditoria(const std::string& nombre_tabla,
+    const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+    const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila) {
+    MedicionFase medicion("auditoria.reconstruirAuditoria");
+    constexpr std::size_t columnas_auditoria = 6;
+    auto [consulta, columnas_clave] = despacharDialecto(motor_actual, [&](auto dialecto) {
+        using Dialecto = decltype(dialecto);
+        const auto columnas_aud = ejecutarConsultaConResultado(Dialecto::consultaColumnas("aud_" + nombre_tabla));
+        const bool es_delta = std::any_of(columnas_aud.filas.begin(), columnas_aud.filas.end(),
+            [](const auto& fila) { return fila[0] == COLUMNA_CLAVE_AUDITORIA; });
+        if (!es_delta) {
+            throw std::runtime_error("La tabla aud_" + nombre_tabla + " no existe o no usa auditoria por diferencias.");
+        }
+        const auto clave_res = ejecutarConsultaConResultado(Dialecto::consultaClavePrimaria(nombre_tabla));
+        if (clave_res.filas.empty()) {
+            throw std::runtime_error("La tabla " + nombre_tabla + " no tiene clave primaria; no se puede reconstruir su auditoria.");
+        }
+        std::unordered_map<std::string, std::string> tipos;
+        for (const auto& fila : ejecutarConsultaConResultado(Dialecto::consultaColumnas(nombre_tabla)).filas) tipos.emplace(fila[0], fila[1]);
+
+        const std::string_view columnas[] = { COLUMNA_CLAVE_AUDITORIA, COLUMNA_CAMBIOS_AUDITORIA, "UsuarioAccion", "FechaAccion", "AccionSql", COLUMNA_SECUENCIA_AUDITORIA };
+        const std::string clave = "a." + Dialecto::citar(COLUMNA_CLAVE_AUDITORIA);
+        std::string consulta = "SELECT ";
+        for (const auto& columna : columnas) {
+            consulta += "a.";
+            Dialecto::citar(consulta, columna);
+            consulta += ", ";
+        }
+        consulta += "t.* FROM " + Dialecto::tablaCalificada("aud_" + nombre_tabla) + " a LEFT JOIN " + Dialecto::tablaCalificada(nombre_tabla) + " t ON ";
+        std::vector<std::string> columnas_clave;
+        for (const auto& fila : clave_res.filas) {
+            if (!columnas_clave.empty()) consulta += " AND ";
+            consulta += Dialecto::expresionTexto("t." + Dialecto::citar(fila[0]), tipos[fila[0]]) + " = " + Dialecto::expresionValorJson(clave, fila[0]);
+            columnas_clave.push_back(fila[0]);
+        }
+        consulta += " ORDER BY " + clave + ", a." + Dialecto::citar(COLUMNA_SECUENCIA_AUDITORIA) + " DESC";
+        return std::pair{ consulta, columnas_clave };
+        });
+
+    std::vector<std::string> columnas_datos;
+    std::unordered_map<std::string, std::size_t> indices_columna;
+    std::size_t indice_clave = 0;
+    std::string clave_actual;
+    bool hay_clave = false;
+    std::vector<ValorCelda> estado;
+    std::vector<std::vector<ValorCelda>> versiones;
+    std::size_t emitidas = 0;
+
+    auto emitirVersiones = [&]() {
+        for (auto it = versiones.rbegin(); it != versiones.rend(); ++it) al_recibir_fila(*it);
+        emitidas += versiones.size();
+        versiones.clear();
+    };
+
+    procesarConsultaPorFilas(consulta,
+        [&](const std::vector<std::string>& columnas) {
+            columnas_datos.assign(columnas.begin() + columnas_auditoria, columnas.end());
+            for (std::size_t i = 0; i < columnas_datos.size(); ++i) indices_columna.emplace(columnas_datos[i], i);
+            indice_clave = indices_columna.at(columnas_clave.front());
+            std::vector<std::string> encabezado = columnas_datos;
+            encabezado.insert(encabezado.end(), columnas.begin() + 2, columnas.begin() + columnas_auditoria);
+            al_recibir_columnas(encabezado);
+        },
+        [&](std::vector<ValorCelda>& fila) {
+            std::string clave = valorATexto(fila[0]);
+            if (!hay_clave || clave != clave_actual) {
+                emitirVersiones();
+                clave_actual = std::move(clave);
+                hay_clave = true;
+                if (esNulo(fila[columnas_auditoria + indice_clave])) estado.assign(columnas_datos.size(), ValorCelda{});
+                else estado.assign(std::make_move_iterator(fila.begin() + columnas_auditoria), std::make_move_iterator(fila.end()));
+            }
+
+            const std::string accion = valorATexto(fila[4]);
+            if (accion != "Modificado") estado.assign(columnas_datos.size(), ValorCelda{});
+            for (const auto& [columna, valor] : nlohmann::json::parse(valorATexto(fila[1])).items()) {
+                auto it = indices_columna.find(columna);
+                if (it == indices_columna.end()) continue;
+                if (valor.is_null()) estado[it->second] = ValorCelda{};
+                else if (valor.is_string()) estado[it->second] = valor.get<std::string>();
+                else estado[it->second] = valor.dump();
+            }
+
+            auto& version = versiones.emplace_back(estado);
+            version.insert(version.end(), std::make_move_iterator(fila.begin() + 2), std::make_move_iterator(fila.begin() + columnas_auditoria));
+            if (accion == "Insertado") estado.assign(columnas_datos.size(), ValorCelda{});
+        });
+    emitirVersiones();
+    return emitidas;
+}
+
+void GestorAuditoria::generarAuditoriaPostgreSQL(const std::string& nombre_tabla) {
+    auto columnas_info_res = ejecutarConsultaConResultado(consultaColumnasAuditoriaPostgreSQL(nombre_tabla));
+    ejecutarComando(renderizarAuditoriaPostgreSQL(nombre_tabla, columnas_info_res));
 }
 
 void GestorAuditoria::generarAuditoriaSQLServer(const std::string& nombre_tabla) {
@@ -256,7 +866,7 @@ void GestorAuditoria::generarAuditoriaMySQL(const std::string& nombre_tabla) {
     datos["campos"] = campos_new;
     datos["campos_old"] = campos_old;
 
-    ejecutarComando(env_plantillas.render_file("MySqlAuditTriggers.tpl", datos));
+    ejecutarComando(GestorPlantillas::instancia().renderizar("MySqlAuditTriggers.tpl", datos));
 }
 
 void GestorAuditoria::generarAuditoriaSQLite(const std::string& nombre_tabla) {
@@ -273,7 +883,8 @@ void GestorAuditoria::generarAuditoriaSQLite(const std::string& nombre_tabla) {
         std::ostringstream definicion_columnas, lista_columnas_old, lista_columnas_new;
 
         for (size_t i = 0; i < columnas_info_res.filas.size(); ++i) {
-            definicion_columnas << "\"" << columnas_info_res.filas[i][1] << "\" TEXT";
+            const std::string& tipo_columna = columnas_info_res.filas[i][2];
+            definicion_columnas << "\"" << columnas_info_res.filas[i][1] << "\" " << (tipo_columna.empty() || tipo_columna == "NULL" ? "TEXT" : tipo_columna);
             lista_columnas_old << "OLD." << columnas_info_res.filas[i][1];
             lista_columnas_new << "NEW." << columnas_info_res.filas[i][1];
             if (i < columnas_info_res.filas.size() - 1) {
@@ -286,6 +897,6 @@ void GestorAuditoria::generarAuditoriaSQLite(const std::string& nombre_tabla) {
         datos["definicion_columnas"] = definicion_columnas.str();
         datos["lista_columnas_old"] = lista_columnas_old.str();
         datos["lista_columnas_new"] = lista_columnas_new.str();
-        ejecutarComando(env_plantillas.render_file("SqliteAudit.tpl", datos));
+        ejecutarComando(GestorPlantillas::instancia().renderizar("SqliteAudit.tpl", datos));
     }
 }
\ No newline at end of file
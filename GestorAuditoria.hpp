@@ -1,14 +1,17 @@
 #pragma once
+#include <utility>
 #include <string>
 #include <vector>
 #include <memory>
 #include <stdexcept>
 #include <sstream>
+#include <functional>
 #include <nlohmann/json.hpp>
-#include <inja/inja.hpp>
+#include <boost/asio/awaitable.hpp>
 #include <libpq-fe.h>
 #include <nanodbc/nanodbc.h>
 #include "GestorCifrado.hpp"
+#include "ValorCelda.hpp"
 
 struct ResultadoConsulta {
     std::vector<std::string> columnas;
@@ -26,29 +29,76 @@ public:
         SQLite
     };
 
+    enum class ModoAuditoria {
+        Completo,
+        Delta
+    };
+
     GestorAuditoria(MotorDB motor, const std::string& connection_string, const std::string& db = "");
     ~GestorAuditoria();
 
     bool estaConectado() const;
     std::vector<std::string> obtenerNombresDeTablas(bool incluir_auditoria);
     void generarAuditoriaParaTabla(const std::string& nombre_tabla);
+    std::size_t reconstruirAuditoria(const std::string& nombre_tabla,
+        const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+        const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila);
     ResultadoConsulta ejecutarConsultaConResultado(const std::string& consulta);
+    ResultadoTipado ejecutarConsultaTipada(const std::string& consulta);
+    void procesarConsultaPorFilas(const std::string& consulta,
+        const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+        const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila,
+        long filas_por_bloque = 1);
+    bool admiteLecturaPorBloques(const std::string& consulta_muestra);
+    void exportarCopiaPostgreSQL(const std::string& sentencia_copy, const std::function<void(const char*, int)>& al_recibir_datos);
+    void importarCopiaPostgreSQL(const std::string& sentencia_copy, const std::function<bool(std::string&)>& siguiente_bloque);
     void ejecutarComando(const std::string& consulta);
+    void ejecutarSentencia(const std::string& sentencia);
+    boost::asio::awaitable<ResultadoConsulta> ejecutarConsultaAsincrona(std::string consulta);
+    boost::asio::awaitable<void> ejecutarSentenciaAsincrona(std::string sentencia);
+    boost::asio::awaitable<void> generarAuditoriaParaTablaAsincrona(std::string nombre_tabla);
     MotorDB getMotor() const;
     void setGestorCifrado(std::shared_ptr<GestorCifrado> gestor);
+    void setModoAuditoria(ModoAuditoria modo);
+    static ModoAuditoria interpretarModoAuditoria(const std::string& texto);
 
 private:
     MotorDB motor_actual;
     std::string db_name;
-    inja::Environment env_plantillas;
     std::shared_ptr<GestorCifrado> gestor_cifrado;
+    ModoAuditoria modo_auditoria = ModoAuditoria::Completo;
 
     PGconn* conn_pg = nullptr;
     std::unique_ptr<nanodbc::connection> conn_odbc;
 
+    using EjecutorConsulta = ResultadoConsulta (GestorAuditoria::*)(const std::string&);
+    using EjecutorComando = void (GestorAuditoria::*)(const std::string&);
+    using EjecutorConsultaTipada = ResultadoTipado (GestorAuditoria::*)(const std::string&);
+    EjecutorConsulta ejecutor_consulta = nullptr;
+    EjecutorComando ejecutor_comando = nullptr;
+    EjecutorConsultaTipada ejecutor_consulta_tipada = nullptr;
+
     void conectar(const std::string& connection_string, const std::string& db);
     void desconectar();
 
+    ResultadoConsulta consultarPostgreSQL(const std::string& consulta);
+    ResultadoConsulta consultarOdbc(const std::string& consulta);
+    ResultadoConsulta consultarSQLServer(const std::string& consulta);
+    ResultadoTipado consultarTipadoPostgreSQL(const std::string& consulta);
+    ResultadoTipado consultarTipadoOdbc(const std::string& consulta);
+    int prepararFormatoPostgreSQL(const std::string& consulta);
+    void recorrerPostgreSQL(const std::string& consulta,
+        const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+        const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila);
+    void recorrerOdbc(const std::string& consulta,
+        const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+        const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila,
+        long filas_por_bloque);
+    void ejecutarComandoPostgreSQL(const std::string& consulta);
+    void ejecutarComandoOdbc(const std::string& consulta);
+    void ejecutarComandoPorLotesMySQL(const std::string& consulta);
+    void ejecutarComandoPorLotesSQLServer(const std::string& consulta);
+
     void crearFuncionesAuditoria();
     void crearFuncionesAuditoriaMySQL();
     void crearFuncionesAuditoriaSQLServer();
@@ -56,4 +106,5 @@ private:
     void generarAuditoriaSQLServer(const std::string& nombre_tabla);
     void generarAuditoriaMySQL(const std::string& nombre_tabla);
     void generarAuditoriaSQLite(const std::string& nombre_tabla);
+    bool generarAuditoriaDelta(const std::string& nombre_tabla);
 };
\ No newline at end of file
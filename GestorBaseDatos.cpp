@@ -1,12 +1,40 @@
 #include "GestorBaseDatos.hpp"
 #include "Utils.hpp" 
+#include "DialectoSql.hpp"
+#include "Perfilador.hpp"
+#include "EjecutorAsincrono.hpp"
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <exception>
+#include <thread>
 #include <boost/algorithm/string.hpp>
 
+namespace {
+
+ResultadoConsulta leerFilasPostgreSQL(PGresult* res) {
+    ResultadoConsulta resultado;
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) return resultado;
+    const int num_columnas = PQnfields(res);
+    const int num_filas = PQntuples(res);
+    Perfilador::sumar(ContadorPerfil::Filas, num_filas);
+    resultado.filas.reserve(num_filas);
+    for (int i = 0; i < num_filas; ++i) {
+        std::vector<std::string> fila;
+        fila.reserve(num_columnas);
+        for (int j = 0; j < num_columnas; ++j) {
+            fila.emplace_back(PQgetvalue(res, i, j), PQgetlength(res, i, j));
+        }
+        resultado.filas.push_back(std::move(fila));
+    }
+    return resultado;
+}
+
+}
+
 GestorBaseDatos::GestorBaseDatos(GestorAuditoria::MotorDB motor, const std::string& info_conexion, const std::string& dbname)
-    : motor_actual(motor), db_name(dbname) {
+    : motor_actual(motor), db_name(dbname), info_conexion(info_conexion) {
     try {
         switch (motor_actual) {
         case GestorAuditoria::MotorDB::PostgreSQL:
@@ -14,11 +42,13 @@ GestorBaseDatos::GestorBaseDatos(GestorAuditoria::MotorDB motor, const std::stri
             if (PQstatus(conn_pg) != CONNECTION_OK) {
                 throw std::runtime_error(PQerrorMessage(conn_pg));
             }
+            ejecutor_consulta = &GestorBaseDatos::consultarPostgreSQL;
             break;
         case GestorAuditoria::MotorDB::SQLServer:
         case GestorAuditoria::MotorDB::MySQL:
         case GestorAuditoria::MotorDB::SQLite:
             conn_odbc = std::make_unique<nanodbc::connection>(NANODBC_TEXT(info_conexion));
+            ejecutor_consulta = &GestorBaseDatos::consultarOdbc;
             break;
         }
     }
@@ -73,183 +103,174 @@ std::string GestorBaseDatos::mapearTipoDbATs(const std::string& tipo_db) {
     return "string";
 }
 
-std::vector<std::string> GestorBaseDatos::obtenerNombresDeTablas() {
-    std::vector<std::string> tablas;
-    std::string consulta;
+ResultadoConsulta GestorBaseDatos::consultarPostgreSQL(const std::string& consulta) {
+    Perfilador::sumar(ContadorPerfil::Sentencias);
+    Perfilador::sumar(ContadorPerfil::IdasYVueltas);
+    PGresult* res = PQexec(conn_pg, consulta.c_str());
+    ResultadoConsulta resultado = leerFilasPostgreSQL(res);
+    PQclear(res);
+    return resultado;
+}
 
-    switch (motor_actual) {
-    case GestorAuditoria::MotorDB::PostgreSQL:
-        consulta = "SELECT tablename FROM pg_catalog.pg_tables WHERE schemaname = 'public' ORDER BY tablename;";
-        break;
-    case GestorAuditoria::MotorDB::MySQL:
-        consulta = "SELECT table_name FROM information_schema.tables WHERE table_schema = DATABASE() ORDER BY table_name;";
-        break;
-    case GestorAuditoria::MotorDB::SQLServer:
-        consulta = "SELECT name FROM sys.tables ORDER BY name;";
-        break;
-    case GestorAuditoria::MotorDB::SQLite:
-        consulta = "SELECT name FROM sqlite_master WHERE type='table' ORDER BY name;";
-        break;
-    }
+boost::asio::awaitable<ResultadoConsulta> GestorBaseDatos::consultarAsincrono(std::string consulta) {
+    if (motor_actual != GestorAuditoria::MotorDB::PostgreSQL) co_return (this->*ejecutor_consulta)(consulta);
+    Perfilador::sumar(ContadorPerfil::Sentencias);
+    Perfilador::sumar(ContadorPerfil::IdasYVueltas);
+    ResultadoPg res = co_await consultarPgAsincrono(conn_pg, std::move(consulta));
+    co_return leerFilasPostgreSQL(res.get());
+}
 
-    if (motor_actual == GestorAuditoria::MotorDB::PostgreSQL) {
-        PGresult* res = PQexec(conn_pg, consulta.c_str());
-        if (PQresultStatus(res) == PGRES_TUPLES_OK) {
-            for (int i = 0; i < PQntuples(res); ++i) {
-                std::string nombre_tabla = PQgetvalue(res, i, 0);
-                if (nombre_tabla.rfind("aud_", 0) != 0 && nombre_tabla != "sysdiagrams") {
-                    tablas.push_back(nombre_tabla);
-                }
-            }
+ResultadoConsulta GestorBaseDatos::consultarOdbc(const std::string& consulta) {
+    ResultadoConsulta resultado;
+    Perfilador::sumar(ContadorPerfil::Sentencias);
+    Perfilador::sumar(ContadorPerfil::IdasYVueltas);
+    nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
+    const short num_columnas = res.columns();
+    while (res.next()) {
+        Perfilador::sumar(ContadorPerfil::Filas);
+        std::vector<std::string> fila;
+        fila.reserve(num_columnas);
+        for (short j = 0; j < num_columnas; ++j) {
+            fila.push_back(res.get<std::string>(j, ""));
         }
-        PQclear(res);
+        resultado.filas.push_back(std::move(fila));
     }
-    else {
-        nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
-        while (res.next()) {
-            std::string nombre_tabla = res.get<std::string>(0);
-            if (nombre_tabla.rfind("aud_", 0) != 0 && nombre_tabla != "sysdiagrams" &&
-                nombre_tabla.rfind("sqlite_", 0) != 0) {
-                tablas.push_back(nombre_tabla);
-            }
+    return resultado;
+}
+
+template <typename Dialecto>
+std::vector<std::string> GestorBaseDatos::obtenerNombresDeTablas() {
+    std::vector<std::string> tablas;
+    auto resultado = (this->*ejecutor_consulta)(Dialecto::consultaNombresTablas());
+    for (auto& fila : resultado.filas) {
+        std::string& nombre_tabla = fila[0];
+        if (nombre_tabla.rfind("aud_", 0) != 0 && nombre_tabla != "sysdiagrams" &&
+            nombre_tabla.rfind("sqlite_", 0) != 0) {
+            tablas.push_back(std::move(nombre_tabla));
         }
     }
-
     return tablas;
 }
 
-std::vector<Columna> GestorBaseDatos::obtenerColumnasParaTabla(const std::string& nombre_tabla) {
-    std::vector<Columna> columnas;
-    std::string consulta;
-    std::string pk_col_name;
-
-    switch (motor_actual) {
-    case GestorAuditoria::MotorDB::PostgreSQL: {
-        std::string pk_query = "SELECT kcu.column_name FROM information_schema.table_constraints tc JOIN information_schema.key_column_usage kcu ON tc.constraint_name = kcu.constraint_name WHERE tc.constraint_type = 'PRIMARY KEY' AND tc.table_name = '" + nombre_tabla + "';";
-        PGresult* pk_res = PQexec(conn_pg, pk_query.c_str());
-        if (PQntuples(pk_res) > 0) pk_col_name = PQgetvalue(pk_res, 0, 0);
-        PQclear(pk_res);
-        consulta = "SELECT column_name, data_type, is_nullable FROM information_schema.columns WHERE table_name = '" + nombre_tabla + "' ORDER BY ordinal_position;";
-        break;
-    }
-    case GestorAuditoria::MotorDB::MySQL:
-        consulta = "SELECT column_name, data_type, is_nullable, column_key FROM information_schema.columns WHERE table_name = '" + nombre_tabla + "' AND table_schema = DATABASE() ORDER BY ordinal_position;";
-        break;
-    case GestorAuditoria::MotorDB::SQLServer:
-        consulta = "SELECT c.name, t.name, c.is_nullable, ISNULL(i.is_primary_key, 0) FROM sys.columns c INNER JOIN sys.types t ON c.user_type_id = t.user_type_id LEFT JOIN sys.index_columns ic ON ic.object_id = c.object_id AND ic.column_id = c.column_id LEFT JOIN sys.indexes i ON i.object_id = ic.object_id AND i.index_id = ic.index_id AND i.is_primary_key = 1 WHERE c.object_id = OBJECT_ID('" + nombre_tabla + "') ORDER BY c.column_id;";
-        break;
-    case GestorAuditoria::MotorDB::SQLite:
-        consulta = "PRAGMA table_info(" + nombre_tabla + ");";
-        break;
+// Con varias conexiones, cada una toma la siguiente tabla pendiente. En
+// PostgreSQL todas se atienden con corrutinas desde el hilo llamador; con ODBC
+// cada conexion usa su propio hilo. Cada resultado queda en la posicion de su
+// tabla, por lo que la salida no depende del reparto.
+template <typename Dialecto>
+std::vector<ResultadoConsulta> GestorBaseDatos::leerColumnasDeTablas(const std::vector<std::string>& nombres_tablas) {
+    MedicionFase medicion("esquema.leerColumnasDeTablas");
+    std::vector<ResultadoConsulta> resultados(nombres_tablas.size());
+    const std::size_t num_hilos = std::min<std::size_t>(hilos_esquema, nombres_tablas.size());
+    if (num_hilos <= 1) {
+        for (std::size_t i = 0; i < nombres_tablas.size(); ++i) {
+            resultados[i] = (this->*ejecutor_consulta)(Dialecto::consultaColumnas(nombres_tablas[i]));
+        }
+        return resultados;
     }
 
-    if (motor_actual == GestorAuditoria::MotorDB::PostgreSQL) {
-        PGresult* res = PQexec(conn_pg, consulta.c_str());
-        if (PQresultStatus(res) == PGRES_TUPLES_OK) {
-            for (int i = 0; i < PQntuples(res); ++i) {
-                Columna col;
-                col.nombre = PQgetvalue(res, i, 0);
-                col.tipo_db = PQgetvalue(res, i, 1);
-                col.tipo_ts = mapearTipoDbATs(col.tipo_db);
-                col.es_nulo = std::string(PQgetvalue(res, i, 2)) == "YES";
-                col.es_pk = col.nombre == pk_col_name;
-                columnas.push_back(col);
-            }
+    if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::PostgreSQL) {
+        std::vector<std::unique_ptr<GestorBaseDatos>> conexiones;
+        conexiones.reserve(num_hilos - 1);
+        for (std::size_t h = 1; h < num_hilos; ++h) {
+            conexiones.push_back(std::make_unique<GestorBaseDatos>(motor_actual, info_conexion, db_name));
         }
-        PQclear(res);
+        ejecutarEnCorrutinas(num_hilos, nombres_tablas.size(), [&](std::size_t canal, std::size_t i) -> boost::asio::awaitable<void> {
+            GestorBaseDatos& conexion = canal == 0 ? *this : *conexiones[canal - 1];
+            resultados[i] = co_await conexion.consultarAsincrono(Dialecto::consultaColumnas(nombres_tablas[i]));
+            });
+        return resultados;
     }
-    else if (motor_actual == GestorAuditoria::MotorDB::SQLite) {
-        nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
-        while (res.next()) {
-            Columna col;
-            col.nombre = res.get<std::string>(1);
-            col.tipo_db = res.get<std::string>(2);
-            col.tipo_ts = mapearTipoDbATs(col.tipo_db);
-            col.es_nulo = res.get<int>(3) == 0;
-            col.es_pk = res.get<int>(5) == 1;
-            columnas.push_back(col);
+
+    std::atomic<std::size_t> siguiente{ 0 };
+    std::atomic<bool> cancelado{ false };
+    std::vector<std::exception_ptr> errores(num_hilos);
+    auto trabajar = [&](GestorBaseDatos& conexion) {
+        for (std::size_t i = siguiente++; i < nombres_tablas.size() && !cancelado; i = siguiente++) {
+            resultados[i] = (conexion.*conexion.ejecutor_consulta)(Dialecto::consultaColumnas(nombres_tablas[i]));
         }
-    }
-    else {
-        nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
-        while (res.next()) {
-            Columna col;
-            col.nombre = res.get<std::string>(0);
-            col.tipo_db = res.get<std::string>(1);
-            col.tipo_ts = mapearTipoDbATs(col.tipo_db);
-            col.es_nulo = res.get<std::string>(2) == "YES";
-            if (motor_actual == GestorAuditoria::MotorDB::MySQL) {
-                col.es_pk = res.get<std::string>(3) == "PRI";
+    };
+
+    std::vector<std::thread> hilos;
+    hilos.reserve(num_hilos - 1);
+    for (std::size_t h = 1; h < num_hilos; ++h) {
+        hilos.emplace_back([&, h] {
+            try {
+                GestorBaseDatos conexion(motor_actual, info_conexion, db_name);
+                trabajar(conexion);
             }
-            else {
-                col.es_pk = res.get<int>(3) == 1;
+            catch (...) {
+                errores[h] = std::current_exception();
+                cancelado = true;
             }
-            columnas.push_back(col);
-        }
+            });
     }
-    return columnas;
+    try {
+        trabajar(*this);
+    }
+    catch (...) {
+        errores[0] = std::current_exception();
+        cancelado = true;
+    }
+    for (auto& hilo : hilos) hilo.join();
+    for (const auto& error : errores) {
+        if (error) std::rethrow_exception(error);
+    }
+    return resultados;
 }
 
-void GestorBaseDatos::obtenerDependenciasFk(std::vector<Tabla>& tablas) {
-    for (auto& tabla : tablas) {
-        std::string consulta;
-        switch (motor_actual) {
-        case GestorAuditoria::MotorDB::PostgreSQL:
-            consulta = "SELECT kcu.column_name, ccu.table_name FROM information_schema.table_constraints tc JOIN information_schema.key_column_usage kcu ON tc.constraint_name = kcu.constraint_name JOIN information_schema.constraint_column_usage ccu ON ccu.constraint_name = tc.constraint_name WHERE tc.constraint_type = 'FOREIGN KEY' AND tc.table_name = '" + tabla.nombre + "';";
-            break;
-        case GestorAuditoria::MotorDB::MySQL:
-            consulta = "SELECT kcu.column_name, kcu.referenced_table_name FROM information_schema.key_column_usage kcu WHERE kcu.table_name = '" + tabla.nombre + "' AND kcu.table_schema = DATABASE() AND kcu.referenced_table_name IS NOT NULL;";
-            break;
-        case GestorAuditoria::MotorDB::SQLServer:
-            consulta = "SELECT col.name, ref_tab.name FROM sys.foreign_key_columns fk INNER JOIN sys.columns col ON fk.parent_object_id = col.object_id AND fk.parent_column_id = col.column_id INNER JOIN sys.tables tab ON fk.parent_object_id = tab.object_id INNER JOIN sys.tables ref_tab ON fk.referenced_object_id = ref_tab.object_id WHERE tab.name = '" + tabla.nombre + "';";
-            break;
-        default:
-            continue;
-        }
-
-        auto procesar_fk = [&](const std::string& col_local, const std::string& tabla_ref) {
-            tabla.dependencias_fk.push_back({ col_local, tabla_ref });
-            for (auto& col : tabla.columnas) {
-                if (col.nombre == col_local) {
-                    col.es_fk = true;
-                    break;
-                }
-            }
-            };
+std::vector<Columna> GestorBaseDatos::construirColumnas(ResultadoConsulta& resultado, InternadorNombres& nombres) {
+    std::vector<Columna> columnas;
+    columnas.reserve(resultado.filas.size());
+    for (auto& fila : resultado.filas) {
+        Columna col;
+        col.nombre = nombres.internar(fila[0]);
+        col.tipo_db = std::move(fila[1]);
+        col.tipo_ts = mapearTipoDbATs(col.tipo_db);
+        col.es_nulo = fila[2] == "YES";
+        col.es_pk = fila[3] == "1";
+        columnas.push_back(std::move(col));
+    }
+    return columnas;
+}
 
-        if (motor_actual == GestorAuditoria::MotorDB::PostgreSQL) {
-            PGresult* res = PQexec(conn_pg, consulta.c_str());
-            if (PQresultStatus(res) == PGRES_TUPLES_OK) {
-                for (int i = 0; i < PQntuples(res); ++i) {
-                    procesar_fk(PQgetvalue(res, i, 0), PQgetvalue(res, i, 1));
+template <typename Dialecto>
+void GestorBaseDatos::obtenerDependenciasFk(Esquema& esquema) {
+    if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::SQLite) {
+        return;
+    }
+    else {
+        for (auto& tabla : esquema.tablas) {
+            auto resultado = (this->*ejecutor_consulta)(Dialecto::consultaClavesForaneas(std::string(esquema.nombres.original(tabla.nombre))));
+            for (const auto& fila : resultado.filas) {
+                const IdNombre col_local = esquema.nombres.internar(fila[0]);
+                tabla.dependencias_fk.push_back({ col_local, esquema.nombres.internar(fila[1]) });
+                for (auto& col : tabla.columnas) {
+                    if (col.nombre == col_local) {
+                        col.es_fk = true;
+                        break;
+                    }
                 }
             }
-            PQclear(res);
-        }
-        else {
-            nanodbc::result res = nanodbc::execute(*conn_odbc, NANODBC_TEXT(consulta));
-            while (res.next()) {
-                procesar_fk(res.get<std::string>(0), res.get<std::string>(1));
-            }
         }
     }
 }
 
-void GestorBaseDatos::analizarDependenciasParaJwt(std::vector<Tabla>& tablas) {
+void GestorBaseDatos::analizarDependenciasParaJwt(Esquema& esquema) {
+    const InternadorNombres& nombres = esquema.nombres;
     Tabla* tabla_usuario = nullptr;
-    for (auto& tabla : tablas) {
-        std::string nombre_lower = boost::to_lower_copy(tabla.nombre);
-        if (nombre_lower.find("user") != std::string::npos || nombre_lower.find("usuario") != std::string::npos) {
+    for (auto& tabla : esquema.tablas) {
+        const std::string_view nombre_tabla = nombres.original(tabla.nombre);
+        if (boost::icontains(nombre_tabla, "user") || boost::icontains(nombre_tabla, "usuario")) {
             for (const auto& col : tabla.columnas) {
-                std::string col_lower = boost::to_lower_copy(col.nombre);
-                if (tabla.campo_email_encontrado.empty() && (col_lower.find("email") != std::string::npos || col_lower.find("correo") != std::string::npos || col_lower.find("username") != std::string::npos)) {
+                const std::string_view nombre_col = nombres.original(col.nombre);
+                if (tabla.campo_email_encontrado == NOMBRE_NULO && (boost::icontains(nombre_col, "email") || boost::icontains(nombre_col, "correo") || boost::icontains(nombre_col, "username"))) {
                     tabla.campo_email_encontrado = col.nombre;
                 }
-                if (tabla.campo_contrasena_encontrado.empty() && (col_lower.find("password") != std::string::npos || col_lower.find("contrasena") != std::string::npos)) {
+                if (tabla.campo_contrasena_encontrado == NOMBRE_NULO && (boost::icontains(nombre_col, "password") || boost::icontains(nombre_col, "contrasena"))) {
                     tabla.campo_contrasena_encontrado = col.nombre;
                 }
             }
-            if (!tabla.campo_email_encontrado.empty() && !tabla.campo_contrasena_encontrado.empty()) {
+            if (tabla.campo_email_encontrado != NOMBRE_NULO && tabla.campo_contrasena_encontrado != NOMBRE_NULO) {
                 tabla.es_tabla_usuario = true;
                 tabla_usuario = &tabla;
                 break;
@@ -258,54 +279,43 @@ void GestorBaseDatos::analizarDependenciasParaJwt(std::vector<Tabla>& tablas) {
     }
 
     if (tabla_usuario) {
-        std::vector<std::string> tablas_desprotegidas = { tabla_usuario->nombre };
-        std::function<void(const std::string&)> agregar_dependencias =
-            [&](const std::string& nombre_tabla) {
-            for (const auto& t : tablas) {
-                if (t.nombre == nombre_tabla) {
-                    for (const auto& dep : t.dependencias_fk) {
-                        if (std::find(tablas_desprotegidas.begin(), tablas_desprotegidas.end(), dep.tabla_referenciada) == tablas_desprotegidas.end()) {
-                            tablas_desprotegidas.push_back(dep.tabla_referenciada);
-                            agregar_dependencias(dep.tabla_referenciada);
-                        }
-                    }
-                }
-            }
-            };
-        agregar_dependencias(tabla_usuario->nombre);
-
-        for (auto& tabla : tablas) {
-            if (std::find(tablas_desprotegidas.begin(), tablas_desprotegidas.end(), tabla.nombre) == tablas_desprotegidas.end()) {
-                tabla.es_protegida = true;
-            }
-            else {
-                tabla.es_protegida = false;
-            }
+        const auto indice_usuario = static_cast<std::uint32_t>(tabla_usuario - esquema.tablas.data());
+        const std::vector<bool> desprotegidas = esquema.grafo.alcanzablesDesde(indice_usuario);
+        for (std::size_t i = 0; i < esquema.tablas.size(); ++i) {
+            esquema.tablas[i].es_protegida = !desprotegidas[i];
         }
     }
 }
 
-std::vector<Tabla> GestorBaseDatos::obtenerEsquemaTablas() {
-    std::vector<Tabla> tablas;
-    std::vector<std::string> nombres_tablas = obtenerNombresDeTablas();
+template <typename Dialecto>
+Esquema GestorBaseDatos::obtenerEsquemaTablas() {
+    Esquema esquema;
+    std::vector<std::string> nombres_tablas = obtenerNombresDeTablas<Dialecto>();
+    std::vector<ResultadoConsulta> columnas_por_tabla = leerColumnasDeTablas<Dialecto>(nombres_tablas);
+    esquema.tablas.reserve(nombres_tablas.size());
 
-    for (const auto& nombre_tabla : nombres_tablas) {
+    for (std::size_t i = 0; i < nombres_tablas.size(); ++i) {
         Tabla tabla;
-        tabla.nombre = nombre_tabla;
-        tabla.nombre_clase = aPascalCase(nombre_tabla);
-        tabla.nombre_variable = aCamelCase(nombre_tabla);
-        tabla.nombre_archivo = aKebabCase(tabla.nombre_clase);
-        tabla.columnas = obtenerColumnasParaTabla(nombre_tabla);
+        tabla.nombre = esquema.nombres.internar(nombres_tablas[i]);
+        tabla.columnas = construirColumnas(columnas_por_tabla[i], esquema.nombres);
         for (const auto& col : tabla.columnas) {
             if (col.es_pk) {
                 tabla.clave_primaria = col;
                 break;
             }
         }
-        tablas.push_back(tabla);
+        esquema.tablas.push_back(std::move(tabla));
     }
 
-    obtenerDependenciasFk(tablas);
-    analizarDependenciasParaJwt(tablas);
-    return tablas;
+    obtenerDependenciasFk<Dialecto>(esquema);
+    esquema.indexar();
+    analizarDependenciasParaJwt(esquema);
+    return esquema;
+}
+
+Esquema GestorBaseDatos::obtenerEsquemaTablas() {
+    MedicionFase medicion("esquema.obtenerEsquemaTablas");
+    return despacharDialecto(motor_actual, [this](auto dialecto) {
+        return obtenerEsquemaTablas<decltype(dialecto)>();
+        });
 }
\ No newline at end of file
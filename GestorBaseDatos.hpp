@@ -1,8 +1,10 @@
 #pragma once
+#include <utility>
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <boost/asio/awaitable.hpp>
 #include "Modelos.hpp"
 #include "GestorAuditoria.hpp"
 #include <libpq-fe.h>
@@ -13,18 +15,30 @@ public:
     GestorBaseDatos(GestorAuditoria::MotorDB motor, const std::string& info_conexion, const std::string& dbname);
     ~GestorBaseDatos();
     bool estaConectado();
-    std::vector<Tabla> obtenerEsquemaTablas();
+    void establecerHilosEsquema(unsigned int hilos) { hilos_esquema = hilos == 0 ? 1 : hilos; }
+    Esquema obtenerEsquemaTablas();
+    static void analizarDependenciasParaJwt(Esquema& esquema);
+    boost::asio::awaitable<ResultadoConsulta> consultarAsincrono(std::string consulta);
 
 private:
     GestorAuditoria::MotorDB motor_actual;
     std::string db_name;
+    std::string info_conexion;
+    unsigned int hilos_esquema = 1;
 
     PGconn* conn_pg = nullptr;
     std::unique_ptr<nanodbc::connection> conn_odbc;
 
+    using EjecutorConsulta = ResultadoConsulta (GestorBaseDatos::*)(const std::string&);
+    EjecutorConsulta ejecutor_consulta = nullptr;
+
+    ResultadoConsulta consultarPostgreSQL(const std::string& consulta);
+    ResultadoConsulta consultarOdbc(const std::string& consulta);
+
     std::string mapearTipoDbATs(const std::string& tipo_db);
-    std::vector<std::string> obtenerNombresDeTablas();
-    std::vector<Columna> obtenerColumnasParaTabla(const std::string& nombre_tabla);
-    void obtenerDependenciasFk(std::vector<Tabla>& tablas);
-    void analizarDependenciasParaJwt(std::vector<Tabla>& tablas);
+    template <typename Dialecto> std::vector<std::string> obtenerNombresDeTablas();
+    template <typename Dialecto> std::vector<ResultadoConsulta> leerColumnasDeTablas(const std::vector<std::string>& nombres_tablas);
+    std::vector<Columna> construirColumnas(ResultadoConsulta& resultado, InternadorNombres& nombres);
+    template <typename Dialecto> void obtenerDependenciasFk(Esquema& esquema);
+    template <typename Dialecto> Esquema obtenerEsquemaTablas();
 };
\ No newline at end of file
@@ -0,0 +1,705 @@
+#include "GestorCapturaLogica.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include "DialectoSql.hpp"
+#include "GestorCifrado.hpp"
+#include "GestorPlantillas.hpp"
+#include "Perfilador.hpp"
+#include "ValorCelda.hpp"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <sys/select.h>
+#endif
+
+namespace fs = std::filesystem;
+using Dialecto = DialectoSql<GestorAuditoria::MotorDB::PostgreSQL>;
+using ResultadoPg = std::unique_ptr<PGresult, decltype(&PQclear)>;
+
+namespace {
+
+constexpr std::size_t FILAS_POR_LOTE = 5000;
+constexpr auto INTERVALO_VACIADO = std::chrono::seconds(1);
+constexpr auto INTERVALO_ESTADO = std::chrono::seconds(10);
+constexpr std::int64_t MICROS_EPOCH_POSTGRES = 946684800LL * 1000000LL;
+constexpr const char* USUARIO_CAPTURA = "REPLICACION";
+
+std::atomic<bool> detencion_solicitada{ false };
+
+class LectorMensaje {
+public:
+    LectorMensaje(const char* datos, std::size_t longitud) : actual(datos), fin(datos + longitud) {}
+
+    std::uint8_t byte() {
+        exigir(1);
+        return static_cast<std::uint8_t>(*actual++);
+    }
+    std::uint16_t entero16() { return static_cast<std::uint16_t>(leerEntero(2)); }
+    std::uint32_t entero32() { return static_cast<std::uint32_t>(leerEntero(4)); }
+    std::uint64_t entero64() { return leerEntero(8); }
+
+    std::string cadena() {
+        const char* terminador = std::find(actual, fin, '\0');
+        if (terminador == fin) throw std::runtime_error("Mensaje de replicacion truncado.");
+        std::string resultado(actual, terminador);
+        actual = terminador + 1;
+        return resultado;
+    }
+    std::string bytes(std::size_t longitud) {
+        exigir(longitud);
+        std::string resultado(actual, longitud);
+        actual += longitud;
+        return resultado;
+    }
+    const char* posicion() const { return actual; }
+    std::size_t restante() const { return static_cast<std::size_t>(fin - actual); }
+
+private:
+    const char* actual;
+    const char* fin;
+
+    void exigir(std::size_t longitud) const {
+        if (static_cast<std::size_t>(fin - actual) < longitud) throw std::runtime_error("Mensaje de replicacion truncado.");
+    }
+    std::uint64_t leerEntero(std::size_t longitud) {
+        exigir(longitud);
+        std::uint64_t valor = 0;
+        for (std::size_t i = 0; i < longitud; ++i) valor = (valor << 8) | static_cast<unsigned char>(actual[i]);
+        actual += longitud;
+        return valor;
+    }
+};
+
+void escribirEntero64(char* destino, std::uint64_t valor) {
+    for (int i = 7; i >= 0; --i) {
+        destino[i] = static_cast<char>(valor & 0xFF);
+        valor >>= 8;
+    }
+}
+
+// Columnas 'u' (TOAST sin cambios) llegan sin valor; con REPLICA IDENTITY FULL
+// solo aparecen en la tupla nueva, que la captura usa para INSERT.
+std::vector<std::optional<std::string>> leerTupla(LectorMensaje& lector) {
+    const std::uint16_t num_columnas = lector.entero16();
+    std::vector<std::optional<std::string>> valores;
+    valores.reserve(num_columnas);
+    for (std::uint16_t i = 0; i < num_columnas; ++i) {
+        const char tipo = static_cast<char>(lector.byte());
+        if (tipo == 't' || tipo == 'b') valores.emplace_back(lector.bytes(lector.entero32()));
+        else valores.emplace_back(std::nullopt);
+    }
+    return valores;
+}
+
+std::string formatoLsn(std::uint64_t lsn) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%X/%X", static_cast<unsigned>(lsn >> 32), static_cast<unsigned>(lsn & 0xFFFFFFFF));
+    return buffer;
+}
+
+std::uint64_t interpretarLsn(const std::string& texto) {
+    unsigned alto = 0, bajo = 0;
+    if (std::sscanf(texto.c_str(), "%X/%X", &alto, &bajo) != 2) throw std::runtime_error("LSN no valido: " + texto);
+    return (static_cast<std::uint64_t>(alto) << 32) | bajo;
+}
+
+std::int64_t microsegundosPostgres() {
+    const auto ahora = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    return ahora - MICROS_EPOCH_POSTGRES;
+}
+
+void esperarSocket(PGconn* conexion, int milisegundos) {
+    const int descriptor = PQsocket(conexion);
+    if (descriptor < 0) throw std::runtime_error("La conexion de replicacion no tiene socket.");
+    fd_set lectura;
+    FD_ZERO(&lectura);
+#ifdef _WIN32
+    FD_SET(static_cast<SOCKET>(descriptor), &lectura);
+#else
+    FD_SET(descriptor, &lectura);
+#endif
+    timeval espera{ milisegundos / 1000, (milisegundos % 1000) * 1000 };
+    select(descriptor + 1, &lectura, nullptr, nullptr, &espera);
+}
+
+void validarNombreSlot(const std::string& slot) {
+    if (slot.empty() || slot.size() > 63 ||
+        slot.find_first_not_of("abcdefghijklmnopqrstuvwxyz0123456789_") != std::string::npos) {
+        throw std::runtime_error("Nombre de slot no valido: " + slot + ". Use minusculas, digitos y guion bajo.");
+    }
+}
+
+}
+
+GestorCapturaLogica::GestorCapturaLogica(const std::string& info_conexion, const std::string& db, Configuracion configuracion)
+    : info_conexion(info_conexion), configuracion(std::move(configuracion)) {
+    validarNombreSlot(this->configuracion.slot);
+    gestor_db = std::make_shared<GestorAuditoria>(GestorAuditoria::MotorDB::PostgreSQL, info_conexion, db);
+    if (!gestor_db->estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+    if (!this->configuracion.clave_encriptacion.empty()) {
+        gestor_cifrado = std::make_shared<GestorCifrado>(gestor_db, this->configuracion.clave_encriptacion);
+        gestor_cifrado->setFormatoCifrado(this->configuracion.formato_cifrado);
+        gestor_cifrado->setAlmacenamiento(this->configuracion.almacenamiento);
+        gestor_cifrado->setColumnasComprimidas(this->configuracion.columnas_comprimidas, this->configuracion.umbral_compresion);
+    }
+    if (this->configuracion.ruta_checkpoint.empty()) {
+        this->configuracion.ruta_checkpoint = "checkpoint_" + this->configuracion.slot + ".json";
+    }
+}
+
+GestorCapturaLogica::~GestorCapturaLogica() {
+    if (conn_replicacion) PQfinish(conn_replicacion);
+}
+
+// El slot se crea antes de quitar los triggers de auditoria, para que ningun
+// cambio quede sin auditar entre ambos pasos.
+void GestorCapturaLogica::ejecutar() {
+    preparar();
+    conectarReplicacion();
+    asegurarSlot();
+    leerCheckpoint();
+    if (configuracion.ruta_archivo.empty()) desactivarTriggers();
+    iniciarReplicacion();
+
+    detencion_solicitada.store(false);
+    auto manejador_anterior = std::signal(SIGINT, [](int) { detencion_solicitada.store(true); });
+    std::cout << "Capturando cambios desde " << formatoLsn(lsn_confirmado) << " con el slot " << configuracion.slot
+              << ". Ctrl+C para detener." << std::endl;
+
+    using Reloj = std::chrono::steady_clock;
+    auto ultimo_vaciado = Reloj::now();
+    auto ultimo_estado = Reloj::now();
+    auto ultima_actividad = Reloj::now();
+    const auto limite_inactividad = std::chrono::seconds(configuracion.segundos_inactividad);
+
+    try {
+        while (!detencion_solicitada.load()) {
+            char* buffer = nullptr;
+            const int longitud = PQgetCopyData(conn_replicacion, &buffer, 1);
+            if (longitud > 0) {
+                std::unique_ptr<char, void (*)(void*)> mensaje(buffer, &PQfreemem);
+                if (procesarMensaje(mensaje.get(), longitud)) ultima_actividad = Reloj::now();
+            }
+            else if (longitud == 0) {
+                esperarSocket(conn_replicacion, 100);
+                if (!PQconsumeInput(conn_replicacion)) throw std::runtime_error(PQerrorMessage(conn_replicacion));
+            }
+            else if (longitud == -1) {
+                throw std::runtime_error("El servidor termino el flujo de replicacion.");
+            }
+            else {
+                throw std::runtime_error(PQerrorMessage(conn_replicacion));
+            }
+
+            const auto ahora = Reloj::now();
+            if (lsn_lote > lsn_confirmado && (lote.size() >= FILAS_POR_LOTE || ahora - ultimo_vaciado >= INTERVALO_VACIADO)) {
+                vaciarLote();
+                ultimo_vaciado = ultimo_estado = ahora;
+            }
+            if (ahora - ultimo_estado >= INTERVALO_ESTADO) {
+                enviarEstado(false);
+                ultimo_estado = ahora;
+            }
+            if (configuracion.segundos_inactividad > 0 && ahora - ultima_actividad >= limite_inactividad) {
+                std::cout << "Sin cambios durante " << configuracion.segundos_inactividad << " s; se detiene la captura." << std::endl;
+                break;
+            }
+        }
+        vaciarLote();
+        PQputCopyEnd(conn_replicacion, nullptr);
+        PQflush(conn_replicacion);
+    }
+    catch (...) {
+        std::signal(SIGINT, manejador_anterior);
+        throw;
+    }
+    std::signal(SIGINT, manejador_anterior);
+    std::cout << "Captura detenida en " << formatoLsn(lsn_confirmado) << ". Checkpoint: " << configuracion.ruta_checkpoint << std::endl;
+}
+
+void GestorCapturaLogica::preparar() {
+    MedicionFase medicion("captura.preparar");
+    if (configuracion.tablas.empty()) configuracion.tablas = gestor_db->obtenerNombresDeTablas(false);
+    if (configuracion.tablas.empty()) throw std::runtime_error("No hay tablas para capturar.");
+
+    if (configuracion.ruta_archivo.empty()) {
+        if (!gestor_cifrado) {
+            for (const auto& tabla : configuracion.tablas) verificarAuditoriaSinCifrar(tabla);
+        }
+        gestor_db->ejecutarComando("CREATE TABLE IF NOT EXISTS " + Dialecto::tablaCalificada(TABLA_CHECKPOINT_CAPTURA) +
+            " (\"Slot\" TEXT NOT NULL, \"Tabla\" TEXT NOT NULL, \"Lsn\" PG_LSN NOT NULL, PRIMARY KEY (\"Slot\", \"Tabla\"))");
+        for (const auto& tabla : configuracion.tablas) prepararTablaAuditoria(tabla);
+    }
+    else {
+        archivo.open(configuracion.ruta_archivo, std::ios::binary | std::ios::app);
+        if (!archivo) throw std::runtime_error("No se pudo abrir el archivo de captura: " + configuracion.ruta_archivo);
+    }
+
+    std::string lista_tablas;
+    for (const auto& tabla : configuracion.tablas) {
+        gestor_db->ejecutarComando("ALTER TABLE " + Dialecto::tablaCalificada(tabla) + " REPLICA IDENTITY FULL");
+        if (!lista_tablas.empty()) lista_tablas += ", ";
+        Dialecto::tablaCalificada(lista_tablas, tabla);
+    }
+
+    const std::string publicacion = Dialecto::citar(configuracion.slot);
+    auto existente = gestor_db->ejecutarConsultaConResultado("SELECT 1 FROM pg_catalog.pg_publication WHERE pubname = '" + configuracion.slot + "'");
+    if (existente.filas.empty()) {
+        gestor_db->ejecutarComando("CREATE PUBLICATION " + publicacion + " FOR TABLE " + lista_tablas);
+    }
+    else {
+        gestor_db->ejecutarComando("ALTER PUBLICATION " + publicacion + " SET TABLE " + lista_tablas);
+    }
+}
+
+// Sin clave, la captura escribiria texto plano y columnas sin codificar en una
+// tabla aud_ cifrada; se rechaza antes de tocar triggers o esquemas.
+void GestorCapturaLogica::verificarAuditoriaSinCifrar(const std::string& tabla) {
+    auto trigger_cifrado = gestor_db->ejecutarConsultaConResultado(
+        "SELECT 1 FROM pg_catalog.pg_trigger WHERE tgrelid = '" + Dialecto::tablaCalificada(tabla) + "'::regclass "
+        "AND tgname = lower('" + tabla + "_aud_cifrado_trigger')");
+    auto columnas_auditoria = gestor_db->ejecutarConsultaConResultado(
+        "SELECT column_name FROM information_schema.columns WHERE table_schema = 'public' AND table_name = 'aud_" + tabla + "'");
+    const bool columnas_codificadas = !columnas_auditoria.filas.empty() &&
+        std::none_of(columnas_auditoria.filas.begin(), columnas_auditoria.filas.end(), [](const auto& fila) { return fila[0] == "AccionSql"; });
+    if (!trigger_cifrado.filas.empty() || columnas_codificadas) {
+        throw std::runtime_error("aud_" + tabla + " esta cifrada; indique --key para capturar sus cambios.");
+    }
+}
+
+void GestorCapturaLogica::prepararTablaAuditoria(const std::string& tabla) {
+    auto columnas_auditoria = gestor_db->ejecutarConsultaConResultado(
+        "SELECT column_name FROM information_schema.columns WHERE table_schema = 'public' AND table_name = 'aud_" + tabla + "'");
+    for (const auto& fila : columnas_auditoria.filas) {
+        if (fila[0] == COLUMNA_CAMBIOS_AUDITORIA) {
+            throw std::runtime_error("aud_" + tabla + " usa auditoria por diferencias; la captura logica escribe filas completas.");
+        }
+    }
+
+    auto columnas = gestor_db->ejecutarConsultaConResultado(
+        "SELECT a.attname, format_type(a.atttypid, a.atttypmod) FROM pg_catalog.pg_attribute a "
+        "WHERE a.attrelid = '" + Dialecto::tablaCalificada(tabla) + "'::regclass AND a.attnum > 0 AND NOT a.attisdropped ORDER BY a.attnum");
+    std::string definicion_columnas;
+    auto anexar_columna = [&](const std::string& nombre, const std::string& tipo) {
+        if (!definicion_columnas.empty()) definicion_columnas += ", ";
+        Dialecto::citar(definicion_columnas, gestor_cifrado ? gestor_cifrado->cifrarNombreColumna(nombre) : nombre);
+        definicion_columnas += ' ';
+        if (!gestor_cifrado) definicion_columnas += tipo;
+        else definicion_columnas += gestor_cifrado->almacenamientoBinario() ? Dialecto::tipo_binario : Dialecto::tipo_texto;
+    };
+    for (const auto& fila : columnas.filas) anexar_columna(fila[0], fila[1]);
+    for (const char* columna_control : { "UsuarioAccion", "FechaAccion", "AccionSql" }) anexar_columna(columna_control, "TEXT");
+
+    nlohmann::json datos;
+    datos["tabla"] = tabla;
+    datos["definicion_columnas"] = definicion_columnas;
+    gestor_db->ejecutarComando(GestorPlantillas::instancia().renderizar("PostgresAuditCaptura.tpl", datos));
+}
+
+void GestorCapturaLogica::conectarReplicacion() {
+    conn_replicacion = PQconnectdb((info_conexion + " replication=database").c_str());
+    if (PQstatus(conn_replicacion) != CONNECTION_OK) {
+        throw std::runtime_error("Error de conexion de replicacion: " + std::string(PQerrorMessage(conn_replicacion)));
+    }
+}
+
+void GestorCapturaLogica::asegurarSlot() {
+    auto existente = gestor_db->ejecutarConsultaConResultado(
+        "SELECT plugin, database FROM pg_catalog.pg_replication_slots WHERE slot_name = '" + configuracion.slot + "'");
+    if (!existente.filas.empty()) {
+        if (existente.filas[0][0] != "pgoutput") {
+            throw std::runtime_error("El slot " + configuracion.slot + " existe con el plugin " + existente.filas[0][0] + ".");
+        }
+        return;
+    }
+
+    ResultadoPg res(PQexec(conn_replicacion, ("CREATE_REPLICATION_SLOT " + Dialecto::citar(configuracion.slot) + " LOGICAL pgoutput").c_str()), &PQclear);
+    if (PQresultStatus(res.get()) != PGRES_TUPLES_OK) {
+        throw std::runtime_error("No se pudo crear el slot de replicacion: " + std::string(PQerrorMessage(conn_replicacion)));
+    }
+    std::cout << "Slot " << configuracion.slot << " creado en " << PQgetvalue(res.get(), 0, 1) << "." << std::endl;
+}
+
+// Los triggers se eliminan en una sola transaccion. DROP TRIGGER bloquea la
+// tabla, asi que las transacciones que la modificaron antes terminan antes del
+// LSN leido aqui (las audito el trigger) y las siguientes despues (las captura
+// el slot). Ese LSN queda como horizonte de la tabla en shc134_captura.
+void GestorCapturaLogica::desactivarTriggers() {
+    MedicionFase medicion("captura.desactivarTriggers");
+    std::vector<std::string> tablas_con_triggers;
+    gestor_db->ejecutarComando("BEGIN");
+    try {
+        for (const auto& tabla : configuracion.tablas) {
+            auto triggers = gestor_db->ejecutarConsultaConResultado(
+                "SELECT tgname FROM pg_catalog.pg_trigger WHERE tgrelid = '" + Dialecto::tablaCalificada(tabla) + "'::regclass "
+                "AND tgname IN (lower('" + tabla + "_aud_trigger'), lower('" + tabla + "_aud_cifrado_trigger'))");
+            for (const auto& fila : triggers.filas) {
+                gestor_db->ejecutarComando("DROP TRIGGER " + Dialecto::citar(fila[0]) + " ON " + Dialecto::tablaCalificada(tabla));
+            }
+            if (!triggers.filas.empty()) tablas_con_triggers.push_back(tabla);
+        }
+        if (!tablas_con_triggers.empty()) {
+            const std::string lsn = gestor_db->ejecutarConsultaConResultado("SELECT pg_current_wal_insert_lsn()").filas[0][0];
+            for (const auto& tabla : tablas_con_triggers) {
+                gestor_db->ejecutarComando(sentenciaGuardarLsn(tabla, lsn));
+                horizontes_triggers[tabla] = interpretarLsn(lsn);
+            }
+            std::cout << "Triggers de auditoria eliminados de " << tablas_con_triggers.size() << " tablas en " << lsn << "." << std::endl;
+        }
+        gestor_db->ejecutarComando("COMMIT");
+    }
+    catch (...) {
+        try {
+            gestor_db->ejecutarComando("ROLLBACK");
+        }
+        catch (const std::exception&) {
+        }
+        throw;
+    }
+}
+
+// Tabla vacia guarda el LSN confirmado del slot; las demas, el horizonte hasta
+// el que esa tabla la auditaban sus triggers.
+std::string GestorCapturaLogica::sentenciaGuardarLsn(const std::string& tabla, const std::string& lsn) const {
+    std::string sentencia = "INSERT INTO " + Dialecto::tablaCalificada(TABLA_CHECKPOINT_CAPTURA) + " (\"Slot\", \"Tabla\", \"Lsn\") VALUES (";
+    Dialecto::literal(sentencia, configuracion.slot);
+    sentencia += ", ";
+    Dialecto::literal(sentencia, tabla);
+    sentencia += ", ";
+    Dialecto::literal(sentencia, lsn);
+    return sentencia + ") ON CONFLICT (\"Slot\", \"Tabla\") DO UPDATE SET \"Lsn\" = EXCLUDED.\"Lsn\"";
+}
+
+void GestorCapturaLogica::iniciarReplicacion() {
+    const std::string comando = "START_REPLICATION SLOT " + Dialecto::citar(configuracion.slot) + " LOGICAL " + formatoLsn(lsn_confirmado) +
+        " (proto_version '1', publication_names '" + Dialecto::citar(configuracion.slot) + "')";
+    ResultadoPg res(PQexec(conn_replicacion, comando.c_str()), &PQclear);
+    if (PQresultStatus(res.get()) != PGRES_COPY_BOTH) {
+        throw std::runtime_error("No se pudo iniciar la replicacion: " + std::string(PQerrorMessage(conn_replicacion)));
+    }
+}
+
+bool GestorCapturaLogica::procesarMensaje(const char* datos, int longitud) {
+    LectorMensaje lector(datos, static_cast<std::size_t>(longitud));
+    const char tipo = static_cast<char>(lector.byte());
+    if (tipo == 'w') {
+        const std::uint64_t inicio = lector.entero64();
+        lector.entero64();
+        lector.entero64();
+        lsn_recibido = std::max(lsn_recibido, inicio);
+        Perfilador::sumar(ContadorPerfil::Bytes, lector.restante());
+        procesarPgoutput(lector.posicion(), lector.restante());
+        return true;
+    }
+    if (tipo == 'k') {
+        lsn_recibido = std::max(lsn_recibido, lector.entero64());
+        lector.entero64();
+        if (lector.byte()) enviarEstado(false);
+    }
+    return false;
+}
+
+// Mensajes del protocolo pgoutput version 1. Las filas de una transaccion pasan
+// al lote solo al recibir su COMMIT; las ya confirmadas en el checkpoint se
+// descartan, porque el servidor puede reenviar desde un LSN anterior, igual que
+// las de tablas cuyo trigger de auditoria seguia activo en ese COMMIT.
+void GestorCapturaLogica::procesarPgoutput(const char* datos, std::size_t longitud) {
+    LectorMensaje lector(datos, longitud);
+    const char tipo = static_cast<char>(lector.byte());
+    switch (tipo) {
+    case 'B': {
+        lector.entero64();
+        const auto marca = static_cast<std::int64_t>(lector.entero64());
+        fecha_transaccion = valorATexto(FechaHora{ marca + MICROS_EPOCH_POSTGRES });
+        transaccion.clear();
+        break;
+    }
+    case 'C': {
+        lector.byte();
+        lector.entero64();
+        const std::uint64_t lsn_fin = lector.entero64();
+        if (lsn_fin > lsn_confirmado) {
+            for (auto& fila : transaccion) {
+                auto horizonte = horizontes_triggers.find(fila.relacion->tabla);
+                if (horizonte == horizontes_triggers.end() || lsn_fin > horizonte->second) lote.push_back(std::move(fila));
+            }
+            lsn_lote = std::max(lsn_lote, lsn_fin);
+        }
+        transaccion.clear();
+        break;
+    }
+    case 'R': {
+        const std::uint32_t id = lector.entero32();
+        lector.cadena();
+        auto relacion = std::make_shared<Relacion>();
+        relacion->tabla = lector.cadena();
+        lector.byte();
+        const std::uint16_t num_columnas = lector.entero16();
+        for (std::uint16_t i = 0; i < num_columnas; ++i) {
+            lector.byte();
+            relacion->columnas.push_back(lector.cadena());
+            lector.entero32();
+            lector.entero32();
+        }
+        registrarRelacion(id, std::move(relacion));
+        break;
+    }
+    case 'I':
+    case 'U':
+    case 'D': {
+        auto relacion = relaciones.find(lector.entero32());
+        if (relacion == relaciones.end()) throw std::runtime_error("Cambio recibido para una relacion desconocida.");
+        char marca = static_cast<char>(lector.byte());
+        std::vector<std::optional<std::string>> valores;
+        if (marca == 'K' || marca == 'O') {
+            valores = leerTupla(lector);
+            if (tipo == 'U' && marca == 'K') valores.clear();
+            if (tipo == 'U') marca = static_cast<char>(lector.byte());
+        }
+        if (tipo != 'D' && valores.empty()) valores = leerTupla(lector);
+        const char* accion = tipo == 'I' ? "Insertado" : tipo == 'U' ? "Modificado" : "Eliminado";
+        transaccion.push_back({ relacion->second, accion, fecha_transaccion, std::move(valores) });
+        Perfilador::sumar(ContadorPerfil::Filas);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// Si la tabla tiene columnas que aun no existen en aud_ (se agregaron despues de
+// preparar la captura), se crean como texto (o binario, si se cifra en binario)
+// antes de escribir filas con ellas.
+void GestorCapturaLogica::registrarRelacion(std::uint32_t id, std::shared_ptr<const Relacion> relacion) {
+    auto& registrada = relaciones[id];
+    const bool sin_cambios = registrada && registrada->columnas == relacion->columnas;
+    registrada = std::move(relacion);
+    if (sin_cambios || !configuracion.ruta_archivo.empty()) return;
+
+    const std::string tabla_auditoria = "aud_" + registrada->tabla;
+    auto existentes = gestor_db->ejecutarConsultaConResultado(
+        "SELECT column_name FROM information_schema.columns WHERE table_schema = 'public' AND table_name = '" + tabla_auditoria + "'");
+    for (const auto& columna : registrada->columnas) {
+        const std::string nombre = gestor_cifrado ? gestor_cifrado->cifrarNombreColumna(columna) : columna;
+        const bool existe = std::any_of(existentes.filas.begin(), existentes.filas.end(), [&](const auto& fila) { return fila[0] == nombre; });
+        if (!existe) {
+            const bool binario = gestor_cifrado && gestor_cifrado->almacenamientoBinario();
+            gestor_db->ejecutarComando("ALTER TABLE " + Dialecto::tablaCalificada(tabla_auditoria) + " ADD COLUMN " + Dialecto::citar(nombre) + " " +
+                std::string(binario ? Dialecto::tipo_binario : Dialecto::tipo_texto));
+        }
+    }
+}
+
+void GestorCapturaLogica::vaciarLote() {
+    if (lsn_lote <= lsn_confirmado) return;
+    MedicionFase medicion("captura.vaciarLote");
+    if (configuracion.ruta_archivo.empty()) escribirLoteEnTablas();
+    else if (!lote.empty()) escribirLoteEnArchivo();
+    if (!lote.empty()) std::cout << lote.size() << " filas de auditoria capturadas hasta " << formatoLsn(lsn_lote) << "." << std::endl;
+    lote.clear();
+    lsn_confirmado = lsn_lote;
+    if (!configuracion.ruta_archivo.empty()) escribirCheckpoint();
+    enviarEstado(false);
+}
+
+// El LSN del lote se guarda en la misma transaccion que sus filas, de modo que
+// un corte entre ambos no vuelva a insertar el lote al reanudar.
+void GestorCapturaLogica::escribirLoteEnTablas() {
+    std::vector<std::string> sentencias;
+    std::vector<bool> procesada(lote.size(), false);
+    for (std::size_t inicio = 0; inicio < lote.size(); ++inicio) {
+        if (procesada[inicio]) continue;
+        const Relacion* relacion = lote[inicio].relacion.get();
+        const std::string tabla_auditoria = "aud_" + relacion->tabla;
+        // En GCM cada celda se liga a su IdAuditoria, que por eso se reserva
+        // de la secuencia antes de cifrar en lugar de dejarlo al DEFAULT.
+        const bool con_contexto = gestor_cifrado && gestor_cifrado->cifradoAutenticado();
+
+        std::string encabezado = Dialecto::sentenciaInsercion(tabla_auditoria);
+        auto anexar_columna = [&](const std::string& columna) {
+            Dialecto::citar(encabezado, gestor_cifrado ? gestor_cifrado->cifrarNombreColumna(columna) : columna);
+        };
+        for (const auto& columna : relacion->columnas) {
+            anexar_columna(columna);
+            encabezado += ", ";
+        }
+        anexar_columna("UsuarioAccion");
+        encabezado += ", ";
+        anexar_columna("FechaAccion");
+        encabezado += ", ";
+        anexar_columna("AccionSql");
+        if (con_contexto) {
+            encabezado += ", ";
+            Dialecto::citar(encabezado, COLUMNA_SECUENCIA_AUDITORIA);
+        }
+        encabezado += ") VALUES ";
+
+        std::vector<bool> comprimir;
+        for (const auto& columna : relacion->columnas) comprimir.push_back(gestor_cifrado && gestor_cifrado->columnaComprimida(columna));
+
+        std::vector<std::size_t> filas;
+        for (std::size_t i = inicio; i < lote.size(); ++i) {
+            if (procesada[i] || lote[i].relacion.get() != relacion) continue;
+            procesada[i] = true;
+            filas.push_back(i);
+        }
+
+        std::string consulta_ids;
+        if (con_contexto) {
+            consulta_ids = "SELECT nextval(pg_get_serial_sequence(";
+            Dialecto::literal(consulta_ids, Dialecto::tablaCalificada(tabla_auditoria));
+            consulta_ids += ", ";
+            Dialecto::literal(consulta_ids, COLUMNA_SECUENCIA_AUDITORIA);
+            consulta_ids += ")) AS id FROM generate_series(1, ";
+        }
+
+        // Los valores de cada sentencia se cifran con una sola llamada a
+        // cifrarValores, en el mismo orden en que se anexan.
+        const auto valores_fila = [&](const FilaCapturada& fila, auto&& al_valor) {
+            for (std::size_t c = 0; c < relacion->columnas.size(); ++c) {
+                al_valor(c < fila.valores.size() ? fila.valores[c] : std::nullopt, comprimir[c], relacion->columnas[c]);
+            }
+            al_valor(std::string(USUARIO_CAPTURA), false, "UsuarioAccion");
+            al_valor(fila.fecha, false, "FechaAccion");
+            al_valor(std::string(fila.accion), false, "AccionSql");
+        };
+        for (std::size_t desde = 0; desde < filas.size(); desde += Dialecto::filas_por_insercion) {
+            const std::size_t hasta = std::min(filas.size(), desde + Dialecto::filas_por_insercion);
+            std::vector<std::string> ids;
+            if (con_contexto) {
+                for (auto& fila : gestor_db->ejecutarConsultaConResultado(consulta_ids + std::to_string(hasta - desde) + ") ORDER BY id").filas) ids.push_back(std::move(fila[0]));
+                if (ids.size() != hasta - desde) throw std::runtime_error("No se pudieron reservar valores de " + std::string(COLUMNA_SECUENCIA_AUDITORIA) + " para " + tabla_auditoria + ".");
+            }
+            std::vector<std::string> cifrados;
+            if (gestor_cifrado) {
+                std::vector<std::string> textos;
+                std::vector<bool> comprimir_textos;
+                std::vector<std::string> contextos;
+                for (std::size_t f = desde; f < hasta; ++f) {
+                    valores_fila(lote[filas[f]], [&](const std::optional<std::string>& valor, bool comprimir_valor, const std::string& columna) {
+                        if (!valor) return;
+                        textos.push_back(*valor);
+                        comprimir_textos.push_back(comprimir_valor);
+                        if (con_contexto) contextos.push_back(GestorCifrado::contextoCelda(tabla_auditoria, columna, ids[f - desde]));
+                    });
+                }
+                cifrados = gestor_cifrado->cifrarValores(textos, comprimir_textos, contextos);
+            }
+
+            std::string sentencia = encabezado;
+            std::size_t siguiente_cifrado = 0;
+            for (std::size_t f = desde; f < hasta; ++f) {
+                if (f > desde) sentencia += ", ";
+                sentencia += '(';
+                bool primero = true;
+                valores_fila(lote[filas[f]], [&](const std::optional<std::string>& valor, bool, const std::string&) {
+                    if (!primero) sentencia += ", ";
+                    primero = false;
+                    if (!valor) sentencia += "NULL";
+                    else if (gestor_cifrado) Dialecto::literalCifrado(sentencia, cifrados[siguiente_cifrado++], gestor_cifrado->almacenamientoBinario());
+                    else Dialecto::literal(sentencia, *valor);
+                });
+                if (con_contexto) sentencia += ", " + ids[f - desde];
+                sentencia += ')';
+            }
+            sentencias.push_back(std::move(sentencia));
+        }
+    }
+    const std::string lsn = formatoLsn(lsn_lote);
+    sentencias.push_back(sentenciaGuardarLsn("", lsn));
+    std::string limpieza = "DELETE FROM " + Dialecto::tablaCalificada(TABLA_CHECKPOINT_CAPTURA) + " WHERE \"Slot\" = ";
+    Dialecto::literal(limpieza, configuracion.slot);
+    limpieza += " AND \"Tabla\" <> '' AND \"Lsn\" < ";
+    Dialecto::literal(limpieza, lsn);
+    sentencias.push_back(std::move(limpieza));
+
+    gestor_db->ejecutarComando("BEGIN");
+    try {
+        for (const auto& sentencia : sentencias) gestor_db->ejecutarComando(sentencia);
+        gestor_db->ejecutarComando("COMMIT");
+    }
+    catch (...) {
+        try {
+            gestor_db->ejecutarComando("ROLLBACK");
+        }
+        catch (const std::exception&) {
+        }
+        throw;
+    }
+}
+
+void GestorCapturaLogica::escribirLoteEnArchivo() {
+    std::string salida;
+    for (const auto& fila : lote) {
+        nlohmann::json valores = nlohmann::json::object();
+        for (std::size_t c = 0; c < fila.relacion->columnas.size(); ++c) {
+            const auto& valor = c < fila.valores.size() ? fila.valores[c] : std::nullopt;
+            if (!valor) valores[fila.relacion->columnas[c]] = nullptr;
+            else valores[fila.relacion->columnas[c]] = gestor_cifrado ? gestor_cifrado->cifrarValor(*valor, gestor_cifrado->columnaComprimida(fila.relacion->columnas[c])) : *valor;
+        }
+        nlohmann::json registro = {
+            {"tabla", fila.relacion->tabla},
+            {"accion", fila.accion},
+            {"fecha", fila.fecha},
+            {"usuario", USUARIO_CAPTURA},
+            {"fila", std::move(valores)}
+        };
+        salida += registro.dump();
+        salida += '\n';
+    }
+    archivo.write(salida.data(), static_cast<std::streamsize>(salida.size()));
+    archivo.flush();
+    if (!archivo) throw std::runtime_error("No se pudo escribir en el archivo de captura: " + configuracion.ruta_archivo);
+}
+
+void GestorCapturaLogica::enviarEstado(bool solicitar_respuesta) {
+    char mensaje[34];
+    mensaje[0] = 'r';
+    escribirEntero64(mensaje + 1, std::max(lsn_recibido, lsn_confirmado));
+    escribirEntero64(mensaje + 9, lsn_confirmado);
+    escribirEntero64(mensaje + 17, lsn_confirmado);
+    escribirEntero64(mensaje + 25, static_cast<std::uint64_t>(microsegundosPostgres()));
+    mensaje[33] = solicitar_respuesta ? 1 : 0;
+    if (PQputCopyData(conn_replicacion, mensaje, sizeof(mensaje)) != 1 || PQflush(conn_replicacion) != 0) {
+        throw std::runtime_error("No se pudo enviar el estado de replicacion: " + std::string(PQerrorMessage(conn_replicacion)));
+    }
+}
+
+void GestorCapturaLogica::leerCheckpoint() {
+    if (configuracion.ruta_archivo.empty()) {
+        auto filas = gestor_db->ejecutarConsultaConResultado("SELECT \"Tabla\", \"Lsn\" FROM " +
+            Dialecto::tablaCalificada(TABLA_CHECKPOINT_CAPTURA) + " WHERE \"Slot\" = '" + configuracion.slot + "'");
+        for (const auto& fila : filas.filas) {
+            if (fila[0].empty()) lsn_confirmado = interpretarLsn(fila[1]);
+            else horizontes_triggers[fila[0]] = interpretarLsn(fila[1]);
+        }
+        lsn_lote = lsn_confirmado;
+        return;
+    }
+    std::ifstream entrada(configuracion.ruta_checkpoint);
+    if (!entrada) return;
+    const nlohmann::json checkpoint = nlohmann::json::parse(entrada);
+    if (checkpoint.value("slot", std::string()) != configuracion.slot) {
+        throw std::runtime_error("El checkpoint " + configuracion.ruta_checkpoint + " pertenece a otro slot.");
+    }
+    lsn_confirmado = interpretarLsn(checkpoint.at("lsn").get<std::string>());
+    lsn_lote = lsn_confirmado;
+}
+
+void GestorCapturaLogica::escribirCheckpoint() const {
+    const std::string ruta_temporal = configuracion.ruta_checkpoint + ".tmp";
+    {
+        std::ofstream archivo_temporal(ruta_temporal, std::ios::trunc);
+        archivo_temporal << nlohmann::json{ {"slot", configuracion.slot}, {"lsn", formatoLsn(lsn_confirmado)} }.dump(2);
+        if (!archivo_temporal) throw std::runtime_error("No se pudo escribir el checkpoint: " + ruta_temporal);
+    }
+    fs::rename(ruta_temporal, configuracion.ruta_checkpoint);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <libpq-fe.h>
+#include "GestorAuditoria.hpp"
+#include "GestorCifrado.hpp"
+
+// Captura de auditoria sin triggers: consume el flujo de cambios de un slot de
+// replicacion logica (plugin pgoutput) y escribe las filas por lotes en las
+// tablas aud_ o en un archivo NDJSON. El ultimo LSN confirmado se guarda en la
+// tabla shc134_captura, en la misma transaccion que el lote (o en un archivo de
+// checkpoint con NDJSON), y se informa al servidor para liberar WAL.
+class GestorCapturaLogica {
+public:
+    struct Configuracion {
+        std::string slot = "shc134_auditoria";
+        std::vector<std::string> tablas;
+        std::string ruta_archivo;
+        std::string ruta_checkpoint;
+        std::string clave_encriptacion;
+        GestorCifrado::FormatoCifrado formato_cifrado = GestorCifrado::FormatoCifrado::Cbc;
+        GestorCifrado::AlmacenamientoCifrado almacenamiento = GestorCifrado::AlmacenamientoCifrado::Hexadecimal;
+        std::string columnas_comprimidas;
+        std::size_t umbral_compresion = 256;
+        unsigned int segundos_inactividad = 0;
+    };
+
+    GestorCapturaLogica(const std::string& info_conexion, const std::string& db, Configuracion configuracion);
+    ~GestorCapturaLogica();
+    GestorCapturaLogica(const GestorCapturaLogica&) = delete;
+    GestorCapturaLogica& operator=(const GestorCapturaLogica&) = delete;
+
+    void ejecutar();
+
+private:
+    struct Relacion {
+        std::string tabla;
+        std::vector<std::string> columnas;
+    };
+    struct FilaCapturada {
+        std::shared_ptr<const Relacion> relacion;
+        const char* accion;
+        std::string fecha;
+        std::vector<std::optional<std::string>> valores;
+    };
+
+    std::string info_conexion;
+    Configuracion configuracion;
+    std::shared_ptr<GestorAuditoria> gestor_db;
+    std::shared_ptr<GestorCifrado> gestor_cifrado;
+    PGconn* conn_replicacion = nullptr;
+    std::ofstream archivo;
+
+    std::unordered_map<std::uint32_t, std::shared_ptr<const Relacion>> relaciones;
+    std::vector<FilaCapturada> transaccion;
+    std::vector<FilaCapturada> lote;
+    std::string fecha_transaccion;
+    std::uint64_t lsn_recibido = 0;
+    std::uint64_t lsn_lote = 0;
+    std::uint64_t lsn_confirmado = 0;
+    std::unordered_map<std::string, std::uint64_t> horizontes_triggers;
+
+    void preparar();
+    void verificarAuditoriaSinCifrar(const std::string& tabla);
+    void prepararTablaAuditoria(const std::string& tabla);
+    void conectarReplicacion();
+    void asegurarSlot();
+    void desactivarTriggers();
+    std::string sentenciaGuardarLsn(const std::string& tabla, const std::string& lsn) const;
+    void iniciarReplicacion();
+    bool procesarMensaje(const char* datos, int longitud);
+    void procesarPgoutput(const char* datos, std::size_t longitud);
+    void registrarRelacion(std::uint32_t id, std::shared_ptr<const Relacion> relacion);
+    void vaciarLote();
+    void escribirLoteEnTablas();
+    void escribirLoteEnArchivo();
+    void enviarEstado(bool solicitar_respuesta);
+    void leerCheckpoint();
+    void escribirCheckpoint() const;
+};
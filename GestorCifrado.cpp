@@ -1,37 +1,89 @@
 #include "GestorCifrado.hpp"
 #include "GestorAuditoria.hpp"
+#include "DialectoSql.hpp"
+#include "Perfilador.hpp"
+#include "GestorPlantillas.hpp"
 #include <openssl/evp.h>
 #include <openssl/aes.h>
 #include <openssl/rand.h>
+#include <openssl/hmac.h>
+#include <zstd.h>
 #include <stdexcept>
 #include <sstream>
-#include <iomanip>
 #include <iostream>
 #include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <map>
+#include <set>
+#include <charconv>
+
+namespace {
+
+constexpr char DIGITOS_HEX[] = "0123456789abcdef";
+constexpr size_t FILAS_POR_BLOQUE_MIGRACION = 5000;
+constexpr size_t CAMBIOS_MAXIMOS_EN_BLOQUEO = 1000;
+
+// Vector de prueba del indice ciego ("Año €" en UTF-8) y el mismo texto armado
+// en T-SQL por puntos de codigo, sin depender de la codificacion del cliente.
+constexpr const char* VECTOR_INDICE_CIEGO = "A\xC3\xB1o \xE2\x82\xAC";
+constexpr const char* VECTOR_INDICE_CIEGO_SQLSERVER = "N'A' + NCHAR(241) + N'o ' + NCHAR(8364)";
+
+struct TablaHex {
+    signed char valores[256];
+    constexpr TablaHex() : valores() {
+        for (int i = 0; i < 256; ++i) valores[i] = -1;
+        for (int i = 0; i < 10; ++i) valores['0' + i] = static_cast<signed char>(i);
+        for (int i = 0; i < 6; ++i) {
+            valores['a' + i] = static_cast<signed char>(10 + i);
+            valores['A' + i] = static_cast<signed char>(10 + i);
+        }
+    }
+};
+constexpr TablaHex TABLA_HEX;
+
+int valorHex(char c) {
+    return TABLA_HEX.valores[static_cast<unsigned char>(c)];
+}
+
+void anexarHex(std::string& salida, const unsigned char* datos, size_t longitud) {
+    const size_t inicio = salida.size();
+    salida.resize(inicio + longitud * 2);
+    char* destino = salida.data() + inicio;
+    for (size_t i = 0; i < longitud; ++i) {
+        destino[2 * i] = DIGITOS_HEX[datos[i] >> 4];
+        destino[2 * i + 1] = DIGITOS_HEX[datos[i] & 0x0F];
+    }
+}
+
+bool decodificarHex(std::string_view hex, std::vector<unsigned char>& destino) {
+    if (hex.size() % 2 != 0) return false;
+    destino.resize(hex.size() / 2);
+    for (size_t i = 0; i < destino.size(); ++i) {
+        const int alto = valorHex(hex[2 * i]);
+        const int bajo = valorHex(hex[2 * i + 1]);
+        if (alto < 0 || bajo < 0) return false;
+        destino[i] = static_cast<unsigned char>((alto << 4) | bajo);
+    }
+    return true;
+}
+
+}
 
 std::vector<unsigned char> hexABytes(const std::string& hex) {
     std::vector<unsigned char> bytes;
     if (hex.length() % 2 != 0) {
         throw std::invalid_argument("La cadena hexadecimal debe tener una longitud par.");
     }
-    bytes.reserve(hex.length() / 2);
-    for (unsigned int i = 0; i < hex.length(); i += 2) {
-        std::string byteString = hex.substr(i, 2);
-        unsigned char byte = (unsigned char)strtol(byteString.c_str(), NULL, 16);
-        bytes.push_back(byte);
+    if (!decodificarHex(hex, bytes)) {
+        throw std::invalid_argument("La cadena contiene caracteres que no son hexadecimales.");
     }
     return bytes;
 }
 
 std::string bytesAHex(const unsigned char* data, size_t len) {
-    std::stringstream ss;
-    ss << std::hex << std::setfill('0');
-    for (size_t i = 0; i < len; ++i) {
-        ss << std::setw(2) << static_cast<unsigned>(data[i]);
-    }
-    return ss.str();
+    std::string hex;
+    anexarHex(hex, data, len);
+    return hex;
 }
 
 std::string cifrarNombreColumnaCesar(const std::string& texto_plano, int desplazamiento) {
@@ -80,12 +132,360 @@ std::string descifrarNombreColumnaCesar(const std::string& texto_cifrado, int de
     return resultado;
 }
 
+namespace {
+
+const std::string PREFIJO_INDICE_CIEGO = "IndiceCiego_";
+constexpr std::string_view PREFIJO_CELDA_GCM = "v2:";
+constexpr std::string_view PREFIJO_CELDA_GCM_LIGADA = "v3:";
+constexpr char SEPARADOR_CONTEXTO_CELDA = '\x1f';
+constexpr size_t LONGITUD_NONCE_GCM = 12;
+constexpr size_t LONGITUD_ETIQUETA_GCM = 16;
+constexpr size_t BYTES_INDICE_CIEGO = 16;
+constexpr size_t BLOQUE_SHA256 = 64;
+// Cabecera del texto plano comprimido con zstd antes de cifrar. Los valores de
+// auditoria son texto y no contienen el byte nulo, asi que no se confunden.
+constexpr std::string_view CABECERA_COMPRIMIDO("\0zs", 3);
+constexpr int NIVEL_ZSTD_CELDA = 3;
+// Tope del texto descomprimido: el tamano declarado en la trama no se reserva si
+// lo supera, para que una celda manipulada no pida gigabytes de memoria.
+constexpr unsigned long long MAXIMO_CELDA_DESCOMPRIMIDA = 64ull * 1024 * 1024;
+
+std::vector<unsigned char> hmacSha256(const std::vector<unsigned char>& clave, const std::string& datos) {
+    std::vector<unsigned char> salida(EVP_MAX_MD_SIZE);
+    unsigned int longitud = 0;
+    if (!HMAC(EVP_sha256(), clave.data(), static_cast<int>(clave.size()),
+        reinterpret_cast<const unsigned char*>(datos.data()), datos.size(), salida.data(), &longitud)) {
+        throw std::runtime_error("Error al calcular el HMAC del indice ciego.");
+    }
+    salida.resize(longitud);
+    return salida;
+}
+
+// Clave del HMAC rellenada al bloque de SHA-256 y combinada con ipad/opad, para
+// que los motores sin funcion HMAC nativa lo calculen con dos hashes anidados.
+std::string claveHmacCombinada(const std::vector<unsigned char>& clave, unsigned char relleno) {
+    std::vector<unsigned char> bloque(BLOQUE_SHA256, relleno);
+    for (size_t i = 0; i < clave.size(); ++i) bloque[i] ^= clave[i];
+    return bytesAHex(bloque.data(), bloque.size());
+}
+
+// Deja en salida la cabecera y el valor comprimido; falso si no ocupa menos o si
+// supera el tope que acepta descomprimirCelda, y entonces se guarda sin comprimir.
+bool comprimirCelda(std::string_view texto, std::string& salida) {
+    if (texto.size() > MAXIMO_CELDA_DESCOMPRIMIDA) return false;
+    salida.resize(CABECERA_COMPRIMIDO.size() + ZSTD_compressBound(texto.size()));
+    std::copy(CABECERA_COMPRIMIDO.begin(), CABECERA_COMPRIMIDO.end(), salida.begin());
+    const size_t tamano = ZSTD_compress(salida.data() + CABECERA_COMPRIMIDO.size(), salida.size() - CABECERA_COMPRIMIDO.size(),
+        texto.data(), texto.size(), NIVEL_ZSTD_CELDA);
+    if (ZSTD_isError(tamano) || CABECERA_COMPRIMIDO.size() + tamano >= texto.size()) return false;
+    salida.resize(CABECERA_COMPRIMIDO.size() + tamano);
+    return true;
+}
+
+// Contexto de descompresion reutilizado entre celdas; se crea con la primera
+// celda comprimida, ya que la mayoria de lotes no tiene ninguna.
+class ContextoZstd {
+public:
+    ContextoZstd() = default;
+    ~ContextoZstd() { ZSTD_freeDCtx(ctx); }
+    ContextoZstd(const ContextoZstd&) = delete;
+    ContextoZstd& operator=(const ContextoZstd&) = delete;
+
+    ZSTD_DCtx* get() {
+        if (!ctx && !(ctx = ZSTD_createDCtx())) throw std::runtime_error("Fallo al crear el contexto de descompresion zstd.");
+        return ctx;
+    }
+
+private:
+    ZSTD_DCtx* ctx = nullptr;
+};
+
+std::string descomprimirCelda(std::string plano, ContextoZstd& contexto) {
+    if (!boost::starts_with(plano, CABECERA_COMPRIMIDO)) return plano;
+    const char* datos = plano.data() + CABECERA_COMPRIMIDO.size();
+    const size_t longitud = plano.size() - CABECERA_COMPRIMIDO.size();
+    const unsigned long long tamano = ZSTD_getFrameContentSize(datos, longitud);
+    if (tamano == ZSTD_CONTENTSIZE_ERROR || tamano == ZSTD_CONTENTSIZE_UNKNOWN || tamano > MAXIMO_CELDA_DESCOMPRIMIDA) {
+        return "[ERROR_DESCOMPRESION]";
+    }
+    std::string texto(static_cast<size_t>(tamano), '\0');
+    const size_t escrito = ZSTD_decompressDCtx(contexto.get(), texto.data(), texto.size(), datos, longitud);
+    if (ZSTD_isError(escrito) || escrito != tamano) return "[ERROR_DESCOMPRESION]";
+    return texto;
+}
+
+class ContextoEvp {
+public:
+    ContextoEvp() : ctx(EVP_CIPHER_CTX_new()) {
+        if (!ctx) throw std::runtime_error("Fallo al crear el contexto de cifrado EVP.");
+    }
+    ~ContextoEvp() { EVP_CIPHER_CTX_free(ctx); }
+    ContextoEvp(const ContextoEvp&) = delete;
+    ContextoEvp& operator=(const ContextoEvp&) = delete;
+
+    EVP_CIPHER_CTX* get() const { return ctx; }
+
+private:
+    EVP_CIPHER_CTX* ctx;
+};
+
+// Cifra un lote de celdas con un solo contexto: la clave se expande una vez y en
+// cada celda solo se reinicia el IV, lo que mantiene ocupadas las unidades AES-NI
+// en celdas cortas. Los IV del lote salen de una sola llamada a RAND_bytes.
+class CifradorCeldas {
+public:
+    CifradorCeldas(const std::vector<unsigned char>& clave, GestorCifrado::FormatoCifrado formato) : formato(formato) {
+        const EVP_CIPHER* cifrador = formato == GestorCifrado::FormatoCifrado::Gcm ? EVP_aes_256_gcm() : EVP_aes_256_cbc();
+        if (1 != EVP_EncryptInit_ex(contexto.get(), cifrador, nullptr, clave.data(), nullptr)) {
+            throw std::runtime_error("Error al inicializar el cifrado AES.");
+        }
+    }
+
+    size_t longitudIv() const {
+        return formato == GestorCifrado::FormatoCifrado::Gcm ? LONGITUD_NONCE_GCM : AES_BLOCK_SIZE;
+    }
+
+    void generarIvs(size_t celdas) {
+        ivs.resize(celdas * longitudIv());
+        if (!ivs.empty() && !RAND_bytes(ivs.data(), static_cast<int>(ivs.size()))) {
+            throw std::runtime_error("Error al generar el IV aleatorio para AES.");
+        }
+    }
+
+    // Con contexto (solo en GCM) la celda se autentica junto a el y se escribe
+    // con el prefijo "v3:".
+    std::string cifrar(std::string_view texto, size_t indice_iv, std::string_view contexto_celda = {}) {
+        const unsigned char* iv = ivs.data() + indice_iv * longitudIv();
+        if (1 != EVP_EncryptInit_ex(contexto.get(), nullptr, nullptr, nullptr, iv)) {
+            throw std::runtime_error("Error al inicializar el cifrado AES.");
+        }
+        const bool ligada = formato == GestorCifrado::FormatoCifrado::Gcm && !contexto_celda.empty();
+        buffer.resize(texto.size() + AES_BLOCK_SIZE + LONGITUD_ETIQUETA_GCM);
+        int longitud = 0;
+        int longitud_final = 0;
+        if (ligada && 1 != EVP_EncryptUpdate(contexto.get(), nullptr, &longitud, reinterpret_cast<const unsigned char*>(contexto_celda.data()), static_cast<int>(contexto_celda.size()))) {
+            throw std::runtime_error("Error al autenticar el contexto de la celda con AES-GCM.");
+        }
+        if (1 != EVP_EncryptUpdate(contexto.get(), buffer.data(), &longitud, reinterpret_cast<const unsigned char*>(texto.data()), static_cast<int>(texto.size())) ||
+            1 != EVP_EncryptFinal_ex(contexto.get(), buffer.data() + longitud, &longitud_final)) {
+            throw std::runtime_error("Error al cifrar el valor con AES.");
+        }
+        size_t total = static_cast<size_t>(longitud + longitud_final);
+
+        std::string salida;
+        if (formato == GestorCifrado::FormatoCifrado::Gcm) {
+            if (1 != EVP_CIPHER_CTX_ctrl(contexto.get(), EVP_CTRL_GCM_GET_TAG, LONGITUD_ETIQUETA_GCM, buffer.data() + total)) {
+                throw std::runtime_error("Error al obtener la etiqueta de AES-GCM.");
+            }
+            total += LONGITUD_ETIQUETA_GCM;
+            salida.reserve(PREFIJO_CELDA_GCM.size() + (LONGITUD_NONCE_GCM + total) * 2);
+            salida += ligada ? PREFIJO_CELDA_GCM_LIGADA : PREFIJO_CELDA_GCM;
+        }
+        else {
+            salida.reserve((AES_BLOCK_SIZE + total) * 2);
+        }
+        anexarHex(salida, iv, longitudIv());
+        anexarHex(salida, buffer.data(), total);
+        return salida;
+    }
+
+private:
+    GestorCifrado::FormatoCifrado formato;
+    ContextoEvp contexto;
+    std::vector<unsigned char> ivs;
+    std::vector<unsigned char> buffer;
+};
+
+// Descifra celdas de cualquier formato reutilizando un contexto por formato.
+// Las celdas llegan como texto hexadecimal ("v2:" o "v3:" para GCM, "\x" si es
+// un bytea leido como texto) o como bytes de una columna binaria; en binario GCM
+// se distingue por esos mismos bytes. Las celdas "v3:" solo se autentican con el
+// contexto de la celda con que se cifraron. Los valores que no tienen forma de
+// texto cifrado se devuelven sin cambios y los comprimidos antes de cifrar se
+// descomprimen salvo que se pida el texto plano tal cual.
+class DescifradorCeldas {
+public:
+    explicit DescifradorCeldas(const std::vector<unsigned char>& clave, bool descomprimir = true) : clave(clave), descomprimir(descomprimir) {}
+
+    std::string descifrar(const std::string& texto, std::string_view contexto_celda = {}) {
+        const bool ligada = boost::starts_with(texto, PREFIJO_CELDA_GCM_LIGADA);
+        if (ligada || boost::starts_with(texto, PREFIJO_CELDA_GCM)) {
+            const std::string_view hex = std::string_view(texto).substr(PREFIJO_CELDA_GCM.size());
+            if (hex.size() < (LONGITUD_NONCE_GCM + LONGITUD_ETIQUETA_GCM) * 2 || !decodificarHex(hex, entrada)) {
+                return texto;
+            }
+            if (ligada && contexto_celda.empty()) return "[ERROR_CONTEXTO]";
+            return descifrarGcm(entrada.data(), entrada.size(), ligada ? contexto_celda : std::string_view());
+        }
+        std::string_view hex = texto;
+        if (boost::starts_with(hex, "\\x")) hex.remove_prefix(2);
+        if (hex.size() < 2 * AES_BLOCK_SIZE * 2 || !decodificarHex(hex, entrada)) {
+            return texto;
+        }
+        std::string resultado;
+        return descifrarBinario(entrada.data(), entrada.size(), resultado) ? resultado : texto;
+    }
+
+    // Celda de texto o binaria; el resto de tipos no puede estar cifrado.
+    void descifrarCelda(ValorCelda& celda, std::string_view contexto_celda) {
+        if (std::string* texto = std::get_if<std::string>(&celda)) {
+            Perfilador::sumar(ContadorPerfil::Bytes, texto->size());
+            *texto = descifrar(*texto, contexto_celda);
+        }
+        else if (const Bytes* bytes = std::get_if<Bytes>(&celda)) {
+            Perfilador::sumar(ContadorPerfil::Bytes, bytes->size());
+            std::string plano;
+            if (bytes->empty()) celda = std::string();
+            else if (descifrarBinario(bytes->data(), bytes->size(), plano, contexto_celda)) celda = std::move(plano);
+        }
+    }
+
+    bool descifrarBinario(const unsigned char* datos, size_t longitud, std::string& resultado, std::string_view contexto_celda = {}) {
+        const bool forma_cbc = longitud >= 2 * AES_BLOCK_SIZE && longitud % AES_BLOCK_SIZE == 0;
+        const bool forma_gcm = longitud >= PREFIJO_CELDA_GCM.size() + LONGITUD_NONCE_GCM + LONGITUD_ETIQUETA_GCM;
+        const bool ligada = forma_gcm && std::equal(PREFIJO_CELDA_GCM_LIGADA.begin(), PREFIJO_CELDA_GCM_LIGADA.end(), datos);
+        if (ligada || (forma_gcm && std::equal(PREFIJO_CELDA_GCM.begin(), PREFIJO_CELDA_GCM.end(), datos))) {
+            resultado = ligada && contexto_celda.empty() ? std::string("[ERROR_CONTEXTO]")
+                : descifrarGcm(datos + PREFIJO_CELDA_GCM.size(), longitud - PREFIJO_CELDA_GCM.size(), ligada ? contexto_celda : std::string_view());
+            // Un IV de CBC puede empezar por "v2:" o "v3:" por azar.
+            if ((resultado != "[ERROR_AUTENTICACION]" && resultado != "[ERROR_CONTEXTO]") || !forma_cbc) return true;
+        }
+        if (!forma_cbc) return false;
+        resultado = descifrarCbc(datos, longitud);
+        return true;
+    }
+
+private:
+    const std::vector<unsigned char>& clave;
+    bool descomprimir;
+    ContextoEvp cbc;
+    ContextoEvp gcm;
+    ContextoZstd zstd;
+    bool cbc_listo = false;
+    bool gcm_listo = false;
+    std::vector<unsigned char> entrada;
+    std::vector<unsigned char> salida;
+    unsigned char etiqueta[LONGITUD_ETIQUETA_GCM];
+
+    std::string terminar(size_t longitud) {
+        std::string plano(reinterpret_cast<const char*>(salida.data()), longitud);
+        return descomprimir ? descomprimirCelda(std::move(plano), zstd) : plano;
+    }
+
+    std::string descifrarCbc(const unsigned char* datos, size_t longitud) {
+        if (1 != EVP_DecryptInit_ex(cbc.get(), cbc_listo ? nullptr : EVP_aes_256_cbc(), nullptr, cbc_listo ? nullptr : clave.data(), datos)) {
+            return "[ERROR_INIT]";
+        }
+        cbc_listo = true;
+        const size_t longitud_cifrada = longitud - AES_BLOCK_SIZE;
+        salida.resize(longitud_cifrada + AES_BLOCK_SIZE);
+        int longitud_salida = 0;
+        int longitud_final = 0;
+        if (1 != EVP_DecryptUpdate(cbc.get(), salida.data(), &longitud_salida, datos + AES_BLOCK_SIZE, static_cast<int>(longitud_cifrada))) {
+            return "[ERROR_UPDATE]";
+        }
+        if (1 != EVP_DecryptFinal_ex(cbc.get(), salida.data() + longitud_salida, &longitud_final)) {
+            return "[ERROR_FINAL]";
+        }
+        return terminar(longitud_salida + longitud_final);
+    }
+
+    // datos: nonce, texto cifrado y etiqueta, sin el prefijo "v2:" o "v3:".
+    std::string descifrarGcm(const unsigned char* datos, size_t longitud, std::string_view contexto_celda) {
+        if (1 != EVP_DecryptInit_ex(gcm.get(), gcm_listo ? nullptr : EVP_aes_256_gcm(), nullptr, gcm_listo ? nullptr : clave.data(), datos)) {
+            return "[ERROR_INIT]";
+        }
+        gcm_listo = true;
+        int longitud_contexto = 0;
+        if (!contexto_celda.empty() &&
+            1 != EVP_DecryptUpdate(gcm.get(), nullptr, &longitud_contexto, reinterpret_cast<const unsigned char*>(contexto_celda.data()), static_cast<int>(contexto_celda.size()))) {
+            return "[ERROR_UPDATE]";
+        }
+        const size_t longitud_cifrada = longitud - LONGITUD_NONCE_GCM - LONGITUD_ETIQUETA_GCM;
+        std::copy_n(datos + LONGITUD_NONCE_GCM + longitud_cifrada, LONGITUD_ETIQUETA_GCM, etiqueta);
+        salida.resize(longitud_cifrada + 1);
+        int longitud_salida = 0;
+        int longitud_final = 0;
+        if (1 != EVP_DecryptUpdate(gcm.get(), salida.data(), &longitud_salida, datos + LONGITUD_NONCE_GCM, static_cast<int>(longitud_cifrada))) {
+            return "[ERROR_UPDATE]";
+        }
+        if (1 != EVP_CIPHER_CTX_ctrl(gcm.get(), EVP_CTRL_GCM_SET_TAG, LONGITUD_ETIQUETA_GCM, etiqueta) ||
+            1 != EVP_DecryptFinal_ex(gcm.get(), salida.data() + longitud_salida, &longitud_final)) {
+            return "[ERROR_AUTENTICACION]";
+        }
+        return terminar(longitud_salida + longitud_final);
+    }
+};
+
+std::vector<std::string> listaDeColumnas(const std::string& lista_columnas, const std::string& uso) {
+    std::vector<std::string> columnas;
+    boost::split(columnas, lista_columnas, boost::is_any_of(","));
+    std::vector<std::string> resultado;
+    for (auto& columna : columnas) {
+        boost::trim(columna);
+        if (columna.empty()) continue;
+        if (columna.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_") != std::string::npos) {
+            throw std::runtime_error("Nombre de columna no valido para " + uso + ": " + columna);
+        }
+        resultado.push_back(columna);
+    }
+    return resultado;
+}
+
+std::optional<double> aNumero(std::string_view texto) {
+    double numero = 0;
+    const auto resultado = std::from_chars(texto.data(), texto.data() + texto.size(), numero);
+    if (texto.empty() || resultado.ec != std::errc() || resultado.ptr != texto.data() + texto.size()) return std::nullopt;
+    return numero;
+}
+
+const char* operadorSql(GestorCifrado::OperadorFiltro operador) {
+    switch (operador) {
+    case GestorCifrado::OperadorFiltro::Igual: return " = ";
+    case GestorCifrado::OperadorFiltro::Distinto: return " <> ";
+    case GestorCifrado::OperadorFiltro::Menor: return " < ";
+    case GestorCifrado::OperadorFiltro::MenorIgual: return " <= ";
+    case GestorCifrado::OperadorFiltro::Mayor: return " > ";
+    case GestorCifrado::OperadorFiltro::MayorIgual: return " >= ";
+    }
+    return " = ";
+}
+
+bool cumpleFiltro(const GestorCifrado::FiltroDescifrado& filtro, const ValorCelda& celda) {
+    if (esNulo(celda)) return false;
+    const std::string* texto = std::get_if<std::string>(&celda);
+    const std::string convertido = texto ? std::string() : valorATexto(celda);
+    const std::string_view valor = texto ? std::string_view(*texto) : std::string_view(convertido);
+
+    int comparacion;
+    std::optional<double> numero;
+    if (filtro.valor_numerico && (numero = aNumero(valor))) {
+        comparacion = *numero < *filtro.valor_numerico ? -1 : (*numero > *filtro.valor_numerico ? 1 : 0);
+    }
+    else {
+        comparacion = valor.compare(filtro.valor);
+    }
+
+    switch (filtro.operador) {
+    case GestorCifrado::OperadorFiltro::Igual: return comparacion == 0;
+    case GestorCifrado::OperadorFiltro::Distinto: return comparacion != 0;
+    case GestorCifrado::OperadorFiltro::Menor: return comparacion < 0;
+    case GestorCifrado::OperadorFiltro::MenorIgual: return comparacion <= 0;
+    case GestorCifrado::OperadorFiltro::Mayor: return comparacion > 0;
+    case GestorCifrado::OperadorFiltro::MayorIgual: return comparacion >= 0;
+    }
+    return false;
+}
+
+}
+
 GestorCifrado::GestorCifrado(std::shared_ptr<GestorAuditoria> gestor, const std::string& clave_encriptacion_hex)
     : gestor_db(gestor), clave_hex(clave_encriptacion_hex) {
     if (clave_encriptacion_hex.length() != 64) {
         throw std::runtime_error("La clave de encriptacion debe ser una cadena hexadecimal de 64 caracteres (32 bytes).");
     }
     clave = hexABytes(clave_encriptacion_hex);
+    clave_indice = hmacSha256(clave, "SHC134-indice-ciego");
 
     char primer_digito = clave_encriptacion_hex[0];
     if (primer_digito >= '0' && primer_digito <= '9') {
@@ -103,6 +503,7 @@ GestorCifrado::GestorCifrado(std::shared_ptr<GestorAuditoria> gestor, const std:
 }
 
 void GestorCifrado::cifrarFilaEInsertar(const std::string& tabla, const std::vector<std::string>& columnas, const std::vector<std::string>& fila, const std::string& accion) {
+    using Dialecto = DialectoSql<GestorAuditoria::MotorDB::SQLite>;
     std::string tabla_auditoria = "aud_" + tabla;
     std::ostringstream insert_sql;
     std::ostringstream values_sql;
@@ -110,6 +511,12 @@ void GestorCifrado::cifrarFilaEInsertar(const std::string& tabla, const std::vec
     insert_sql << "INSERT INTO " << tabla_auditoria << " (";
     values_sql << ") VALUES (";
 
+    auto anexar_cifrado = [&](const std::string& texto_plano, bool comprimir) {
+        std::string literal;
+        Dialecto::literalCifrado(literal, cifrarValor(texto_plano, comprimir), almacenamientoBinario());
+        values_sql << literal;
+    };
+
     bool first = true;
     for (size_t i = 0; i < columnas.size(); ++i) {
         if (!first) {
@@ -118,97 +525,147 @@ void GestorCifrado::cifrarFilaEInsertar(const std::string& tabla, const std::vec
         }
 
         insert_sql << "\"" << cifrarNombreColumnaCesar(columnas[i], desplazamiento_cesar) << "\"";
-
-        std::string valor_cifrado = cifrarValor(fila[i]);
-        boost::replace_all(valor_cifrado, "'", "''");
-        values_sql << "'" << valor_cifrado << "'";
+        anexar_cifrado(fila[i], columnaComprimida(columnas[i]));
 
         first = false;
     }
 
     insert_sql << ", \"" << cifrarNombreColumnaCesar("UsuarioAccion", desplazamiento_cesar) << "\", \"" << cifrarNombreColumnaCesar("FechaAccion", desplazamiento_cesar) << "\", \"" << cifrarNombreColumnaCesar("AccionSql", desplazamiento_cesar) << "\"";
 
-    std::string valor_usuario_cifrado = cifrarValor("SYSTEM");
-    boost::replace_all(valor_usuario_cifrado, "'", "''");
-    std::string valor_accion_cifrado = cifrarValor(accion);
-    boost::replace_all(valor_accion_cifrado, "'", "''");
-
-    values_sql << ", '" << valor_usuario_cifrado << "', '" << cifrarValor("datetime('now')") << "', '" << valor_accion_cifrado << "')";
+    for (const std::string& control : { std::string("SYSTEM"), std::string("datetime('now')"), accion }) {
+        values_sql << ", ";
+        anexar_cifrado(control, false);
+    }
+    values_sql << ")";
 
     gestor_db->ejecutarComando(insert_sql.str() + values_sql.str());
 }
 
-std::string GestorCifrado::cifrarValor(const std::string& texto_plano) {
+std::string GestorCifrado::cifrarValor(const std::string& texto_plano, bool comprimir) const {
     if (texto_plano.empty() || texto_plano == "NULL") {
         return texto_plano;
     }
-
-    unsigned char iv[AES_BLOCK_SIZE];
-    if (!RAND_bytes(iv, sizeof(iv))) {
-        throw std::runtime_error("Error al generar el IV aleatorio para AES.");
+    MedicionFase medicion("cifrado.cifrarValor", false);
+    Perfilador::sumar(ContadorPerfil::Bytes, texto_plano.size());
+
+    CifradorCeldas cifrador(clave, formato_cifrado);
+    cifrador.generarIvs(1);
+    std::string comprimido;
+    if (comprimir && texto_plano.size() >= umbral_compresion && comprimirCelda(texto_plano, comprimido)) {
+        return cifrador.cifrar(comprimido, 0);
     }
+    return cifrador.cifrar(texto_plano, 0);
+}
 
-    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-    if (!ctx) throw std::runtime_error("Fallo al crear el contexto de cifrado EVP.");
+std::string GestorCifrado::descifrarValor(const std::string& texto_cifrado_hex, const std::string& contexto) const {
+    MedicionFase medicion("cifrado.descifrarValor", false);
+    Perfilador::sumar(ContadorPerfil::Bytes, texto_cifrado_hex.size());
+
+    DescifradorCeldas descifrador(clave);
+    return descifrador.descifrar(texto_cifrado_hex, contexto);
+}
 
-    EVP_EncryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, clave.data(), iv);
+std::vector<std::string> GestorCifrado::cifrarValores(const std::vector<std::string>& textos_planos, const std::vector<bool>& comprimir, const std::vector<std::string>& contextos) const {
+    MedicionFase medicion("cifrado.cifrarValores", false);
+    std::vector<std::string> cifrados(textos_planos.size());
+    size_t celdas = 0;
+    for (const auto& texto : textos_planos) {
+        if (!texto.empty() && texto != "NULL") ++celdas;
+    }
 
-    std::vector<unsigned char> texto_cifrado(texto_plano.length() + AES_BLOCK_SIZE);
-    int len = 0;
-    int ciphertext_len = 0;
+    CifradorCeldas cifrador(clave, formato_cifrado);
+    cifrador.generarIvs(celdas);
+    size_t indice_iv = 0;
+    std::string comprimido;
+    for (size_t i = 0; i < textos_planos.size(); ++i) {
+        const std::string& texto = textos_planos[i];
+        if (texto.empty() || texto == "NULL") {
+            cifrados[i] = texto;
+            continue;
+        }
+        Perfilador::sumar(ContadorPerfil::Bytes, texto.size());
+        const std::string_view contexto = i < contextos.size() ? std::string_view(contextos[i]) : std::string_view();
+        if (i < comprimir.size() && comprimir[i] && texto.size() >= umbral_compresion && comprimirCelda(texto, comprimido)) {
+            cifrados[i] = cifrador.cifrar(comprimido, indice_iv++, contexto);
+        }
+        else {
+            cifrados[i] = cifrador.cifrar(texto, indice_iv++, contexto);
+        }
+    }
+    return cifrados;
+}
 
-    EVP_EncryptUpdate(ctx, texto_cifrado.data(), &len, reinterpret_cast<const unsigned char*>(texto_plano.c_str()), texto_plano.length());
-    ciphertext_len = len;
+void GestorCifrado::descifrarCeldas(std::vector<ValorCelda>& celdas, bool descomprimir, const std::vector<std::string>& contextos) const {
+    MedicionFase medicion("cifrado.descifrarCeldas", false);
+    DescifradorCeldas descifrador(clave, descomprimir);
+    for (size_t i = 0; i < celdas.size(); ++i) {
+        descifrador.descifrarCelda(celdas[i], i < contextos.size() ? std::string_view(contextos[i]) : std::string_view());
+    }
+}
 
-    EVP_EncryptFinal_ex(ctx, texto_cifrado.data() + len, &len);
-    ciphertext_len += len;
+std::string GestorCifrado::contextoCelda(const std::string& tabla, const std::string& columna, const std::string& id_auditoria) {
+    std::string contexto;
+    contexto.reserve(tabla.size() + columna.size() + id_auditoria.size() + 2);
+    contexto += tabla;
+    contexto += SEPARADOR_CONTEXTO_CELDA;
+    contexto += columna;
+    contexto += SEPARADOR_CONTEXTO_CELDA;
+    contexto += id_auditoria;
+    return contexto;
+}
 
-    EVP_CIPHER_CTX_free(ctx);
+std::vector<std::string> GestorCifrado::contextosDeFila(const std::string& tabla, const std::vector<std::string>& columnas, const std::vector<ValorCelda>& fila) const {
+    std::vector<std::string> contextos;
+    const auto posicion_id = std::find(columnas.begin(), columnas.end(), COLUMNA_SECUENCIA_AUDITORIA);
+    const size_t indice_id = posicion_id - columnas.begin();
+    if (posicion_id == columnas.end() || indice_id >= fila.size() || esNulo(fila[indice_id])) return contextos;
+    const std::string id = valorATexto(fila[indice_id]);
+    contextos.reserve(columnas.size());
+    for (const auto& columna : columnas) contextos.push_back(contextoCelda(tabla, descifrarNombreColumna(columna), id));
+    return contextos;
+}
 
-    return bytesAHex(iv, AES_BLOCK_SIZE) + bytesAHex(texto_cifrado.data(), ciphertext_len);
+bool GestorCifrado::cifradoAutenticado() const {
+    return formato_cifrado == FormatoCifrado::Gcm;
 }
 
-std::string GestorCifrado::descifrarValor(const std::string& texto_cifrado_hex) {
-    if (texto_cifrado_hex.length() < 32 || texto_cifrado_hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
-        return texto_cifrado_hex;
-    }
+void GestorCifrado::setFormatoCifrado(FormatoCifrado formato) {
+    formato_cifrado = formato;
+}
 
-    try {
-        std::vector<unsigned char> iv = hexABytes(texto_cifrado_hex.substr(0, 32));
-        std::vector<unsigned char> texto_cifrado = hexABytes(texto_cifrado_hex.substr(32));
+void GestorCifrado::setAlmacenamiento(AlmacenamientoCifrado nuevo_almacenamiento) {
+    almacenamiento = nuevo_almacenamiento;
+}
 
-        EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
-        if (!ctx) return "[ERROR_CTX]";
+bool GestorCifrado::almacenamientoBinario() const {
+    return almacenamiento == AlmacenamientoCifrado::Binario;
+}
 
-        if (1 != EVP_DecryptInit_ex(ctx, EVP_aes_256_cbc(), NULL, clave.data(), iv.data())) {
-            EVP_CIPHER_CTX_free(ctx);
-            return "[ERROR_INIT]";
-        }
+GestorCifrado::AlmacenamientoCifrado GestorCifrado::interpretarAlmacenamiento(const std::string& texto) {
+    const std::string valor = boost::to_lower_copy(texto);
+    if (valor == "hex") return AlmacenamientoCifrado::Hexadecimal;
+    if (valor == "binario") return AlmacenamientoCifrado::Binario;
+    throw std::runtime_error("Almacenamiento de cifrado no valido: " + texto + " (use hex o binario).");
+}
 
-        std::vector<unsigned char> texto_plano(texto_cifrado.size() + AES_BLOCK_SIZE);
-        int len = 0;
-        int plaintext_len = 0;
+std::string GestorCifrado::descomprimirValor(const std::string& texto_plano) {
+    ContextoZstd contexto;
+    return descomprimirCelda(texto_plano, contexto);
+}
 
-        if (1 != EVP_DecryptUpdate(ctx, texto_plano.data(), &len, texto_cifrado.data(), texto_cifrado.size())) {
-            EVP_CIPHER_CTX_free(ctx);
-            return "[ERROR_UPDATE]";
-        }
-        plaintext_len = len;
+void GestorCifrado::setMigracionEnLinea(bool en_linea) {
+    migracion_en_linea = en_linea;
+}
 
-        if (1 != EVP_DecryptFinal_ex(ctx, texto_plano.data() + len, &len)) {
-            EVP_CIPHER_CTX_free(ctx);
-            return "[ERROR_FINAL]";
-        }
-        plaintext_len += len;
-        EVP_CIPHER_CTX_free(ctx);
-        return std::string(reinterpret_cast<char*>(texto_plano.data()), plaintext_len);
-    }
-    catch (const std::exception&) {
-        return texto_cifrado_hex;
-    }
+GestorCifrado::FormatoCifrado GestorCifrado::interpretarFormatoCifrado(const std::string& texto) {
+    const std::string formato = boost::to_lower_copy(texto);
+    if (formato == "cbc") return FormatoCifrado::Cbc;
+    if (formato == "gcm") return FormatoCifrado::Gcm;
+    throw std::runtime_error("Formato de cifrado no valido: " + texto + " (use cbc o gcm).");
 }
 
 void GestorCifrado::cifrarTablasDeAuditoria() {
+    MedicionFase medicion("cifrado.cifrarTablasDeAuditoria");
     auto tablas_auditoria = gestor_db->obtenerNombresDeTablas(true);
     tablas_auditoria.erase(
         std::remove_if(tablas_auditoria.begin(), tablas_auditoria.end(),
@@ -223,148 +680,435 @@ void GestorCifrado::cifrarTablasDeAuditoria() {
         return;
     }
 
-    if (gestor_db->getMotor() == GestorAuditoria::MotorDB::SQLServer) {
-        prepararCifradoSQLServer();
+    reescrituras_realizadas = 0;
+    reescrituras_evitadas = 0;
+    despacharDialecto(gestor_db->getMotor(), [&](auto dialecto) {
+        using Dialecto = decltype(dialecto);
+        if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::SQLServer) {
+            // Los triggers usan EncryptByKey, cuyo formato no es IV + AES-CBC: sus
+            // filas no se podrian descifrar junto a las escritas desde C++.
+            if (almacenamientoBinario()) {
+                throw std::runtime_error("--storage binario no esta soportado en SQL Server; use --storage hex.");
+            }
+            prepararCifradoSQLServer();
+        }
+        for (const auto& tabla : tablas_auditoria) {
+            try {
+                if (migracion_en_linea) cifrarTablaDeAuditoriaEnLinea<Dialecto>(tabla);
+                else cifrarTablaDeAuditoria<Dialecto>(tabla);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Error procesando tabla " << tabla << ": " << e.what() << std::endl;
+            }
+        }
+        });
+    std::cout << "Cambios de esquema: " << reescrituras_realizadas << " reescrituras de tabla, " << reescrituras_evitadas << " evitadas." << std::endl;
+}
+
+template <typename Dialecto>
+void GestorCifrado::cifrarTablaDeAuditoria(const std::string& tabla) {
+    if constexpr (!Dialecto::soporta_cambio_tipo) {
+        return;
     }
+    else {
+        MedicionFase medicion("cifrado.cifrarTablaDeAuditoria");
+        std::cout << "Procesando tabla " << tabla << "..." << std::endl;
 
-    for (const auto& tabla : tablas_auditoria) {
-        try {
-            std::cout << "Procesando tabla " << tabla << "..." << std::endl;
+        auto resultado_columnas = gestor_db->ejecutarConsultaConResultado(Dialecto::paginar("SELECT * FROM " + tabla, 1));
+        if (std::find(resultado_columnas.columnas.begin(), resultado_columnas.columnas.end(), COLUMNA_CAMBIOS_AUDITORIA) != resultado_columnas.columnas.end()) {
+            std::cout << "Tabla " << tabla << " omitida: usa auditoria por diferencias." << std::endl;
+            return;
+        }
 
-            if (gestor_db->getMotor() == GestorAuditoria::MotorDB::MySQL) {
-                eliminarIndicesMySQL(tabla);
-            }
+        if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::MySQL) {
+            eliminarIndicesMySQL(tabla);
+        }
 
-            auto resultado_columnas = gestor_db->ejecutarConsultaConResultado("SELECT * FROM " + tabla + " LIMIT 1");
-            std::map<std::string, std::string> mapa_columnas;
-
-            for (const auto& col : resultado_columnas.columnas) {
-                mapa_columnas[col] = cifrarNombreColumnaCesar(col, desplazamiento_cesar);
-                std::string alter_sql;
-                switch (gestor_db->getMotor()) {
-                case GestorAuditoria::MotorDB::PostgreSQL:
-                    alter_sql = "ALTER TABLE public.\"" + tabla + "\" ALTER COLUMN \"" + col + "\" TYPE TEXT";
-                    break;
-                case GestorAuditoria::MotorDB::MySQL:
-                    alter_sql = "ALTER TABLE `" + tabla + "` MODIFY COLUMN `" + col + "` TEXT";
-                    break;
-                case GestorAuditoria::MotorDB::SQLServer:
-                    alter_sql = "ALTER TABLE dbo.[" + tabla + "] ALTER COLUMN [" + col + "] NVARCHAR(MAX)";
-                    break;
-                default: continue;
-                }
-                gestor_db->ejecutarComando(alter_sql);
+        const auto tipos = tiposDeColumnas<Dialecto>(tabla);
+        std::map<std::string, std::string> mapa_columnas;
+        CambioEsquema cambio;
+
+        for (const auto& col : resultado_columnas.columnas) {
+            if (col == COLUMNA_SECUENCIA_AUDITORIA) continue;
+            mapa_columnas[col] = cifrarNombreColumnaCesar(col, desplazamiento_cesar);
+            const auto tipo = tipos.find(col);
+            cambio.tipos.emplace_back(col, tipo == tipos.end() ? std::string() : tipo->second);
+            cambio.renombrados.emplace_back(col, mapa_columnas[col]);
+        }
+
+        if (mapa_columnas.empty()) return;
+
+        std::map<std::string, std::string> indices_ciegos;
+        std::map<std::string, std::string> indices_por_columna_cifrada;
+        for (const auto& columna : columnas_indice_ciego) {
+            if (mapa_columnas.count(columna) == 0) continue;
+            indices_ciegos[columna] = columnaIndiceCiego(columna);
+            indices_por_columna_cifrada[mapa_columnas[columna]] = indices_ciegos[columna];
+            cambio.columnas_nuevas.emplace_back(indices_ciegos[columna], std::string(Dialecto::tipo_indice_ciego));
+        }
+
+        aplicarCambioEsquema<Dialecto>(tabla, cambio);
+
+        std::string lista_columnas;
+        for (const auto& col : resultado_columnas.columnas) {
+            if (!lista_columnas.empty()) lista_columnas += ", ";
+            Dialecto::citar(lista_columnas, col == COLUMNA_SECUENCIA_AUDITORIA ? col : mapa_columnas[col]);
+        }
+        auto datos_actuales = gestor_db->ejecutarConsultaConResultado("SELECT " + lista_columnas + " FROM " + Dialecto::tablaCalificada(tabla));
+        if (!datos_actuales.filas.empty()) {
+            gestor_db->ejecutarComando(Dialecto::sentenciaVaciar(tabla));
+        }
+        if (almacenamientoBinario()) {
+            CambioEsquema cambio_binario;
+            cambio_binario.tipo_destino = Dialecto::tipo_binario;
+            for (const auto& par : mapa_columnas) cambio_binario.tipos.emplace_back(par.second, std::string(Dialecto::tipo_texto));
+            aplicarCambioEsquema<Dialecto>(tabla, cambio_binario);
+        }
+        if (!datos_actuales.filas.empty()) {
+            std::cout << "Cifrando " << datos_actuales.filas.size() << " filas de datos existentes..." << std::endl;
+            reescribirFilasCifradas<Dialecto>(tabla, datos_actuales, indices_por_columna_cifrada, tabla, true);
+        }
+
+        for (const auto& par : indices_ciegos) {
+            gestor_db->ejecutarComando(Dialecto::sentenciaCrearIndice(tabla, "ix_" + tabla + "_" + par.second, par.second));
+            std::cout << "Indice ciego creado para la columna " << par.first << "." << std::endl;
+        }
+
+        std::string nombre_tabla_original = tabla;
+        boost::replace_first(nombre_tabla_original, "aud_", "");
+        boost::replace_first(nombre_tabla_original, "Aud", "");
+        actualizarTriggersParaCifrado<Dialecto>(nombre_tabla_original, indices_ciegos);
+
+        std::cout << "Tabla " << tabla << " cifrada exitosamente." << std::endl;
+    }
+}
+
+// Cifrado sin bloquear la tabla aud_ durante la copia: las filas se copian
+// cifradas por bloques a una tabla sombra mientras un trigger anota en
+// shc134_cambios_<tabla> los IdAuditoria escritos en paralelo. Esos cambios se
+// reaplican en la sombra y, con las escrituras bloqueadas solo durante el
+// intercambio, se aplican los ultimos, la sombra reemplaza a la tabla original
+// y se instalan los triggers de cifrado.
+template <typename Dialecto>
+void GestorCifrado::cifrarTablaDeAuditoriaEnLinea(const std::string& tabla) {
+    if constexpr (Dialecto::plantilla_migracion.empty()) {
+        cifrarTablaDeAuditoria<Dialecto>(tabla);
+    }
+    else {
+        MedicionFase medicion("cifrado.cifrarTablaDeAuditoriaEnLinea");
+        std::cout << "Procesando tabla " << tabla << " en linea..." << std::endl;
+
+        auto resultado_columnas = gestor_db->ejecutarConsultaConResultado(Dialecto::paginar("SELECT * FROM " + tabla, 1));
+        const auto& columnas = resultado_columnas.columnas;
+        if (std::find(columnas.begin(), columnas.end(), COLUMNA_CAMBIOS_AUDITORIA) != columnas.end()) {
+            std::cout << "Tabla " << tabla << " omitida: usa auditoria por diferencias." << std::endl;
+            return;
+        }
+        const auto posicion_secuencia = std::find(columnas.begin(), columnas.end(), COLUMNA_SECUENCIA_AUDITORIA);
+        if (posicion_secuencia == columnas.end()) {
+            std::cout << "Tabla " << tabla << " sin columna " << COLUMNA_SECUENCIA_AUDITORIA << ": se cifra sin migracion en linea." << std::endl;
+            cifrarTablaDeAuditoria<Dialecto>(tabla);
+            return;
+        }
+        const size_t indice_secuencia = posicion_secuencia - columnas.begin();
+
+        std::string nombre_tabla_original = tabla;
+        boost::replace_first(nombre_tabla_original, "aud_", "");
+        boost::replace_first(nombre_tabla_original, "Aud", "");
+        const std::string sombra = "shc134_sombra_" + tabla;
+        const std::string cambios = "shc134_cambios_" + tabla;
+        const std::string secuencia = Dialecto::citar(COLUMNA_SECUENCIA_AUDITORIA);
+
+        // La copia por bloques y la reaplicacion de cambios buscan por IdAuditoria
+        // en ambas tablas; sin indice, cada bloque recorreria la tabla entera. La
+        // tabla cifrada conserva el indice de la sombra.
+        asegurarIndiceSecuencia<Dialecto>(*gestor_db, tabla, true);
+        gestor_db->ejecutarComando("DROP TABLE IF EXISTS " + Dialecto::tablaCalificada(sombra));
+        gestor_db->ejecutarComando(Dialecto::sentenciaCrearTablaSombra(tabla, sombra));
+        if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::MySQL) {
+            eliminarIndicesMySQL(sombra);
+        }
+        asegurarIndiceSecuencia<Dialecto>(*gestor_db, sombra);
+
+        const auto tipos = tiposDeColumnas<Dialecto>(tabla);
+        std::map<std::string, std::string> mapa_columnas;
+        CambioEsquema cambio_sombra;
+        CambioEsquema cambio_nombres;
+        // Las filas se leen convertidas a texto en el motor, como las convierten
+        // los triggers de cifrado (y ALTER ... TYPE TEXT sin migracion en linea):
+        // el texto libpq de un booleano es 't', el del cast es 'true'.
+        std::string columnas_texto;
+        for (const auto& col : columnas) {
+            if (!columnas_texto.empty()) columnas_texto += ", ";
+            if (col == COLUMNA_SECUENCIA_AUDITORIA) {
+                Dialecto::citar(columnas_texto, col);
+                continue;
             }
+            mapa_columnas[col] = cifrarNombreColumnaCesar(col, desplazamiento_cesar);
+            const auto tipo = tipos.find(col);
+            cambio_sombra.tipos.emplace_back(col, tipo == tipos.end() ? std::string() : tipo->second);
+            cambio_nombres.renombrados.emplace_back(col, mapa_columnas[col]);
+            columnas_texto += Dialecto::expresionTexto(Dialecto::citar(col), tipo == tipos.end() ? std::string() : tipo->second) + " AS " + Dialecto::citar(col);
+        }
 
-            if (mapa_columnas.empty()) continue;
+        std::map<std::string, std::string> indices_ciegos;
+        for (const auto& columna : columnas_indice_ciego) {
+            if (mapa_columnas.count(columna) == 0) continue;
+            indices_ciegos[columna] = columnaIndiceCiego(columna);
+            cambio_sombra.columnas_nuevas.emplace_back(indices_ciegos[columna], std::string(Dialecto::tipo_indice_ciego));
+        }
+        aplicarCambioEsquema<Dialecto>(sombra, cambio_sombra);
+        if (almacenamientoBinario()) {
+            CambioEsquema cambio_binario;
+            cambio_binario.tipo_destino = Dialecto::tipo_binario;
+            for (const auto& par : mapa_columnas) cambio_binario.tipos.emplace_back(par.first, std::string(Dialecto::tipo_texto));
+            aplicarCambioEsquema<Dialecto>(sombra, cambio_binario);
+        }
 
-            auto datos_actuales = gestor_db->ejecutarConsultaConResultado("SELECT * FROM " + tabla);
+        nlohmann::json datos;
+        datos["tabla_auditoria"] = tabla;
+        datos["tabla_cambios"] = cambios;
+        gestor_db->ejecutarComando(GestorPlantillas::instancia().renderizar(std::string(Dialecto::plantilla_migracion), datos));
+
+        auto maximo = gestor_db->ejecutarConsultaConResultado("SELECT MAX(" + secuencia + ") FROM " + Dialecto::tablaCalificada(tabla));
+        const std::string id_maximo = maximo.filas.empty() || maximo.filas[0].empty() ? "NULL" : maximo.filas[0][0];
+        if (!id_maximo.empty() && id_maximo != "NULL") {
+            std::string ultimo_id;
+            size_t filas_copiadas = 0;
+            while (true) {
+                std::string consulta = "SELECT " + columnas_texto + " FROM " + Dialecto::tablaCalificada(tabla) + " WHERE " + secuencia + " <= " + id_maximo;
+                if (!ultimo_id.empty()) consulta += " AND " + secuencia + " > " + ultimo_id;
+                auto bloque = gestor_db->ejecutarConsultaConResultado(Dialecto::paginar(consulta + " ORDER BY " + secuencia, FILAS_POR_BLOQUE_MIGRACION));
+                if (bloque.filas.empty()) break;
+                reescribirFilasCifradas<Dialecto>(sombra, bloque, indices_ciegos, tabla, false);
+                ultimo_id = bloque.filas.back()[indice_secuencia];
+                filas_copiadas += bloque.filas.size();
+                std::cout << "Tabla " << tabla << ": " << filas_copiadas << " filas copiadas a la tabla sombra." << std::endl;
+                if (bloque.filas.size() < FILAS_POR_BLOQUE_MIGRACION) break;
+            }
+        }
 
-            if (!datos_actuales.filas.empty()) {
-                std::cout << "Cifrando " << datos_actuales.filas.size() << " filas de datos existentes..." << std::endl;
+        // Fuera del bloqueo se reaplican cambios hasta que quedan pocos, para que
+        // las escrituras solo esperen por ese resto.
+        const std::string consulta_pendientes = "SELECT COUNT(*) FROM " + Dialecto::tablaCalificada(cambios);
+        while (std::stoull(gestor_db->ejecutarConsultaConResultado(consulta_pendientes).filas[0][0]) > CAMBIOS_MAXIMOS_EN_BLOQUEO) {
+            aplicarCambiosEnSombra<Dialecto>(tabla, sombra, cambios, columnas_texto, indices_ciegos);
+        }
 
-                if (gestor_db->getMotor() == GestorAuditoria::MotorDB::MySQL) {
-                    gestor_db->ejecutarComando("DELETE FROM " + tabla);
-                }
-                else if (gestor_db->getMotor() == GestorAuditoria::MotorDB::PostgreSQL) {
-                    gestor_db->ejecutarComando("TRUNCATE TABLE public.\"" + tabla + "\"");
+        const auto intercambiar = [&]() {
+            while (aplicarCambiosEnSombra<Dialecto>(tabla, sombra, cambios, columnas_texto, indices_ciegos) > 0) {
+            }
+            if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::PostgreSQL) {
+                // La secuencia de IdAuditoria pertenece a la tabla original y se borraria con ella.
+                auto serie = gestor_db->ejecutarConsultaConResultado("SELECT pg_get_serial_sequence('" + Dialecto::tablaCalificada(tabla) + "', '" + std::string(COLUMNA_SECUENCIA_AUDITORIA) + "')");
+                if (!serie.filas.empty() && !serie.filas[0].empty() && !serie.filas[0][0].empty() && serie.filas[0][0] != "NULL") {
+                    gestor_db->ejecutarComando("ALTER SEQUENCE " + serie.filas[0][0] + " OWNED BY " + Dialecto::tablaCalificada(sombra) + "." + secuencia);
                 }
-                else if (gestor_db->getMotor() == GestorAuditoria::MotorDB::SQLServer) {
-                    gestor_db->ejecutarComando("TRUNCATE TABLE dbo.[" + tabla + "]");
+            }
+            gestor_db->ejecutarComando("DROP TABLE " + Dialecto::tablaCalificada(tabla));
+            gestor_db->ejecutarComando("DROP TABLE " + Dialecto::tablaCalificada(cambios));
+            if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::PostgreSQL) {
+                gestor_db->ejecutarComando("DROP FUNCTION IF EXISTS public." + tabla + "_migracion()");
+            }
+            gestor_db->ejecutarComando(Dialecto::sentenciaRenombrarTabla(sombra, tabla));
+            aplicarCambioEsquema<Dialecto>(tabla, cambio_nombres);
+            for (const auto& par : indices_ciegos) {
+                gestor_db->ejecutarComando(Dialecto::sentenciaCrearIndice(tabla, "ix_" + tabla + "_" + par.second, par.second));
+            }
+            actualizarTriggersParaCifrado<Dialecto>(nombre_tabla_original, indices_ciegos);
+        };
+
+        if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::MySQL) {
+            // En MySQL el DDL confirma la transaccion; el intercambio se protege con LOCK TABLES.
+            gestor_db->ejecutarSentencia("LOCK TABLES " + Dialecto::tablaCalificada(nombre_tabla_original) + " WRITE, " + Dialecto::tablaCalificada(tabla) + " WRITE, "
+                + Dialecto::tablaCalificada(sombra) + " WRITE, " + Dialecto::tablaCalificada(cambios) + " WRITE");
+            try {
+                intercambiar();
+            }
+            catch (...) {
+                try {
+                    gestor_db->ejecutarSentencia("UNLOCK TABLES");
                 }
-
-                for (const auto& fila : datos_actuales.filas) {
-                    std::ostringstream insert_sql;
-                    std::ostringstream values_sql;
-
-                    switch (gestor_db->getMotor()) {
-                    case GestorAuditoria::MotorDB::PostgreSQL:
-                        insert_sql << "INSERT INTO public.\"" << tabla << "\" (";
-                        break;
-                    case GestorAuditoria::MotorDB::MySQL:
-                        insert_sql << "INSERT INTO `" << tabla << "` (";
-                        break;
-                    case GestorAuditoria::MotorDB::SQLServer:
-                        insert_sql << "INSERT INTO dbo.[" << tabla << "] (";
-                        break;
-                    default:
-                        insert_sql << "INSERT INTO " << tabla << " (";
-                    }
-
-                    values_sql << ") VALUES (";
-
-                    bool first = true;
-                    for (size_t i = 0; i < datos_actuales.columnas.size(); ++i) {
-                        if (!first) {
-                            insert_sql << ", ";
-                            values_sql << ", ";
-                        }
-
-                        std::string col_name_quoted;
-                        switch (gestor_db->getMotor()) {
-                        case GestorAuditoria::MotorDB::PostgreSQL:
-                            col_name_quoted = "\"" + datos_actuales.columnas[i] + "\"";
-                            break;
-                        case GestorAuditoria::MotorDB::MySQL:
-                            col_name_quoted = "`" + datos_actuales.columnas[i] + "`";
-                            break;
-                        case GestorAuditoria::MotorDB::SQLServer:
-                            col_name_quoted = "[" + datos_actuales.columnas[i] + "]";
-                            break;
-                        default:
-                            col_name_quoted = datos_actuales.columnas[i];
-                        }
-
-                        insert_sql << col_name_quoted;
-
-                        std::string valor_cifrado = cifrarValor(fila[i]);
-                        boost::replace_all(valor_cifrado, "'", "''");
-
-                        if (gestor_db->getMotor() == GestorAuditoria::MotorDB::SQLServer) {
-                            values_sql << "N'" << valor_cifrado << "'";
-                        }
-                        else {
-                            values_sql << "'" << valor_cifrado << "'";
-                        }
-
-                        first = false;
-                    }
-
-                    values_sql << ")";
-                    gestor_db->ejecutarComando(insert_sql.str() + values_sql.str());
+                catch (const std::exception&) {
                 }
+                throw;
             }
-
-            for (const auto& par : mapa_columnas) {
-                std::string rename_sql;
-                switch (gestor_db->getMotor()) {
-                case GestorAuditoria::MotorDB::PostgreSQL:
-                    rename_sql = "ALTER TABLE public.\"" + tabla + "\" RENAME COLUMN \"" + par.first + "\" TO \"" + par.second + "\"";
-                    break;
-                case GestorAuditoria::MotorDB::MySQL:
-                    rename_sql = "ALTER TABLE `" + tabla + "` RENAME COLUMN `" + par.first + "` TO `" + par.second + "`";
-                    break;
-                case GestorAuditoria::MotorDB::SQLServer:
-                    rename_sql = "EXEC sp_rename '" + tabla + "." + par.first + "', '" + par.second + "', 'COLUMN'";
-                    break;
-                default: continue;
+            gestor_db->ejecutarSentencia("UNLOCK TABLES");
+        }
+        else {
+            gestor_db->ejecutarSentencia(std::string(Dialecto::inicio_transaccion));
+            try {
+                gestor_db->ejecutarSentencia(Dialecto::sentenciaBloquearEscrituras(nombre_tabla_original));
+                gestor_db->ejecutarSentencia(Dialecto::sentenciaBloquearEscrituras(tabla));
+                intercambiar();
+                gestor_db->ejecutarSentencia("COMMIT");
+            }
+            catch (...) {
+                try {
+                    gestor_db->ejecutarSentencia("ROLLBACK");
+                }
+                catch (const std::exception&) {
                 }
-                gestor_db->ejecutarComando(rename_sql);
+                throw;
             }
+        }
+
+        std::cout << "Tabla " << tabla << " cifrada exitosamente en linea." << std::endl;
+    }
+}
 
-            std::string nombre_tabla_original = tabla;
-            boost::replace_first(nombre_tabla_original, "aud_", "");
-            boost::replace_first(nombre_tabla_original, "Aud", "");
-            actualizarTriggersParaCifrado(nombre_tabla_original, mapa_columnas);
+// Reaplica en la sombra un lote de IdAuditoria anotados por el trigger de
+// captura: borra esas filas de la sombra, vuelve a copiar cifrado su estado
+// actual y descarta las anotaciones procesadas. Devuelve cuantas proceso.
+template <typename Dialecto>
+size_t GestorCifrado::aplicarCambiosEnSombra(const std::string& tabla, const std::string& sombra, const std::string& cambios, const std::string& columnas_texto,
+    const std::map<std::string, std::string>& indices_ciegos) {
+    MedicionFase medicion("cifrado.aplicarCambiosEnSombra");
+    const std::string secuencia = Dialecto::citar(COLUMNA_SECUENCIA_AUDITORIA);
+    const std::string orden = Dialecto::citar("Secuencia");
+    auto pendientes = gestor_db->ejecutarConsultaConResultado(Dialecto::paginar(
+        "SELECT " + orden + ", " + secuencia + " FROM " + Dialecto::tablaCalificada(cambios) + " ORDER BY " + orden, FILAS_POR_BLOQUE_MIGRACION));
+    if (pendientes.filas.empty()) return 0;
+
+    std::string lista_orden;
+    std::set<std::string> ids;
+    for (const auto& fila : pendientes.filas) {
+        if (!lista_orden.empty()) lista_orden += ", ";
+        lista_orden += fila[0];
+        ids.insert(fila[1]);
+    }
+    const std::string lista_ids = boost::algorithm::join(ids, ", ");
 
-            std::cout << "Tabla " << tabla << " cifrada exitosamente." << std::endl;
+    gestor_db->ejecutarComando("DELETE FROM " + Dialecto::tablaCalificada(sombra) + " WHERE " + secuencia + " IN (" + lista_ids + ")");
+    auto actuales = gestor_db->ejecutarConsultaConResultado("SELECT " + columnas_texto + " FROM " + Dialecto::tablaCalificada(tabla) + " WHERE " + secuencia + " IN (" + lista_ids + ")");
+    if (!actuales.filas.empty()) {
+        reescribirFilasCifradas<Dialecto>(sombra, actuales, indices_ciegos, tabla, false);
+    }
+    gestor_db->ejecutarComando("DELETE FROM " + Dialecto::tablaCalificada(cambios) + " WHERE " + orden + " IN (" + lista_orden + ")");
+    return pendientes.filas.size();
+}
+
+template <typename Dialecto>
+std::map<std::string, std::string> GestorCifrado::tiposDeColumnas(const std::string& tabla) {
+    std::map<std::string, std::string> tipos;
+    auto resultado = gestor_db->ejecutarConsultaConResultado(Dialecto::consultaTiposColumnas(tabla));
+    for (const auto& fila : resultado.filas) {
+        if (fila.size() >= 2) tipos[fila[0]] = fila[1];
+    }
+    return tipos;
+}
+
+// Ejecuta el plan del dialecto, que agrupa los cambios de tipo, las columnas
+// nuevas y los renombrados en el menor numero de ALTER TABLE posible.
+template <typename Dialecto>
+void GestorCifrado::aplicarCambioEsquema(const std::string& tabla, const CambioEsquema& cambio) {
+    MedicionFase medicion("cifrado.aplicarCambioEsquema");
+    const PlanEsquema plan = Dialecto::planificarCambioEsquema(tabla, cambio);
+    for (const auto& sentencia : plan.sentencias) {
+        gestor_db->ejecutarComando(sentencia);
+    }
+    reescrituras_realizadas += plan.reescrituras;
+    reescrituras_evitadas += plan.reescrituras_evitadas;
+    if (!cambio.tipos.empty()) {
+        std::cout << "Esquema de " << tabla << ": " << plan.sentencias.size() << " sentencias, " << plan.reescrituras
+            << " reescrituras de tabla (" << plan.reescrituras_evitadas << " evitadas)." << std::endl;
+    }
+}
+
+// tabla_auditoria es la tabla aud_ a la que quedan ligadas las celdas GCM (la
+// sombra se renombra a ella) y columnas_cifradas indica si datos.columnas ya
+// son los nombres cifrados.
+template <typename Dialecto>
+void GestorCifrado::reescribirFilasCifradas(const std::string& tabla, const ResultadoConsulta& datos, const std::map<std::string, std::string>& indices_ciegos,
+    const std::string& tabla_auditoria, bool columnas_cifradas) {
+    MedicionFase medicion("cifrado.reescribirFilasCifradas");
+    std::string encabezado = Dialecto::sentenciaInsercion(tabla);
+    for (size_t i = 0; i < datos.columnas.size(); ++i) {
+        if (i > 0) encabezado += ", ";
+        Dialecto::citar(encabezado, datos.columnas[i]);
+    }
+    std::vector<size_t> posiciones_indice;
+    for (const auto& par : indices_ciegos) {
+        posiciones_indice.push_back(std::find(datos.columnas.begin(), datos.columnas.end(), par.first) - datos.columnas.begin());
+        encabezado += ", ";
+        Dialecto::citar(encabezado, par.second);
+    }
+    encabezado += ") VALUES ";
+
+    std::vector<bool> comprimir;
+    for (const auto& columna : datos.columnas) comprimir.push_back(columnaComprimida(columna));
+
+    const auto posicion_secuencia = std::find(datos.columnas.begin(), datos.columnas.end(), COLUMNA_SECUENCIA_AUDITORIA);
+    const size_t indice_secuencia = posicion_secuencia - datos.columnas.begin();
+    if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::SQLServer) {
+        if (posicion_secuencia != datos.columnas.end()) {
+            gestor_db->ejecutarComando("SET IDENTITY_INSERT " + Dialecto::tablaCalificada(tabla) + " ON");
         }
-        catch (const std::exception& e) {
-            std::cerr << "Error procesando tabla " << tabla << ": " << e.what() << std::endl;
+    }
+    const bool con_contexto = cifradoAutenticado() && posicion_secuencia != datos.columnas.end();
+    std::vector<std::string> columnas_en_claro;
+    if (con_contexto) {
+        for (const auto& columna : datos.columnas) columnas_en_claro.push_back(columnas_cifradas ? descifrarNombreColumna(columna) : columna);
+    }
+
+    // Los textos de todas las filas de una sentencia se cifran en una sola
+    // llamada a cifrarValores (un contexto y un lote de IVs por sentencia).
+    std::string sentencia;
+    std::vector<std::string> textos_planos;
+    std::vector<bool> comprimir_lote;
+    std::vector<std::string> contextos;
+    for (size_t inicio = 0; inicio < datos.filas.size(); inicio += Dialecto::filas_por_insercion) {
+        const size_t fin = std::min(datos.filas.size(), inicio + Dialecto::filas_por_insercion);
+        textos_planos.clear();
+        comprimir_lote.clear();
+        contextos.clear();
+        for (size_t f = inicio; f < fin; ++f) {
+            const size_t base = textos_planos.size();
+            textos_planos.insert(textos_planos.end(), datos.filas[f].begin(), datos.filas[f].end());
+            if (indice_secuencia < datos.filas[f].size()) textos_planos[base + indice_secuencia].clear();
+            comprimir_lote.insert(comprimir_lote.end(), comprimir.begin(), comprimir.end());
+            comprimir_lote.resize(textos_planos.size(), false);
+            if (con_contexto) {
+                for (const auto& columna : columnas_en_claro) contextos.push_back(contextoCelda(tabla_auditoria, columna, datos.filas[f][indice_secuencia]));
+                contextos.resize(textos_planos.size());
+            }
+        }
+        const std::vector<std::string> cifrados = cifrarValores(textos_planos, comprimir_lote, contextos);
+
+        sentencia = encabezado;
+        size_t posicion_cifrado = 0;
+        for (size_t f = inicio; f < fin; ++f) {
+            const auto& fila = datos.filas[f];
+            if (f > inicio) sentencia += ", ";
+            sentencia += '(';
+            for (size_t i = 0; i < fila.size(); ++i, ++posicion_cifrado) {
+                if (i > 0) sentencia += ", ";
+                if (i == indice_secuencia) sentencia += fila[i];
+                else Dialecto::literalCifrado(sentencia, cifrados[posicion_cifrado], almacenamientoBinario());
+            }
+            for (size_t posicion : posiciones_indice) {
+                sentencia += ", ";
+                if (fila[posicion] == "NULL") sentencia += "NULL";
+                else Dialecto::literal(sentencia, indiceCiego(fila[posicion]));
+            }
+            sentencia += ')';
+        }
+        gestor_db->ejecutarComando(sentencia);
+    }
+
+    if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::SQLServer) {
+        if (posicion_secuencia != datos.columnas.end()) {
+            gestor_db->ejecutarComando("SET IDENTITY_INSERT " + Dialecto::tablaCalificada(tabla) + " OFF");
         }
     }
 }
 
+void GestorCifrado::reescribirFilasCifradas(const std::string& tabla, const ResultadoConsulta& datos, const std::map<std::string, std::string>& indices_ciegos) {
+    despacharDialecto(gestor_db->getMotor(), [&](auto dialecto) {
+        reescribirFilasCifradas<decltype(dialecto)>(tabla, datos, indices_ciegos, tabla, false);
+        });
+}
+
 void GestorCifrado::eliminarIndicesMySQL(const std::string& tabla) {
     try {
         auto resultado = gestor_db->ejecutarConsultaConResultado(
@@ -385,6 +1129,7 @@ void GestorCifrado::eliminarIndicesMySQL(const std::string& tabla) {
 }
 
 std::vector<std::vector<std::string>> GestorCifrado::ejecutarConsultaConDesencriptado(const std::string& consulta) {
+    MedicionFase medicion("cifrado.ejecutarConsultaConDesencriptado");
     auto resultado_cifrado = gestor_db->ejecutarConsultaConResultado(consulta);
     std::vector<std::vector<std::string>> resultado_final;
 
@@ -392,7 +1137,7 @@ std::vector<std::vector<std::string>> GestorCifrado::ejecutarConsultaConDesencri
 
     std::vector<std::string> cabeceras_descifradas;
     for (const auto& col : resultado_cifrado.columnas) {
-        cabeceras_descifradas.push_back(descifrarNombreColumnaCesar(col, desplazamiento_cesar));
+        cabeceras_descifradas.push_back(descifrarNombreColumna(col));
     }
     resultado_final.push_back(cabeceras_descifradas);
 
@@ -406,6 +1151,141 @@ std::vector<std::vector<std::string>> GestorCifrado::ejecutarConsultaConDesencri
     return resultado_final;
 }
 
+GestorCifrado::FiltroDescifrado GestorCifrado::interpretarFiltro(const std::string& texto) {
+    const size_t inicio_operador = texto.find_first_of("=!<>");
+    if (inicio_operador == std::string::npos || inicio_operador == 0) {
+        throw std::runtime_error("Filtro no valido: " + texto + " (se espera columna, operador y valor, p. ej. FechaAccion>=2024-01-01).");
+    }
+    size_t fin_operador = texto.find_first_not_of("=!<>", inicio_operador);
+    if (fin_operador == std::string::npos) fin_operador = texto.size();
+
+    static const std::map<std::string, OperadorFiltro> operadores = {
+        { "=", OperadorFiltro::Igual }, { "==", OperadorFiltro::Igual },
+        { "!=", OperadorFiltro::Distinto }, { "<>", OperadorFiltro::Distinto },
+        { "<", OperadorFiltro::Menor }, { "<=", OperadorFiltro::MenorIgual },
+        { ">", OperadorFiltro::Mayor }, { ">=", OperadorFiltro::MayorIgual }
+    };
+    const auto operador = operadores.find(texto.substr(inicio_operador, fin_operador - inicio_operador));
+    if (operador == operadores.end()) {
+        throw std::runtime_error("Operador no valido en el filtro: " + texto);
+    }
+
+    FiltroDescifrado filtro;
+    filtro.columna = boost::trim_copy(texto.substr(0, inicio_operador));
+    filtro.operador = operador->second;
+    filtro.valor = boost::trim_copy(texto.substr(fin_operador));
+    if (filtro.valor.size() >= 2 && filtro.valor.front() == '\'' && filtro.valor.back() == '\'') {
+        filtro.valor = filtro.valor.substr(1, filtro.valor.size() - 2);
+    }
+    filtro.valor_numerico = aNumero(filtro.valor);
+    return filtro;
+}
+
+size_t GestorCifrado::ejecutarConsultaConDesencriptado(const std::string& tabla, const std::vector<std::string>& columnas, const std::vector<FiltroDescifrado>& filtros,
+    const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+    const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila,
+    long filas_por_bloque) {
+    MedicionFase medicion("cifrado.ejecutarConsultaSelectiva");
+
+    std::vector<std::string> columnas_leidas;
+    for (const auto& filtro : filtros) {
+        if (std::find(columnas_leidas.begin(), columnas_leidas.end(), filtro.columna) == columnas_leidas.end()) columnas_leidas.push_back(filtro.columna);
+    }
+    for (const auto& columna : columnas) {
+        if (std::find(columnas_leidas.begin(), columnas_leidas.end(), columna) == columnas_leidas.end()) columnas_leidas.push_back(columna);
+    }
+
+    const std::string consulta = despacharDialecto(gestor_db->getMotor(), [&](auto dialecto) {
+        using Dialecto = decltype(dialecto);
+        // Las celdas GCM "v3:" se autentican con el IdAuditoria de su fila.
+        if (!columnas.empty() && std::find(columnas_leidas.begin(), columnas_leidas.end(), COLUMNA_SECUENCIA_AUDITORIA) == columnas_leidas.end()) {
+            const auto existentes = gestor_db->ejecutarConsultaConResultado(Dialecto::paginar("SELECT * FROM " + tabla, 0)).columnas;
+            if (std::find(existentes.begin(), existentes.end(), COLUMNA_SECUENCIA_AUDITORIA) != existentes.end()) columnas_leidas.emplace_back(COLUMNA_SECUENCIA_AUDITORIA);
+        }
+        std::string sql = "SELECT ";
+        if (columnas.empty()) sql += '*';
+        for (size_t i = 0; i < columnas_leidas.size() && !columnas.empty(); ++i) {
+            if (i > 0) sql += ", ";
+            Dialecto::citar(sql, cifrarNombreColumna(columnas_leidas[i]));
+        }
+        sql += " FROM " + tabla;
+
+        // IdAuditoria no se cifra y las igualdades con indice ciego se resuelven
+        // en el servidor; el resto de filtros se evalua tras descifrar.
+        bool primera_condicion = true;
+        for (const auto& filtro : filtros) {
+            std::string condicion;
+            if (filtro.columna == COLUMNA_SECUENCIA_AUDITORIA && filtro.valor_numerico) {
+                condicion = Dialecto::citar(filtro.columna) + operadorSql(filtro.operador) + filtro.valor;
+            }
+            else if (filtro.operador == OperadorFiltro::Igual &&
+                std::find(columnas_indice_ciego.begin(), columnas_indice_ciego.end(), filtro.columna) != columnas_indice_ciego.end()) {
+                condicion = Dialecto::citar(columnaIndiceCiego(filtro.columna)) + " = '" + indiceCiego(filtro.valor) + "'";
+            }
+            else {
+                continue;
+            }
+            sql += (primera_condicion ? " WHERE " : " AND ") + condicion;
+            primera_condicion = false;
+        }
+        return sql;
+        });
+
+    std::vector<size_t> posiciones_filtro;
+    std::vector<size_t> posiciones_salida;
+    std::vector<bool> descifrada;
+    std::vector<std::string> nombres;
+    size_t posicion_id = 0;
+    std::vector<ValorCelda> fila_salida;
+    DescifradorCeldas descifrador(clave);
+    size_t filas_leidas = 0;
+
+    gestor_db->procesarConsultaPorFilas(consulta,
+        [&](const std::vector<std::string>& columnas_fisicas) {
+            nombres.reserve(columnas_fisicas.size());
+            for (const auto& columna : columnas_fisicas) nombres.push_back(descifrarNombreColumna(columna));
+            posicion_id = std::find(nombres.begin(), nombres.end(), COLUMNA_SECUENCIA_AUDITORIA) - nombres.begin();
+
+            auto posicion = [&](const std::string& columna) {
+                const auto it = std::find(nombres.begin(), nombres.end(), columna);
+                if (it == nombres.end()) throw std::runtime_error("La columna " + columna + " no existe en " + tabla + ".");
+                return static_cast<size_t>(it - nombres.begin());
+            };
+            for (const auto& filtro : filtros) posiciones_filtro.push_back(posicion(filtro.columna));
+            if (columnas.empty()) {
+                for (size_t i = 0; i < nombres.size(); ++i) posiciones_salida.push_back(i);
+                al_recibir_columnas(nombres);
+            }
+            else {
+                for (const auto& columna : columnas) posiciones_salida.push_back(posicion(columna));
+                al_recibir_columnas(columnas);
+            }
+        },
+        [&](std::vector<ValorCelda>& fila) {
+            ++filas_leidas;
+            const std::string id = posicion_id < fila.size() && !esNulo(fila[posicion_id]) ? valorATexto(fila[posicion_id]) : std::string();
+            // Cada columna se descifra una sola vez por fila aunque la usen
+            // varios filtros y la salida.
+            descifrada.assign(fila.size(), false);
+            const auto descifrar = [&](size_t posicion) -> const ValorCelda& {
+                ValorCelda& celda = fila[posicion];
+                if (descifrada[posicion]) return celda;
+                descifrada[posicion] = true;
+                descifrador.descifrarCelda(celda, id.empty() ? std::string() : contextoCelda(tabla, nombres[posicion], id));
+                return celda;
+            };
+            for (size_t i = 0; i < filtros.size(); ++i) {
+                if (!cumpleFiltro(filtros[i], descifrar(posiciones_filtro[i]))) return;
+            }
+            fila_salida.clear();
+            for (size_t posicion : posiciones_salida) fila_salida.push_back(descifrar(posicion));
+            al_recibir_fila(fila_salida);
+        },
+        filas_por_bloque);
+
+    return filas_leidas;
+}
+
 void GestorCifrado::prepararCifradoSQLServer() {
     try {
         gestor_db->ejecutarComando("CREATE MASTER KEY ENCRYPTION BY PASSWORD = 'DevPasswordComplexEnough#123!'");
@@ -428,110 +1308,139 @@ void GestorCifrado::prepararCifradoSQLServer() {
     gestor_db->ejecutarComando(preparacion_sql);
 }
 
-void GestorCifrado::actualizarTriggersParaCifrado(const std::string& nombre_tabla_original, const std::map<std::string, std::string>& mapa_columnas) {
-    nlohmann::json datos;
-    datos["tabla"] = nombre_tabla_original;
-    datos["tabla_auditoria"] = "aud_" + nombre_tabla_original;
-    datos["clave_hex"] = clave_hex;
-
-    std::ostringstream columnas_cifradas_lista, valores_insert_new, valores_update_old, valores_delete_old;
-    bool first = true;
+template <typename Dialecto>
+void GestorCifrado::actualizarTriggersParaCifrado(const std::string& nombre_tabla_original, const std::map<std::string, std::string>& indices_ciegos) {
+    if constexpr (Dialecto::plantilla_cifrado.empty()) {
+        return;
+    }
+    else {
+        nlohmann::json datos;
+        datos["tabla"] = nombre_tabla_original;
+        datos["tabla_auditoria"] = "aud_" + nombre_tabla_original;
+        datos["clave_hex"] = clave_hex;
+        datos["clave_indice_hex"] = bytesAHex(clave_indice.data(), clave_indice.size());
+        datos["clave_indice_ipad"] = claveHmacCombinada(clave_indice, 0x36);
+        datos["clave_indice_opad"] = claveHmacCombinada(clave_indice, 0x5c);
+        datos["almacenamiento_binario"] = almacenamientoBinario();
+        datos["indice_ciego"] = !indices_ciegos.empty();
+
+        std::string columnas_cifradas_lista, valores_insert_new, valores_update_old, valores_delete_old;
+
+        auto resultado_columnas_original = gestor_db->ejecutarConsultaConResultado(Dialecto::paginar("SELECT * FROM " + nombre_tabla_original, 1));
+
+        for (const auto& col_name : resultado_columnas_original.columnas) {
+            if (!columnas_cifradas_lista.empty()) {
+                columnas_cifradas_lista += ", ";
+                valores_insert_new += ", ";
+                valores_update_old += ", ";
+                valores_delete_old += ", ";
+            }
 
-    auto resultado_columnas_original = gestor_db->ejecutarConsultaConResultado("SELECT * FROM " + nombre_tabla_original + " LIMIT 1");
-    std::vector<std::string> nombres_columnas_original = resultado_columnas_original.columnas;
+            Dialecto::citar(columnas_cifradas_lista, cifrarNombreColumnaCesar(col_name, desplazamiento_cesar));
 
-    for (const auto& col_name : nombres_columnas_original) {
-        if (!first) {
-            columnas_cifradas_lista << ", ";
-            valores_insert_new << ", ";
-            valores_update_old << ", ";
-            valores_delete_old << ", ";
+            const std::string columna_citada = Dialecto::citar(col_name);
+            valores_insert_new += Dialecto::expresionCifrado(std::string(Dialecto::registro_nuevo) + columna_citada);
+            std::string valor_old = Dialecto::expresionCifrado(std::string(Dialecto::registro_viejo) + columna_citada);
+            valores_update_old += valor_old;
+            valores_delete_old += valor_old;
         }
 
-        std::string cast_str, quote_open, quote_close, record_prefix_new, record_prefix_old;
-        switch (gestor_db->getMotor()) {
-        case GestorAuditoria::MotorDB::PostgreSQL:
-            cast_str = "::TEXT"; quote_open = "\""; quote_close = "\""; record_prefix_new = "NEW."; record_prefix_old = "OLD."; break;
-        case GestorAuditoria::MotorDB::MySQL:
-            cast_str = ""; quote_open = "`"; quote_close = "`"; record_prefix_new = "NEW."; record_prefix_old = "OLD."; break;
-        case GestorAuditoria::MotorDB::SQLServer:
-            cast_str = ")"; quote_open = "["; quote_close = "]"; record_prefix_new = "i."; record_prefix_old = "d."; break;
-        default: break;
+        for (const char* columna_control : { "UsuarioAccion", "FechaAccion", "AccionSql" }) {
+            columnas_cifradas_lista += ", ";
+            Dialecto::citar(columnas_cifradas_lista, cifrarNombreColumnaCesar(columna_control, desplazamiento_cesar));
         }
 
-        columnas_cifradas_lista << quote_open << cifrarNombreColumnaCesar(col_name, desplazamiento_cesar) << quote_close;
+        const std::string valores_control = ", " + Dialecto::expresionCifrado(Dialecto::expresion_usuario) + ", " + Dialecto::expresionCifrado(Dialecto::expresion_fecha) + ", ";
+        valores_insert_new += valores_control + Dialecto::expresionCifrado("'Insertado'");
+        valores_update_old += valores_control + Dialecto::expresionCifrado("'Modificado'");
+        valores_delete_old += valores_control + Dialecto::expresionCifrado("'Eliminado'");
 
-        if (gestor_db->getMotor() == GestorAuditoria::MotorDB::SQLServer) {
-            valores_insert_new << "EncryptByKey(Key_GUID('AuditoriaKey'), CAST(" << record_prefix_new << quote_open << col_name << quote_close << " AS NVARCHAR(MAX))" << cast_str;
-            valores_update_old << "EncryptByKey(Key_GUID('AuditoriaKey'), CAST(" << record_prefix_old << quote_open << col_name << quote_close << " AS NVARCHAR(MAX))" << cast_str;
-            valores_delete_old << "EncryptByKey(Key_GUID('AuditoriaKey'), CAST(" << record_prefix_old << quote_open << col_name << quote_close << " AS NVARCHAR(MAX))" << cast_str;
-        }
-        else {
-            valores_insert_new << "encrypt_val(" << record_prefix_new << quote_open << col_name << quote_close << cast_str << ")";
-            valores_update_old << "encrypt_val(" << record_prefix_old << quote_open << col_name << quote_close << cast_str << ")";
-            valores_delete_old << "encrypt_val(" << record_prefix_old << quote_open << col_name << quote_close << cast_str << ")";
+        for (const auto& par : indices_ciegos) {
+            if (std::find(resultado_columnas_original.columnas.begin(), resultado_columnas_original.columnas.end(), par.first) == resultado_columnas_original.columnas.end()) {
+                continue;
+            }
+            columnas_cifradas_lista += ", ";
+            Dialecto::citar(columnas_cifradas_lista, par.second);
+            const std::string columna_citada = Dialecto::citar(par.first);
+            valores_insert_new += ", " + Dialecto::expresionIndiceCiego(std::string(Dialecto::registro_nuevo) + columna_citada);
+            std::string indice_old = ", " + Dialecto::expresionIndiceCiego(std::string(Dialecto::registro_viejo) + columna_citada);
+            valores_update_old += indice_old;
+            valores_delete_old += indice_old;
         }
 
-        first = false;
+        datos["lista_columnas_cifradas"] = columnas_cifradas_lista;
+        datos["valores_insert_new"] = valores_insert_new;
+        datos["valores_update_old"] = valores_update_old;
+        datos["valores_delete_old"] = valores_delete_old;
+
+        std::string sql_comando = GestorPlantillas::instancia().renderizar(std::string(Dialecto::plantilla_cifrado), datos);
+        gestor_db->ejecutarComando(sql_comando);
+
+        // dbo.blind_idx debe hashear los mismos bytes UTF-8 que indiceCiego, o las
+        // busquedas no encuentran las filas escritas por el trigger.
+        if constexpr (Dialecto::motor == GestorAuditoria::MotorDB::SQLServer) {
+            if (!indices_ciegos.empty()) {
+                auto prueba = gestor_db->ejecutarConsultaConResultado("SELECT dbo.blind_idx(" + std::string(VECTOR_INDICE_CIEGO_SQLSERVER) + ")");
+                if (prueba.filas.empty() || prueba.filas[0][0] != indiceCiego(VECTOR_INDICE_CIEGO)) {
+                    throw std::runtime_error("dbo.blind_idx no coincide con el indice ciego calculado en C++ para un valor no ASCII.");
+                }
+            }
+        }
     }
-
-    std::string quote_open, quote_close;
-    switch (gestor_db->getMotor()) {
-    case GestorAuditoria::MotorDB::PostgreSQL:
-        quote_open = "\""; quote_close = "\""; break;
-    case GestorAuditoria::MotorDB::MySQL:
-        quote_open = "`"; quote_close = "`"; break;
-    case GestorAuditoria::MotorDB::SQLServer:
-        quote_open = "["; quote_close = "]"; break;
-    default: break;
-    }
-
-    columnas_cifradas_lista << ", " << quote_open << cifrarNombreColumnaCesar("UsuarioAccion", desplazamiento_cesar) << quote_close
-        << ", " << quote_open << cifrarNombreColumnaCesar("FechaAccion", desplazamiento_cesar) << quote_close
-        << ", " << quote_open << cifrarNombreColumnaCesar("AccionSql", desplazamiento_cesar) << quote_close;
-
-    switch (gestor_db->getMotor()) {
-    case GestorAuditoria::MotorDB::PostgreSQL:
-        valores_insert_new << ", encrypt_val(SESSION_USER::TEXT), encrypt_val(NOW()::TEXT), encrypt_val('Insertado')";
-        valores_update_old << ", encrypt_val(SESSION_USER::TEXT), encrypt_val(NOW()::TEXT), encrypt_val('Modificado')";
-        valores_delete_old << ", encrypt_val(SESSION_USER::TEXT), encrypt_val(NOW()::TEXT), encrypt_val('Eliminado')";
-        break;
-    case GestorAuditoria::MotorDB::MySQL:
-        valores_insert_new << ", encrypt_val(SUBSTRING_INDEX(CURRENT_USER(),'@',1)), encrypt_val(CAST(NOW() AS CHAR)), encrypt_val('Insertado')";
-        valores_update_old << ", encrypt_val(SUBSTRING_INDEX(CURRENT_USER(),'@',1)), encrypt_val(CAST(NOW() AS CHAR)), encrypt_val('Modificado')";
-        valores_delete_old << ", encrypt_val(SUBSTRING_INDEX(CURRENT_USER(),'@',1)), encrypt_val(CAST(NOW() AS CHAR)), encrypt_val('Eliminado')";
-        break;
-    case GestorAuditoria::MotorDB::SQLServer:
-        valores_insert_new << ", EncryptByKey(Key_GUID('AuditoriaKey'), CAST(SUSER_SNAME() AS NVARCHAR(MAX))), EncryptByKey(Key_GUID('AuditoriaKey'), CAST(GETDATE() AS NVARCHAR(MAX))), EncryptByKey(Key_GUID('AuditoriaKey'), CAST('Insertado' AS NVARCHAR(MAX)))";
-        valores_update_old << ", EncryptByKey(Key_GUID('AuditoriaKey'), CAST(SUSER_SNAME() AS NVARCHAR(MAX))), EncryptByKey(Key_GUID('AuditoriaKey'), CAST(GETDATE() AS NVARCHAR(MAX))), EncryptByKey(Key_GUID('AuditoriaKey'), CAST('Modificado' AS NVARCHAR(MAX)))";
-        valores_delete_old << ", EncryptByKey(Key_GUID('AuditoriaKey'), CAST(SUSER_SNAME() AS NVARCHAR(MAX))), EncryptByKey(Key_GUID('AuditoriaKey'), CAST(GETDATE() AS NVARCHAR(MAX))), EncryptByKey(Key_GUID('AuditoriaKey'), CAST('Eliminado' AS NVARCHAR(MAX)))";
-        break;
-    default: break;
-    }
-
-    datos["lista_columnas_cifradas"] = columnas_cifradas_lista.str();
-    datos["valores_insert_new"] = valores_insert_new.str();
-    datos["valores_update_old"] = valores_update_old.str();
-    datos["valores_delete_old"] = valores_delete_old.str();
-
-    std::string plantilla_a_usar;
-    switch (gestor_db->getMotor()) {
-    case GestorAuditoria::MotorDB::PostgreSQL:
-        plantilla_a_usar = "PostgresAuditCifrado.tpl";
-        break;
-    case GestorAuditoria::MotorDB::MySQL:
-        plantilla_a_usar = "MySqlAuditCifrado.tpl";
-        break;
-    case GestorAuditoria::MotorDB::SQLServer:
-        plantilla_a_usar = "SqlServerAuditCifrado.tpl";
-        break;
-    default: return;
-    }
-
-    std::string sql_comando = env_plantillas.render_file(plantilla_a_usar, datos);
-    gestor_db->ejecutarComando(sql_comando);
 }
 
 std::string GestorCifrado::getClave() const {
     return clave_hex;
-}
\ No newline at end of file
+}
+
+std::string GestorCifrado::cifrarNombreColumna(const std::string& nombre) const {
+    if (nombre == COLUMNA_SECUENCIA_AUDITORIA) return nombre;
+    return cifrarNombreColumnaCesar(nombre, desplazamiento_cesar);
+}
+
+std::string GestorCifrado::descifrarNombreColumna(const std::string& nombre_cifrado) const {
+    if (nombre_cifrado == COLUMNA_SECUENCIA_AUDITORIA) return nombre_cifrado;
+    return descifrarNombreColumnaCesar(nombre_cifrado, desplazamiento_cesar);
+}
+
+std::string GestorCifrado::columnaIndiceCiego(const std::string& columna) const {
+    return cifrarNombreColumnaCesar(PREFIJO_INDICE_CIEGO + columna, desplazamiento_cesar);
+}
+
+std::string GestorCifrado::columnaOrigenIndiceCiego(const std::string& columna_fisica) const {
+    const std::string nombre = descifrarNombreColumna(columna_fisica);
+    return boost::starts_with(nombre, PREFIJO_INDICE_CIEGO) ? nombre.substr(PREFIJO_INDICE_CIEGO.size()) : std::string();
+}
+
+void GestorCifrado::regenerarTriggersCifrado(const std::string& tabla_auditoria, const std::vector<std::string>& columnas_indice) {
+    std::map<std::string, std::string> indices_ciegos;
+    for (const auto& columna : columnas_indice) indices_ciegos[columna] = columnaIndiceCiego(columna);
+
+    std::string nombre_tabla_original = tabla_auditoria;
+    boost::replace_first(nombre_tabla_original, "aud_", "");
+    boost::replace_first(nombre_tabla_original, "Aud", "");
+    despacharDialecto(gestor_db->getMotor(), [&](auto dialecto) {
+        actualizarTriggersParaCifrado<decltype(dialecto)>(nombre_tabla_original, indices_ciegos);
+        });
+}
+
+void GestorCifrado::setColumnasIndiceCiego(const std::string& lista_columnas) {
+    columnas_indice_ciego = listaDeColumnas(lista_columnas, "indice ciego");
+}
+
+void GestorCifrado::setColumnasComprimidas(const std::string& lista_columnas, size_t umbral_bytes) {
+    columnas_comprimidas = listaDeColumnas(lista_columnas, "compresion");
+    umbral_compresion = umbral_bytes;
+}
+
+// Acepta el nombre original o el desplazado de una columna de aud_.
+bool GestorCifrado::columnaComprimida(const std::string& columna) const {
+    if (columnas_comprimidas.empty()) return false;
+    return std::find(columnas_comprimidas.begin(), columnas_comprimidas.end(), columna) != columnas_comprimidas.end() ||
+        std::find(columnas_comprimidas.begin(), columnas_comprimidas.end(), descifrarNombreColumna(columna)) != columnas_comprimidas.end();
+}
+
+std::string GestorCifrado::indiceCiego(const std::string& texto_plano) const {
+    auto hmac = hmacSha256(clave_indice, texto_plano);
+    return bytesAHex(hmac.data(), BYTES_INDICE_CIEGO);
+}
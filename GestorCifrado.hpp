@@ -3,28 +3,107 @@
 #include <vector>
 #include <memory>
 #include <map>
-#include <inja/inja.hpp>
+#include <optional>
+#include <functional>
+#include "ValorCelda.hpp"
 
 class GestorAuditoria;
+struct ResultadoConsulta;
+struct CambioEsquema;
 
 class GestorCifrado {
 public:
+    // Formato de las celdas cifradas en C++. Cbc es el formato original (IV y
+    // bloques en hexadecimal, igual que encrypt_val); Gcm antepone "v2:" y agrega
+    // la etiqueta de autenticacion, o "v3:" si la etiqueta cubre tambien el
+    // contexto de la celda (contextoCelda). Al descifrar se detecta el formato de
+    // cada celda.
+    enum class FormatoCifrado { Cbc, Gcm };
+    // Tipo de las columnas cifradas de las tablas aud_: texto con el cifrado en
+    // hexadecimal, o columnas binarias (BYTEA, LONGBLOB, VARBINARY(MAX), BLOB)
+    // con los mismos bytes, que ocupan la mitad.
+    enum class AlmacenamientoCifrado { Hexadecimal, Binario };
+    enum class OperadorFiltro { Igual, Distinto, Menor, MenorIgual, Mayor, MayorIgual };
+
+    // Condicion "columna operador valor" evaluada sobre el valor descifrado. Si el
+    // valor es numerico, la comparacion es numerica; si no, lexicografica.
+    struct FiltroDescifrado {
+        std::string columna;
+        OperadorFiltro operador;
+        std::string valor;
+        std::optional<double> valor_numerico;
+    };
+
     GestorCifrado(std::shared_ptr<GestorAuditoria> gestor, const std::string& clave_encriptacion_hex);
     void cifrarTablasDeAuditoria();
     std::vector<std::vector<std::string>> ejecutarConsultaConDesencriptado(const std::string& consulta);
+    size_t ejecutarConsultaConDesencriptado(const std::string& tabla, const std::vector<std::string>& columnas, const std::vector<FiltroDescifrado>& filtros,
+        const std::function<void(const std::vector<std::string>&)>& al_recibir_columnas,
+        const std::function<void(std::vector<ValorCelda>&)>& al_recibir_fila,
+        long filas_por_bloque = 1);
+    static FiltroDescifrado interpretarFiltro(const std::string& texto);
     void cifrarFilaEInsertar(const std::string& tabla, const std::vector<std::string>& columnas, const std::vector<std::string>& fila, const std::string& accion);
+    // Inserta las filas en tabla con sus valores cifrados, como al cifrar una
+    // tabla aud_ con datos; la tabla debe tener columnas de texto.
+    void reescribirFilasCifradas(const std::string& tabla, const ResultadoConsulta& datos, const std::map<std::string, std::string>& indices_ciegos = {});
+    // Contexto de una celda de la tabla aud_ tabla: la columna en claro y el
+    // IdAuditoria de su fila. En GCM se autentica con la celda, de modo que una
+    // celda copiada a otra fila, columna o tabla no se descifra.
+    static std::string contextoCelda(const std::string& tabla, const std::string& columna, const std::string& id_auditoria);
+    // Contextos de las celdas de una fila leida de tabla, por columna fisica
+    // (nombres cifrados); vacio si la fila no trae IdAuditoria.
+    std::vector<std::string> contextosDeFila(const std::string& tabla, const std::vector<std::string>& columnas, const std::vector<ValorCelda>& fila) const;
+    bool cifradoAutenticado() const;
     std::string getClave() const;
+    // Con comprimir, los valores de al menos umbral_compresion bytes se comprimen
+    // con zstd antes de cifrar si asi ocupan menos; una cabecera en el texto plano
+    // lo marca y al descifrar se descomprimen sin que el llamador lo note.
+    std::string cifrarValor(const std::string& texto_plano, bool comprimir = false) const;
+    std::string descifrarValor(const std::string& texto_cifrado_hex, const std::string& contexto = {}) const;
+    // contextos[i], si no esta vacio, es el contexto de la celda i.
+    std::vector<std::string> cifrarValores(const std::vector<std::string>& textos_planos, const std::vector<bool>& comprimir = {}, const std::vector<std::string>& contextos = {}) const;
+    void descifrarCeldas(std::vector<ValorCelda>& celdas, bool descomprimir = true, const std::vector<std::string>& contextos = {}) const;
+    static std::string descomprimirValor(const std::string& texto_plano);
+    void setFormatoCifrado(FormatoCifrado formato);
+    void setAlmacenamiento(AlmacenamientoCifrado nuevo_almacenamiento);
+    bool almacenamientoBinario() const;
+    static AlmacenamientoCifrado interpretarAlmacenamiento(const std::string& texto);
+    void setMigracionEnLinea(bool en_linea);
+    static FormatoCifrado interpretarFormatoCifrado(const std::string& texto);
+    std::string cifrarNombreColumna(const std::string& nombre) const;
+    std::string descifrarNombreColumna(const std::string& nombre_cifrado) const;
+    void setColumnasIndiceCiego(const std::string& lista_columnas);
+    void setColumnasComprimidas(const std::string& lista_columnas, size_t umbral_bytes);
+    bool columnaComprimida(const std::string& columna) const;
+    std::string indiceCiego(const std::string& texto_plano) const;
+    std::string columnaIndiceCiego(const std::string& columna) const;
+    std::string columnaOrigenIndiceCiego(const std::string& columna_fisica) const;
+    void regenerarTriggersCifrado(const std::string& tabla_auditoria, const std::vector<std::string>& columnas_indice);
 
 private:
     std::shared_ptr<GestorAuditoria> gestor_db;
     std::string clave_hex;
     std::vector<unsigned char> clave;
+    std::vector<unsigned char> clave_indice;
+    std::vector<std::string> columnas_indice_ciego;
+    std::vector<std::string> columnas_comprimidas;
+    size_t umbral_compresion = 256;
     int desplazamiento_cesar;
-    inja::Environment env_plantillas;
+    FormatoCifrado formato_cifrado = FormatoCifrado::Cbc;
+    AlmacenamientoCifrado almacenamiento = AlmacenamientoCifrado::Hexadecimal;
+    bool migracion_en_linea = false;
+    size_t reescrituras_realizadas = 0;
+    size_t reescrituras_evitadas = 0;
 
-    std::string cifrarValor(const std::string& texto_plano);
-    std::string descifrarValor(const std::string& texto_cifrado_hex);
     void prepararCifradoSQLServer();
-    void actualizarTriggersParaCifrado(const std::string& nombre_tabla_original, const std::map<std::string, std::string>& mapa_columnas);
+    template <typename Dialecto> void cifrarTablaDeAuditoria(const std::string& tabla);
+    template <typename Dialecto> void cifrarTablaDeAuditoriaEnLinea(const std::string& tabla);
+    template <typename Dialecto> size_t aplicarCambiosEnSombra(const std::string& tabla, const std::string& sombra, const std::string& cambios, const std::string& columnas_texto,
+        const std::map<std::string, std::string>& indices_ciegos);
+    template <typename Dialecto> std::map<std::string, std::string> tiposDeColumnas(const std::string& tabla);
+    template <typename Dialecto> void aplicarCambioEsquema(const std::string& tabla, const CambioEsquema& cambio);
+    template <typename Dialecto> void reescribirFilasCifradas(const std::string& tabla, const ResultadoConsulta& datos, const std::map<std::string, std::string>& indices_ciegos,
+        const std::string& tabla_auditoria, bool columnas_cifradas);
+    template <typename Dialecto> void actualizarTriggersParaCifrado(const std::string& nombre_tabla_original, const std::map<std::string, std::string>& indices_ciegos);
     void eliminarIndicesMySQL(const std::string& tabla);
 };
\ No newline at end of file
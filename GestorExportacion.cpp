@@ -1,6 +1,187 @@
 #include "GestorExportacion.hpp"
 #include <iostream>
 #include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <optional>
+#include <set>
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include "DialectoSql.hpp"
+#include "FormatoColumnar.hpp"
+#include "EscritorSalida.hpp"
+#include "Perfilador.hpp"
+
+namespace {
+
+constexpr char FIRMA_COPIA[] = "PGCOPY\n\377\r\n";
+constexpr std::size_t LONGITUD_FIRMA_COPIA = 11;
+constexpr std::size_t TAMANO_BLOQUE_COPIA = 1024 * 1024;
+constexpr long FILAS_POR_BLOQUE_ODBC = 1024;
+constexpr int VERSION_MANIFIESTO = 1;
+// Variable de sesion que los triggers de auditoria de MySQL consultan para no
+// registrar las filas que carga una restauracion.
+constexpr char VARIABLE_RESTAURACION_MYSQL[] = "@shc134_restauracion";
+
+std::int32_t leerBE32(const char* datos) {
+    std::uint32_t valor = 0;
+    for (int i = 0; i < 4; ++i) valor = (valor << 8) | static_cast<unsigned char>(datos[i]);
+    return static_cast<std::int32_t>(valor);
+}
+
+std::int16_t leerBE16(const char* datos) {
+    return static_cast<std::int16_t>((static_cast<unsigned char>(datos[0]) << 8) | static_cast<unsigned char>(datos[1]));
+}
+
+void anexarBE32(std::string& salida, std::int32_t valor) {
+    const std::uint32_t bits = static_cast<std::uint32_t>(valor);
+    salida += static_cast<char>(bits >> 24);
+    salida += static_cast<char>(bits >> 16);
+    salida += static_cast<char>(bits >> 8);
+    salida += static_cast<char>(bits);
+}
+
+void anexarBE16(std::string& salida, std::int16_t valor) {
+    const std::uint16_t bits = static_cast<std::uint16_t>(valor);
+    salida += static_cast<char>(bits >> 8);
+    salida += static_cast<char>(bits);
+}
+
+class LectorCopiaBinaria {
+public:
+    explicit LectorCopiaBinaria(EscritorColumnar& escritor) : escritor(escritor) {}
+
+    void consumir(const char* datos, int longitud) {
+        pendiente.append(datos, longitud);
+        std::size_t pos = 0;
+        if (!cabecera_leida) {
+            if (pendiente.size() < LONGITUD_FIRMA_COPIA + 8) return;
+            if (std::memcmp(pendiente.data(), FIRMA_COPIA, LONGITUD_FIRMA_COPIA) != 0) {
+                throw std::runtime_error("Cabecera COPY binaria no reconocida.");
+            }
+            const std::size_t extension = static_cast<std::uint32_t>(leerBE32(pendiente.data() + LONGITUD_FIRMA_COPIA + 4));
+            if (pendiente.size() < LONGITUD_FIRMA_COPIA + 8 + extension) return;
+            pos = LONGITUD_FIRMA_COPIA + 8 + extension;
+            cabecera_leida = true;
+        }
+
+        while (!fin && pos + 2 <= pendiente.size()) {
+            const std::int16_t num_campos = leerBE16(pendiente.data() + pos);
+            if (num_campos == -1) {
+                fin = true;
+                pos += 2;
+                break;
+            }
+
+            std::size_t cursor = pos + 2;
+            bool completa = true;
+            for (std::int16_t c = 0; c < num_campos && completa; ++c) {
+                if (cursor + 4 > pendiente.size()) {
+                    completa = false;
+                    break;
+                }
+                const std::int32_t longitud_campo = leerBE32(pendiente.data() + cursor);
+                cursor += 4;
+                if (longitud_campo > 0) {
+                    if (cursor + longitud_campo > pendiente.size()) completa = false;
+                    cursor += longitud_campo;
+                }
+            }
+            if (!completa) break;
+
+            cursor = pos + 2;
+            for (std::int16_t c = 0; c < num_campos; ++c) {
+                const std::int32_t longitud_campo = leerBE32(pendiente.data() + cursor);
+                cursor += 4;
+                escritor.agregarCampoCopia(c, pendiente.data() + cursor, longitud_campo);
+                if (longitud_campo > 0) cursor += longitud_campo;
+            }
+            escritor.finalizarFila();
+            pos = cursor;
+        }
+        pendiente.erase(0, pos);
+    }
+
+    bool terminado() const { return fin; }
+
+private:
+    EscritorColumnar& escritor;
+    std::string pendiente;
+    bool cabecera_leida = false;
+    bool fin = false;
+};
+
+std::string nombreMotor(GestorAuditoria::MotorDB motor) {
+    switch (motor) {
+    case GestorAuditoria::MotorDB::PostgreSQL: return "postgres";
+    case GestorAuditoria::MotorDB::MySQL: return "mysql";
+    case GestorAuditoria::MotorDB::SQLServer: return "sqlserver";
+    case GestorAuditoria::MotorDB::SQLite: return "sqlite";
+    }
+    return "";
+}
+
+std::string nombreSeguro(const std::string& texto) {
+    std::string nombre;
+    nombre.reserve(texto.size());
+    for (char c : texto) {
+        nombre += (std::isalnum(static_cast<unsigned char>(c)) || c == '_') ? c : '_';
+    }
+    return nombre;
+}
+
+std::string nombreArchivoTabla(std::size_t indice, const std::string& tabla) {
+    char prefijo[16];
+    std::snprintf(prefijo, sizeof(prefijo), "%04zu_", indice);
+    return prefijo + nombreSeguro(tabla) + ".shcb";
+}
+
+template <typename D>
+void anexarValorSql(std::string& sentencia, const ValorCelda& valor) {
+    switch (valor.index()) {
+    case 0:
+        sentencia += "NULL";
+        break;
+    case 1:
+        sentencia += std::get<bool>(valor) ? '1' : '0';
+        break;
+    case 2:
+        anexarValorTexto(sentencia, valor);
+        break;
+    case 3:
+        if (std::isfinite(std::get<double>(valor))) anexarValorTexto(sentencia, valor);
+        else D::literal(sentencia, valorATexto(valor));
+        break;
+    case 5: {
+        const Bytes& bytes = std::get<Bytes>(valor);
+        D::literalBinario(sentencia, bytes.data(), bytes.size());
+        break;
+    }
+    case 7: {
+        // El desfase "+00" de un timestamptz solo lo aceptan los literales de
+        // PostgreSQL; en el resto de motores se escribe la hora UTC.
+        FechaHora fecha_hora = std::get<FechaHora>(valor);
+        if constexpr (D::motor != GestorAuditoria::MotorDB::PostgreSQL) fecha_hora.utc = false;
+        D::literalFechaHora(sentencia, valorATexto(fecha_hora));
+        break;
+    }
+    case 8:
+        sentencia += std::get<Numerico>(valor).digitos;
+        break;
+    default:
+        D::literal(sentencia, valorATexto(valor));
+        break;
+    }
+}
+
+}
 
 GestorExportacion::GestorExportacion(
     GestorAuditoria::MotorDB motor,
@@ -10,6 +191,11 @@ GestorExportacion::GestorExportacion(
 {
 }
 
+GestorExportacion::GestorExportacion(GestorAuditoria::MotorDB motor, const std::string& info_conexion, const std::string& db, unsigned int num_trabajadores)
+    : motor_db(motor), db_name(db), info_conexion(info_conexion), num_trabajadores(std::max(1u, num_trabajadores))
+{
+}
+
 bool GestorExportacion::exportarRespaldo(const std::string& ruta_archivo_salida) {
     std::string comando_dump;
     std::cout << "Iniciando exportacion completa de la base de datos..." << std::endl;
@@ -39,4 +225,545 @@ bool GestorExportacion::exportarRespaldo(const std::string& ruta_archivo_salida)
 
     std::cout << "Exportacion completada. Respaldo guardado en: " << ruta_archivo_salida << std::endl;
     return true;
+}
+
+std::vector<std::string> GestorExportacion::obtenerTablasDeDatos(GestorAuditoria& conexion) {
+    std::vector<std::string> tablas;
+    for (auto& tabla : conexion.obtenerNombresDeTablas(true)) {
+        if (tabla.rfind("sqlite_", 0) == 0 || tabla == "sysdiagrams") continue;
+        tablas.push_back(std::move(tabla));
+    }
+    return tablas;
+}
+
+// Con preparar_conexion, todas las conexiones se abren y preparan antes de
+// repartir las tareas y despues se llama a al_preparar_conexiones; asi cada
+// conexion puede fijar su instantanea mientras el coordinador la sostiene.
+void GestorExportacion::ejecutarEnParalelo(std::size_t num_tareas, const std::function<void(GestorAuditoria&, std::size_t)>& tarea,
+    const std::function<void(GestorAuditoria&)>& preparar_conexion, const std::function<void()>& al_preparar_conexiones) {
+    std::atomic<std::size_t> siguiente{ 0 };
+    std::atomic<bool> fallo{ false };
+    std::string primer_error;
+
+    const std::size_t total_trabajadores = std::max<std::size_t>(1, std::min<std::size_t>(num_trabajadores, num_tareas));
+    std::vector<std::unique_ptr<GestorAuditoria>> conexiones;
+    if (preparar_conexion) {
+        for (std::size_t i = 0; i < total_trabajadores; ++i) {
+            conexiones.push_back(std::make_unique<GestorAuditoria>(motor_db, info_conexion, db_name));
+            if (!conexiones.back()->estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+            preparar_conexion(*conexiones.back());
+        }
+        if (al_preparar_conexiones) al_preparar_conexiones();
+    }
+
+    auto trabajador = [&](std::size_t numero) {
+        try {
+            std::unique_ptr<GestorAuditoria> conexion = numero < conexiones.size() ? std::move(conexiones[numero]) : nullptr;
+            if (!conexion) {
+                conexion = std::make_unique<GestorAuditoria>(motor_db, info_conexion, db_name);
+                if (!conexion->estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+            }
+            for (std::size_t i = siguiente++; i < num_tareas && !fallo; i = siguiente++) {
+                tarea(*conexion, i);
+            }
+        }
+        catch (const std::exception& e) {
+            std::lock_guard<std::mutex> bloqueo(mutex_salida);
+            if (!fallo.exchange(true)) primer_error = e.what();
+        }
+        };
+
+    std::vector<std::thread> hilos;
+    hilos.reserve(total_trabajadores);
+    for (std::size_t i = 0; i < total_trabajadores; ++i) hilos.emplace_back(trabajador, i);
+    for (auto& hilo : hilos) hilo.join();
+
+    if (fallo) throw std::runtime_error(primer_error);
+}
+
+template <typename D>
+std::uint64_t GestorExportacion::exportarTabla(GestorAuditoria& conexion, const std::string& tabla, const std::string& ruta, std::vector<std::string>& columnas) {
+    MedicionFase medicion("exportacion.exportarTabla");
+    const std::string consulta = "SELECT * FROM " + D::tablaCalificada(tabla);
+
+    if constexpr (D::motor == GestorAuditoria::MotorDB::PostgreSQL) {
+        columnas = conexion.ejecutarConsultaTipada(D::paginar(consulta, 0)).columnas;
+        EscritorColumnar escritor(ruta, FormatoValores::CopiaBinariaPostgreSQL, columnas);
+        LectorCopiaBinaria lector(escritor);
+        conexion.exportarCopiaPostgreSQL("COPY " + D::tablaCalificada(tabla) + " TO STDOUT (FORMAT binary)",
+            [&](const char* datos, int longitud) { lector.consumir(datos, longitud); });
+        if (!lector.terminado()) throw std::runtime_error("Flujo COPY incompleto para la tabla: " + tabla);
+        escritor.cerrar();
+        return escritor.filasEscritas();
+    }
+    else {
+        const long filas_por_bloque = conexion.admiteLecturaPorBloques(D::paginar(consulta, 0)) ? FILAS_POR_BLOQUE_ODBC : 1;
+        std::optional<EscritorColumnar> escritor;
+        conexion.procesarConsultaPorFilas(consulta,
+            [&](const std::vector<std::string>& nombres) {
+                columnas = nombres;
+                escritor.emplace(ruta, FormatoValores::ValorEtiquetado, columnas);
+            },
+            [&](std::vector<ValorCelda>& fila) {
+                for (std::size_t c = 0; c < fila.size(); ++c) escritor->agregarValor(c, fila[c]);
+                escritor->finalizarFila();
+            },
+            filas_por_bloque);
+        if (!escritor) escritor.emplace(ruta, FormatoValores::ValorEtiquetado, columnas);
+        escritor->cerrar();
+        return escritor->filasEscritas();
+    }
+}
+
+template <typename D>
+std::uint64_t GestorExportacion::importarTabla(GestorAuditoria& conexion, const std::string& tabla, const std::string& ruta) {
+    MedicionFase medicion("exportacion.importarTabla");
+    LectorColumnar lector(ruta);
+    const auto& columnas = lector.columnas();
+    std::uint64_t filas = 0;
+
+    std::string lista_columnas;
+    for (std::size_t c = 0; c < columnas.size(); ++c) {
+        if (c > 0) lista_columnas += ", ";
+        D::citar(lista_columnas, columnas[c]);
+    }
+
+    if constexpr (D::motor == GestorAuditoria::MotorDB::PostgreSQL) {
+        if (lector.formato() != FormatoValores::CopiaBinariaPostgreSQL) {
+            throw std::runtime_error("El archivo de la tabla " + tabla + " no contiene datos COPY de PostgreSQL.");
+        }
+
+        bool cabecera_enviada = false;
+        bool terminado = false;
+        std::size_t fila_actual = 0;
+        conexion.importarCopiaPostgreSQL("COPY " + D::tablaCalificada(tabla) + " (" + lista_columnas + ") FROM STDIN (FORMAT binary)",
+            [&](std::string& bloque) {
+                bloque.clear();
+                if (terminado) return false;
+                if (!cabecera_enviada) {
+                    bloque.append(FIRMA_COPIA, LONGITUD_FIRMA_COPIA);
+                    anexarBE32(bloque, 0);
+                    anexarBE32(bloque, 0);
+                    cabecera_enviada = true;
+                }
+                while (bloque.size() < TAMANO_BLOQUE_COPIA) {
+                    if (fila_actual >= lector.filasEnGrupo()) {
+                        if (!lector.leerGrupo()) {
+                            anexarBE16(bloque, -1);
+                            terminado = true;
+                            break;
+                        }
+                        fila_actual = 0;
+                        continue;
+                    }
+                    anexarBE16(bloque, static_cast<std::int16_t>(columnas.size()));
+                    for (std::size_t c = 0; c < columnas.size(); ++c) {
+                        bool es_nulo = false;
+                        std::string_view campo = lector.campoCopia(c, fila_actual, es_nulo);
+                        anexarBE32(bloque, es_nulo ? -1 : static_cast<std::int32_t>(campo.size()));
+                        bloque.append(campo.data(), campo.size());
+                    }
+                    ++fila_actual;
+                    ++filas;
+                }
+                return true;
+            });
+        return filas;
+    }
+    else {
+        if (lector.formato() != FormatoValores::ValorEtiquetado) {
+            throw std::runtime_error("El archivo de la tabla " + tabla + " fue generado con COPY de PostgreSQL y solo puede restaurarse en PostgreSQL.");
+        }
+
+        // Las tablas aud_* se restauran aparte; si los triggers de auditoria se
+        // disparasen con la carga, el historial quedaria duplicado.
+        bool identidad_activada = false;
+        if constexpr (D::motor == GestorAuditoria::MotorDB::MySQL) {
+            std::string consulta_triggers = "SELECT TRIGGER_NAME FROM information_schema.TRIGGERS WHERE EVENT_OBJECT_SCHEMA = DATABASE() AND EVENT_OBJECT_TABLE = ";
+            D::literal(consulta_triggers, tabla);
+            consulta_triggers += std::string(" AND TRIGGER_NAME LIKE '%\\_aud%' AND ACTION_STATEMENT NOT LIKE '%") + VARIABLE_RESTAURACION_MYSQL + "%'";
+            auto sin_guarda = conexion.ejecutarConsultaConResultado(consulta_triggers);
+            if (!sin_guarda.filas.empty()) {
+                throw std::runtime_error("El trigger " + sin_guarda.filas[0][0] + " de la tabla " + tabla +
+                    " registraria las filas restauradas; vuelva a generar la auditoria antes de restaurar.");
+            }
+            conexion.ejecutarSentencia("SET FOREIGN_KEY_CHECKS = 0");
+            conexion.ejecutarSentencia(std::string("SET ") + VARIABLE_RESTAURACION_MYSQL + " = 1");
+        }
+        else if constexpr (D::motor == GestorAuditoria::MotorDB::SQLServer) {
+            conexion.ejecutarSentencia("ALTER TABLE " + D::tablaCalificada(tabla) + " NOCHECK CONSTRAINT ALL");
+            conexion.ejecutarSentencia("DISABLE TRIGGER ALL ON " + D::tablaCalificada(tabla));
+            auto identidad = conexion.ejecutarConsultaConResultado("SELECT OBJECTPROPERTY(OBJECT_ID(N'" + D::tablaCalificada(tabla) + "'), 'TableHasIdentity');");
+            if (!identidad.filas.empty() && identidad.filas[0][0] == "1") {
+                conexion.ejecutarSentencia("SET IDENTITY_INSERT " + D::tablaCalificada(tabla) + " ON");
+                identidad_activada = true;
+            }
+        }
+
+        // DISABLE TRIGGER no depende de la sesion: los triggers se reactivan
+        // tambien si la carga falla.
+        const auto restablecer = [&]() {
+            if (identidad_activada) conexion.ejecutarSentencia("SET IDENTITY_INSERT " + D::tablaCalificada(tabla) + " OFF");
+            if constexpr (D::motor == GestorAuditoria::MotorDB::MySQL) {
+                conexion.ejecutarSentencia(std::string("SET ") + VARIABLE_RESTAURACION_MYSQL + " = NULL");
+            }
+            else if constexpr (D::motor == GestorAuditoria::MotorDB::SQLServer) {
+                conexion.ejecutarSentencia("ENABLE TRIGGER ALL ON " + D::tablaCalificada(tabla));
+            }
+        };
+
+        const std::string prefijo = D::sentenciaInsercion(tabla) + lista_columnas + ") VALUES ";
+        std::string sentencia;
+        std::size_t filas_en_lote = 0;
+        try {
+            while (lector.leerGrupo()) {
+                for (std::uint32_t f = 0; f < lector.filasEnGrupo(); ++f) {
+                    if (filas_en_lote == 0) sentencia = prefijo;
+                    else sentencia += ", ";
+                    sentencia += '(';
+                    for (std::size_t c = 0; c < columnas.size(); ++c) {
+                        if (c > 0) sentencia += ", ";
+                        anexarValorSql<D>(sentencia, lector.valor(c, f));
+                    }
+                    sentencia += ')';
+                    ++filas;
+                    if (++filas_en_lote == D::filas_por_insercion) {
+                        conexion.ejecutarSentencia(sentencia);
+                        filas_en_lote = 0;
+                    }
+                }
+            }
+            if (filas_en_lote > 0) conexion.ejecutarSentencia(sentencia);
+        }
+        catch (...) {
+            try {
+                restablecer();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Advertencia: no se pudieron reactivar los triggers de " << tabla << ": " << e.what() << std::endl;
+            }
+            throw;
+        }
+
+        restablecer();
+        return filas;
+    }
+}
+
+// Los valores de IdAuditoria se reparten antes del COMMIT, asi que una
+// transaccion lenta puede hacer visible un id menor que otro ya exportado. La
+// marca guardada es el ultimo id sin huecos por debajo; las filas exportadas por
+// encima se recuerdan en el checkpoint y se descartan al releer. Cada ejecucion
+// guarda un corte de transacciones tomado tras leer su maximo: cuando ya no
+// queda abierta ninguna transaccion anterior al corte, los huecos hasta ese
+// maximo son definitivos y se abandonan. En PostgreSQL tambien se abandonan
+// si no habia ninguna transaccion en curso al leer.
+template <typename D>
+nlohmann::json GestorExportacion::exportarIncrementoTabla(GestorAuditoria& conexion, const std::string& tabla, const nlohmann::json& marca_anterior,
+    const std::string& directorio_salida, const std::string& formato, const GestorCifrado* gestor_cifrado) {
+    MedicionFase medicion("exportacion.exportarIncrementoTabla");
+    const std::string tabla_sql = D::tablaCalificada(tabla);
+    const auto columnas = conexion.ejecutarConsultaTipada(D::paginar("SELECT * FROM " + tabla_sql, 0)).columnas;
+    if (std::find(columnas.begin(), columnas.end(), COLUMNA_SECUENCIA_AUDITORIA) == columnas.end()) {
+        throw std::runtime_error("La tabla " + tabla + " no tiene columna IdAuditoria. Regenere la auditoria.");
+    }
+    const std::string columna_sql = D::citar(COLUMNA_SECUENCIA_AUDITORIA);
+
+    std::optional<std::int64_t> desde;
+    std::set<std::int64_t> exportados;
+    std::string corte;
+    std::optional<std::int64_t> maximo_corte;
+    if (marca_anterior.is_object() && marca_anterior.value("columna", std::string()) == COLUMNA_SECUENCIA_AUDITORIA) {
+        const std::string valor = marca_anterior.value("valor", std::string());
+        if (!valor.empty()) desde = std::stoll(valor);
+        if (marca_anterior.contains("exportados")) exportados = marca_anterior["exportados"].get<std::set<std::int64_t>>();
+        corte = marca_anterior.value("corte", std::string());
+        if (marca_anterior.contains("maximo_corte")) maximo_corte = marca_anterior["maximo_corte"].get<std::int64_t>();
+    }
+
+    bool sin_transacciones_en_curso = false;
+    if constexpr (D::motor == GestorAuditoria::MotorDB::PostgreSQL) {
+        conexion.ejecutarSentencia("BEGIN ISOLATION LEVEL REPEATABLE READ, READ ONLY");
+        const ResultadoConsulta instantanea = conexion.ejecutarConsultaConResultado(
+            "SELECT pg_snapshot_xmin(s) = pg_snapshot_xmax(s) FROM pg_current_snapshot() s");
+        sin_transacciones_en_curso = !instantanea.filas.empty() && instantanea.filas[0][0] == "t";
+    }
+    // Se comprueba antes de leer, para que las filas de las transacciones
+    // anteriores al corte que ya terminaron entren en esta lectura.
+    const bool huecos_definitivos = D::consultaCorteTransacciones().empty();
+    bool corte_cumplido = false;
+    if (!corte.empty() && maximo_corte && !huecos_definitivos) {
+        const ResultadoConsulta abiertas = conexion.ejecutarConsultaConResultado(D::consultaAbiertasAntesDeCorte(corte));
+        corte_cumplido = !abiertas.filas.empty() && abiertas.filas[0][0] == "0";
+    }
+
+    std::string consulta = "SELECT * FROM " + tabla_sql;
+    if (desde) consulta += " WHERE " + columna_sql + " > " + std::to_string(*desde);
+    consulta += " ORDER BY " + columna_sql;
+
+    const std::string archivo_temporal = nombreSeguro(tabla) + "_parcial" + extensionFormatoSalida(formato);
+    const std::filesystem::path ruta_temporal = std::filesystem::path(directorio_salida) / archivo_temporal;
+    auto escritor = crearEscritorSalida(formato, ruta_temporal.string());
+    const long filas_por_bloque = conexion.admiteLecturaPorBloques(D::paginar("SELECT * FROM " + tabla_sql, 0)) ? FILAS_POR_BLOQUE_ODBC : 1;
+
+    std::size_t posicion_id = 0;
+    std::optional<std::int64_t> contiguo = desde;
+    std::optional<std::int64_t> maximo;
+    std::vector<std::int64_t> vistos_tras_hueco;
+    std::int64_t ultimo_exportado = 0;
+    std::uint64_t filas = 0;
+    conexion.procesarConsultaPorFilas(consulta,
+        [&](const std::vector<std::string>& nombres) {
+            posicion_id = std::find(nombres.begin(), nombres.end(), COLUMNA_SECUENCIA_AUDITORIA) - nombres.begin();
+            if (!gestor_cifrado) {
+                escritor->escribirEncabezado(nombres);
+                return;
+            }
+            std::vector<std::string> nombres_descifrados;
+            nombres_descifrados.reserve(nombres.size());
+            for (const auto& nombre : nombres) nombres_descifrados.push_back(gestor_cifrado->descifrarNombreColumna(nombre));
+            escritor->escribirEncabezado(nombres_descifrados);
+        },
+        [&](std::vector<ValorCelda>& fila) {
+            const ValorCelda& celda_id = fila[posicion_id];
+            const std::int64_t* entero = std::get_if<std::int64_t>(&celda_id);
+            const std::int64_t id = entero ? *entero : std::stoll(valorATexto(celda_id));
+            maximo = id;
+            if (!contiguo || id == *contiguo + 1) contiguo = id;
+            else vistos_tras_hueco.push_back(id);
+            if (exportados.count(id)) return;
+            if (gestor_cifrado) gestor_cifrado->descifrarCeldas(fila, true, gestor_cifrado->contextosDeFila(tabla, columnas, fila));
+            escritor->escribirFila(fila);
+            ultimo_exportado = id;
+            ++filas;
+        },
+        filas_por_bloque);
+    escritor->finalizar();
+    std::string corte_actual;
+    if (!huecos_definitivos) {
+        const ResultadoConsulta resultado_corte = conexion.ejecutarConsultaConResultado(D::consultaCorteTransacciones());
+        if (!resultado_corte.filas.empty()) corte_actual = resultado_corte.filas[0][0];
+    }
+    if constexpr (D::motor == GestorAuditoria::MotorDB::PostgreSQL) conexion.ejecutarSentencia("COMMIT");
+
+    std::optional<std::int64_t> marca = contiguo;
+    if (maximo && (sin_transacciones_en_curso || huecos_definitivos)) marca = *maximo;
+    if (corte_cumplido && (!marca || *maximo_corte > *marca)) marca = *maximo_corte;
+    // Un corte pendiente se conserva hasta cumplirse; uno nuevo lo sustituiria
+    // por otro posterior y, con transacciones largas, no se cumpliria nunca.
+    if (corte_cumplido || !maximo_corte || (marca && *maximo_corte <= *marca)) {
+        corte.clear();
+        maximo_corte.reset();
+        if (maximo && (!marca || *marca < *maximo) && !corte_actual.empty()) {
+            corte = corte_actual;
+            maximo_corte = maximo;
+        }
+    }
+    std::set<std::int64_t> exportados_nuevos;
+    for (std::int64_t id : vistos_tras_hueco) {
+        if (id > *marca) exportados_nuevos.insert(id);
+    }
+
+    nlohmann::json resultado = {
+        {"columna", COLUMNA_SECUENCIA_AUDITORIA},
+        {"valor", marca ? std::to_string(*marca) : std::string()},
+        {"exportados", exportados_nuevos},
+        {"filas", filas}
+    };
+    if (maximo_corte) {
+        resultado["corte"] = corte;
+        resultado["maximo_corte"] = *maximo_corte;
+    }
+    if (filas == 0) {
+        std::filesystem::remove(ruta_temporal);
+        return resultado;
+    }
+    // Cada id se exporta una sola vez, asi que el ultimo exportado no repite nombre.
+    const std::string archivo = nombreSeguro(tabla) + "_" + std::to_string(ultimo_exportado) + extensionFormatoSalida(formato);
+    std::filesystem::rename(ruta_temporal, std::filesystem::path(directorio_salida) / archivo);
+    resultado["archivo"] = archivo;
+    return resultado;
+}
+
+bool GestorExportacion::exportarRespaldoNativo(const std::string& directorio_salida) {
+    namespace fs = std::filesystem;
+    std::cout << "Iniciando respaldo columnar con " << num_trabajadores << " conexiones..." << std::endl;
+    const auto inicio = std::chrono::steady_clock::now();
+
+    GestorAuditoria conexion_principal(motor_db, info_conexion, db_name);
+    if (!conexion_principal.estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+    const std::vector<std::string> tablas = obtenerTablasDeDatos(conexion_principal);
+    fs::create_directories(directorio_salida);
+
+    // Todas las conexiones leen la misma instantanea para que el respaldo sea
+    // coherente entre tablas. PostgreSQL exporta la instantanea del coordinador;
+    // MySQL abre las transacciones bajo un bloqueo global de lectura, que se
+    // libera en cuanto todas empezaron; SQLite lee todo en una transaccion.
+    std::function<void(GestorAuditoria&)> preparar_conexion;
+    std::function<void()> al_preparar_conexiones;
+    if (motor_db == GestorAuditoria::MotorDB::PostgreSQL) {
+        conexion_principal.ejecutarSentencia("BEGIN ISOLATION LEVEL REPEATABLE READ, READ ONLY");
+        const ResultadoConsulta instantanea = conexion_principal.ejecutarConsultaConResultado("SELECT pg_export_snapshot()");
+        if (instantanea.filas.empty()) throw std::runtime_error("No se pudo exportar la instantanea del respaldo.");
+        const std::string id_instantanea = instantanea.filas[0][0];
+        preparar_conexion = [id_instantanea](GestorAuditoria& conexion) {
+            conexion.ejecutarSentencia("BEGIN ISOLATION LEVEL REPEATABLE READ, READ ONLY");
+            conexion.ejecutarSentencia("SET TRANSACTION SNAPSHOT '" + id_instantanea + "'");
+        };
+    }
+    else if (motor_db == GestorAuditoria::MotorDB::MySQL) {
+        conexion_principal.ejecutarSentencia("FLUSH TABLES WITH READ LOCK");
+        preparar_conexion = [](GestorAuditoria& conexion) {
+            conexion.ejecutarSentencia("SET SESSION TRANSACTION ISOLATION LEVEL REPEATABLE READ");
+            conexion.ejecutarSentencia("START TRANSACTION WITH CONSISTENT SNAPSHOT, READ ONLY");
+        };
+        al_preparar_conexiones = [&conexion_principal]() { conexion_principal.ejecutarSentencia("UNLOCK TABLES"); };
+    }
+    else if (motor_db == GestorAuditoria::MotorDB::SQLite) {
+        num_trabajadores = 1;
+        preparar_conexion = [](GestorAuditoria& conexion) { conexion.ejecutarSentencia("BEGIN"); };
+    }
+    else if (num_trabajadores > 1) {
+        std::cerr << "Advertencia: en SQL Server cada conexion lee en su propio momento; detenga las escrituras o use --workers 1 con la base en solo lectura para un respaldo coherente entre tablas." << std::endl;
+    }
+
+    std::vector<nlohmann::json> entradas(tablas.size());
+    ejecutarEnParalelo(tablas.size(), [&](GestorAuditoria& conexion, std::size_t indice) {
+        const std::string& tabla = tablas[indice];
+        const std::string archivo = nombreArchivoTabla(indice, tabla);
+        const std::string ruta = (fs::path(directorio_salida) / archivo).string();
+
+        std::vector<std::string> columnas;
+        const std::uint64_t filas = despacharDialecto(motor_db, [&](auto dialecto) {
+            return exportarTabla<decltype(dialecto)>(conexion, tabla, ruta, columnas);
+            });
+        const std::uint64_t bytes = fs::file_size(ruta);
+        entradas[indice] = { {"nombre", tabla}, {"archivo", archivo}, {"columnas", columnas}, {"filas", filas}, {"bytes", bytes} };
+
+        std::lock_guard<std::mutex> bloqueo(mutex_salida);
+        std::cout << "  " << tabla << ": " << filas << " filas, " << bytes << " bytes" << std::endl;
+        }, preparar_conexion, al_preparar_conexiones);
+    if (motor_db == GestorAuditoria::MotorDB::PostgreSQL) conexion_principal.ejecutarSentencia("COMMIT");
+
+    nlohmann::json manifiesto = {
+        {"version", VERSION_MANIFIESTO},
+        {"motor", nombreMotor(motor_db)},
+        {"base_datos", db_name},
+        {"tablas", entradas}
+    };
+    std::ofstream archivo_manifiesto(fs::path(directorio_salida) / "manifiesto.json");
+    archivo_manifiesto << manifiesto.dump(2);
+
+    const double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    std::cout << "Respaldo columnar completado en " << segundos << " s. Directorio: " << directorio_salida << std::endl;
+    return true;
+}
+
+bool GestorExportacion::importarRespaldoNativo(const std::string& directorio_entrada) {
+    namespace fs = std::filesystem;
+    std::ifstream archivo_manifiesto(fs::path(directorio_entrada) / "manifiesto.json");
+    if (!archivo_manifiesto) throw std::runtime_error("No se encontro manifiesto.json en: " + directorio_entrada);
+    nlohmann::json manifiesto = nlohmann::json::parse(archivo_manifiesto);
+
+    if (manifiesto.value("version", 0) != VERSION_MANIFIESTO) throw std::runtime_error("Version de manifiesto no soportada.");
+    if (manifiesto.value("motor", std::string()) != nombreMotor(motor_db)) {
+        throw std::runtime_error("El respaldo fue generado para el motor " + manifiesto.value("motor", std::string()) + " y no puede restaurarse en " + nombreMotor(motor_db) + ".");
+    }
+
+    std::vector<nlohmann::json> entradas = manifiesto["tablas"].get<std::vector<nlohmann::json>>();
+    std::stable_sort(entradas.begin(), entradas.end(), [](const nlohmann::json& a, const nlohmann::json& b) {
+        return a.value("bytes", 0ull) > b.value("bytes", 0ull);
+        });
+
+    std::cout << "Iniciando restauracion columnar con " << num_trabajadores << " conexiones..." << std::endl;
+    const auto inicio = std::chrono::steady_clock::now();
+
+    ejecutarEnParalelo(entradas.size(), [&](GestorAuditoria& conexion, std::size_t indice) {
+        const std::string tabla = entradas[indice]["nombre"].get<std::string>();
+        const std::string ruta = (fs::path(directorio_entrada) / entradas[indice]["archivo"].get<std::string>()).string();
+
+        // Sin el rol replica la carga dispararia los triggers de auditoria y
+        // comprobaria las claves foraneas fila a fila, en el orden de las tablas.
+        if (motor_db == GestorAuditoria::MotorDB::PostgreSQL) {
+            try {
+                conexion.ejecutarSentencia("SET session_replication_role = replica");
+            }
+            catch (const std::exception& e) {
+                throw std::runtime_error(std::string("No se pudo desactivar triggers y claves foraneas (SET session_replication_role = replica requiere superusuario): ") + e.what());
+            }
+        }
+        const std::uint64_t filas = despacharDialecto(motor_db, [&](auto dialecto) {
+            return importarTabla<decltype(dialecto)>(conexion, tabla, ruta);
+            });
+
+        std::lock_guard<std::mutex> bloqueo(mutex_salida);
+        std::cout << "  " << tabla << ": " << filas << " filas restauradas" << std::endl;
+        });
+
+    if (motor_db == GestorAuditoria::MotorDB::SQLServer) {
+        GestorAuditoria conexion_principal(motor_db, info_conexion, db_name);
+        for (const auto& entrada : entradas) {
+            conexion_principal.ejecutarSentencia("ALTER TABLE " + DialectoSql<GestorAuditoria::MotorDB::SQLServer>::tablaCalificada(entrada["nombre"].get<std::string>()) + " WITH CHECK CHECK CONSTRAINT ALL");
+        }
+    }
+
+    const double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    std::cout << "Restauracion columnar completada en " << segundos << " s." << std::endl;
+    return true;
+}
+
+bool GestorExportacion::exportarAuditoriaIncremental(const std::string& directorio_salida, const std::string& formato, const std::string& ruta_checkpoint, std::shared_ptr<GestorCifrado> gestor_cifrado) {
+    namespace fs = std::filesystem;
+    if (formato != "ndjson" && formato != "csv" && formato != "tsv" && formato != "binario") {
+        throw std::runtime_error("Formato no soportado para la exportacion de auditoria: " + formato);
+    }
+    fs::create_directories(directorio_salida);
+
+    nlohmann::json checkpoint = nlohmann::json::object();
+    if (std::ifstream archivo_checkpoint(ruta_checkpoint); archivo_checkpoint) {
+        checkpoint = nlohmann::json::parse(archivo_checkpoint);
+    }
+
+    GestorAuditoria conexion_principal(motor_db, info_conexion, db_name);
+    if (!conexion_principal.estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+    std::vector<std::string> tablas = conexion_principal.obtenerNombresDeTablas(true);
+    tablas.erase(std::remove_if(tablas.begin(), tablas.end(), [](const std::string& tabla) {
+        return tabla.rfind("aud_", 0) != 0 && tabla.rfind("Aud", 0) != 0;
+        }), tablas.end());
+
+    if (tablas.empty()) {
+        std::cout << "No se encontraron tablas de auditoria para exportar." << std::endl;
+        return true;
+    }
+    std::cout << "Exportando cambios de " << tablas.size() << " tablas de auditoria..." << std::endl;
+
+    std::uint64_t total_filas = 0;
+    ejecutarEnParalelo(tablas.size(), [&](GestorAuditoria& conexion, std::size_t indice) {
+        const std::string& tabla = tablas[indice];
+        nlohmann::json marca_anterior;
+        {
+            std::lock_guard<std::mutex> bloqueo(mutex_salida);
+            if (checkpoint.contains(tabla)) marca_anterior = checkpoint[tabla];
+        }
+
+        nlohmann::json marca = despacharDialecto(motor_db, [&](auto dialecto) {
+            return exportarIncrementoTabla<decltype(dialecto)>(conexion, tabla, marca_anterior, directorio_salida, formato, gestor_cifrado.get());
+            });
+        const std::uint64_t filas = marca.value("filas", 0ull);
+
+        std::lock_guard<std::mutex> bloqueo(mutex_salida);
+        checkpoint[tabla] = { {"columna", marca["columna"]}, {"valor", marca["valor"]}, {"exportados", marca["exportados"]} };
+        const std::string ruta_temporal = ruta_checkpoint + ".tmp";
+        {
+            std::ofstream archivo_temporal(ruta_temporal, std::ios::trunc);
+            archivo_temporal << checkpoint.dump(2);
+            if (!archivo_temporal) throw std::runtime_error("No se pudo escribir el checkpoint: " + ruta_temporal);
+        }
+        fs::rename(ruta_temporal, ruta_checkpoint);
+        total_filas += filas;
+        std::cout << "  " << tabla << ": " << filas << " filas nuevas" << (filas > 0 ? " -> " + marca.value("archivo", std::string()) : std::string()) << std::endl;
+        });
+
+    std::cout << "Exportacion incremental completada: " << total_filas << " filas. Checkpoint: " << ruta_checkpoint << std::endl;
+    return true;
 }
\ No newline at end of file
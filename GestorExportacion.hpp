@@ -1,5 +1,10 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
 #include "GestorAuditoria.hpp"
 
 class GestorExportacion {
@@ -9,10 +14,29 @@ public:
         const std::string& db, const std::string& user, const std::string& pass,
         const std::string& host, const std::string& port
     );
+    GestorExportacion(GestorAuditoria::MotorDB motor, const std::string& info_conexion, const std::string& db, unsigned int num_trabajadores);
 
     bool exportarRespaldo(const std::string& ruta_archivo_salida);
+    bool exportarRespaldoNativo(const std::string& directorio_salida);
+    bool importarRespaldoNativo(const std::string& directorio_entrada);
+    bool exportarAuditoriaIncremental(const std::string& directorio_salida, const std::string& formato, const std::string& ruta_checkpoint, std::shared_ptr<GestorCifrado> gestor_cifrado);
 
 private:
     GestorAuditoria::MotorDB motor_db;
     std::string db_user, db_pass, db_name, db_host, db_port;
-};
\ No newline at end of file
+    std::string info_conexion;
+    unsigned int num_trabajadores = 1;
+    std::mutex mutex_salida;
+
+    std::vector<std::string> obtenerTablasDeDatos(GestorAuditoria& conexion);
+    void ejecutarEnParalelo(std::size_t num_tareas, const std::function<void(GestorAuditoria&, std::size_t)>& tarea,
+        const std::function<void(GestorAuditoria&)>& preparar_conexion = nullptr, const std::function<void()>& al_preparar_conexiones = nullptr);
+
+    template <typename D>
+    std::uint64_t exportarTabla(GestorAuditoria& conexion, const std::string& tabla, const std::string& ruta, std::vector<std::string>& columnas);
+    template <typename D>
+    nlohmann::json exportarIncrementoTabla(GestorAuditoria& conexion, const std::string& tabla, const nlohmann::json& marca_anterior,
+        const std::string& directorio_salida, const std::string& formato, const GestorCifrado* gestor_cifrado);
+    template <typename D>
+    std::uint64_t importarTabla(GestorAuditoria& conexion, const std::string& tabla, const std::string& ruta);
+};
@@ -0,0 +1,56 @@
+#include "GestorPlantillas.hpp"
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include "PlantillasEmbebidas.hpp"
+#include "Perfilador.hpp"
+
+GestorPlantillas& GestorPlantillas::instancia() {
+    static GestorPlantillas gestor;
+    return gestor;
+}
+
+void GestorPlantillas::establecerDirectorioPersonalizado(const std::string& directorio) {
+    std::unique_lock<std::shared_mutex> bloqueo(mutex);
+    directorio_personalizado = directorio;
+    plantillas.clear();
+}
+
+std::string GestorPlantillas::renderizar(const std::string& nombre, const nlohmann::json& datos) {
+    const inja::Template& plantilla = obtener(nombre);
+    MedicionFase medicion("plantillas.renderizar");
+    std::shared_lock<std::shared_mutex> bloqueo(mutex);
+    return entorno.render(plantilla, datos);
+}
+
+const inja::Template& GestorPlantillas::obtener(const std::string& nombre) {
+    {
+        std::shared_lock<std::shared_mutex> bloqueo(mutex);
+        auto it = plantillas.find(nombre);
+        if (it != plantillas.end()) return *it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> bloqueo(mutex);
+    auto it = plantillas.find(nombre);
+    if (it != plantillas.end()) return *it->second;
+
+    MedicionFase medicion("plantillas.analizar");
+    auto plantilla = std::make_unique<const inja::Template>(entorno.parse(leerFuente(nombre)));
+    return *plantillas.emplace(nombre, std::move(plantilla)).first->second;
+}
+
+std::string GestorPlantillas::leerFuente(const std::string& nombre) const {
+    if (!directorio_personalizado.empty()) {
+        std::ifstream archivo(directorio_personalizado + "/" + nombre, std::ios::binary);
+        if (archivo) {
+            std::ostringstream contenido;
+            contenido << archivo.rdbuf();
+            return contenido.str();
+        }
+    }
+    for (const auto& plantilla : obtenerPlantillasEmbebidas()) {
+        if (plantilla.nombre == nombre) return std::string(plantilla.contenido);
+    }
+    throw std::runtime_error("No se encontro la plantilla " + nombre + ".");
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include <inja/inja.hpp>
+
+class GestorPlantillas {
+public:
+    static GestorPlantillas& instancia();
+
+    void establecerDirectorioPersonalizado(const std::string& directorio);
+    std::string renderizar(const std::string& nombre, const nlohmann::json& datos);
+
+private:
+    GestorPlantillas() = default;
+
+    inja::Environment entorno;
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<const inja::Template>> plantillas;
+    std::string directorio_personalizado;
+
+    const inja::Template& obtener(const std::string& nombre);
+    std::string leerFuente(const std::string& nombre) const;
+};
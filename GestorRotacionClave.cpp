@@ -0,0 +1,417 @@
+#include "GestorRotacionClave.hpp"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+#include <boost/algorithm/string.hpp>
+#include "DialectoSql.hpp"
+#include "Perfilador.hpp"
+
+namespace {
+
+const std::string TABLA_AVANCE = "shc134_rotacion_clave";
+const std::string COLUMNA_CONTROL = "UsuarioAccion";
+constexpr int SEGMENTO_FINALIZADA = -1;
+
+bool esErrorDescifrado(const std::string& texto) {
+    return boost::starts_with(texto, "[ERROR_");
+}
+
+template <typename D>
+void ejecutarEnTransaccion(GestorAuditoria& conexion, const std::function<void()>& cuerpo) {
+    conexion.ejecutarSentencia(std::string(D::inicio_transaccion));
+    try {
+        cuerpo();
+        conexion.ejecutarSentencia("COMMIT");
+    }
+    catch (...) {
+        try {
+            conexion.ejecutarSentencia("ROLLBACK");
+        }
+        catch (const std::exception&) {
+        }
+        throw;
+    }
+}
+
+}
+
+GestorRotacionClave::GestorRotacionClave(GestorAuditoria::MotorDB motor, const std::string& info_conexion, const std::string& db, Configuracion configuracion)
+    : motor_db(motor), info_conexion(info_conexion), db_name(db), configuracion(std::move(configuracion)) {
+    if (boost::iequals(this->configuracion.clave_actual, this->configuracion.clave_nueva)) {
+        throw std::runtime_error("La clave nueva debe ser distinta de la actual.");
+    }
+    // SQLite serializa las escrituras: varias conexiones solo se bloquearian entre si.
+    if (motor_db == GestorAuditoria::MotorDB::SQLite) this->configuracion.num_trabajadores = 1;
+
+    gestor_db = std::make_shared<GestorAuditoria>(motor_db, info_conexion, db_name);
+    if (!gestor_db->estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+
+    cifrado_actual = std::make_shared<GestorCifrado>(gestor_db, this->configuracion.clave_actual);
+    cifrado_nuevo = std::make_shared<GestorCifrado>(gestor_db, this->configuracion.clave_nueva);
+    cifrado_nuevo->setFormatoCifrado(this->configuracion.formato_cifrado);
+    huella = cifrado_nuevo->indiceCiego(cifrado_actual->indiceCiego("SHC134-rotacion"));
+}
+
+void GestorRotacionClave::ejecutar() {
+    MedicionFase medicion("rotacion.ejecutar");
+    despacharDialecto(motor_db, [&](auto dialecto) {
+        ejecutarConDialecto<decltype(dialecto)>();
+        });
+}
+
+template <typename D>
+void GestorRotacionClave::ejecutarConDialecto() {
+    auto tablas = gestor_db->obtenerNombresDeTablas(true);
+    tablas.erase(std::remove_if(tablas.begin(), tablas.end(), [](const std::string& s) {
+        return !boost::starts_with(s, "aud_") && !boost::starts_with(s, "Aud");
+        }), tablas.end());
+    if (tablas.empty()) {
+        std::cout << "No se encontraron tablas de auditoria para rotar." << std::endl;
+        return;
+    }
+
+    cargarAvance<D>();
+    std::cout << "Rotando la clave de " << tablas.size() << " tablas de auditoria con " << configuracion.num_trabajadores
+        << " conexiones. Detenga las escrituras en la base de datos hasta que termine." << std::endl;
+
+    std::vector<std::string> tablas_rotadas;
+    for (const auto& tabla : tablas) {
+        Avance& avance = avances[tabla];
+        if (avance.finalizada) {
+            std::cout << "Tabla " << tabla << " ya rotada." << std::endl;
+            continue;
+        }
+
+        const auto columnas = gestor_db->ejecutarConsultaTipada(D::paginar("SELECT * FROM " + D::tablaCalificada(tabla), 0)).columnas;
+        if (std::find(columnas.begin(), columnas.end(), COLUMNA_CAMBIOS_AUDITORIA) != columnas.end()) {
+            std::cout << "Tabla " << tabla << " omitida: usa auditoria por diferencias." << std::endl;
+            continue;
+        }
+        if (std::find(columnas.begin(), columnas.end(), COLUMNA_SECUENCIA_AUDITORIA) == columnas.end()) {
+            std::cout << "Tabla " << tabla << " omitida: no tiene la columna " << COLUMNA_SECUENCIA_AUDITORIA << " para recorrerla por bloques." << std::endl;
+            continue;
+        }
+
+        const std::string indice_temporal = asegurarIndiceSecuencia<D>(*gestor_db, tabla);
+        if (avance.tramos.empty()) crearTramos<D>(tabla);
+        std::atomic<std::uint64_t> filas{ 0 };
+        if (!avance.tramos.empty()) {
+            ejecutarEnParalelo(avance.tramos.size(), [&](GestorAuditoria& conexion, std::size_t indice) {
+                filas += rotarTramo<D>(conexion, tabla, avance.tramos[indice]);
+                });
+        }
+        if (!indice_temporal.empty()) gestor_db->ejecutarComando(D::sentenciaEliminarIndice(tabla, indice_temporal));
+        std::cout << "Tabla " << tabla << ": " << filas.load() << " filas recifradas." << std::endl;
+        tablas_rotadas.push_back(tabla);
+    }
+
+    for (const auto& tabla : tablas_rotadas) finalizarTabla<D>(tabla);
+
+    gestor_db->ejecutarSentencia("DROP TABLE " + D::tablaCalificada(TABLA_AVANCE));
+    std::cout << "Rotacion de clave completada." << std::endl;
+}
+
+template <typename D>
+void GestorRotacionClave::cargarAvance() {
+    const auto nombres = gestor_db->obtenerNombresDeTablas(true);
+    if (std::find(nombres.begin(), nombres.end(), TABLA_AVANCE) == nombres.end()) {
+        gestor_db->ejecutarSentencia("CREATE TABLE " + D::tablaCalificada(TABLA_AVANCE) +
+            " (tabla VARCHAR(255) NOT NULL, segmento INT NOT NULL, huella CHAR(32) NOT NULL, hasta BIGINT NOT NULL, ultimo BIGINT NOT NULL)");
+        return;
+    }
+
+    const auto registro = gestor_db->ejecutarConsultaConResultado("SELECT tabla, segmento, huella, hasta, ultimo FROM " + D::tablaCalificada(TABLA_AVANCE));
+    for (const auto& fila : registro.filas) {
+        if (boost::trim_copy(fila[2]) != huella) {
+            throw std::runtime_error("La rotacion pendiente en " + TABLA_AVANCE + " se inicio con otras claves; continuela con las mismas --key y --new-key.");
+        }
+        const int segmento = std::stoi(fila[1]);
+        if (segmento == SEGMENTO_FINALIZADA) avances[fila[0]].finalizada = true;
+        else avances[fila[0]].tramos.push_back({ segmento, std::stoll(fila[3]), std::stoll(fila[4]) });
+    }
+    for (auto& par : avances) {
+        std::sort(par.second.tramos.begin(), par.second.tramos.end(), [](const Tramo& a, const Tramo& b) { return a.segmento < b.segmento; });
+    }
+    if (!registro.filas.empty()) {
+        std::cout << "Reanudando la rotacion registrada en " << TABLA_AVANCE << "." << std::endl;
+    }
+}
+
+// Divide el rango de IdAuditoria en un tramo por conexion. Cada tramo guarda el
+// ultimo id confirmado, asi que los tramos avanzan y se reanudan por separado.
+template <typename D>
+void GestorRotacionClave::crearTramos(const std::string& tabla) {
+    const std::string id = D::citar(COLUMNA_SECUENCIA_AUDITORIA);
+    const auto limites = gestor_db->ejecutarConsultaConResultado("SELECT MIN(" + id + "), MAX(" + id + ") FROM " + D::tablaCalificada(tabla));
+    if (limites.filas.empty() || limites.filas[0][0] == "NULL") return;
+
+    const std::int64_t minimo = std::stoll(limites.filas[0][0]) - 1;
+    const std::int64_t maximo = std::stoll(limites.filas[0][1]);
+    const std::int64_t segmentos = std::clamp<std::int64_t>(configuracion.num_trabajadores, 1, maximo - minimo);
+    const std::int64_t ancho = (maximo - minimo + segmentos - 1) / segmentos;
+
+    auto& tramos = avances[tabla].tramos;
+    std::string sentencia = D::sentenciaInsercion(TABLA_AVANCE) + "tabla, segmento, huella, hasta, ultimo) VALUES ";
+    for (std::int64_t desde = minimo; desde < maximo; desde += ancho) {
+        const Tramo tramo{ static_cast<int>(tramos.size()), std::min(maximo, desde + ancho), desde };
+        if (!tramos.empty()) sentencia += ", ";
+        sentencia += '(';
+        D::literal(sentencia, tabla);
+        sentencia += ", " + std::to_string(tramo.segmento) + ", '" + huella + "', " + std::to_string(tramo.hasta) + ", " + std::to_string(tramo.ultimo) + ')';
+        tramos.push_back(tramo);
+    }
+    gestor_db->ejecutarSentencia(sentencia);
+}
+
+template <typename D>
+std::uint64_t GestorRotacionClave::rotarTramo(GestorAuditoria& conexion, const std::string& tabla, Tramo& tramo) {
+    MedicionFase medicion("rotacion.rotarTramo");
+    const std::string id = D::citar(COLUMNA_SECUENCIA_AUDITORIA);
+    const std::string consulta_base = "SELECT * FROM " + D::tablaCalificada(tabla) + " WHERE " + id + " > ";
+    std::string registro_avance = "UPDATE " + D::tablaCalificada(TABLA_AVANCE) + " SET ultimo = ";
+    std::string condicion_avance = " WHERE segmento = " + std::to_string(tramo.segmento) + " AND tabla = ";
+    D::literal(condicion_avance, tabla);
+
+    std::uint64_t filas = 0;
+    while (tramo.ultimo < tramo.hasta) {
+        ResultadoTipado bloque = conexion.ejecutarConsultaTipada(D::paginar(
+            consulta_base + std::to_string(tramo.ultimo) + " AND " + id + " <= " + std::to_string(tramo.hasta) + " ORDER BY " + id,
+            configuracion.filas_por_bloque));
+        const std::size_t num_filas = bloque.numeroFilas();
+
+        std::int64_t ultimo = tramo.hasta;
+        std::vector<std::string> sentencias;
+        if (num_filas > 0) {
+            sentencias = sentenciasRecifrado<D>(tabla, bloque);
+            const std::size_t posicion_id = std::find(bloque.columnas.begin(), bloque.columnas.end(), COLUMNA_SECUENCIA_AUDITORIA) - bloque.columnas.begin();
+            if (num_filas == configuracion.filas_por_bloque) ultimo = std::stoll(valorATexto(bloque.celda(num_filas - 1, posicion_id)));
+        }
+
+        ejecutarEnTransaccion<D>(conexion, [&]() {
+            for (const auto& sentencia : sentencias) conexion.ejecutarSentencia(sentencia);
+            conexion.ejecutarSentencia(registro_avance + std::to_string(ultimo) + condicion_avance);
+            });
+        tramo.ultimo = ultimo;
+        filas += num_filas;
+        Perfilador::sumar(ContadorPerfil::Filas, num_filas);
+    }
+
+    std::lock_guard<std::mutex> bloqueo(mutex_salida);
+    std::cout << "Tabla " << tabla << ": tramo " << tramo.segmento + 1 << " completado." << std::endl;
+    return filas;
+}
+
+// Descifra el bloque con la clave actual, cifra con la nueva las celdas que eran
+// texto cifrado y recalcula los indices ciegos. Devuelve los UPDATE por lotes de
+// las filas con cambios; las celdas en claro o nulas se conservan tal cual.
+template <typename D>
+std::vector<std::string> GestorRotacionClave::sentenciasRecifrado(const std::string& tabla, ResultadoTipado& bloque) const {
+    MedicionFase medicion("rotacion.recifrarBloque", false);
+    const GestorCifrado& nombres = cifradoDeNombres(bloque.columnas);
+    const std::size_t num_columnas = bloque.columnas.size();
+    const std::size_t num_filas = bloque.numeroFilas();
+    const std::size_t posicion_id = std::find(bloque.columnas.begin(), bloque.columnas.end(), COLUMNA_SECUENCIA_AUDITORIA) - bloque.columnas.begin();
+
+    std::vector<std::pair<std::size_t, std::size_t>> indices_ciegos;
+    std::vector<bool> es_indice(num_columnas, false);
+    for (std::size_t c = 0; c < num_columnas; ++c) {
+        const std::string origen = nombres.columnaOrigenIndiceCiego(bloque.columnas[c]);
+        if (origen.empty()) continue;
+        const auto posicion = std::find(bloque.columnas.begin(), bloque.columnas.end(), nombres.cifrarNombreColumna(origen));
+        if (posicion == bloque.columnas.end()) continue;
+        indices_ciegos.emplace_back(c, posicion - bloque.columnas.begin());
+        es_indice[c] = true;
+    }
+
+    // Cada celda se descifra y se vuelve a cifrar con el contexto de su fila
+    // (tabla, columna en claro e IdAuditoria), que no cambia con la clave.
+    std::vector<std::string> columnas_en_claro;
+    for (const auto& columna : bloque.columnas) columnas_en_claro.push_back(nombres.descifrarNombreColumna(columna));
+
+    constexpr std::size_t SIN_PLANO = static_cast<std::size_t>(-1);
+    std::vector<ValorCelda> planos;
+    std::vector<std::string> contextos_planos;
+    std::vector<std::size_t> origen_plano;
+    std::vector<std::size_t> plano_de_celda(bloque.celdas.size(), SIN_PLANO);
+    for (std::size_t i = 0; i < bloque.celdas.size(); ++i) {
+        const std::size_t c = i % num_columnas;
+        if (c == posicion_id || es_indice[c] || !(std::holds_alternative<std::string>(bloque.celdas[i]) || std::holds_alternative<Bytes>(bloque.celdas[i]))) continue;
+        plano_de_celda[i] = planos.size();
+        origen_plano.push_back(i);
+        planos.push_back(bloque.celdas[i]);
+        contextos_planos.push_back(GestorCifrado::contextoCelda(tabla, columnas_en_claro[c], valorATexto(bloque.celdas[i - c + posicion_id])));
+    }
+    // Las celdas comprimidas se vuelven a cifrar comprimidas, sin descomprimirlas.
+    cifrado_actual->descifrarCeldas(planos, false, contextos_planos);
+
+    // Las celdas de columnas binarias se vuelven a escribir como binario.
+    std::vector<bool> binaria(bloque.celdas.size(), false);
+    std::vector<std::string> textos;
+    std::vector<std::string> contextos;
+    std::vector<std::size_t> destinos;
+    for (std::size_t k = 0; k < planos.size(); ++k) {
+        const std::size_t i = origen_plano[k];
+        const std::string* plano_descifrado = std::get_if<std::string>(&planos[k]);
+        const std::string* original = std::get_if<std::string>(&bloque.celdas[i]);
+        if (!plano_descifrado || (original ? *plano_descifrado == *original : plano_descifrado->empty())) {
+            plano_de_celda[i] = SIN_PLANO;
+            continue;
+        }
+        const std::string& plano = *plano_descifrado;
+        binaria[i] = !original;
+        if (esErrorDescifrado(plano)) {
+            throw std::runtime_error("No se pudo descifrar con la clave actual la columna " + nombres.descifrarNombreColumna(bloque.columnas[i % num_columnas]) +
+                " de la fila " + valorATexto(bloque.celdas[i - i % num_columnas + posicion_id]) + " en " + tabla + ".");
+        }
+        textos.push_back(plano);
+        contextos.push_back(std::move(contextos_planos[k]));
+        destinos.push_back(i);
+    }
+
+    std::vector<bool> modificada(bloque.celdas.size(), false);
+    for (std::size_t f = 0; f < num_filas; ++f) {
+        for (const auto& [columna_indice, columna_origen] : indices_ciegos) {
+            const std::size_t i_origen = f * num_columnas + columna_origen;
+            const ValorCelda& fuente = plano_de_celda[i_origen] != SIN_PLANO ? planos[plano_de_celda[i_origen]] : bloque.celdas[i_origen];
+            const std::string texto = esNulo(fuente) ? std::string("NULL") : GestorCifrado::descomprimirValor(valorATexto(fuente));
+            ValorCelda& celda = bloque.celdas[f * num_columnas + columna_indice];
+            if (texto == "NULL") {
+                if (esNulo(celda)) continue;
+                celda = std::monostate{};
+            }
+            else {
+                std::string indice = cifrado_nuevo->indiceCiego(texto);
+                if (const std::string* actual = std::get_if<std::string>(&celda); actual && boost::trim_copy(*actual) == indice) continue;
+                celda = std::move(indice);
+            }
+            modificada[f * num_columnas + columna_indice] = true;
+        }
+    }
+
+    std::vector<std::string> cifrados = cifrado_nuevo->cifrarValores(textos, {}, contextos);
+    for (std::size_t k = 0; k < destinos.size(); ++k) {
+        bloque.celdas[destinos[k]] = std::move(cifrados[k]);
+        modificada[destinos[k]] = true;
+    }
+
+    std::vector<std::size_t> columnas_modificadas;
+    std::vector<std::size_t> filas_modificadas;
+    for (std::size_t c = 0; c < num_columnas; ++c) {
+        for (std::size_t f = 0; f < num_filas; ++f) {
+            if (modificada[f * num_columnas + c]) {
+                columnas_modificadas.push_back(c);
+                break;
+            }
+        }
+    }
+    for (std::size_t f = 0; f < num_filas; ++f) {
+        if (std::any_of(modificada.begin() + f * num_columnas, modificada.begin() + (f + 1) * num_columnas, [](bool m) { return m; })) filas_modificadas.push_back(f);
+    }
+
+    std::vector<std::string> nombres_columnas;
+    for (std::size_t c : columnas_modificadas) nombres_columnas.push_back(bloque.columnas[c]);
+
+    std::vector<std::string> sentencias;
+    std::vector<std::vector<std::string>> lote;
+    for (std::size_t f : filas_modificadas) {
+        std::vector<std::string> literales;
+        literales.reserve(columnas_modificadas.size() + 1);
+        literales.push_back(valorATexto(bloque.celda(f, posicion_id)));
+        for (std::size_t c : columnas_modificadas) {
+            const ValorCelda& celda = bloque.celda(f, c);
+            std::string literal;
+            if (esNulo(celda)) literal = "NULL";
+            else D::literalCifrado(literal, valorATexto(celda), binaria[f * num_columnas + c]);
+            literales.push_back(std::move(literal));
+        }
+        lote.push_back(std::move(literales));
+        if (lote.size() == D::filas_por_insercion) {
+            sentencias.push_back(D::sentenciaActualizarLote(tabla, COLUMNA_SECUENCIA_AUDITORIA, nombres_columnas, lote));
+            lote.clear();
+        }
+    }
+    if (!lote.empty()) sentencias.push_back(D::sentenciaActualizarLote(tabla, COLUMNA_SECUENCIA_AUDITORIA, nombres_columnas, lote));
+    return sentencias;
+}
+
+// Renombra las columnas al desplazamiento de la clave nueva (la de control al
+// final, para que su nombre indique si el renombrado termino) y regenera los
+// triggers. La marca de tabla finalizada se registra en la misma transaccion.
+template <typename D>
+void GestorRotacionClave::finalizarTabla(const std::string& tabla) {
+    MedicionFase medicion("rotacion.finalizarTabla");
+    const auto columnas = gestor_db->ejecutarConsultaTipada(D::paginar("SELECT * FROM " + D::tablaCalificada(tabla), 0)).columnas;
+    const GestorCifrado& nombres = cifradoDeNombres(columnas);
+
+    std::vector<std::string> columnas_indice;
+    CambioEsquema cambio;
+    auto& renombrados = cambio.renombrados;
+    for (const auto& columna : columnas) {
+        if (columna == COLUMNA_SECUENCIA_AUDITORIA) continue;
+        const std::string origen = nombres.columnaOrigenIndiceCiego(columna);
+        if (!origen.empty()) columnas_indice.push_back(origen);
+        const std::string nuevo = cifrado_nuevo->cifrarNombreColumna(nombres.descifrarNombreColumna(columna));
+        if (nuevo != columna) renombrados.emplace_back(columna, nuevo);
+    }
+    std::stable_partition(renombrados.begin(), renombrados.end(), [&](const auto& par) {
+        return nombres.descifrarNombreColumna(par.first) != COLUMNA_CONTROL;
+        });
+
+    // encrypt_val devuelve el tipo de las columnas cifradas de la tabla.
+    bool binaria = false;
+    for (const auto& fila : gestor_db->ejecutarConsultaConResultado(D::consultaTiposColumnas(tabla)).filas) {
+        if (fila.size() >= 2 && D::esTipo(fila[1], D::tipo_binario)) binaria = true;
+    }
+    cifrado_nuevo->setAlmacenamiento(binaria ? GestorCifrado::AlmacenamientoCifrado::Binario : GestorCifrado::AlmacenamientoCifrado::Hexadecimal);
+
+    std::string marca = D::sentenciaInsercion(TABLA_AVANCE) + "tabla, segmento, huella, hasta, ultimo) VALUES (";
+    D::literal(marca, tabla);
+    marca += ", " + std::to_string(SEGMENTO_FINALIZADA) + ", '" + huella + "', 0, 0)";
+
+    ejecutarEnTransaccion<D>(*gestor_db, [&]() {
+        for (const auto& sentencia : D::planificarCambioEsquema(tabla, cambio).sentencias) gestor_db->ejecutarComando(sentencia);
+        cifrado_nuevo->regenerarTriggersCifrado(tabla, columnas_indice);
+        gestor_db->ejecutarSentencia(marca);
+        });
+    std::cout << "Tabla " << tabla << ": columnas y triggers actualizados a la clave nueva." << std::endl;
+}
+
+// Los nombres siguen el desplazamiento de la clave actual hasta que finalizarTabla
+// los renombra; si el de la columna de control ya usa el nuevo, se usa la nueva.
+const GestorCifrado& GestorRotacionClave::cifradoDeNombres(const std::vector<std::string>& columnas) const {
+    if (std::find(columnas.begin(), columnas.end(), cifrado_actual->cifrarNombreColumna(COLUMNA_CONTROL)) == columnas.end() &&
+        std::find(columnas.begin(), columnas.end(), cifrado_nuevo->cifrarNombreColumna(COLUMNA_CONTROL)) != columnas.end()) {
+        return *cifrado_nuevo;
+    }
+    return *cifrado_actual;
+}
+
+void GestorRotacionClave::ejecutarEnParalelo(std::size_t num_tareas, const std::function<void(GestorAuditoria&, std::size_t)>& tarea) {
+    std::atomic<std::size_t> siguiente{ 0 };
+    std::atomic<bool> fallo{ false };
+    std::string primer_error;
+
+    auto trabajador = [&]() {
+        try {
+            GestorAuditoria conexion(motor_db, info_conexion, db_name);
+            if (!conexion.estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+            for (std::size_t i = siguiente++; i < num_tareas && !fallo; i = siguiente++) {
+                tarea(conexion, i);
+            }
+        }
+        catch (const std::exception& e) {
+            std::lock_guard<std::mutex> bloqueo(mutex_salida);
+            if (!fallo.exchange(true)) primer_error = e.what();
+        }
+        };
+
+    const std::size_t total_trabajadores = std::max<std::size_t>(1, std::min<std::size_t>(configuracion.num_trabajadores, num_tareas));
+    std::vector<std::thread> hilos;
+    hilos.reserve(total_trabajadores);
+    for (std::size_t i = 0; i < total_trabajadores; ++i) hilos.emplace_back(trabajador);
+    for (auto& hilo : hilos) hilo.join();
+
+    if (fallo) throw std::runtime_error(primer_error);
+}
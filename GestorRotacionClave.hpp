@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "GestorAuditoria.hpp"
+#include "GestorCifrado.hpp"
+
+// Rotacion de la clave de las tablas aud_ cifradas. Cada tabla se recorre por
+// tramos de IdAuditoria repartidos entre varias conexiones; cada bloque se
+// descifra con la clave actual, se cifra con la nueva y se escribe con un UPDATE
+// por lotes en la misma transaccion que guarda el avance del tramo en la tabla
+// shc134_rotacion_clave. Una rotacion interrumpida continua desde ese avance.
+// Al terminar las filas se renombran las columnas si cambia el desplazamiento
+// y se regeneran los triggers con la clave nueva.
+class GestorRotacionClave {
+public:
+    struct Configuracion {
+        std::string clave_actual;
+        std::string clave_nueva;
+        GestorCifrado::FormatoCifrado formato_cifrado = GestorCifrado::FormatoCifrado::Cbc;
+        unsigned int num_trabajadores = 4;
+        std::size_t filas_por_bloque = 5000;
+    };
+
+    GestorRotacionClave(GestorAuditoria::MotorDB motor, const std::string& info_conexion, const std::string& db, Configuracion configuracion);
+
+    void ejecutar();
+
+private:
+    struct Tramo {
+        int segmento;
+        std::int64_t hasta;
+        std::int64_t ultimo;
+    };
+    struct Avance {
+        std::vector<Tramo> tramos;
+        bool finalizada = false;
+    };
+
+    GestorAuditoria::MotorDB motor_db;
+    std::string info_conexion;
+    std::string db_name;
+    Configuracion configuracion;
+    std::shared_ptr<GestorAuditoria> gestor_db;
+    std::shared_ptr<GestorCifrado> cifrado_actual;
+    std::shared_ptr<GestorCifrado> cifrado_nuevo;
+    std::string huella;
+    std::map<std::string, Avance> avances;
+    std::mutex mutex_salida;
+
+    template <typename D> void ejecutarConDialecto();
+    template <typename D> void cargarAvance();
+    template <typename D> void crearTramos(const std::string& tabla);
+    template <typename D> std::uint64_t rotarTramo(GestorAuditoria& conexion, const std::string& tabla, Tramo& tramo);
+    template <typename D> std::vector<std::string> sentenciasRecifrado(const std::string& tabla, ResultadoTipado& bloque) const;
+    template <typename D> void finalizarTabla(const std::string& tabla);
+    const GestorCifrado& cifradoDeNombres(const std::vector<std::string>& columnas) const;
+    void ejecutarEnParalelo(std::size_t num_tareas, const std::function<void(GestorAuditoria&, std::size_t)>& tarea);
+};
@@ -0,0 +1,140 @@
+#include "GrafoEsquema.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+void llenarCsr(std::size_t num_nodos, const std::vector<std::pair<std::uint32_t, std::uint32_t>>& aristas,
+    std::vector<std::uint32_t>& inicio, std::vector<std::uint32_t>& vecinos) {
+    inicio.assign(num_nodos + 1, 0);
+    for (const auto& [desde, hacia] : aristas) ++inicio[desde + 1];
+    for (std::size_t i = 0; i < num_nodos; ++i) inicio[i + 1] += inicio[i];
+    vecinos.resize(aristas.size());
+    std::vector<std::uint32_t> cursor(inicio.begin(), inicio.end() - 1);
+    for (const auto& [desde, hacia] : aristas) vecinos[cursor[desde]++] = hacia;
+}
+
+}
+
+void GrafoEsquema::construir(std::size_t num_tablas, std::vector<std::pair<std::uint32_t, std::uint32_t>> aristas) {
+    std::sort(aristas.begin(), aristas.end());
+    aristas.erase(std::unique(aristas.begin(), aristas.end()), aristas.end());
+    llenarCsr(num_tablas, aristas, inicio_salida, destinos);
+
+    for (auto& arista : aristas) std::swap(arista.first, arista.second);
+    std::sort(aristas.begin(), aristas.end());
+    llenarCsr(num_tablas, aristas, inicio_entrada, origenes);
+}
+
+std::span<const std::uint32_t> GrafoEsquema::referenciadas(std::uint32_t tabla) const {
+    return std::span<const std::uint32_t>(destinos).subspan(inicio_salida[tabla], inicio_salida[tabla + 1] - inicio_salida[tabla]);
+}
+
+std::span<const std::uint32_t> GrafoEsquema::referenciantes(std::uint32_t tabla) const {
+    return std::span<const std::uint32_t>(origenes).subspan(inicio_entrada[tabla], inicio_entrada[tabla + 1] - inicio_entrada[tabla]);
+}
+
+std::vector<bool> GrafoEsquema::alcanzablesDesde(std::uint32_t origen) const {
+    std::vector<bool> visitado(tamano(), false);
+    std::vector<std::uint32_t> cola = { origen };
+    visitado[origen] = true;
+    for (std::size_t i = 0; i < cola.size(); ++i) {
+        for (std::uint32_t destino : referenciadas(cola[i])) {
+            if (!visitado[destino]) {
+                visitado[destino] = true;
+                cola.push_back(destino);
+            }
+        }
+    }
+    return visitado;
+}
+
+// Kahn sobre las dependencias: una tabla se emite cuando ya se emitieron todas
+// las que referencia. Las autorreferencias no bloquean. Lo que queda sin
+// emitir pertenece a un ciclo o depende de uno.
+OrdenDependencias GrafoEsquema::ordenarPorDependencias() const {
+    const std::size_t n = tamano();
+    OrdenDependencias resultado;
+    resultado.orden.reserve(n);
+
+    std::vector<std::uint32_t> pendientes(n, 0);
+    for (std::uint32_t t = 0; t < n; ++t) {
+        for (std::uint32_t destino : referenciadas(t)) {
+            if (destino != t) ++pendientes[t];
+        }
+        if (pendientes[t] == 0) resultado.orden.push_back(t);
+    }
+    for (std::size_t i = 0; i < resultado.orden.size(); ++i) {
+        const std::uint32_t emitida = resultado.orden[i];
+        for (std::uint32_t referenciante : referenciantes(emitida)) {
+            if (referenciante != emitida && --pendientes[referenciante] == 0) resultado.orden.push_back(referenciante);
+        }
+    }
+    if (resultado.orden.size() < n) {
+        for (std::uint32_t t = 0; t < n; ++t) {
+            if (pendientes[t] > 0) resultado.bloqueadas.push_back(t);
+        }
+    }
+    return resultado;
+}
+
+// Tarjan iterativo. Devuelve las componentes fuertemente conexas con mas de
+// una tabla, cada una ordenada por indice.
+std::vector<std::vector<std::uint32_t>> GrafoEsquema::componentesCiclicas() const {
+    constexpr std::uint32_t SIN_VISITAR = std::numeric_limits<std::uint32_t>::max();
+    const std::size_t n = tamano();
+    std::vector<std::uint32_t> indice(n, SIN_VISITAR);
+    std::vector<std::uint32_t> enlace(n, 0);
+    std::vector<bool> en_pila(n, false);
+    std::vector<std::uint32_t> pila;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> llamadas;
+    std::vector<std::vector<std::uint32_t>> componentes;
+    std::uint32_t siguiente = 0;
+
+    for (std::uint32_t raiz = 0; raiz < n; ++raiz) {
+        if (indice[raiz] != SIN_VISITAR) continue;
+        llamadas.push_back({ raiz, 0 });
+        while (!llamadas.empty()) {
+            auto& [nodo, posicion] = llamadas.back();
+            if (posicion == 0) {
+                indice[nodo] = enlace[nodo] = siguiente++;
+                pila.push_back(nodo);
+                en_pila[nodo] = true;
+            }
+            const auto vecinos = referenciadas(nodo);
+            if (posicion < vecinos.size()) {
+                const std::uint32_t vecino = vecinos[posicion++];
+                if (indice[vecino] == SIN_VISITAR) {
+                    llamadas.push_back({ vecino, 0 });
+                }
+                else if (en_pila[vecino]) {
+                    enlace[nodo] = std::min(enlace[nodo], indice[vecino]);
+                }
+                continue;
+            }
+
+            const std::uint32_t terminado = nodo;
+            llamadas.pop_back();
+            if (!llamadas.empty()) {
+                std::uint32_t& padre = llamadas.back().first;
+                enlace[padre] = std::min(enlace[padre], enlace[terminado]);
+            }
+            if (enlace[terminado] != indice[terminado]) continue;
+
+            std::vector<std::uint32_t> componente;
+            std::uint32_t miembro;
+            do {
+                miembro = pila.back();
+                pila.pop_back();
+                en_pila[miembro] = false;
+                componente.push_back(miembro);
+            } while (miembro != terminado);
+            if (componente.size() > 1) {
+                std::sort(componente.begin(), componente.end());
+                componentes.push_back(std::move(componente));
+            }
+        }
+    }
+    std::sort(componentes.begin(), componentes.end());
+    return componentes;
+}
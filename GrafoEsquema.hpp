@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+struct OrdenDependencias {
+    std::vector<std::uint32_t> orden;
+    std::vector<std::uint32_t> bloqueadas;
+};
+
+// Grafo de claves foraneas en formato CSR: la arista a -> b indica que la
+// tabla a referencia a la tabla b. Los nodos son indices de Esquema::tablas.
+class GrafoEsquema {
+public:
+    void construir(std::size_t num_tablas, std::vector<std::pair<std::uint32_t, std::uint32_t>> aristas);
+
+    std::size_t tamano() const { return inicio_salida.empty() ? 0 : inicio_salida.size() - 1; }
+    std::span<const std::uint32_t> referenciadas(std::uint32_t tabla) const;
+    std::span<const std::uint32_t> referenciantes(std::uint32_t tabla) const;
+
+    std::vector<bool> alcanzablesDesde(std::uint32_t origen) const;
+    OrdenDependencias ordenarPorDependencias() const;
+    std::vector<std::vector<std::uint32_t>> componentesCiclicas() const;
+
+private:
+    std::vector<std::uint32_t> inicio_salida;
+    std::vector<std::uint32_t> destinos;
+    std::vector<std::uint32_t> inicio_entrada;
+    std::vector<std::uint32_t> origenes;
+};
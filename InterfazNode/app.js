@@ -7,72 +7,275 @@ const app = express();
 const PORT = 9542;
 const exePath = path.join(__dirname, './SHC134DatabaseProjectManagerCpp.exe');
 
+const MAX_TRABAJOS_SIMULTANEOS = Number(process.env.SHC_MAX_TRABAJOS) || 2;
+const MAX_TRABAJOS_EN_COLA = Number(process.env.SHC_MAX_COLA) || 20;
+const MAX_TRABAJOS_RETENIDOS = 50;
+const MAX_BYTES_HISTORIAL = 1024 * 1024;
+const MAX_BYTES_PENDIENTES_CLIENTE = 4 * 1024 * 1024;
+const INTERVALO_AGRUPACION_MS = 50;
+const INTERVALO_LATIDO_MS = 15000;
+
 app.use(cors());
 app.use(express.json());
 app.use(express.static(path.join(__dirname, 'public')));
 
-let sseClient = null;
+const trabajos = new Map();
+const cola = [];
+const clientesGlobales = new Set();
+let siguienteId = 1;
+let trabajosEnEjecucion = 0;
 
-app.get('/api/stream', (req, res) => {
-    res.setHeader('Content-Type', 'text/event-stream');
-    res.setHeader('Cache-Control', 'no-cache');
-    res.setHeader('Connection', 'keep-alive');
-    res.flushHeaders();
+function crearTrabajo(action, args) {
+    const trabajo = {
+        id: String(siguienteId++),
+        action,
+        args,
+        estado: 'en_cola',
+        codigo: null,
+        creado: new Date().toISOString(),
+        historial: [],
+        bytesHistorial: 0,
+        siguienteSeq: 1,
+        pendientes: [],
+        temporizador: null,
+        clientes: new Set(),
+        proceso: null,
+        cancelado: false
+    };
+    trabajos.set(trabajo.id, trabajo);
+    return trabajo;
+}
 
-    sseClient = res;
+function resumenTrabajo(trabajo) {
+    return {
+        id: trabajo.id,
+        action: trabajo.action,
+        estado: trabajo.estado,
+        codigo: trabajo.codigo,
+        creado: trabajo.creado,
+        posicion: trabajo.estado === 'en_cola' ? cola.indexOf(trabajo) + 1 : 0
+    };
+}
 
-    req.on('close', () => {
-        sseClient = null;
-    });
-});
+function serializarEvento(trabajo, evento) {
+    return `id: ${evento.seq}\ndata: ${JSON.stringify({ job: trabajo.id, type: evento.type, data: evento.data })}\n\n`;
+}
 
-function sendSseMessage(type, data) {
-    if (sseClient) {
-        const message = `data: ${JSON.stringify({ type, data })}\n\n`;
-        sseClient.write(message);
+function clienteCerrado(cliente) {
+    return cliente.writableEnded || cliente.destroyed;
+}
+
+// Un cliente lento se destruye (no end(), que aun escribiria lo pendiente) y se
+// quita del conjunto; el evento 'close' detiene su latido.
+function escribirCliente(clientes, cliente, texto) {
+    if (clienteCerrado(cliente)) {
+        clientes.delete(cliente);
+        return;
+    }
+    if (cliente.writableLength > MAX_BYTES_PENDIENTES_CLIENTE) {
+        clientes.delete(cliente);
+        cliente.destroy();
+        return;
     }
+    cliente.write(texto);
 }
 
-app.post('/api/execute', (req, res) => {
-    const { action, params } = req.body;
+function guardarEnHistorial(trabajo, evento) {
+    trabajo.historial.push(evento);
+    trabajo.bytesHistorial += evento.data.length;
+    while (trabajo.bytesHistorial > MAX_BYTES_HISTORIAL && trabajo.historial.length > 1) {
+        trabajo.bytesHistorial -= trabajo.historial.shift().data.length;
+    }
+}
+
+function volcarPendientes(trabajo) {
+    if (trabajo.temporizador) {
+        clearTimeout(trabajo.temporizador);
+        trabajo.temporizador = null;
+    }
+    if (trabajo.pendientes.length === 0) return;
+
+    const eventos = [];
+    for (const fragmento of trabajo.pendientes) {
+        const ultimo = eventos[eventos.length - 1];
+        if (ultimo && ultimo.type === fragmento.type) {
+            ultimo.data += fragmento.data;
+        } else {
+            eventos.push({ type: fragmento.type, data: fragmento.data });
+        }
+    }
+    trabajo.pendientes = [];
+
+    let trama = '';
+    for (const evento of eventos) {
+        evento.seq = trabajo.siguienteSeq++;
+        guardarEnHistorial(trabajo, evento);
+        trama += serializarEvento(trabajo, evento);
+    }
+    for (const cliente of trabajo.clientes) escribirCliente(trabajo.clientes, cliente, trama);
+    for (const cliente of clientesGlobales) escribirCliente(clientesGlobales, cliente, trama);
+}
+
+function emitir(trabajo, type, data) {
+    trabajo.pendientes.push({ type, data });
+    if (!trabajo.temporizador) {
+        trabajo.temporizador = setTimeout(() => volcarPendientes(trabajo), INTERVALO_AGRUPACION_MS);
+    }
+}
+
+function finalizarTrabajo(trabajo, estado, codigo, mensaje) {
+    if (trabajo.estado === 'finalizado' || trabajo.estado === 'error' || trabajo.estado === 'cancelado') return;
+    trabajo.estado = estado;
+    trabajo.codigo = codigo;
+    trabajo.proceso = null;
+    emitir(trabajo, 'info', mensaje);
+    emitir(trabajo, 'fin', estado);
+    volcarPendientes(trabajo);
+    for (const cliente of trabajo.clientes) {
+        if (!clienteCerrado(cliente)) cliente.end();
+    }
+    trabajo.clientes.clear();
+    depurarTrabajos();
+}
+
+function depurarTrabajos() {
+    const terminados = [...trabajos.values()].filter(t => t.estado !== 'en_cola' && t.estado !== 'ejecutando');
+    while (terminados.length > MAX_TRABAJOS_RETENIDOS) {
+        trabajos.delete(terminados.shift().id);
+    }
+}
+
+function iniciarSiguiente() {
+    while (trabajosEnEjecucion < MAX_TRABAJOS_SIMULTANEOS && cola.length > 0) {
+        ejecutarTrabajo(cola.shift());
+    }
+}
+
+function ejecutarTrabajo(trabajo) {
+    trabajosEnEjecucion++;
+    trabajo.estado = 'ejecutando';
+    emitir(trabajo, 'info', `▶ Ejecutando: ${path.basename(exePath)} ${trabajo.args.join(' ')}\n` + '─'.repeat(80));
+
+    let liberado = false;
+    const liberar = () => {
+        if (liberado) return;
+        liberado = true;
+        trabajosEnEjecucion--;
+        iniciarSiguiente();
+    };
+
+    const child = spawn(exePath, trabajo.args);
+    trabajo.proceso = child;
+
+    child.stdout.on('data', (data) => emitir(trabajo, 'stdout', data.toString()));
+    child.stderr.on('data', (data) => emitir(trabajo, 'stderr', data.toString()));
+
+    child.on('close', (code) => {
+        const estado = trabajo.cancelado ? 'cancelado' : (code === 0 ? 'finalizado' : 'error');
+        finalizarTrabajo(trabajo, estado, code,
+            '─'.repeat(80) + `\n✔ Proceso finalizado con código: ${code}`);
+        liberar();
+    });
+    child.on('error', (err) => {
+        emitir(trabajo, 'stderr', `Error al iniciar el ejecutable: ${err.message}`);
+        finalizarTrabajo(trabajo, 'error', null, '─'.repeat(80) + '\n✖ El proceso no pudo iniciarse');
+        liberar();
+    });
+}
 
+function construirArgumentos(action, params) {
     const args = [action];
     for (const key in params) {
         if (params[key] === true) {
             args.push(`--${key}`);
         } else if (params[key]) {
-            args.push(`--${key}`, params[key]);
+            args.push(`--${key}`, String(params[key]));
         }
     }
+    return args;
+}
 
-    res.status(200).json({ message: 'Proceso iniciado' });
-    
-    sendSseMessage('info', `▶ Ejecutando: ${path.basename(exePath)} ${args.join(' ')}\n` + '─'.repeat(80));
+function abrirStream(req, res) {
+    res.setHeader('Content-Type', 'text/event-stream');
+    res.setHeader('Cache-Control', 'no-cache');
+    res.setHeader('Connection', 'keep-alive');
+    res.flushHeaders();
 
-    const child = spawn(exePath, args);
+    const latido = setInterval(() => {
+        if (clienteCerrado(res)) {
+            clearInterval(latido);
+            return;
+        }
+        res.write(': latido\n\n');
+    }, INTERVALO_LATIDO_MS);
+    res.on('close', () => clearInterval(latido));
+}
 
-    child.stdout.on('data', (data) => {
-        sendSseMessage('stdout', data.toString());
-    });
+app.post('/api/execute', (req, res) => {
+    const { action, params } = req.body;
+    if (!action) {
+        return res.status(400).json({ message: 'El campo action es obligatorio' });
+    }
+    if (cola.length >= MAX_TRABAJOS_EN_COLA) {
+        return res.status(429).json({ message: 'La cola de trabajos está llena' });
+    }
 
-    child.stderr.on('data', (data) => {
-        sendSseMessage('stderr', data.toString());
-    });
+    const trabajo = crearTrabajo(action, construirArgumentos(action, params || {}));
+    cola.push(trabajo);
+    emitir(trabajo, 'info', `Trabajo ${trabajo.id} en cola`);
+    iniciarSiguiente();
 
-    child.on('close', (code) => {
-        sendSseMessage('info', '─'.repeat(80) + `\n✔ Proceso finalizado con código: ${code}`);
-        if (sseClient) {
-            sseClient.end(); 
-            sseClient = null;
-        }
-    });
-    child.on('error', (err) => {
-        sendSseMessage('stderr', `Error al iniciar el ejecutable: ${err.message}`);
-        if (sseClient) {
-            sseClient.end();
-            sseClient = null;
-        }
-    });
+    res.status(202).json({ message: 'Proceso encolado', jobId: trabajo.id, ...resumenTrabajo(trabajo) });
+});
+
+app.get('/api/jobs', (req, res) => {
+    res.json([...trabajos.values()].map(resumenTrabajo));
+});
+
+app.get('/api/jobs/:id', (req, res) => {
+    const trabajo = trabajos.get(req.params.id);
+    if (!trabajo) return res.status(404).json({ message: 'Trabajo no encontrado' });
+    res.json(resumenTrabajo(trabajo));
+});
+
+app.get('/api/jobs/:id/stream', (req, res) => {
+    const trabajo = trabajos.get(req.params.id);
+    if (!trabajo) return res.status(404).json({ message: 'Trabajo no encontrado' });
+
+    abrirStream(req, res);
+
+    const ultimoId = Number(req.get('Last-Event-ID')) || 0;
+    let reproduccion = '';
+    for (const evento of trabajo.historial) {
+        if (evento.seq > ultimoId) reproduccion += serializarEvento(trabajo, evento);
+    }
+    if (reproduccion) res.write(reproduccion);
+
+    if (trabajo.estado !== 'en_cola' && trabajo.estado !== 'ejecutando') {
+        return res.end();
+    }
+    trabajo.clientes.add(res);
+    req.on('close', () => trabajo.clientes.delete(res));
+});
+
+app.delete('/api/jobs/:id', (req, res) => {
+    const trabajo = trabajos.get(req.params.id);
+    if (!trabajo) return res.status(404).json({ message: 'Trabajo no encontrado' });
+
+    if (trabajo.estado === 'en_cola') {
+        cola.splice(cola.indexOf(trabajo), 1);
+        finalizarTrabajo(trabajo, 'cancelado', null, '✖ Trabajo cancelado antes de iniciar');
+    } else if (trabajo.estado === 'ejecutando' && trabajo.proceso) {
+        trabajo.cancelado = true;
+        trabajo.proceso.kill();
+    }
+    res.json(resumenTrabajo(trabajo));
+});
+
+app.get('/api/stream', (req, res) => {
+    abrirStream(req, res);
+    clientesGlobales.add(res);
+    req.on('close', () => clientesGlobales.delete(res));
 });
 
 app.get('/', (req, res) => {
@@ -82,4 +285,4 @@ app.get('/', (req, res) => {
 app.listen(PORT, () => {
     console.log(`Servidor web iniciado.`);
     console.log(`Abre tu navegador en http://localhost:${PORT}`);
-});
\ No newline at end of file
+});
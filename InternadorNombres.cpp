@@ -0,0 +1,54 @@
+#include "InternadorNombres.hpp"
+#include "Utils.hpp"
+
+IdNombre InternadorNombres::internar(std::string_view nombre) {
+    auto existente = indice.find(nombre);
+    if (existente != indice.end()) return existente->second;
+
+    const std::size_t largo_pascal = longitudPascalCase(nombre);
+    const std::size_t largo_kebab = largo_pascal + separadoresKebabCase(nombre);
+
+    Entrada entrada;
+    entrada.texto.reserve(nombre.size() + 2 * largo_pascal + largo_kebab);
+    entrada.texto.append(nombre);
+    entrada.fin_original = static_cast<std::uint32_t>(entrada.texto.size());
+    anexarPascalCase(nombre, entrada.texto);
+    entrada.fin_pascal = static_cast<std::uint32_t>(entrada.texto.size());
+    anexarCamelCase(nombre, entrada.texto);
+    entrada.fin_camel = static_cast<std::uint32_t>(entrada.texto.size());
+    anexarKebabCase(std::string_view(entrada.texto).substr(entrada.fin_original, largo_pascal), entrada.texto);
+
+    const IdNombre id = static_cast<IdNombre>(entradas.size());
+    entradas.push_back(std::move(entrada));
+    indice.emplace(original(id), id);
+    return id;
+}
+
+IdNombre InternadorNombres::buscar(std::string_view nombre) const {
+    auto existente = indice.find(nombre);
+    return existente == indice.end() ? NOMBRE_NULO : existente->second;
+}
+
+std::string_view InternadorNombres::original(IdNombre id) const {
+    if (id == NOMBRE_NULO) return {};
+    const Entrada& e = entradas[id];
+    return std::string_view(e.texto).substr(0, e.fin_original);
+}
+
+std::string_view InternadorNombres::pascal(IdNombre id) const {
+    if (id == NOMBRE_NULO) return {};
+    const Entrada& e = entradas[id];
+    return std::string_view(e.texto).substr(e.fin_original, e.fin_pascal - e.fin_original);
+}
+
+std::string_view InternadorNombres::camel(IdNombre id) const {
+    if (id == NOMBRE_NULO) return {};
+    const Entrada& e = entradas[id];
+    return std::string_view(e.texto).substr(e.fin_pascal, e.fin_camel - e.fin_pascal);
+}
+
+std::string_view InternadorNombres::kebab(IdNombre id) const {
+    if (id == NOMBRE_NULO) return {};
+    const Entrada& e = entradas[id];
+    return std::string_view(e.texto).substr(e.fin_camel);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using IdNombre = std::uint32_t;
+constexpr IdNombre NOMBRE_NULO = std::numeric_limits<IdNombre>::max();
+
+class InternadorNombres {
+public:
+    InternadorNombres() = default;
+    InternadorNombres(const InternadorNombres&) = delete;
+    InternadorNombres& operator=(const InternadorNombres&) = delete;
+    InternadorNombres(InternadorNombres&&) = default;
+    InternadorNombres& operator=(InternadorNombres&&) = default;
+
+    IdNombre internar(std::string_view nombre);
+    IdNombre buscar(std::string_view nombre) const;
+    std::size_t tamano() const { return entradas.size(); }
+
+    std::string_view original(IdNombre id) const;
+    std::string_view pascal(IdNombre id) const;
+    std::string_view camel(IdNombre id) const;
+    std::string_view kebab(IdNombre id) const;
+
+private:
+    // Las cuatro formas del nombre viven contiguas en un solo bloque:
+    // original | PascalCase | camelCase | kebab-case.
+    struct Entrada {
+        std::string texto;
+        std::uint32_t fin_original;
+        std::uint32_t fin_pascal;
+        std::uint32_t fin_camel;
+    };
+
+    std::deque<Entrada> entradas;
+    std::unordered_map<std::string_view, IdNombre> indice;
+};
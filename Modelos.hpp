@@ -1,34 +1,69 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "InternadorNombres.hpp"
+#include "GrafoEsquema.hpp"
 
 struct Columna {
-    std::string nombre;
-    std::string nombre_camel_case;
+    IdNombre nombre = NOMBRE_NULO;
     std::string tipo_db;
     std::string tipo_ts;
-    bool es_nulo;
+    bool es_nulo = false;
     bool es_pk = false;
     bool es_fk = false;
 };
 
 struct DependenciaFK {
-    std::string columna_local;
-    std::string tabla_referenciada;
-    std::string clase_tabla_referenciada;
-    std::string variable_tabla_referenciada;
+    IdNombre columna_local = NOMBRE_NULO;
+    IdNombre tabla_referenciada = NOMBRE_NULO;
 };
 
 struct Tabla {
-    std::string nombre;
-    std::string nombre_clase;
-    std::string nombre_variable;
-    std::string nombre_archivo;
+    IdNombre nombre = NOMBRE_NULO;
     Columna clave_primaria;
     std::vector<Columna> columnas;
     std::vector<DependenciaFK> dependencias_fk;
     bool es_tabla_usuario = false;
     bool es_protegida = true;
-    std::string campo_email_encontrado;
-    std::string campo_contrasena_encontrado;
-};
\ No newline at end of file
+    IdNombre campo_email_encontrado = NOMBRE_NULO;
+    IdNombre campo_contrasena_encontrado = NOMBRE_NULO;
+};
+
+struct Esquema {
+    InternadorNombres nombres;
+    std::vector<Tabla> tablas;
+    std::vector<std::uint32_t> tabla_por_nombre;
+    GrafoEsquema grafo;
+
+    // Reconstruye el indice nombre -> tabla y el grafo de claves foraneas.
+    // Debe llamarse despues de modificar tablas o sus dependencias.
+    void indexar() {
+        tabla_por_nombre.assign(nombres.tamano(), SIN_TABLA);
+        for (std::size_t i = 0; i < tablas.size(); ++i) {
+            tabla_por_nombre[tablas[i].nombre] = static_cast<std::uint32_t>(i);
+        }
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> aristas;
+        for (std::size_t i = 0; i < tablas.size(); ++i) {
+            for (const auto& dep : tablas[i].dependencias_fk) {
+                const std::uint32_t destino = indiceTabla(dep.tabla_referenciada);
+                if (destino != SIN_TABLA) aristas.push_back({ static_cast<std::uint32_t>(i), destino });
+            }
+        }
+        grafo.construir(tablas.size(), std::move(aristas));
+    }
+
+    std::uint32_t indiceTabla(IdNombre nombre) const {
+        return nombre < tabla_por_nombre.size() ? tabla_por_nombre[nombre] : SIN_TABLA;
+    }
+
+    const Tabla* buscarTabla(IdNombre nombre) const {
+        const std::uint32_t indice = indiceTabla(nombre);
+        return indice == SIN_TABLA ? nullptr : &tablas[indice];
+    }
+
+    const Tabla* buscarTabla(std::string_view nombre) const {
+        return buscarTabla(nombres.buscar(nombre));
+    }
+
+    static constexpr std::uint32_t SIN_TABLA = NOMBRE_NULO;
+};
@@ -1,19 +1,39 @@
 DROP FUNCTION IF EXISTS encrypt_val;
 
 CREATE FUNCTION encrypt_val(data_to_encrypt TEXT)
-RETURNS TEXT CHARSET utf8mb4
+{% if almacenamiento_binario %}RETURNS LONGBLOB{% else %}RETURNS TEXT CHARSET utf8mb4{% endif %}
 DETERMINISTIC
 BEGIN
     DECLARE iv VARBINARY(16);
-    DECLARE encrypted_data TEXT;
+{% if almacenamiento_binario %}    IF data_to_encrypt IS NULL OR data_to_encrypt = 'NULL' THEN
+        RETURN NULL;
+    END IF;
+    SET iv = RANDOM_BYTES(16);
+    RETURN CONCAT(iv, AES_ENCRYPT(data_to_encrypt, UNHEX('{{ clave_hex }}'), iv));
+{% else %}    DECLARE encrypted_data TEXT;
     IF data_to_encrypt IS NULL OR data_to_encrypt = 'NULL' THEN
         RETURN data_to_encrypt;
     END IF;
     SET iv = RANDOM_BYTES(16);
     SET encrypted_data = HEX(AES_ENCRYPT(data_to_encrypt, UNHEX('{{ clave_hex }}'), iv));
     RETURN CONCAT(HEX(iv), encrypted_data);
+{% endif %}END;
+
+DROP FUNCTION IF EXISTS blind_idx;
+
+CREATE FUNCTION blind_idx(data_to_index TEXT)
+RETURNS CHAR(32) CHARSET ascii
+DETERMINISTIC
+BEGIN
+    IF data_to_index IS NULL OR data_to_index = 'NULL' THEN
+        RETURN NULL;
+    END IF;
+    RETURN LEFT(SHA2(CONCAT(UNHEX('{{ clave_indice_opad }}'), UNHEX(SHA2(CONCAT(UNHEX('{{ clave_indice_ipad }}'), CONVERT(data_to_index USING utf8mb4)), 256))), 256), 32);
 END;
 
+DROP TRIGGER IF EXISTS insert_{{ tabla }}_aud;
+DROP TRIGGER IF EXISTS update_{{ tabla }}_aud;
+DROP TRIGGER IF EXISTS delete_{{ tabla }}_aud;
 DROP TRIGGER IF EXISTS insert_{{ tabla }}_aud_cifrado;
 DROP TRIGGER IF EXISTS update_{{ tabla }}_aud_cifrado;
 DROP TRIGGER IF EXISTS delete_{{ tabla }}_aud_cifrado;
@@ -22,19 +42,25 @@ CREATE TRIGGER insert_{{ tabla }}_aud_cifrado
 AFTER INSERT ON {{ tabla }}
 FOR EACH ROW
 BEGIN
-    INSERT INTO {{ tabla_auditoria }}({{ lista_columnas_cifradas }}) VALUES ({{ valores_insert_new }});
+    IF @shc134_restauracion IS NULL THEN
+        INSERT INTO {{ tabla_auditoria }}({{ lista_columnas_cifradas }}) VALUES ({{ valores_insert_new }});
+    END IF;
 END;
 
 CREATE TRIGGER update_{{ tabla }}_aud_cifrado
 AFTER UPDATE ON {{ tabla }}
 FOR EACH ROW
 BEGIN
-    INSERT INTO {{ tabla_auditoria }}({{ lista_columnas_cifradas }}) VALUES ({{ valores_update_old }});
+    IF @shc134_restauracion IS NULL THEN
+        INSERT INTO {{ tabla_auditoria }}({{ lista_columnas_cifradas }}) VALUES ({{ valores_update_old }});
+    END IF;
 END;
 
 CREATE TRIGGER delete_{{ tabla }}_aud_cifrado
 AFTER DELETE ON {{ tabla }}
 FOR EACH ROW
 BEGIN
-    INSERT INTO {{ tabla_auditoria }}({{ lista_columnas_cifradas }}) VALUES ({{ valores_delete_old }});
+    IF @shc134_restauracion IS NULL THEN
+        INSERT INTO {{ tabla_auditoria }}({{ lista_columnas_cifradas }}) VALUES ({{ valores_delete_old }});
+    END IF;
 END;
\ No newline at end of file
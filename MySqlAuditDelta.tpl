@@ -0,0 +1,33 @@
+DELIMITER $$
+DROP TABLE IF EXISTS aud_{{ tabla }}$$
+CREATE TABLE aud_{{ tabla }} (`Clave` TEXT, `Cambios` LONGTEXT, `UsuarioAccion` TEXT, `FechaAccion` TEXT, `AccionSql` TEXT, `IdAuditoria` BIGINT AUTO_INCREMENT PRIMARY KEY)$$
+
+DROP TRIGGER IF EXISTS insert_{{ tabla }}_aud$$
+CREATE TRIGGER insert_{{ tabla }}_aud AFTER INSERT ON {{ tabla }} FOR EACH ROW
+BEGIN
+    IF @shc134_restauracion IS NULL THEN
+        INSERT INTO aud_{{ tabla }} VALUES({{ clave_nueva }}, {{ fila_nueva }}, SUBSTRING_INDEX(CURRENT_USER(),'@',1), CAST(NOW() AS CHAR), 'Insertado', NULL);
+    END IF;
+END$$
+
+DROP TRIGGER IF EXISTS update_{{ tabla }}_aud$$
+CREATE TRIGGER update_{{ tabla }}_aud AFTER UPDATE ON {{ tabla }} FOR EACH ROW
+BEGIN
+    IF @shc134_restauracion IS NULL THEN
+        IF {{ clave_cambiada }} THEN
+            INSERT INTO aud_{{ tabla }} VALUES({{ clave_vieja }}, {{ fila_vieja }}, SUBSTRING_INDEX(CURRENT_USER(),'@',1), CAST(NOW() AS CHAR), 'Eliminado', NULL);
+            INSERT INTO aud_{{ tabla }} VALUES({{ clave_nueva }}, {{ fila_nueva }}, SUBSTRING_INDEX(CURRENT_USER(),'@',1), CAST(NOW() AS CHAR), 'Insertado', NULL);
+        ELSE
+            INSERT INTO aud_{{ tabla }} VALUES({{ clave_vieja }}, {{ cambios }}, SUBSTRING_INDEX(CURRENT_USER(),'@',1), CAST(NOW() AS CHAR), 'Modificado', NULL);
+        END IF;
+    END IF;
+END$$
+
+DROP TRIGGER IF EXISTS delete_{{ tabla }}_aud$$
+CREATE TRIGGER delete_{{ tabla }}_aud AFTER DELETE ON {{ tabla }} FOR EACH ROW
+BEGIN
+    IF @shc134_restauracion IS NULL THEN
+        INSERT INTO aud_{{ tabla }} VALUES({{ clave_vieja }}, {{ fila_vieja }}, SUBSTRING_INDEX(CURRENT_USER(),'@',1), CAST(NOW() AS CHAR), 'Eliminado', NULL);
+    END IF;
+END$$
+DELIMITER ;
\ No newline at end of file
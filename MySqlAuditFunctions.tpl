@@ -4,17 +4,18 @@ CREATE FUNCTION fcampos (tabla TEXT) RETURNS TEXT CHARSET utf8mb4 DETERMINISTIC
 BEGIN
     DECLARE valores TEXT DEFAULT '';
     DECLARE nombre TEXT;
+    DECLARE tipo TEXT;
     DECLARE finished INT DEFAULT 0;
-    DECLARE cur CURSOR FOR SELECT column_name FROM information_schema.columns WHERE table_schema = DATABASE() AND table_name = tabla ORDER BY ordinal_position;
+    DECLARE cur CURSOR FOR SELECT column_name, column_type FROM information_schema.columns WHERE table_schema = DATABASE() AND table_name = tabla ORDER BY ordinal_position;
     DECLARE CONTINUE HANDLER FOR NOT FOUND SET finished = 1;
     OPEN cur;
     Bucle: LOOP
-        FETCH cur INTO nombre;
+        FETCH cur INTO nombre, tipo;
         IF finished THEN LEAVE Bucle; END IF;
-        SET valores = CONCAT(valores, '`', nombre, '` TEXT, ');
+        SET valores = CONCAT(valores, '`', nombre, '` ', tipo, ', ');
     END LOOP;
     CLOSE cur;
-    SET valores = CONCAT(valores, '`UsuarioAccion` TEXT, `FechaAccion` TEXT, `AccionSql` TEXT');
+    SET valores = CONCAT(valores, '`UsuarioAccion` TEXT, `FechaAccion` TEXT, `AccionSql` TEXT, `IdAuditoria` BIGINT AUTO_INCREMENT PRIMARY KEY');
     RETURN valores;
 END$$
 
@@ -0,0 +1,21 @@
+DELIMITER $$
+CREATE TABLE IF NOT EXISTS `{{ tabla_cambios }}` (`Secuencia` BIGINT AUTO_INCREMENT PRIMARY KEY, `IdAuditoria` BIGINT NOT NULL)$$
+
+DROP TRIGGER IF EXISTS insert_{{ tabla_auditoria }}_migracion$$
+CREATE TRIGGER insert_{{ tabla_auditoria }}_migracion AFTER INSERT ON `{{ tabla_auditoria }}` FOR EACH ROW
+BEGIN
+    INSERT INTO `{{ tabla_cambios }}` (`IdAuditoria`) VALUES (NEW.`IdAuditoria`);
+END$$
+
+DROP TRIGGER IF EXISTS update_{{ tabla_auditoria }}_migracion$$
+CREATE TRIGGER update_{{ tabla_auditoria }}_migracion AFTER UPDATE ON `{{ tabla_auditoria }}` FOR EACH ROW
+BEGIN
+    INSERT INTO `{{ tabla_cambios }}` (`IdAuditoria`) VALUES (NEW.`IdAuditoria`);
+END$$
+
+DROP TRIGGER IF EXISTS delete_{{ tabla_auditoria }}_migracion$$
+CREATE TRIGGER delete_{{ tabla_auditoria }}_migracion AFTER DELETE ON `{{ tabla_auditoria }}` FOR EACH ROW
+BEGIN
+    INSERT INTO `{{ tabla_cambios }}` (`IdAuditoria`) VALUES (OLD.`IdAuditoria`);
+END$$
+DELIMITER ;
@@ -0,0 +1,213 @@
+#include "Perfilador.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t NUM_CONTADORES = static_cast<std::size_t>(ContadorPerfil::Total);
+constexpr std::size_t MAX_EVENTOS_TRAZA = 1000000;
+constexpr const char* NOMBRES_CONTADORES[NUM_CONTADORES] = { "filas", "bytes", "idas_y_vueltas", "sentencias", "asignaciones" };
+
+struct AcumuladoFase {
+    std::uint64_t llamadas = 0;
+    std::int64_t ns = 0;
+    std::uint64_t contadores[NUM_CONTADORES] = {};
+};
+
+struct EventoTraza {
+    const char* fase;
+    std::int64_t inicio_ns;
+    std::int64_t duracion_ns;
+    std::uint32_t hilo;
+    std::uint64_t contadores[NUM_CONTADORES];
+};
+
+// Fases y eventos de un hilo. Solo su hilo escribe en ellos, asi que su mutex
+// no se disputa mientras se mide; finalizar los combina al generar el informe.
+struct DatosHilo {
+    std::mutex mutex;
+    std::unordered_map<const char*, AcumuladoFase> fases;
+    std::vector<EventoTraza> eventos;
+};
+
+struct EstadoPerfil {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<DatosHilo>> hilos;
+    std::string ruta_traza;
+    std::int64_t inicio_ns = 0;
+    std::atomic<std::uint64_t> totales[NUM_CONTADORES] = {};
+    std::atomic<std::uint64_t> eventos_registrados{ 0 };
+    std::atomic<std::uint32_t> siguiente_hilo{ 0 };
+};
+
+EstadoPerfil& estado() {
+    static EstadoPerfil* instancia = new EstadoPerfil();
+    return *instancia;
+}
+
+thread_local std::uint64_t contadores_hilo[NUM_CONTADORES] = {};
+thread_local std::uint32_t id_hilo = 0;
+thread_local bool id_asignado = false;
+thread_local std::shared_ptr<DatosHilo> datos_hilo;
+
+std::int64_t ahoraNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::uint32_t idHiloActual() {
+    if (!id_asignado) {
+        id_hilo = estado().siguiente_hilo.fetch_add(1, std::memory_order_relaxed) + 1;
+        id_asignado = true;
+    }
+    return id_hilo;
+}
+
+DatosHilo& datosHiloActual() {
+    if (!datos_hilo) {
+        auto datos = std::make_shared<DatosHilo>();
+        EstadoPerfil& e = estado();
+        std::lock_guard<std::mutex> bloqueo(e.mutex);
+        e.hilos.push_back(datos);
+        datos_hilo = std::move(datos);
+    }
+    return *datos_hilo;
+}
+
+void escribirTraza(EstadoPerfil& e, std::vector<EventoTraza>& eventos) {
+    std::FILE* archivo = std::fopen(e.ruta_traza.c_str(), "wb");
+    if (!archivo) {
+        std::cerr << "No se pudo escribir la traza en " << e.ruta_traza << std::endl;
+        return;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", archivo);
+    std::sort(eventos.begin(), eventos.end(), [](const EventoTraza& a, const EventoTraza& b) { return a.inicio_ns < b.inicio_ns; });
+    for (std::size_t i = 0; i < eventos.size(); ++i) {
+        const EventoTraza& evento = eventos[i];
+        std::fprintf(archivo, "%s{\"name\":\"%s\",\"cat\":\"shc134\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+            i == 0 ? "" : ",\n", evento.fase, evento.hilo,
+            (evento.inicio_ns - e.inicio_ns) / 1000.0, evento.duracion_ns / 1000.0);
+        for (std::size_t c = 0; c < NUM_CONTADORES; ++c) {
+            std::fprintf(archivo, "%s\"%s\":%llu", c == 0 ? "" : ",", NOMBRES_CONTADORES[c],
+                static_cast<unsigned long long>(evento.contadores[c]));
+        }
+        std::fputs("}}", archivo);
+    }
+    std::fputs("\n]}\n", archivo);
+    std::fclose(archivo);
+    std::cout << "Traza escrita en " << e.ruta_traza << " (" << eventos.size() << " eventos)." << std::endl;
+}
+
+}
+
+void Perfilador::activar(const std::string& ruta_traza) {
+    EstadoPerfil& e = estado();
+    e.ruta_traza = ruta_traza;
+    e.inicio_ns = ahoraNs();
+    habilitado.store(true, std::memory_order_relaxed);
+}
+
+void Perfilador::acumular(ContadorPerfil contador, std::uint64_t cantidad) {
+    const auto indice = static_cast<std::size_t>(contador);
+    contadores_hilo[indice] += cantidad;
+    estado().totales[indice].fetch_add(cantidad, std::memory_order_relaxed);
+}
+
+void Perfilador::finalizar() {
+    if (!activo()) return;
+    habilitado.store(false, std::memory_order_relaxed);
+
+    EstadoPerfil& e = estado();
+    std::lock_guard<std::mutex> bloqueo(e.mutex);
+    const double total_ms = (ahoraNs() - e.inicio_ns) / 1e6;
+
+    std::map<std::string, AcumuladoFase> por_nombre;
+    std::vector<EventoTraza> eventos;
+    for (const auto& hilo : e.hilos) {
+        std::lock_guard<std::mutex> bloqueo_hilo(hilo->mutex);
+        for (const auto& [nombre, acumulado] : hilo->fases) {
+            AcumuladoFase& destino = por_nombre[nombre];
+            destino.llamadas += acumulado.llamadas;
+            destino.ns += acumulado.ns;
+            for (std::size_t c = 0; c < NUM_CONTADORES; ++c) destino.contadores[c] += acumulado.contadores[c];
+        }
+        eventos.insert(eventos.end(), hilo->eventos.begin(), hilo->eventos.end());
+    }
+    std::vector<std::pair<std::string, AcumuladoFase>> fases(por_nombre.begin(), por_nombre.end());
+    std::sort(fases.begin(), fases.end(), [](const auto& a, const auto& b) { return a.second.ns > b.second.ns; });
+
+    std::cout << "\n--- Perfil de Ejecucion ---" << std::endl;
+    std::cout << "Tiempo total: " << std::fixed << std::setprecision(1) << total_ms << " ms\n" << std::endl;
+    std::cout << std::left << std::setw(36) << "Fase" << std::right
+              << std::setw(10) << "Llamadas" << std::setw(12) << "Total ms" << std::setw(8) << "%"
+              << std::setw(12) << "Filas" << std::setw(14) << "Bytes" << std::setw(10) << "Idas"
+              << std::setw(12) << "Sentencias" << std::setw(14) << "Asignaciones" << std::endl;
+    for (const auto& [nombre, fase] : fases) {
+        const double ms = fase.ns / 1e6;
+        std::cout << std::left << std::setw(36) << nombre << std::right
+                  << std::setw(10) << fase.llamadas
+                  << std::setw(12) << std::setprecision(1) << ms
+                  << std::setw(8) << (total_ms > 0 ? 100.0 * ms / total_ms : 0.0)
+                  << std::setw(12) << fase.contadores[0] << std::setw(14) << fase.contadores[1]
+                  << std::setw(10) << fase.contadores[2] << std::setw(12) << fase.contadores[3]
+                  << std::setw(14) << fase.contadores[4] << std::endl;
+    }
+    std::cout << "\nTotales:";
+    for (std::size_t c = 0; c < NUM_CONTADORES; ++c) {
+        std::cout << " " << NOMBRES_CONTADORES[c] << "=" << e.totales[c].load(std::memory_order_relaxed);
+    }
+    std::cout << std::endl;
+
+    if (!e.ruta_traza.empty()) escribirTraza(e, eventos);
+}
+
+void MedicionFase::iniciar(const char* nombre, bool registrar_en_traza) {
+    fase = nombre;
+    en_traza = registrar_en_traza;
+    std::copy(std::begin(contadores_hilo), std::end(contadores_hilo), std::begin(contadores_inicio));
+    inicio_ns = ahoraNs();
+}
+
+void MedicionFase::terminar() {
+    const std::int64_t duracion_ns = ahoraNs() - inicio_ns;
+    std::uint64_t delta[NUM_CONTADORES];
+    for (std::size_t c = 0; c < NUM_CONTADORES; ++c) delta[c] = contadores_hilo[c] - contadores_inicio[c];
+
+    EstadoPerfil& e = estado();
+    const std::uint32_t hilo = en_traza ? idHiloActual() : 0;
+    DatosHilo& datos = datosHiloActual();
+    std::lock_guard<std::mutex> bloqueo(datos.mutex);
+    AcumuladoFase& acumulado = datos.fases[fase];
+    ++acumulado.llamadas;
+    acumulado.ns += duracion_ns;
+    for (std::size_t c = 0; c < NUM_CONTADORES; ++c) acumulado.contadores[c] += delta[c];
+
+    if (en_traza && !e.ruta_traza.empty() && e.eventos_registrados.fetch_add(1, std::memory_order_relaxed) < MAX_EVENTOS_TRAZA) {
+        EventoTraza evento{ fase, inicio_ns, duracion_ns, hilo, {} };
+        std::copy(std::begin(delta), std::end(delta), std::begin(evento.contadores));
+        datos.eventos.push_back(evento);
+    }
+}
+
+void* operator new(std::size_t tamano) {
+    Perfilador::sumar(ContadorPerfil::Asignaciones);
+    if (void* memoria = std::malloc(tamano ? tamano : 1)) return memoria;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memoria) noexcept {
+    std::free(memoria);
+}
+
+void operator delete(void* memoria, std::size_t) noexcept {
+    std::free(memoria);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+enum class ContadorPerfil : std::size_t {
+    Filas,
+    Bytes,
+    IdasYVueltas,
+    Sentencias,
+    Asignaciones,
+    Total
+};
+
+class Perfilador {
+public:
+    static void activar(const std::string& ruta_traza);
+    static void finalizar();
+
+    static bool activo() { return habilitado.load(std::memory_order_relaxed); }
+    static void sumar(ContadorPerfil contador, std::uint64_t cantidad = 1) {
+        if (activo()) acumular(contador, cantidad);
+    }
+
+private:
+    static inline std::atomic<bool> habilitado{ false };
+    static void acumular(ContadorPerfil contador, std::uint64_t cantidad);
+};
+
+class MedicionFase {
+public:
+    explicit MedicionFase(const char* nombre, bool registrar_en_traza = true) {
+        if (Perfilador::activo()) iniciar(nombre, registrar_en_traza);
+    }
+    ~MedicionFase() {
+        if (fase) terminar();
+    }
+    MedicionFase(const MedicionFase&) = delete;
+    MedicionFase& operator=(const MedicionFase&) = delete;
+
+private:
+    const char* fase = nullptr;
+    bool en_traza = false;
+    std::int64_t inicio_ns = 0;
+    std::uint64_t contadores_inicio[static_cast<std::size_t>(ContadorPerfil::Total)] = {};
+
+    void iniciar(const char* nombre, bool registrar_en_traza);
+    void terminar();
+};
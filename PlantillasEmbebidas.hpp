@@ -0,0 +1,10 @@
+#pragma once
+#include <span>
+#include <string_view>
+
+struct PlantillaEmbebida {
+    std::string_view nombre;
+    std::string_view contenido;
+};
+
+std::span<const PlantillaEmbebida> obtenerPlantillasEmbebidas();
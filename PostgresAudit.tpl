@@ -1,6 +1,6 @@
 DROP TABLE IF EXISTS public.aud_{{ tabla }};
 CREATE TABLE public.aud_{{ tabla }} ({{ definicion_columnas }});
-ALTER TABLE public.aud_{{ tabla }} ADD COLUMN "UsuarioAccion" TEXT, ADD COLUMN "FechaAccion" TEXT, ADD COLUMN "AccionSql" TEXT;
+ALTER TABLE public.aud_{{ tabla }} ADD COLUMN "UsuarioAccion" TEXT, ADD COLUMN "FechaAccion" TEXT, ADD COLUMN "AccionSql" TEXT, ADD COLUMN "IdAuditoria" BIGSERIAL;
 CREATE OR REPLACE FUNCTION public.{{ tabla }}_aud() RETURNS TRIGGER AS $$ BEGIN IF TG_OP = 'INSERT' THEN INSERT INTO public.aud_{{ tabla }} SELECT NEW.*, SESSION_USER, NOW()::TEXT, 'Insertado';
 RETURN NEW; ELSIF TG_OP = 'UPDATE' THEN INSERT INTO public.aud_{{ tabla }} SELECT OLD.*, SESSION_USER, NOW()::TEXT, 'Modificado'; RETURN NEW;
 ELSIF TG_OP = 'DELETE' THEN INSERT INTO public.aud_{{ tabla }} SELECT OLD.*, SESSION_USER, NOW()::TEXT, 'Eliminado'; RETURN OLD; END IF;
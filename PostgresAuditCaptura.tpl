@@ -0,0 +1 @@
+CREATE TABLE IF NOT EXISTS public.aud_{{ tabla }} ({{ definicion_columnas }}, "IdAuditoria" BIGSERIAL);
\ No newline at end of file
@@ -5,23 +5,37 @@ DROP FUNCTION IF EXISTS public.{{ tabla }}_aud() CASCADE;
 DROP TRIGGER IF EXISTS {{ tabla }}_aud_cifrado_trigger ON public.{{ tabla }};
 DROP FUNCTION IF EXISTS public.{{ tabla }}_aud_cifrado() CASCADE;
 DROP FUNCTION IF EXISTS public.encrypt_val(TEXT) CASCADE;
+DROP FUNCTION IF EXISTS public.blind_idx(TEXT) CASCADE;
 
 CREATE OR REPLACE FUNCTION encrypt_val(data_to_encrypt TEXT)
-RETURNS TEXT AS $$
+{% if almacenamiento_binario %}RETURNS BYTEA AS $${% else %}RETURNS TEXT AS $${% endif %}
 DECLARE
     iv BYTEA := gen_random_bytes(16);
     encrypted_data BYTEA;
     key BYTEA := decode('{{ clave_hex }}', 'hex');
 BEGIN
     IF data_to_encrypt IS NULL OR data_to_encrypt = 'NULL' THEN
-        RETURN data_to_encrypt;
-    END IF;
+{% if almacenamiento_binario %}        RETURN NULL;
+{% else %}        RETURN data_to_encrypt;
+{% endif %}    END IF;
 
     encrypted_data := encrypt_iv(data_to_encrypt::bytea, key, iv, 'aes-cbc/pad:pkcs');
-    RETURN encode(iv || encrypted_data, 'hex');
-END;
+{% if almacenamiento_binario %}    RETURN iv || encrypted_data;
+{% else %}    RETURN encode(iv || encrypted_data, 'hex');
+{% endif %}END;
 $$ LANGUAGE plpgsql;
 
+CREATE OR REPLACE FUNCTION blind_idx(data_to_index TEXT)
+RETURNS TEXT AS $$
+BEGIN
+    IF data_to_index IS NULL OR data_to_index = 'NULL' THEN
+        RETURN NULL;
+    END IF;
+
+    RETURN encode(substring(hmac(convert_to(data_to_index, 'UTF8'), decode('{{ clave_indice_hex }}', 'hex'), 'sha256') FROM 1 FOR 16), 'hex');
+END;
+$$ LANGUAGE plpgsql IMMUTABLE;
+
 CREATE OR REPLACE FUNCTION public.{{ tabla }}_aud_cifrado()
 RETURNS TRIGGER AS $$
 BEGIN
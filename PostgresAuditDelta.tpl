@@ -0,0 +1,10 @@
+DROP TABLE IF EXISTS public.aud_{{ tabla }};
+CREATE TABLE public.aud_{{ tabla }} ("Clave" TEXT, "Cambios" TEXT, "UsuarioAccion" TEXT, "FechaAccion" TEXT, "AccionSql" TEXT, "IdAuditoria" BIGSERIAL);
+CREATE OR REPLACE FUNCTION public.{{ tabla }}_aud() RETURNS TRIGGER AS $$ BEGIN IF TG_OP = 'INSERT' THEN INSERT INTO public.aud_{{ tabla }} VALUES ({{ clave_nueva }}, {{ fila_nueva }}, SESSION_USER, NOW()::TEXT, 'Insertado');
+RETURN NEW; ELSIF TG_OP = 'UPDATE' AND ({{ clave_cambiada }}) THEN INSERT INTO public.aud_{{ tabla }} VALUES ({{ clave_vieja }}, {{ fila_vieja }}, SESSION_USER, NOW()::TEXT, 'Eliminado');
+INSERT INTO public.aud_{{ tabla }} VALUES ({{ clave_nueva }}, {{ fila_nueva }}, SESSION_USER, NOW()::TEXT, 'Insertado'); RETURN NEW;
+ELSIF TG_OP = 'UPDATE' THEN INSERT INTO public.aud_{{ tabla }} VALUES ({{ clave_vieja }}, {{ cambios }}, SESSION_USER, NOW()::TEXT, 'Modificado'); RETURN NEW;
+ELSIF TG_OP = 'DELETE' THEN INSERT INTO public.aud_{{ tabla }} VALUES ({{ clave_vieja }}, {{ fila_vieja }}, SESSION_USER, NOW()::TEXT, 'Eliminado'); RETURN OLD; END IF;
+RETURN NULL; END; $$ LANGUAGE plpgsql;
+DROP TRIGGER IF EXISTS {{ tabla }}_aud_trigger ON public.{{ tabla }};
+CREATE TRIGGER {{ tabla }}_aud_trigger AFTER INSERT OR UPDATE OR DELETE ON public.{{ tabla }} FOR EACH ROW EXECUTE PROCEDURE public.{{ tabla }}_aud();
\ No newline at end of file
@@ -0,0 +1,5 @@
+CREATE TABLE IF NOT EXISTS public."{{ tabla_cambios }}" ("Secuencia" BIGSERIAL PRIMARY KEY, "IdAuditoria" BIGINT NOT NULL);
+CREATE OR REPLACE FUNCTION public.{{ tabla_auditoria }}_migracion() RETURNS TRIGGER AS $$ BEGIN IF TG_OP = 'DELETE' THEN INSERT INTO public."{{ tabla_cambios }}" ("IdAuditoria") VALUES (OLD."IdAuditoria"); RETURN OLD; END IF;
+INSERT INTO public."{{ tabla_cambios }}" ("IdAuditoria") VALUES (NEW."IdAuditoria"); RETURN NEW; END; $$ LANGUAGE plpgsql;
+DROP TRIGGER IF EXISTS {{ tabla_auditoria }}_migracion_trigger ON public."{{ tabla_auditoria }}";
+CREATE TRIGGER {{ tabla_auditoria }}_migracion_trigger AFTER INSERT OR UPDATE OR DELETE ON public."{{ tabla_auditoria }}" FOR EACH ROW EXECUTE PROCEDURE public.{{ tabla_auditoria }}_migracion();
@@ -0,0 +1,462 @@
+#include "ServidorApi.hpp"
+#include <iostream>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/algorithm/string.hpp>
+
+#include "GestorCifrado.hpp"
+#include "GeneradorCodigo.hpp"
+#include "EscritorSalida.hpp"
+#include "Utils.hpp"
+
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+namespace asio = boost::asio;
+using tcp = boost::asio::ip::tcp;
+using json = nlohmann::json;
+
+namespace {
+
+constexpr std::size_t BYTES_TOKEN_ACCESO = 32;
+constexpr std::chrono::seconds TIEMPO_LECTURA{ 30 };
+constexpr std::chrono::seconds TIEMPO_ESCRITURA{ 300 };
+
+class ErrorPeticion : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+std::string tipoContenidoFormato(const std::string& formato) {
+    if (formato == "ndjson") return "application/x-ndjson";
+    if (formato == "csv") return "text/csv; charset=utf-8";
+    if (formato == "tsv") return "text/tab-separated-values; charset=utf-8";
+    return "text/plain; charset=utf-8";
+}
+
+std::string textoObligatorio(const json& parametros, const char* campo) {
+    if (!parametros.contains(campo) || !parametros[campo].is_string() || parametros[campo].get<std::string>().empty()) {
+        throw ErrorPeticion(std::string("El campo '") + campo + "' es obligatorio.");
+    }
+    return parametros[campo].get<std::string>();
+}
+
+std::string generarTokenAcceso() {
+    unsigned char bytes[BYTES_TOKEN_ACCESO];
+    if (!RAND_bytes(bytes, sizeof(bytes))) throw std::runtime_error("No se pudo generar el token de acceso del servidor.");
+    static constexpr char digitos[] = "0123456789abcdef";
+    std::string token;
+    for (unsigned char byte : bytes) {
+        token += digitos[byte >> 4];
+        token += digitos[byte & 0x0F];
+    }
+    return token;
+}
+
+// Solo se aceptan nombres de host locales, para que una pagina que resuelva su
+// dominio a 127.0.0.1 (DNS rebinding) no pueda usar la API.
+bool hostLocal(beast::string_view host) {
+    std::string nombre(host);
+    if (boost::starts_with(nombre, "[")) nombre = nombre.substr(0, nombre.find(']') + 1);
+    else nombre = nombre.substr(0, nombre.find(':'));
+    boost::to_lower(nombre);
+    return nombre == "localhost" || nombre == "127.0.0.1" || nombre == "[::1]";
+}
+
+bool parametroActivo(beast::string_view destino, const std::string& nombre) {
+    const std::size_t inicio = destino.find('?');
+    if (inicio == beast::string_view::npos) return false;
+    std::vector<std::string> pares;
+    std::string consulta(destino.substr(inicio + 1));
+    boost::split(pares, consulta, boost::is_any_of("&"));
+    for (const auto& par : pares) {
+        if (par == nombre || par == nombre + "=1" || par == nombre + "=true") return true;
+    }
+    return false;
+}
+
+}
+
+ServidorApi::ServidorApi(const ConfiguracionServidor& configuracion)
+    : configuracion(configuracion), token_acceso(generarTokenAcceso()) {
+    if (this->configuracion.num_trabajadores == 0) this->configuracion.num_trabajadores = 1;
+}
+
+std::shared_ptr<GestorAuditoria> ServidorApi::tomarConexion() {
+    std::unique_ptr<GestorAuditoria> conexion;
+    {
+        std::unique_lock<std::mutex> bloqueo(mutex_conexiones);
+        conexion_liberada.wait(bloqueo, [this] {
+            return !conexiones_libres.empty() || conexiones_abiertas < configuracion.num_trabajadores;
+        });
+        if (!conexiones_libres.empty()) {
+            conexion = std::move(conexiones_libres.back());
+            conexiones_libres.pop_back();
+        }
+        else {
+            ++conexiones_abiertas;
+        }
+    }
+
+    if (!conexion) {
+        try {
+            conexion = std::make_unique<GestorAuditoria>(configuracion.motor, configuracion.info_conexion, configuracion.db_name);
+        }
+        catch (...) {
+            devolverConexion(nullptr);
+            throw;
+        }
+        if (!conexion->estaConectado()) {
+            devolverConexion(nullptr);
+            throw std::runtime_error("No se pudo conectar a la base de datos.");
+        }
+    }
+    return std::shared_ptr<GestorAuditoria>(conexion.release(), [this](GestorAuditoria* c) { devolverConexion(c); });
+}
+
+void ServidorApi::devolverConexion(GestorAuditoria* conexion) {
+    std::unique_ptr<GestorAuditoria> propia(conexion);
+    {
+        std::lock_guard<std::mutex> bloqueo(mutex_conexiones);
+        if (propia && propia->estaConectado()) {
+            propia->setGestorCifrado(nullptr);
+            conexiones_libres.push_back(std::move(propia));
+        }
+        else {
+            --conexiones_abiertas;
+        }
+    }
+    conexion_liberada.notify_one();
+}
+
+std::shared_ptr<const Esquema> ServidorApi::obtenerEsquema(bool refrescar) {
+    std::lock_guard<std::mutex> bloqueo(mutex_esquema);
+    if (refrescar) esquema_cache.reset();
+    if (esquema_cache) return esquema_cache;
+
+    if (!gestor_esquema || !gestor_esquema->estaConectado()) {
+        gestor_esquema = std::make_unique<GestorBaseDatos>(configuracion.motor, configuracion.info_conexion, configuracion.db_name);
+        if (!gestor_esquema->estaConectado()) {
+            gestor_esquema.reset();
+            throw std::runtime_error("No se pudo conectar a la base de datos.");
+        }
+        gestor_esquema->establecerHilosEsquema(configuracion.num_trabajadores);
+    }
+    esquema_cache = std::make_shared<const Esquema>(gestor_esquema->obtenerEsquemaTablas());
+    return esquema_cache;
+}
+
+void ServidorApi::invalidarEsquema() {
+    std::lock_guard<std::mutex> bloqueo(mutex_esquema);
+    esquema_cache.reset();
+}
+
+void ServidorApi::ejecutar() {
+    asio::io_context contexto;
+    tcp::acceptor aceptador(contexto, tcp::endpoint(asio::ip::make_address(configuracion.direccion), configuracion.puerto));
+
+    std::vector<std::thread> trabajadores;
+    for (unsigned int i = 0; i < configuracion.num_trabajadores; ++i) {
+        trabajadores.emplace_back([this] { atenderClientes(); });
+    }
+
+    std::cout << "Servidor escuchando en http://" << configuracion.direccion << ":" << configuracion.puerto
+              << " con " << configuracion.num_trabajadores << " trabajadores." << std::endl;
+    std::cout << "Token de acceso (cabecera Authorization: Bearer <token>): " << token_acceso << std::endl;
+
+    for (;;) {
+        tcp::socket socket(contexto);
+        beast::error_code error;
+        aceptador.accept(socket, error);
+        if (error) {
+            std::cerr << "Error aceptando conexion: " << error.message() << std::endl;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> bloqueo(mutex_cola);
+            clientes_pendientes.push_back(std::move(socket));
+        }
+        cola_con_clientes.notify_one();
+    }
+}
+
+void ServidorApi::atenderClientes() {
+    for (;;) {
+        std::unique_lock<std::mutex> bloqueo(mutex_cola);
+        cola_con_clientes.wait(bloqueo, [this] { return !clientes_pendientes.empty(); });
+        tcp::socket socket = std::move(clientes_pendientes.front());
+        clientes_pendientes.pop_front();
+        bloqueo.unlock();
+
+        atenderCliente(socket);
+    }
+}
+
+// El socket pasa a un contexto propio del trabajador para leer y escribir con
+// plazo: un cliente que no envia la peticion completa no retiene al trabajador.
+void ServidorApi::atenderCliente(tcp::socket& socket) {
+    beast::error_code error;
+    const auto protocolo = socket.local_endpoint(error).protocol();
+    if (error) return;
+    asio::io_context contexto;
+    beast::tcp_stream flujo(contexto);
+    flujo.socket().assign(protocolo, socket.release(error), error);
+    if (error) return;
+
+    beast::flat_buffer buffer;
+    http::request_parser<http::string_body> lector;
+    lector.body_limit(16 * 1024 * 1024);
+    flujo.expires_after(TIEMPO_LECTURA);
+    http::async_read(flujo, buffer, lector, [&error](beast::error_code resultado, std::size_t) { error = resultado; });
+    contexto.run();
+    if (error) return;
+
+    Respuesta respuesta = despachar(lector.get());
+    respuesta.set(http::field::server, "SHC134DatabaseProjectManager");
+    respuesta.keep_alive(false);
+    respuesta.prepare_payload();
+    flujo.expires_after(TIEMPO_ESCRITURA);
+    http::async_write(flujo, respuesta, [&error](beast::error_code resultado, std::size_t) { error = resultado; });
+    contexto.restart();
+    contexto.run();
+    flujo.socket().shutdown(tcp::socket::shutdown_send, error);
+}
+
+// Rechaza hosts no locales, origenes distintos de la interfaz y peticiones sin
+// el token de esta ejecucion. Responde las cabeceras CORS solo al origen permitido.
+bool ServidorApi::peticionAutorizada(const Peticion& peticion, Respuesta& respuesta) const {
+    if (!hostLocal(peticion[http::field::host])) {
+        respuesta.result(http::status::forbidden);
+        respuesta.body() = json{{"error", "Host no permitido."}}.dump();
+        return false;
+    }
+
+    const beast::string_view origen = peticion[http::field::origin];
+    if (!origen.empty()) {
+        if (configuracion.origen_permitido.empty() || origen != configuracion.origen_permitido) {
+            respuesta.result(http::status::forbidden);
+            respuesta.body() = json{{"error", "Origen no permitido."}}.dump();
+            return false;
+        }
+        respuesta.set(http::field::access_control_allow_origin, configuracion.origen_permitido);
+        respuesta.set(http::field::vary, "Origin");
+    }
+    if (peticion.method() == http::verb::options) return true;
+
+    const std::string autorizacion(peticion[http::field::authorization]);
+    const std::string prefijo = "Bearer ";
+    const bool valido = autorizacion.size() == prefijo.size() + token_acceso.size() &&
+        boost::starts_with(autorizacion, prefijo) &&
+        CRYPTO_memcmp(autorizacion.data() + prefijo.size(), token_acceso.data(), token_acceso.size()) == 0;
+    if (!valido) {
+        respuesta.result(http::status::unauthorized);
+        respuesta.set(http::field::www_authenticate, "Bearer");
+        respuesta.body() = json{{"error", "Token de acceso ausente o no valido."}}.dump();
+        return false;
+    }
+
+    if (peticion.method() == http::verb::post) {
+        const std::string tipo = boost::to_lower_copy(std::string(peticion[http::field::content_type]));
+        if (tipo != "application/json" && !boost::starts_with(tipo, "application/json;")) {
+            respuesta.result(http::status::unsupported_media_type);
+            respuesta.body() = json{{"error", "Las peticiones POST deben enviar Content-Type: application/json."}}.dump();
+            return false;
+        }
+    }
+    return true;
+}
+
+ServidorApi::Respuesta ServidorApi::despachar(const Peticion& peticion) {
+    Respuesta respuesta{http::status::ok, peticion.version()};
+    respuesta.set(http::field::content_type, "application/json");
+
+    const beast::string_view destino = peticion.target();
+    const std::string ruta(destino.substr(0, destino.find('?')));
+
+    try {
+        if (!peticionAutorizada(peticion, respuesta)) return respuesta;
+        if (peticion.method() == http::verb::options) {
+            respuesta.result(http::status::no_content);
+            respuesta.set(http::field::access_control_allow_methods, "GET, POST, OPTIONS");
+            respuesta.set(http::field::access_control_allow_headers, "Content-Type, Authorization");
+            return respuesta;
+        }
+
+        if (peticion.method() == http::verb::get) {
+            if (ruta == "/api/salud") {
+                respuesta.body() = json{{"estado", "ok"}, {"motor", configuracion.motor_texto}}.dump();
+                return respuesta;
+            }
+            if (ruta == "/api/esquema") {
+                respuesta.body() = describirEsquema(parametroActivo(destino, "refrescar")).dump();
+                return respuesta;
+            }
+        }
+
+        if (peticion.method() == http::verb::post) {
+            json parametros = json::object();
+            if (!peticion.body().empty()) {
+                parametros = json::parse(peticion.body(), nullptr, false);
+                if (parametros.is_discarded() || !parametros.is_object()) throw ErrorPeticion("El cuerpo de la peticion debe ser un objeto JSON.");
+            }
+
+            if (ruta == "/api/sql") {
+                std::string tipo_contenido;
+                respuesta.body() = ejecutarSql(parametros, tipo_contenido);
+                respuesta.set(http::field::content_type, tipo_contenido);
+                return respuesta;
+            }
+            if (ruta == "/api/auditoria") {
+                respuesta.body() = ejecutarAuditoria(parametros).dump();
+                return respuesta;
+            }
+            if (ruta == "/api/encriptado") {
+                respuesta.body() = ejecutarEncriptado(parametros).dump();
+                return respuesta;
+            }
+            if (ruta == "/api/scaffolding") {
+                respuesta.body() = ejecutarScaffolding(parametros).dump();
+                return respuesta;
+            }
+        }
+
+        respuesta.result(http::status::not_found);
+        respuesta.body() = json{{"error", "Ruta no encontrada: " + ruta}}.dump();
+    }
+    catch (const ErrorPeticion& e) {
+        respuesta.result(http::status::bad_request);
+        respuesta.set(http::field::content_type, "application/json");
+        respuesta.body() = json{{"error", e.what()}}.dump();
+    }
+    catch (const std::exception& e) {
+        respuesta.result(http::status::internal_server_error);
+        respuesta.set(http::field::content_type, "application/json");
+        respuesta.body() = json{{"error", e.what()}}.dump();
+    }
+    return respuesta;
+}
+
+// Con "tabla" en lugar de "query" la consulta se arma sobre una tabla de
+// auditoria cifrada, como sql --tabla: "columnas" y "filtros" usan nombres en
+// claro y las igualdades sobre columnas de "indice_ciego" van por el indice.
+std::string ServidorApi::ejecutarSql(const json& parametros, std::string& tipo_contenido) {
+    const bool consulta_descifrada = !parametros.contains("query") && parametros.contains("tabla");
+    const std::string formato = boost::to_lower_copy(parametros.value("formato", std::string("ndjson")));
+    if (formato == "binario") throw ErrorPeticion("El formato binario solo esta disponible en la linea de comandos.");
+    if (consulta_descifrada && !parametros.contains("key")) throw ErrorPeticion("Una consulta por 'tabla' requiere 'key'.");
+    if (!consulta_descifrada && parametros.contains("indice_ciego")) {
+        throw ErrorPeticion("'indice_ciego' solo se aplica a los 'filtros' de una consulta por 'tabla'.");
+    }
+
+    auto conexion = tomarConexion();
+    std::unique_ptr<GestorCifrado> gestor_cifrado;
+    if (parametros.contains("key")) {
+        gestor_cifrado = std::make_unique<GestorCifrado>(conexion, textoObligatorio(parametros, "key"));
+        if (parametros.contains("indice_ciego")) gestor_cifrado->setColumnasIndiceCiego(textoObligatorio(parametros, "indice_ciego"));
+    }
+
+    std::string cuerpo;
+    auto escritor = crearEscritorEnMemoria(formato, cuerpo);
+    if (consulta_descifrada) {
+        std::vector<std::string> columnas;
+        if (parametros.contains("columnas")) {
+            boost::split(columnas, textoObligatorio(parametros, "columnas"), boost::is_any_of(","));
+            for (auto& columna : columnas) boost::trim(columna);
+            columnas.erase(std::remove(columnas.begin(), columnas.end(), std::string()), columnas.end());
+        }
+        std::vector<GestorCifrado::FiltroDescifrado> filtros;
+        for (const auto& filtro : parametros.value("filtros", json::array())) {
+            if (!filtro.is_string()) throw ErrorPeticion("Cada elemento de 'filtros' debe ser un texto columna<op>valor.");
+            filtros.push_back(GestorCifrado::interpretarFiltro(filtro.get<std::string>()));
+        }
+        volcarConsultaDescifrada(*conexion, *gestor_cifrado, textoObligatorio(parametros, "tabla"), columnas, filtros, *escritor);
+    }
+    else {
+        volcarConsulta(*conexion, textoObligatorio(parametros, "query"), *escritor, gestor_cifrado.get());
+    }
+    tipo_contenido = tipoContenidoFormato(formato);
+    return cuerpo;
+}
+
+json ServidorApi::ejecutarAuditoria(const json& parametros) {
+    auto conexion = tomarConexion();
+    conexion->setModoAuditoria(GestorAuditoria::interpretarModoAuditoria(parametros.value("modo", std::string("completo"))));
+    if (configuracion.motor == GestorAuditoria::MotorDB::SQLite && parametros.contains("key")) {
+        conexion->setGestorCifrado(std::make_shared<GestorCifrado>(conexion, textoObligatorio(parametros, "key")));
+    }
+
+    std::vector<std::string> tablas = parametros.contains("tabla") ?
+        std::vector<std::string>{textoObligatorio(parametros, "tabla")} :
+        conexion->obtenerNombresDeTablas(false);
+
+    for (const auto& tabla : tablas) {
+        conexion->generarAuditoriaParaTabla(tabla);
+    }
+    invalidarEsquema();
+    return json{{"tablas", tablas}};
+}
+
+json ServidorApi::ejecutarEncriptado(const json& parametros) {
+    auto conexion = tomarConexion();
+    GestorCifrado gestor_cifrado(conexion, textoObligatorio(parametros, "key"));
+    gestor_cifrado.setFormatoCifrado(GestorCifrado::interpretarFormatoCifrado(parametros.value("cifrado", std::string("cbc"))));
+    if (parametros.contains("indice_ciego")) {
+        gestor_cifrado.setColumnasIndiceCiego(textoObligatorio(parametros, "indice_ciego"));
+    }
+    gestor_cifrado.setAlmacenamiento(GestorCifrado::interpretarAlmacenamiento(parametros.value("almacenamiento", std::string("hex"))));
+    if (parametros.contains("comprimir")) {
+        gestor_cifrado.setColumnasComprimidas(textoObligatorio(parametros, "comprimir"), parametros.value("compresion_minima", std::size_t{256}));
+    }
+    gestor_cifrado.setMigracionEnLinea(parametros.value("en_linea", false));
+    gestor_cifrado.cifrarTablasDeAuditoria();
+    invalidarEsquema();
+    return json{{"estado", "ok"}};
+}
+
+json ServidorApi::ejecutarScaffolding(const json& parametros) {
+    const std::string jwt_secret = textoObligatorio(parametros, "jwt-secret");
+    namespace fs = std::filesystem;
+    const fs::path relativo = fs::path(parametros.contains("out") ? textoObligatorio(parametros, "out") : "api-generada-nest").lexically_normal();
+    if (relativo.empty() || relativo.has_root_path() || *relativo.begin() == "..") {
+        throw ErrorPeticion("'out' debe ser una ruta relativa dentro del directorio base del servidor.");
+    }
+    const fs::path base = fs::weakly_canonical(fs::absolute(configuracion.directorio_base));
+    const fs::path destino = fs::weakly_canonical(base / relativo);
+    const auto [fin_base, fin_destino] = std::mismatch(base.begin(), base.end(), destino.begin(), destino.end());
+    if (fin_base != base.end()) throw ErrorPeticion("'out' sale del directorio base del servidor.");
+    const std::string dir_salida = destino.string();
+
+    std::shared_ptr<const Esquema> esquema = obtenerEsquema(false);
+    if (esquema->tablas.empty()) throw std::runtime_error("No se encontraron tablas.");
+
+    GeneradorCodigo generador(dir_salida);
+    generador.generarProyectoCompleto(*esquema, configuracion.motor_texto, configuracion.host, configuracion.puerto_db,
+        configuracion.usuario, configuracion.contrasena, configuracion.db_name, jwt_secret);
+
+    json recursos = json::array();
+    for (const auto& tabla : esquema->tablas) {
+        recursos.push_back({{"clase", esquema->nombres.pascal(tabla.nombre)}, {"ruta", "/" + std::string(esquema->nombres.kebab(tabla.nombre))}, {"protegida", tabla.es_protegida}});
+    }
+    return json{{"directorio", dir_salida}, {"recursos", recursos}};
+}
+
+json ServidorApi::describirEsquema(bool refrescar) {
+    json tablas = json::array();
+    std::shared_ptr<const Esquema> esquema = obtenerEsquema(refrescar);
+    const InternadorNombres& nombres = esquema->nombres;
+    for (const auto& tabla : esquema->tablas) {
+        json columnas = json::array();
+        for (const auto& columna : tabla.columnas) {
+            columnas.push_back({{"nombre", nombres.original(columna.nombre)}, {"tipo", columna.tipo_db}, {"pk", columna.es_pk}, {"fk", columna.es_fk}, {"nulo", columna.es_nulo}});
+        }
+        tablas.push_back({{"nombre", nombres.original(tabla.nombre)}, {"clase", nombres.pascal(tabla.nombre)}, {"columnas", columnas}});
+    }
+    return json{{"tablas", tablas}};
+}
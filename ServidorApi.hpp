@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/http.hpp>
+#include <nlohmann/json.hpp>
+#include "GestorAuditoria.hpp"
+#include "GestorBaseDatos.hpp"
+#include "Modelos.hpp"
+
+struct ConfiguracionServidor {
+    GestorAuditoria::MotorDB motor;
+    std::string info_conexion;
+    std::string motor_texto;
+    std::string host;
+    std::string puerto_db;
+    std::string usuario;
+    std::string contrasena;
+    std::string db_name;
+    std::string direccion = "127.0.0.1";
+    unsigned short puerto = 9543;
+    unsigned int num_trabajadores = 4;
+    // Unico origen al que se responden las cabeceras CORS (la interfaz Node).
+    std::string origen_permitido = "http://localhost:9542";
+    // Directorio bajo el que /api/scaffolding puede escribir.
+    std::string directorio_base = ".";
+};
+
+class ServidorApi {
+public:
+    explicit ServidorApi(const ConfiguracionServidor& configuracion);
+    void ejecutar();
+
+private:
+    using Peticion = boost::beast::http::request<boost::beast::http::string_body>;
+    using Respuesta = boost::beast::http::response<boost::beast::http::string_body>;
+
+    ConfiguracionServidor configuracion;
+    std::string token_acceso;
+
+    std::mutex mutex_conexiones;
+    std::condition_variable conexion_liberada;
+    std::vector<std::unique_ptr<GestorAuditoria>> conexiones_libres;
+    unsigned int conexiones_abiertas = 0;
+
+    std::mutex mutex_esquema;
+    std::unique_ptr<GestorBaseDatos> gestor_esquema;
+    std::shared_ptr<const Esquema> esquema_cache;
+
+    std::mutex mutex_cola;
+    std::condition_variable cola_con_clientes;
+    std::deque<boost::asio::ip::tcp::socket> clientes_pendientes;
+
+    std::shared_ptr<GestorAuditoria> tomarConexion();
+    void devolverConexion(GestorAuditoria* conexion);
+    std::shared_ptr<const Esquema> obtenerEsquema(bool refrescar);
+    void invalidarEsquema();
+
+    void atenderClientes();
+    void atenderCliente(boost::asio::ip::tcp::socket& socket);
+    Respuesta despachar(const Peticion& peticion);
+    bool peticionAutorizada(const Peticion& peticion, Respuesta& respuesta) const;
+
+    std::string ejecutarSql(const nlohmann::json& parametros, std::string& tipo_contenido);
+    nlohmann::json ejecutarAuditoria(const nlohmann::json& parametros);
+    nlohmann::json ejecutarEncriptado(const nlohmann::json& parametros);
+    nlohmann::json ejecutarScaffolding(const nlohmann::json& parametros);
+    nlohmann::json describirEsquema(bool refrescar);
+};
@@ -1,3 +1,21 @@
+{% if indice_ciego %}IF OBJECT_ID('dbo.blind_idx', 'FN') IS NOT NULL
+    DROP FUNCTION dbo.blind_idx;
+GO
+
+CREATE FUNCTION dbo.blind_idx(@valor NVARCHAR(MAX))
+RETURNS CHAR(32)
+AS
+BEGIN
+    IF @valor IS NULL OR @valor = N'NULL'
+        RETURN NULL;
+    RETURN LOWER(CONVERT(CHAR(32), SUBSTRING(HASHBYTES('SHA2_256', 0x{{ clave_indice_opad }} + HASHBYTES('SHA2_256', 0x{{ clave_indice_ipad }} + CAST(CAST(@valor COLLATE Latin1_General_100_CI_AS_SC_UTF8 AS VARCHAR(MAX)) AS VARBINARY(MAX)))), 1, 16), 2));
+END;
+GO
+{% endif %}
+IF OBJECT_ID('Trg{{ tabla }}Aud', 'TR') IS NOT NULL
+    DROP TRIGGER Trg{{ tabla }}Aud;
+GO
+
 IF OBJECT_ID('Trg{{ tabla }}AudCifrado', 'TR') IS NOT NULL
     DROP TRIGGER Trg{{ tabla }}AudCifrado;
 GO
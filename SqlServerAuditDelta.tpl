@@ -0,0 +1,32 @@
+IF OBJECT_ID(N'dbo.Trg{{ tabla }}Aud', N'TR') IS NOT NULL
+    DROP TRIGGER dbo.Trg{{ tabla }}Aud;
+IF OBJECT_ID(N'dbo.aud_{{ tabla }}', N'U') IS NOT NULL
+    DROP TABLE dbo.aud_{{ tabla }};
+CREATE TABLE dbo.aud_{{ tabla }} ([Clave] NVARCHAR(MAX), [Cambios] NVARCHAR(MAX), [UsuarioAccion] NVARCHAR(MAX), [FechaAccion] NVARCHAR(MAX), [AccionSql] NVARCHAR(MAX), [IdAuditoria] BIGINT IDENTITY(1,1) NOT NULL);
+GO
+
+CREATE TRIGGER dbo.Trg{{ tabla }}Aud ON dbo.{{ tabla }}
+AFTER INSERT, UPDATE, DELETE AS
+BEGIN
+    SET NOCOUNT ON;
+    IF EXISTS(SELECT 1 FROM inserted) AND NOT EXISTS(SELECT 1 FROM deleted)
+    BEGIN
+        INSERT INTO dbo.aud_{{ tabla }} ([Clave], [Cambios], [UsuarioAccion], [FechaAccion], [AccionSql])
+        SELECT {{ clave_nueva }}, {{ fila_nueva }}, SUSER_SNAME(), GETDATE(), N'Insertado' FROM inserted i;
+    END
+    ELSE IF EXISTS(SELECT 1 FROM inserted) AND EXISTS(SELECT 1 FROM deleted)
+    BEGIN
+        INSERT INTO dbo.aud_{{ tabla }} ([Clave], [Cambios], [UsuarioAccion], [FechaAccion], [AccionSql])
+        SELECT {{ clave_vieja }}, {{ cambios }}, SUSER_SNAME(), GETDATE(), N'Modificado' FROM deleted d INNER JOIN inserted i ON {{ union_clave }};
+        INSERT INTO dbo.aud_{{ tabla }} ([Clave], [Cambios], [UsuarioAccion], [FechaAccion], [AccionSql])
+        SELECT {{ clave_vieja }}, {{ fila_vieja }}, SUSER_SNAME(), GETDATE(), N'Eliminado' FROM deleted d WHERE NOT EXISTS(SELECT 1 FROM inserted i WHERE {{ union_clave }});
+        INSERT INTO dbo.aud_{{ tabla }} ([Clave], [Cambios], [UsuarioAccion], [FechaAccion], [AccionSql])
+        SELECT {{ clave_nueva }}, {{ fila_nueva }}, SUSER_SNAME(), GETDATE(), N'Insertado' FROM inserted i WHERE NOT EXISTS(SELECT 1 FROM deleted d WHERE {{ union_clave }});
+    END
+    ELSE IF EXISTS(SELECT 1 FROM deleted)
+    BEGIN
+        INSERT INTO dbo.aud_{{ tabla }} ([Clave], [Cambios], [UsuarioAccion], [FechaAccion], [AccionSql])
+        SELECT {{ clave_vieja }}, {{ fila_vieja }}, SUSER_SNAME(), GETDATE(), N'Eliminado' FROM deleted d;
+    END;
+END;
+GO
\ No newline at end of file
@@ -7,25 +7,34 @@ RETURNS NVARCHAR(MAX) AS
 BEGIN
     DECLARE @valores NVARCHAR(MAX) = N'';
     DECLARE @col_name NVARCHAR(128);
+    DECLARE @col_type NVARCHAR(200);
 
     DECLARE cur CURSOR FOR
-        SELECT name
-        FROM sys.columns
-        WHERE object_id = OBJECT_ID(@tabla)
-        ORDER BY column_id;
+        SELECT c.name,
+            CASE
+                WHEN t.name IN (N'varchar', N'char') THEN t.name + N'(' + CASE WHEN c.max_length = -1 THEN N'MAX' ELSE CAST(c.max_length AS NVARCHAR(10)) END + N')'
+                WHEN t.name IN (N'nvarchar', N'nchar') THEN t.name + N'(' + CASE WHEN c.max_length = -1 THEN N'MAX' ELSE CAST(c.max_length / 2 AS NVARCHAR(10)) END + N')'
+                WHEN t.name IN (N'decimal', N'numeric') THEN t.name + N'(' + CAST(c.precision AS NVARCHAR(10)) + N',' + CAST(c.scale AS NVARCHAR(10)) + N')'
+                WHEN t.name IN (N'int', N'bigint', N'smallint', N'tinyint', N'bit', N'float', N'real', N'money', N'smallmoney',
+                                N'date', N'datetime', N'datetime2', N'smalldatetime', N'datetimeoffset', N'time', N'uniqueidentifier') THEN t.name
+                ELSE N'VARCHAR(MAX)'
+            END
+        FROM sys.columns c JOIN sys.types t ON c.user_type_id = t.user_type_id
+        WHERE c.object_id = OBJECT_ID(@tabla)
+        ORDER BY c.column_id;
 
     OPEN cur;
-    FETCH NEXT FROM cur INTO @col_name;
+    FETCH NEXT FROM cur INTO @col_name, @col_type;
 
     WHILE (@@FETCH_STATUS = 0)
     BEGIN
-        SET @valores = @valores + QUOTENAME(@col_name) + N' VARCHAR(MAX), ';
-        FETCH NEXT FROM cur INTO @col_name;
+        SET @valores = @valores + QUOTENAME(@col_name) + N' ' + @col_type + N', ';
+        FETCH NEXT FROM cur INTO @col_name, @col_type;
     END;
     CLOSE cur;
     DEALLOCATE cur;
 
-    SET @valores = @valores + N'[UsuarioAccion] NVARCHAR(MAX), [FechaAccion] NVARCHAR(MAX), [AccionSql] NVARCHAR(MAX)';
+    SET @valores = @valores + N'[UsuarioAccion] NVARCHAR(MAX), [FechaAccion] NVARCHAR(MAX), [AccionSql] NVARCHAR(MAX), [IdAuditoria] BIGINT IDENTITY(1,1) NOT NULL';
     RETURN @valores;
 END;
 GO
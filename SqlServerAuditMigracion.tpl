@@ -0,0 +1,14 @@
+IF OBJECT_ID(N'dbo.{{ tabla_cambios }}', N'U') IS NULL
+    CREATE TABLE dbo.[{{ tabla_cambios }}] ([Secuencia] BIGINT IDENTITY(1,1) PRIMARY KEY, [IdAuditoria] BIGINT NOT NULL);
+IF OBJECT_ID(N'dbo.Trg{{ tabla_auditoria }}Migracion', N'TR') IS NOT NULL
+    DROP TRIGGER dbo.Trg{{ tabla_auditoria }}Migracion;
+GO
+
+CREATE TRIGGER dbo.Trg{{ tabla_auditoria }}Migracion ON dbo.[{{ tabla_auditoria }}]
+AFTER INSERT, UPDATE, DELETE AS
+BEGIN
+    SET NOCOUNT ON;
+    INSERT INTO dbo.[{{ tabla_cambios }}] ([IdAuditoria])
+    SELECT [IdAuditoria] FROM inserted UNION SELECT [IdAuditoria] FROM deleted;
+END;
+GO
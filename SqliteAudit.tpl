@@ -1,11 +1,11 @@
 DROP TABLE IF EXISTS aud_{{ tabla }};
-CREATE TABLE aud_{{ tabla }} ({{ definicion_columnas }}, UsuarioAccion TEXT, FechaAccion TEXT, AccionSql TEXT);
+CREATE TABLE aud_{{ tabla }} ({{ definicion_columnas }}, UsuarioAccion TEXT, FechaAccion TEXT, AccionSql TEXT, IdAuditoria INTEGER PRIMARY KEY AUTOINCREMENT);
 DROP TRIGGER IF EXISTS {{ tabla }}_aud_insert;
-CREATE TRIGGER {{ tabla }}_aud_insert AFTER INSERT ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ lista_columnas_new }}, 'SYSTEM', datetime('now'), 'Insertado');
+CREATE TRIGGER {{ tabla }}_aud_insert AFTER INSERT ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ lista_columnas_new }}, 'SYSTEM', datetime('now'), 'Insertado', NULL);
 END;
 DROP TRIGGER IF EXISTS {{ tabla }}_aud_update;
-CREATE TRIGGER {{ tabla }}_aud_update AFTER UPDATE ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ lista_columnas_old }}, 'SYSTEM', datetime('now'), 'Modificado');
+CREATE TRIGGER {{ tabla }}_aud_update AFTER UPDATE ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ lista_columnas_old }}, 'SYSTEM', datetime('now'), 'Modificado', NULL);
 END;
 DROP TRIGGER IF EXISTS {{ tabla }}_aud_delete;
-CREATE TRIGGER {{ tabla }}_aud_delete AFTER DELETE ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ lista_columnas_old }}, 'SYSTEM', datetime('now'), 'Eliminado');
+CREATE TRIGGER {{ tabla }}_aud_delete AFTER DELETE ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ lista_columnas_old }}, 'SYSTEM', datetime('now'), 'Eliminado', NULL);
 END;
\ No newline at end of file
@@ -0,0 +1,15 @@
+DROP TABLE IF EXISTS aud_{{ tabla }};
+CREATE TABLE aud_{{ tabla }} (Clave TEXT, Cambios TEXT, UsuarioAccion TEXT, FechaAccion TEXT, AccionSql TEXT, IdAuditoria INTEGER PRIMARY KEY AUTOINCREMENT);
+DROP TRIGGER IF EXISTS {{ tabla }}_aud_insert;
+CREATE TRIGGER {{ tabla }}_aud_insert AFTER INSERT ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ clave_nueva }}, {{ fila_nueva }}, 'SYSTEM', datetime('now'), 'Insertado', NULL);
+END;
+DROP TRIGGER IF EXISTS {{ tabla }}_aud_update;
+CREATE TRIGGER {{ tabla }}_aud_update AFTER UPDATE ON {{ tabla }} FOR EACH ROW WHEN NOT ({{ clave_cambiada }}) BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ clave_vieja }}, {{ cambios }}, 'SYSTEM', datetime('now'), 'Modificado', NULL);
+END;
+DROP TRIGGER IF EXISTS {{ tabla }}_aud_update_clave;
+CREATE TRIGGER {{ tabla }}_aud_update_clave AFTER UPDATE ON {{ tabla }} FOR EACH ROW WHEN {{ clave_cambiada }} BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ clave_vieja }}, {{ fila_vieja }}, 'SYSTEM', datetime('now'), 'Eliminado', NULL);
+INSERT INTO aud_{{ tabla }} VALUES({{ clave_nueva }}, {{ fila_nueva }}, 'SYSTEM', datetime('now'), 'Insertado', NULL);
+END;
+DROP TRIGGER IF EXISTS {{ tabla }}_aud_delete;
+CREATE TRIGGER {{ tabla }}_aud_delete AFTER DELETE ON {{ tabla }} FOR EACH ROW BEGIN INSERT INTO aud_{{ tabla }} VALUES({{ clave_vieja }}, {{ fila_vieja }}, 'SYSTEM', datetime('now'), 'Eliminado', NULL);
+END;
\ No newline at end of file
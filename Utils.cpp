@@ -1,4 +1,6 @@
 #include "Utils.hpp"
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <cstdlib>
 #include <fstream>
@@ -7,42 +9,143 @@
 #include "GestorBaseDatos.hpp"
 #include "GeneradorCodigo.hpp"
 #include "GestorCifrado.hpp"
+#include "GestorExportacion.hpp"
+#include "DialectoSql.hpp"
+#include "ServidorApi.hpp"
+#include "EjecutorAsincrono.hpp"
+#include "GestorCapturaLogica.hpp"
+#include "GestorRotacionClave.hpp"
 
-std::string aPascalCase(const std::string& entrada) {
-    std::string resultado;
+long filasPorBloqueParaConsulta(GestorAuditoria& gestor_db, const std::string& consulta) {
+    if (gestor_db.getMotor() == GestorAuditoria::MotorDB::PostgreSQL) return 1;
+    std::string inicio = boost::to_upper_copy(boost::trim_copy(consulta).substr(0, 6));
+    if (inicio != "SELECT" || consulta.find(';') != std::string::npos) return 1;
+    try {
+        std::string muestra = despacharDialecto(gestor_db.getMotor(), [&](auto dialecto) {
+            return decltype(dialecto)::paginar("SELECT * FROM (" + consulta + ") muestra", 0);
+            });
+        return gestor_db.admiteLecturaPorBloques(muestra) ? 1024 : 1;
+    }
+    catch (const std::exception&) {
+        return 1;
+    }
+}
+
+size_t volcarConsulta(GestorAuditoria& gestor_db, const std::string& consulta, EscritorSalida& escritor, const GestorCifrado* gestor_cifrado) {
+    size_t filas = 0;
+    gestor_db.procesarConsultaPorFilas(consulta,
+        [&](const std::vector<std::string>& columnas) {
+            if (!gestor_cifrado) {
+                escritor.escribirEncabezado(columnas);
+                return;
+            }
+            std::vector<std::string> columnas_descifradas;
+            columnas_descifradas.reserve(columnas.size());
+            for (const auto& columna : columnas) columnas_descifradas.push_back(gestor_cifrado->descifrarNombreColumna(columna));
+            escritor.escribirEncabezado(columnas_descifradas);
+        },
+        [&](std::vector<ValorCelda>& fila) {
+            if (gestor_cifrado) gestor_cifrado->descifrarCeldas(fila);
+            escritor.escribirFila(fila);
+            ++filas;
+        },
+        filasPorBloqueParaConsulta(gestor_db, consulta));
+    escritor.finalizar();
+    return filas;
+}
+
+namespace {
+
+bool esSeparador(char c) {
+    return c == '_' || c == '-';
+}
+
+char aMayuscula(char c) {
+    return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+}
+
+char aMinuscula(char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+bool esMayuscula(char c) {
+    return std::isupper(static_cast<unsigned char>(c)) != 0;
+}
+
+}
+
+std::size_t longitudPascalCase(std::string_view entrada) {
+    return static_cast<std::size_t>(std::count_if(entrada.begin(), entrada.end(), [](char c) { return !esSeparador(c); }));
+}
+
+std::size_t separadoresKebabCase(std::string_view entrada) {
+    std::size_t separadores = 0;
+    std::size_t posicion = 0;
+    bool capitalizar_siguiente = true;
+    for (char c : entrada) {
+        if (esSeparador(c)) {
+            capitalizar_siguiente = true;
+            continue;
+        }
+        const char salida = capitalizar_siguiente ? aMayuscula(c) : c;
+        capitalizar_siguiente = false;
+        if (posicion++ > 0 && esMayuscula(salida)) ++separadores;
+    }
+    return separadores;
+}
+
+void anexarPascalCase(std::string_view entrada, std::string& destino) {
     bool capitalizar_siguiente = true;
     for (char c : entrada) {
-        if (c == '_' || c == '-') {
+        if (esSeparador(c)) {
             capitalizar_siguiente = true;
         }
         else if (capitalizar_siguiente) {
-            resultado += std::toupper(c);
+            destino += aMayuscula(c);
             capitalizar_siguiente = false;
         }
         else {
-            resultado += c;
+            destino += c;
         }
     }
-    return resultado;
 }
 
-std::string aCamelCase(const std::string& entrada) {
-    std::string pascal = aPascalCase(entrada);
-    if (!pascal.empty()) {
-        pascal[0] = std::tolower(pascal[0]);
+void anexarCamelCase(std::string_view entrada, std::string& destino) {
+    const std::size_t inicio = destino.size();
+    anexarPascalCase(entrada, destino);
+    if (destino.size() > inicio) {
+        destino[inicio] = aMinuscula(destino[inicio]);
     }
-    return pascal;
 }
 
-std::string aKebabCase(const std::string& entrada_pascal_case) {
-    std::string resultado;
-    for (size_t i = 0; i < entrada_pascal_case.length(); ++i) {
-        char c = entrada_pascal_case[i];
-        if (i > 0 && std::isupper(c)) {
-            resultado += '-';
+void anexarKebabCase(std::string_view entrada_pascal_case, std::string& destino) {
+    for (std::size_t i = 0; i < entrada_pascal_case.size(); ++i) {
+        const char c = entrada_pascal_case[i];
+        if (i > 0 && esMayuscula(c)) {
+            destino += '-';
         }
-        resultado += std::tolower(c);
+        destino += aMinuscula(c);
     }
+}
+
+std::string aPascalCase(std::string_view entrada) {
+    std::string resultado;
+    resultado.reserve(longitudPascalCase(entrada));
+    anexarPascalCase(entrada, resultado);
+    return resultado;
+}
+
+std::string aCamelCase(std::string_view entrada) {
+    std::string resultado;
+    resultado.reserve(longitudPascalCase(entrada));
+    anexarCamelCase(entrada, resultado);
+    return resultado;
+}
+
+std::string aKebabCase(std::string_view entrada_pascal_case) {
+    std::string resultado;
+    resultado.reserve(entrada_pascal_case.size() + separadoresKebabCase(entrada_pascal_case));
+    anexarKebabCase(entrada_pascal_case, resultado);
     return resultado;
 }
 
@@ -54,15 +157,24 @@ void ejecutarComando(const std::string& comando, bool esperar) {
     }
 }
 
-void imprimirRutasApi(const std::vector<Tabla>& tablas, const std::string& dir_salida) {
+std::string obtenerPuertoDb(const po::variables_map& vm, GestorAuditoria::MotorDB motor) {
+    if (vm.count("port")) return vm["port"].as<std::string>();
+    if (motor == GestorAuditoria::MotorDB::PostgreSQL) return "5432";
+    if (motor == GestorAuditoria::MotorDB::MySQL) return "3306";
+    if (motor == GestorAuditoria::MotorDB::SQLServer) return "1433";
+    return "";
+}
+
+void imprimirRutasApi(const Esquema& esquema, const std::string& dir_salida) {
     std::cout << "\n--- Rutas de API Generadas ---" << std::endl;
     std::cout << "URL Base: http://localhost:3000\n" << std::endl;
-    for (const auto& tabla : tablas) {
+    for (const auto& tabla : esquema.tablas) {
         if (tabla.es_tabla_usuario) {
             std::cout << "Autenticacion: POST /autenticacion/login" << std::endl;
         }
-        std::string ruta = "/" + tabla.nombre_archivo;
-        std::cout << "Recurso: " << tabla.nombre_clase << (tabla.es_protegida ? " (Protegida)" : " (Publica)") << std::endl;
+        std::string ruta = "/";
+        ruta += esquema.nombres.kebab(tabla.nombre);
+        std::cout << "Recurso: " << esquema.nombres.pascal(tabla.nombre) << (tabla.es_protegida ? " (Protegida)" : " (Publica)") << std::endl;
         std::cout << "  POST " << ruta << ", GET " << ruta << ", GET " << ruta << "/:id, PATCH " << ruta << "/:id, DELETE " << ruta << "/:id" << std::endl;
     }
 }
@@ -72,16 +184,17 @@ void manejarScaffolding(const po::variables_map& vm, GestorAuditoria::MotorDB mo
 
     GestorBaseDatos gestor_db(motor, info_conexion, vm["dbname"].as<std::string>());
     if (!gestor_db.estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+    gestor_db.establecerHilosEsquema(vm["workers"].as<unsigned int>());
 
-    std::vector<Tabla> esquema = gestor_db.obtenerEsquemaTablas();
-    if (esquema.empty()) throw std::runtime_error("No se encontraron tablas.");
+    Esquema esquema = gestor_db.obtenerEsquemaTablas();
+    if (esquema.tablas.empty()) throw std::runtime_error("No se encontraron tablas.");
 
     const std::string dir_salida = vm.count("out") ? vm["out"].as<std::string>() : "api-generada-nest";
     GeneradorCodigo generador(dir_salida);
     generador.generarProyectoCompleto(esquema,
         boost::to_lower_copy(vm["motor"].as<std::string>()),
         vm["host"].as<std::string>(),
-        vm["port"].as<std::string>(),
+        obtenerPuertoDb(vm, motor),
         vm["user"].as<std::string>(),
         vm["password"].as<std::string>(),
         vm["dbname"].as<std::string>(),
@@ -95,8 +208,18 @@ void manejarAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB moto
     auto gestor_auditoria = std::make_shared<GestorAuditoria>(motor, info_conexion, vm["dbname"].as<std::string>());
     if (!gestor_auditoria->estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
 
+    const auto modo = GestorAuditoria::interpretarModoAuditoria(vm["audit-mode"].as<std::string>());
+    gestor_auditoria->setModoAuditoria(modo);
     if (motor == GestorAuditoria::MotorDB::SQLite && vm.count("key")) {
+        if (modo == GestorAuditoria::ModoAuditoria::Delta) {
+            std::cerr << "Advertencia: con --key, SQLite guarda instantaneas cifradas y se ignora --audit-mode delta." << std::endl;
+        }
         auto gestor_cifrado = std::make_shared<GestorCifrado>(gestor_auditoria, vm["key"].as<std::string>());
+        gestor_cifrado->setFormatoCifrado(GestorCifrado::interpretarFormatoCifrado(vm["cipher"].as<std::string>()));
+        gestor_cifrado->setAlmacenamiento(GestorCifrado::interpretarAlmacenamiento(vm["storage"].as<std::string>()));
+        if (vm.count("compress")) {
+            gestor_cifrado->setColumnasComprimidas(vm["compress"].as<std::string>(), vm["compress-min"].as<std::size_t>());
+        }
         gestor_auditoria->setGestorCifrado(gestor_cifrado);
     }
 
@@ -104,13 +227,66 @@ void manejarAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB moto
         std::vector<std::string>{vm["tabla"].as<std::string>()} :
         gestor_auditoria->obtenerNombresDeTablas(false);
 
-    for (const auto& tabla : tablas) {
-        std::cout << "Generando auditoria para: " << tabla << std::endl;
-        gestor_auditoria->generarAuditoriaParaTabla(tabla);
+    const std::size_t num_conexiones = std::min<std::size_t>(vm["workers"].as<unsigned int>(), tablas.size());
+    if (motor == GestorAuditoria::MotorDB::PostgreSQL && num_conexiones > 1) {
+        std::vector<std::shared_ptr<GestorAuditoria>> conexiones = { gestor_auditoria };
+        for (std::size_t i = 1; i < num_conexiones; ++i) {
+            conexiones.push_back(std::make_shared<GestorAuditoria>(motor, info_conexion, vm["dbname"].as<std::string>()));
+            conexiones.back()->setModoAuditoria(modo);
+        }
+        ejecutarEnCorrutinas(num_conexiones, tablas.size(), [&](std::size_t canal, std::size_t i) -> boost::asio::awaitable<void> {
+            std::cout << "Generando auditoria para: " << tablas[i] << std::endl;
+            co_await conexiones[canal]->generarAuditoriaParaTablaAsincrona(tablas[i]);
+            });
+    }
+    else {
+        for (const auto& tabla : tablas) {
+            std::cout << "Generando auditoria para: " << tabla << std::endl;
+            gestor_auditoria->generarAuditoriaParaTabla(tabla);
+        }
     }
     std::cout << "Proceso de auditoria completado." << std::endl;
 }
 
+void manejarCapturaAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
+    if (motor != GestorAuditoria::MotorDB::PostgreSQL) throw std::runtime_error("La captura por replicacion logica solo esta disponible en PostgreSQL.");
+
+    GestorCapturaLogica::Configuracion configuracion;
+    configuracion.slot = vm["slot"].as<std::string>();
+    if (vm.count("tabla")) configuracion.tablas.push_back(vm["tabla"].as<std::string>());
+    if (vm.count("out")) configuracion.ruta_archivo = vm["out"].as<std::string>();
+    if (vm.count("checkpoint")) configuracion.ruta_checkpoint = vm["checkpoint"].as<std::string>();
+    configuracion.segundos_inactividad = vm["idle-timeout"].as<unsigned int>();
+
+    if (vm.count("key")) configuracion.clave_encriptacion = vm["key"].as<std::string>();
+    configuracion.formato_cifrado = GestorCifrado::interpretarFormatoCifrado(vm["cipher"].as<std::string>());
+    configuracion.almacenamiento = GestorCifrado::interpretarAlmacenamiento(vm["storage"].as<std::string>());
+    if (vm.count("compress")) configuracion.columnas_comprimidas = vm["compress"].as<std::string>();
+    configuracion.umbral_compresion = vm["compress-min"].as<std::size_t>();
+
+    GestorCapturaLogica captura(info_conexion, vm["dbname"].as<std::string>(), std::move(configuracion));
+    captura.ejecutar();
+}
+
+void manejarReconstruccionAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
+    if (!vm.count("tabla")) throw std::runtime_error("--tabla es obligatorio para reconstruir la auditoria.");
+
+    GestorAuditoria gestor_auditoria(motor, info_conexion, vm["dbname"].as<std::string>());
+    if (!gestor_auditoria.estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
+
+    std::string formato = vm.count("formato") ? boost::to_lower_copy(vm["formato"].as<std::string>()) : "tabla";
+    std::string ruta_salida = vm.count("out") ? vm["out"].as<std::string>() : "";
+    auto escritor = crearEscritorSalida(formato, ruta_salida);
+    const std::size_t filas = gestor_auditoria.reconstruirAuditoria(vm["tabla"].as<std::string>(),
+        [&](const std::vector<std::string>& columnas) { escritor->escribirEncabezado(columnas); },
+        [&](std::vector<ValorCelda>& fila) { escritor->escribirFila(fila); });
+    escritor->finalizar();
+
+    if (!ruta_salida.empty()) {
+        std::cout << filas << " filas escritas en " << ruta_salida << std::endl;
+    }
+}
+
 void manejarEncriptado(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
     if (!vm.count("key")) throw std::runtime_error("--key es obligatorio para cualquier operacion de cifrado.");
 
@@ -118,6 +294,15 @@ void manejarEncriptado(const po::variables_map& vm, GestorAuditoria::MotorDB mot
     if (!gestor_db->estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
 
     GestorCifrado gestor_cifrado(gestor_db, vm["key"].as<std::string>());
+    gestor_cifrado.setFormatoCifrado(GestorCifrado::interpretarFormatoCifrado(vm["cipher"].as<std::string>()));
+    gestor_cifrado.setAlmacenamiento(GestorCifrado::interpretarAlmacenamiento(vm["storage"].as<std::string>()));
+    if (vm.count("blind-index")) {
+        gestor_cifrado.setColumnasIndiceCiego(vm["blind-index"].as<std::string>());
+    }
+    if (vm.count("compress")) {
+        gestor_cifrado.setColumnasComprimidas(vm["compress"].as<std::string>(), vm["compress-min"].as<std::size_t>());
+    }
+    gestor_cifrado.setMigracionEnLinea(vm.count("online") > 0);
 
     if (vm.count("encrypt-audit-tables")) {
         gestor_cifrado.cifrarTablasDeAuditoria();
@@ -127,50 +312,136 @@ void manejarEncriptado(const po::variables_map& vm, GestorAuditoria::MotorDB mot
     }
 }
 
+void manejarRotacionClave(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
+    if (!vm.count("key") || !vm.count("new-key")) throw std::runtime_error("--key (clave actual) y --new-key son obligatorios para rotar la clave.");
+
+    GestorRotacionClave::Configuracion configuracion;
+    configuracion.clave_actual = vm["key"].as<std::string>();
+    configuracion.clave_nueva = vm["new-key"].as<std::string>();
+    configuracion.formato_cifrado = GestorCifrado::interpretarFormatoCifrado(vm["cipher"].as<std::string>());
+    configuracion.num_trabajadores = vm["workers"].as<unsigned int>();
+
+    GestorRotacionClave rotacion(motor, info_conexion, vm["dbname"].as<std::string>(), std::move(configuracion));
+    rotacion.ejecutar();
+}
+
+size_t volcarConsultaDescifrada(GestorAuditoria& gestor_db, GestorCifrado& gestor_cifrado, const std::string& tabla,
+    const std::vector<std::string>& columnas, const std::vector<GestorCifrado::FiltroDescifrado>& filtros, EscritorSalida& escritor) {
+    size_t filas = 0;
+    const size_t filas_leidas = gestor_cifrado.ejecutarConsultaConDesencriptado(tabla, columnas, filtros,
+        [&](const std::vector<std::string>& nombres) { escritor.escribirEncabezado(nombres); },
+        [&](std::vector<ValorCelda>& fila) {
+            escritor.escribirFila(fila);
+            ++filas;
+        },
+        filasPorBloqueParaConsulta(gestor_db, "SELECT * FROM " + tabla));
+    escritor.finalizar();
+    std::cout << filas << " de " << filas_leidas << " filas leidas cumplen los filtros." << std::endl;
+    return filas;
+}
+
+namespace {
+
+size_t volcarConsultaDescifrada(GestorAuditoria& gestor_db, GestorCifrado& gestor_cifrado, const po::variables_map& vm, EscritorSalida& escritor) {
+    const std::string tabla = vm["tabla"].as<std::string>();
+    std::vector<std::string> columnas;
+    if (vm.count("columnas")) {
+        boost::split(columnas, vm["columnas"].as<std::string>(), boost::is_any_of(","));
+        for (auto& columna : columnas) boost::trim(columna);
+        columnas.erase(std::remove(columnas.begin(), columnas.end(), std::string()), columnas.end());
+    }
+    std::vector<GestorCifrado::FiltroDescifrado> filtros;
+    if (vm.count("filtro")) {
+        for (const auto& texto : vm["filtro"].as<std::vector<std::string>>()) filtros.push_back(GestorCifrado::interpretarFiltro(texto));
+    }
+    return volcarConsultaDescifrada(gestor_db, gestor_cifrado, tabla, columnas, filtros, escritor);
+}
+
+}
+
 void manejarConsultaSql(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
-    if (!vm.count("query")) throw std::runtime_error("--query es obligatorio para ejecutar una consulta SQL.");
+    const bool consulta_descifrada = !vm.count("query") && vm.count("tabla") && vm.count("key");
+    if (!vm.count("query") && !consulta_descifrada) {
+        throw std::runtime_error("--query es obligatorio para ejecutar una consulta SQL (o --tabla con --key para una consulta descifrada).");
+    }
 
     auto gestor_db = std::make_shared<GestorAuditoria>(motor, info_conexion, vm["dbname"].as<std::string>());
     if (!gestor_db->estaConectado()) throw std::runtime_error("No se pudo conectar a la base de datos.");
 
-    std::string query = vm["query"].as<std::string>();
+    std::string query = consulta_descifrada ? std::string() : vm["query"].as<std::string>();
+    std::string formato = vm.count("formato") ? boost::to_lower_copy(vm["formato"].as<std::string>()) : "tabla";
+    std::string ruta_salida = vm.count("out") ? vm["out"].as<std::string>() : "";
     std::cout << "Ejecutando consulta..." << std::endl;
 
+    std::shared_ptr<GestorCifrado> gestor_cifrado;
     if (vm.count("key")) {
         std::cout << "Desencriptando resultados con la clave proporcionada..." << std::endl;
-        GestorCifrado gestor_cifrado(gestor_db, vm["key"].as<std::string>());
-        auto resultados = gestor_cifrado.ejecutarConsultaConDesencriptado(query);
-
-        for (const auto& fila : resultados) {
-            bool first = true;
-            for (const auto& celda : fila) {
-                if (!first) std::cout << "\t|\t";
-                std::cout << celda;
-                first = false;
-            }
-            std::cout << std::endl;
+        gestor_cifrado = std::make_shared<GestorCifrado>(gestor_db, vm["key"].as<std::string>());
+        if (vm.count("blind-index")) {
+            if (!consulta_descifrada) throw std::runtime_error("--blind-index en sql solo se aplica a --filtro de una consulta descifrada con --tabla, sin --query.");
+            gestor_cifrado->setColumnasIndiceCiego(vm["blind-index"].as<std::string>());
         }
     }
-    else {
-        auto resultado = gestor_db->ejecutarConsultaConResultado(query);
+    else if (vm.count("blind-index")) {
+        throw std::runtime_error("--blind-index requiere --key.");
+    }
 
-        bool first = true;
-        for (const auto& col : resultado.columnas) {
-            if (!first) std::cout << "\t|\t";
-            std::cout << col;
-            first = false;
-        }
-        std::cout << std::endl;
-        std::cout << std::string(80, '-') << std::endl;
-
-        for (const auto& fila : resultado.filas) {
-            bool first = true;
-            for (const auto& celda : fila) {
-                if (!first) std::cout << "\t|\t";
-                std::cout << celda;
-                first = false;
-            }
-            std::cout << std::endl;
-        }
+    auto escritor = crearEscritorSalida(formato, ruta_salida);
+    size_t filas = consulta_descifrada
+        ? volcarConsultaDescifrada(*gestor_db, *gestor_cifrado, vm, *escritor)
+        : volcarConsulta(*gestor_db, query, *escritor, gestor_cifrado.get());
+
+    if (!ruta_salida.empty()) {
+        std::cout << filas << " filas escritas en " << ruta_salida << std::endl;
     }
-}
\ No newline at end of file
+}
+
+void manejarRespaldo(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
+    if (!vm.count("out")) throw std::runtime_error("--out es obligatorio para generar un respaldo.");
+
+    GestorExportacion gestor_exportacion(motor, info_conexion, vm["dbname"].as<std::string>(), vm["workers"].as<unsigned int>());
+    gestor_exportacion.exportarRespaldoNativo(vm["out"].as<std::string>());
+}
+
+void manejarRestauracion(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
+    if (!vm.count("in")) throw std::runtime_error("--in es obligatorio para restaurar un respaldo.");
+
+    GestorExportacion gestor_exportacion(motor, info_conexion, vm["dbname"].as<std::string>(), vm["workers"].as<unsigned int>());
+    gestor_exportacion.importarRespaldoNativo(vm["in"].as<std::string>());
+}
+
+void manejarExportacionAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
+    if (!vm.count("out")) throw std::runtime_error("--out es obligatorio para exportar la auditoria.");
+
+    std::string dir_salida = vm["out"].as<std::string>();
+    std::string formato = vm.count("formato") ? boost::to_lower_copy(vm["formato"].as<std::string>()) : "ndjson";
+    std::string ruta_checkpoint = vm.count("checkpoint") ? vm["checkpoint"].as<std::string>() : dir_salida + "/checkpoint_auditoria.json";
+
+    std::shared_ptr<GestorCifrado> gestor_cifrado;
+    if (vm.count("key")) {
+        std::cout << "Desencriptando filas con la clave proporcionada..." << std::endl;
+        gestor_cifrado = std::make_shared<GestorCifrado>(nullptr, vm["key"].as<std::string>());
+    }
+
+    GestorExportacion gestor_exportacion(motor, info_conexion, vm["dbname"].as<std::string>(), vm["workers"].as<unsigned int>());
+    gestor_exportacion.exportarAuditoriaIncremental(dir_salida, formato, ruta_checkpoint, gestor_cifrado);
+}
+
+void manejarServidor(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion) {
+    ConfiguracionServidor configuracion;
+    configuracion.motor = motor;
+    configuracion.info_conexion = info_conexion;
+    configuracion.motor_texto = boost::to_lower_copy(vm["motor"].as<std::string>());
+    configuracion.host = vm["host"].as<std::string>();
+    configuracion.puerto_db = obtenerPuertoDb(vm, motor);
+    configuracion.usuario = vm["user"].as<std::string>();
+    configuracion.contrasena = vm["password"].as<std::string>();
+    configuracion.db_name = vm["dbname"].as<std::string>();
+    configuracion.puerto = vm["api-port"].as<unsigned short>();
+    configuracion.num_trabajadores = vm["workers"].as<unsigned int>();
+    configuracion.origen_permitido = vm["api-origin"].as<std::string>();
+    configuracion.directorio_base = vm.count("out") ? vm["out"].as<std::string>() : ".";
+
+    ServidorApi servidor(configuracion);
+    servidor.ejecutar();
+}
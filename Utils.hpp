@@ -1,20 +1,38 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <boost/program_options.hpp>
 #include "Modelos.hpp"
 #include "GestorAuditoria.hpp"
+#include "EscritorSalida.hpp"
 
 namespace po = boost::program_options;
 
-std::string aPascalCase(const std::string& entrada);
-std::string aCamelCase(const std::string& entrada);
-std::string aKebabCase(const std::string& entrada_pascal_case);
+std::string aPascalCase(std::string_view entrada);
+std::string aCamelCase(std::string_view entrada);
+std::string aKebabCase(std::string_view entrada_pascal_case);
+std::size_t longitudPascalCase(std::string_view entrada);
+std::size_t separadoresKebabCase(std::string_view entrada);
+void anexarPascalCase(std::string_view entrada, std::string& destino);
+void anexarCamelCase(std::string_view entrada, std::string& destino);
+void anexarKebabCase(std::string_view entrada_pascal_case, std::string& destino);
 
 void ejecutarComando(const std::string& comando, bool esperar = true);
-void imprimirRutasApi(const std::vector<Tabla>& tablas, const std::string& dir_salida);
+long filasPorBloqueParaConsulta(GestorAuditoria& gestor_db, const std::string& consulta);
+size_t volcarConsulta(GestorAuditoria& gestor_db, const std::string& consulta, EscritorSalida& escritor, const GestorCifrado* gestor_cifrado);
+size_t volcarConsultaDescifrada(GestorAuditoria& gestor_db, GestorCifrado& gestor_cifrado, const std::string& tabla,
+    const std::vector<std::string>& columnas, const std::vector<GestorCifrado::FiltroDescifrado>& filtros, EscritorSalida& escritor);
+std::string obtenerPuertoDb(const po::variables_map& vm, GestorAuditoria::MotorDB motor);
+void imprimirRutasApi(const Esquema& esquema, const std::string& dir_salida);
 
 void manejarScaffolding(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
 void manejarAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
+void manejarCapturaAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
+void manejarReconstruccionAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
 void manejarEncriptado(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
-void manejarConsultaSql(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
\ No newline at end of file
+void manejarRotacionClave(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
+void manejarConsultaSql(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
+void manejarRespaldo(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
+void manejarRestauracion(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
+void manejarExportacionAuditoria(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);void manejarServidor(const po::variables_map& vm, GestorAuditoria::MotorDB motor, const std::string& info_conexion);
@@ -0,0 +1,259 @@
+#include "ValorCelda.hpp"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+constexpr unsigned int OID_BOOL = 16;
+constexpr unsigned int OID_BYTEA = 17;
+constexpr unsigned int OID_CHAR = 18;
+constexpr unsigned int OID_NAME = 19;
+constexpr unsigned int OID_INT8 = 20;
+constexpr unsigned int OID_INT2 = 21;
+constexpr unsigned int OID_INT4 = 23;
+constexpr unsigned int OID_TEXT = 25;
+constexpr unsigned int OID_OID = 26;
+constexpr unsigned int OID_JSON = 114;
+constexpr unsigned int OID_FLOAT4 = 700;
+constexpr unsigned int OID_FLOAT8 = 701;
+constexpr unsigned int OID_BPCHAR = 1042;
+constexpr unsigned int OID_VARCHAR = 1043;
+constexpr unsigned int OID_DATE = 1082;
+constexpr unsigned int OID_TIMESTAMP = 1114;
+constexpr unsigned int OID_TIMESTAMPTZ = 1184;
+constexpr unsigned int OID_NUMERIC = 1700;
+constexpr unsigned int OID_UUID = 2950;
+constexpr unsigned int OID_JSONB = 3802;
+
+constexpr std::int64_t DIAS_EPOCH_POSTGRES = 10957;
+constexpr std::int64_t MICROS_EPOCH_POSTGRES = DIAS_EPOCH_POSTGRES * 86400LL * 1000000LL;
+
+template <typename Entero>
+Entero leerBigEndian(const char* datos) {
+    std::make_unsigned_t<Entero> valor = 0;
+    for (std::size_t i = 0; i < sizeof(Entero); ++i) {
+        valor = static_cast<std::make_unsigned_t<Entero>>((valor << 8) | static_cast<unsigned char>(datos[i]));
+    }
+    return static_cast<Entero>(valor);
+}
+
+void anexarGrupoNumerico(std::string& salida, int grupo, bool rellenar) {
+    char buffer[8];
+    int n = std::snprintf(buffer, sizeof(buffer), rellenar ? "%04d" : "%d", grupo);
+    salida.append(buffer, n);
+}
+
+std::string decodificarNumerico(const char* datos, int longitud) {
+    if (longitud < 8) return "";
+    const int num_digitos = leerBigEndian<std::int16_t>(datos);
+    const int peso = leerBigEndian<std::int16_t>(datos + 2);
+    const std::uint16_t signo = leerBigEndian<std::uint16_t>(datos + 4);
+    const int escala = leerBigEndian<std::int16_t>(datos + 6);
+    if (signo == 0xC000) return "NaN";
+    if (signo == 0xD000) return "Infinity";
+    if (signo == 0xF000) return "-Infinity";
+
+    auto digito = [&](int i) -> int {
+        return (i >= 0 && i < num_digitos && 8 + i * 2 + 2 <= longitud) ? leerBigEndian<std::int16_t>(datos + 8 + i * 2) : 0;
+        };
+
+    std::string resultado;
+    if (signo == 0x4000) resultado += '-';
+    if (peso < 0) {
+        resultado += '0';
+    }
+    else {
+        for (int i = 0; i <= peso; ++i) {
+            anexarGrupoNumerico(resultado, digito(i), i > 0);
+        }
+    }
+    if (escala > 0) {
+        std::string fraccion;
+        for (int i = peso + 1; static_cast<int>(fraccion.size()) < escala; ++i) {
+            anexarGrupoNumerico(fraccion, digito(i), true);
+        }
+        fraccion.resize(escala);
+        resultado += '.';
+        resultado += fraccion;
+    }
+    return resultado;
+}
+
+std::string decodificarUuid(const unsigned char* datos) {
+    static const char digitos_hex[] = "0123456789abcdef";
+    std::string resultado;
+    resultado.reserve(36);
+    for (int i = 0; i < 16; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) resultado += '-';
+        resultado += digitos_hex[datos[i] >> 4];
+        resultado += digitos_hex[datos[i] & 0x0F];
+    }
+    return resultado;
+}
+
+void civilDesdeDias(std::int64_t dias, int& anio, unsigned& mes, unsigned& dia) {
+    dias += 719468;
+    const std::int64_t era = (dias >= 0 ? dias : dias - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(dias - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    dia = doy - (153 * mp + 2) / 5 + 1;
+    mes = mp < 10 ? mp + 3 : mp - 9;
+    anio = static_cast<int>(yoe + era * 400 + (mes <= 2 ? 1 : 0));
+}
+
+void anexarFecha(std::string& salida, std::int64_t dias) {
+    int anio;
+    unsigned mes, dia;
+    civilDesdeDias(dias, anio, mes, dia);
+    char buffer[16];
+    int n = std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", anio, mes, dia);
+    salida.append(buffer, n);
+}
+
+void anexarFechaHora(std::string& salida, std::int64_t microsegundos) {
+    constexpr std::int64_t micros_por_dia = 86400LL * 1000000LL;
+    std::int64_t dias = microsegundos / micros_por_dia;
+    std::int64_t resto = microsegundos % micros_por_dia;
+    if (resto < 0) {
+        resto += micros_por_dia;
+        --dias;
+    }
+    anexarFecha(salida, dias);
+
+    const std::int64_t segundos = resto / 1000000;
+    const std::int64_t fraccion = resto % 1000000;
+    char buffer[24];
+    int n = std::snprintf(buffer, sizeof(buffer), " %02d:%02d:%02d",
+        static_cast<int>(segundos / 3600), static_cast<int>((segundos / 60) % 60), static_cast<int>(segundos % 60));
+    salida.append(buffer, n);
+    if (fraccion != 0) {
+        n = std::snprintf(buffer, sizeof(buffer), ".%06d", static_cast<int>(fraccion));
+        while (n > 1 && buffer[n - 1] == '0') --n;
+        salida.append(buffer, n);
+    }
+}
+
+template <typename Numero>
+void anexarNumero(std::string& salida, Numero numero) {
+    char buffer[32];
+    auto [fin, error] = std::to_chars(buffer, buffer + sizeof(buffer), numero);
+    salida.append(buffer, fin);
+}
+
+}
+
+void anexarValorTexto(std::string& salida, const ValorCelda& valor) {
+    static const char digitos_hex[] = "0123456789abcdef";
+    switch (valor.index()) {
+    case 0:
+        salida += "NULL";
+        break;
+    case 1:
+        salida += std::get<bool>(valor) ? "t" : "f";
+        break;
+    case 2:
+        anexarNumero(salida, std::get<std::int64_t>(valor));
+        break;
+    case 3:
+        anexarNumero(salida, std::get<double>(valor));
+        break;
+    case 4:
+        salida += std::get<std::string>(valor);
+        break;
+    case 5: {
+        const Bytes& bytes = std::get<Bytes>(valor);
+        salida.reserve(salida.size() + 2 + bytes.size() * 2);
+        salida += "\\x";
+        for (unsigned char b : bytes) {
+            salida += digitos_hex[b >> 4];
+            salida += digitos_hex[b & 0x0F];
+        }
+        break;
+    }
+    case 6:
+        anexarFecha(salida, std::get<Fecha>(valor).dias_desde_epoch);
+        break;
+    case 7:
+        anexarFechaHora(salida, std::get<FechaHora>(valor).microsegundos_desde_epoch);
+        if (std::get<FechaHora>(valor).utc) salida += "+00";
+        break;
+    case 8:
+        salida += std::get<Numerico>(valor).digitos;
+        break;
+    }
+}
+
+std::string valorATexto(const ValorCelda& valor) {
+    if (const std::string* texto = std::get_if<std::string>(&valor)) {
+        return *texto;
+    }
+    std::string salida;
+    anexarValorTexto(salida, valor);
+    return salida;
+}
+
+bool esTipoBinarioSoportadoPostgreSQL(unsigned int oid) {
+    switch (oid) {
+    case OID_BOOL: case OID_BYTEA: case OID_CHAR: case OID_NAME: case OID_INT8: case OID_INT2:
+    case OID_INT4: case OID_TEXT: case OID_OID: case OID_JSON: case OID_FLOAT4: case OID_FLOAT8:
+    case OID_BPCHAR: case OID_VARCHAR: case OID_DATE: case OID_TIMESTAMP: case OID_TIMESTAMPTZ:
+    case OID_NUMERIC: case OID_UUID: case OID_JSONB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+ValorCelda decodificarBinarioPostgreSQL(unsigned int oid, const char* datos, int longitud) {
+    switch (oid) {
+    case OID_BOOL:
+        return longitud > 0 && datos[0] != 0;
+    case OID_INT2:
+        return static_cast<std::int64_t>(leerBigEndian<std::int16_t>(datos));
+    case OID_INT4:
+        return static_cast<std::int64_t>(leerBigEndian<std::int32_t>(datos));
+    case OID_OID:
+        return static_cast<std::int64_t>(leerBigEndian<std::uint32_t>(datos));
+    case OID_INT8:
+        return leerBigEndian<std::int64_t>(datos);
+    case OID_FLOAT4: {
+        std::uint32_t bits = leerBigEndian<std::uint32_t>(datos);
+        float valor;
+        std::memcpy(&valor, &bits, sizeof(valor));
+        return static_cast<double>(valor);
+    }
+    case OID_FLOAT8: {
+        std::uint64_t bits = leerBigEndian<std::uint64_t>(datos);
+        double valor;
+        std::memcpy(&valor, &bits, sizeof(valor));
+        return valor;
+    }
+    case OID_NUMERIC:
+        return Numerico{ decodificarNumerico(datos, longitud) };
+    case OID_DATE: {
+        std::int32_t dias = leerBigEndian<std::int32_t>(datos);
+        if (dias == INT32_MAX) return std::string("infinity");
+        if (dias == INT32_MIN) return std::string("-infinity");
+        return Fecha{ static_cast<std::int32_t>(dias + DIAS_EPOCH_POSTGRES) };
+    }
+    case OID_TIMESTAMP:
+    case OID_TIMESTAMPTZ: {
+        std::int64_t micros = leerBigEndian<std::int64_t>(datos);
+        if (micros == INT64_MAX) return std::string("infinity");
+        if (micros == INT64_MIN) return std::string("-infinity");
+        return FechaHora{ micros + MICROS_EPOCH_POSTGRES, oid == OID_TIMESTAMPTZ };
+    }
+    case OID_BYTEA:
+        return Bytes(reinterpret_cast<const unsigned char*>(datos), reinterpret_cast<const unsigned char*>(datos) + longitud);
+    case OID_UUID:
+        return decodificarUuid(reinterpret_cast<const unsigned char*>(datos));
+    case OID_JSONB:
+        return longitud > 0 ? std::string(datos + 1, longitud - 1) : std::string();
+    default:
+        return std::string(datos, longitud);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <variant>
+#include <cstdint>
+#include <cstddef>
+
+struct Fecha {
+    std::int32_t dias_desde_epoch;
+};
+
+struct FechaHora {
+    std::int64_t microsegundos_desde_epoch;
+    // timestamptz: el instante esta en UTC y su texto lleva el desfase "+00".
+    bool utc = false;
+};
+
+struct Numerico {
+    std::string digitos;
+};
+
+using Bytes = std::vector<unsigned char>;
+
+using ValorCelda = std::variant<std::monostate, bool, std::int64_t, double, std::string, Bytes, Fecha, FechaHora, Numerico>;
+
+inline bool esNulo(const ValorCelda& valor) {
+    return std::holds_alternative<std::monostate>(valor);
+}
+
+void anexarValorTexto(std::string& salida, const ValorCelda& valor);
+std::string valorATexto(const ValorCelda& valor);
+
+bool esTipoBinarioSoportadoPostgreSQL(unsigned int oid);
+ValorCelda decodificarBinarioPostgreSQL(unsigned int oid, const char* datos, int longitud);
+
+struct ResultadoTipado {
+    std::vector<std::string> columnas;
+    std::vector<ValorCelda> celdas;
+
+    std::size_t numeroFilas() const {
+        return columnas.empty() ? 0 : celdas.size() / columnas.size();
+    }
+    const ValorCelda& celda(std::size_t fila, std::size_t columna) const {
+        return celdas[fila * columnas.size() + columna];
+    }
+};
@@ -0,0 +1,28 @@
+if(NOT DIRECTORIO OR NOT SALIDA)
+    message(FATAL_ERROR "Uso: cmake -DDIRECTORIO=<dir> -DSALIDA=<archivo.cpp> -P EmbeberPlantillas.cmake")
+endif()
+
+file(GLOB plantillas RELATIVE ${DIRECTORIO} ${DIRECTORIO}/*.tpl)
+list(SORT plantillas)
+
+set(arreglos "")
+set(entradas "")
+set(indice 0)
+foreach(plantilla IN LISTS plantillas)
+    file(READ ${DIRECTORIO}/${plantilla} contenido HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${contenido}")
+    string(REGEX REPLACE "(0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,0x..,)" "\\1\n    " bytes "${bytes}")
+    string(APPEND arreglos "const unsigned char plantilla_${indice}[] = {\n    ${bytes}0x00\n};\n\n")
+    string(APPEND entradas "    { \"${plantilla}\", std::string_view(reinterpret_cast<const char*>(plantilla_${indice}), sizeof(plantilla_${indice}) - 1) },\n")
+    math(EXPR indice "${indice} + 1")
+endforeach()
+
+set(codigo "#include \"PlantillasEmbebidas.hpp\"\n\nnamespace {\n\n${arreglos}const PlantillaEmbebida plantillas[] = {\n${entradas}};\n\n}\n\nstd::span<const PlantillaEmbebida> obtenerPlantillasEmbebidas() {\n    return plantillas;\n}\n")
+
+if(EXISTS ${SALIDA})
+    file(READ ${SALIDA} anterior)
+    if(anterior STREQUAL codigo)
+        return()
+    endif()
+endif()
+file(WRITE ${SALIDA} "${codigo}")
@@ -2,6 +2,8 @@
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string.hpp>
 #include "Utils.hpp"
+#include "Perfilador.hpp"
+#include "GestorPlantillas.hpp"
 
 namespace po = boost::program_options;
 
@@ -10,15 +12,7 @@ std::string construirCadenaConexion(const po::variables_map& vm, GestorAuditoria
     std::string dbname = vm["dbname"].as<std::string>();
     std::string user = vm["user"].as<std::string>();
     std::string password = vm["password"].as<std::string>();
-    std::string port;
-    if (vm.count("port")) {
-        port = vm["port"].as<std::string>();
-    }
-    else {
-        if (motor == GestorAuditoria::MotorDB::PostgreSQL) port = "5432";
-        if (motor == GestorAuditoria::MotorDB::MySQL) port = "3306";
-        if (motor == GestorAuditoria::MotorDB::SQLServer) port = "1433";
-    }
+    std::string port = obtenerPuertoDb(vm, motor);
 
     if (motor == GestorAuditoria::MotorDB::PostgreSQL) {
         return "host=" + host +
@@ -85,7 +79,7 @@ int main(int argc, char* argv[]) {
         desc.add_options()
             ("help,h", "Muestra esta ayuda")
             ("accion", po::value<std::string>()->required(),
-                "Accion a realizar: scaffolding, auditoria, encriptado, sql")
+                "Accion a realizar: scaffolding, auditoria, reconstruir-auditoria, capturar-auditoria, encriptado, rekey, sql, respaldo, restaurar, exportar-auditoria, serve")
             ("motor", po::value<std::string>()->default_value("postgres"),
                 "Motor de base de datos: postgres, mysql, sqlserver, sqlite")
             ("host", po::value<std::string>()->default_value("localhost"),
@@ -100,16 +94,58 @@ int main(int argc, char* argv[]) {
                 "Nombre de la base de datos")
             ("tabla", po::value<std::string>(),
                 "Nombre de tabla especifica (para auditoria)")
+            ("audit-mode", po::value<std::string>()->default_value("completo"),
+                "Registro de auditoria: completo (fila entera) o delta (clave y columnas modificadas)")
             ("key", po::value<std::string>(),
                 "Clave de encriptacion en hexadecimal (64 caracteres)")
+            ("new-key", po::value<std::string>(),
+                "Con rekey, clave nueva en hexadecimal (64 caracteres) con la que se vuelven a cifrar las tablas de auditoria")
             ("encrypt-audit-tables",
                 "Cifrar las tablas de auditoria existentes")
+            ("online",
+                "Con --encrypt-audit-tables, cifra cada tabla en una tabla sombra por bloques sin bloquear las escrituras y la intercambia al final")
+            ("cipher", po::value<std::string>()->default_value("cbc"),
+                "Formato de las celdas cifradas desde C++: cbc (compatible con los triggers) o gcm (autenticado); al descifrar se detecta")
+            ("storage", po::value<std::string>()->default_value("hex"),
+                "Tipo de las columnas cifradas de auditoria: hex (texto hexadecimal) o binario (BYTEA, LONGBLOB, VARBINARY(MAX) o BLOB, la mitad de tamano)")
+            ("compress", po::value<std::string>(),
+                "Columnas separadas por coma cuyos valores se comprimen con zstd antes de cifrarlos (encriptado, auditoria en SQLite y capturar-auditoria)")
+            ("compress-min", po::value<std::size_t>()->default_value(256),
+                "Con --compress, tamano minimo en bytes de un valor para comprimirlo")
+            ("blind-index", po::value<std::string>(),
+                "Columnas separadas por coma con indice ciego HMAC al cifrar; en sql con --tabla, sus filtros de igualdad se buscan por el indice")
             ("query", po::value<std::string>(),
                 "Consulta SQL a ejecutar")
+            ("columnas", po::value<std::string>(),
+                "Con sql, --tabla y --key sin --query: columnas (descifradas) a devolver, separadas por coma")
+            ("filtro", po::value<std::vector<std::string>>()->composing(),
+                "Con sql, --tabla y --key sin --query: condicion columna<op>valor sobre el valor descifrado (repetible)")
             ("out", po::value<std::string>(),
-                "Directorio de salida para scaffolding")
+                "Directorio de salida (scaffolding, respaldo), archivo de resultados (sql) o directorio base de los proyectos generados por serve")
+            ("in", po::value<std::string>(),
+                "Directorio de un respaldo columnar a restaurar")
+            ("workers", po::value<unsigned int>()->default_value(4),
+                "Numero de conexiones paralelas para respaldo, restauracion, exportacion, auditoria, rotacion de clave y lectura del esquema")
+            ("formato", po::value<std::string>(),
+                "Formato de salida: tabla, csv, tsv, ndjson o binario (sql, reconstruir-auditoria); ndjson, csv, tsv o binario (exportar-auditoria)")
+            ("checkpoint", po::value<std::string>(),
+                "Archivo de checkpoint para la exportacion incremental o la captura de auditoria")
+            ("slot", po::value<std::string>()->default_value("shc134_auditoria"),
+                "Slot de replicacion logica y publicacion para capturar-auditoria")
+            ("idle-timeout", po::value<unsigned int>()->default_value(0),
+                "Con capturar-auditoria, segundos sin cambios tras los que se detiene (0: hasta Ctrl+C)")
+            ("api-port", po::value<unsigned short>()->default_value(9543),
+                "Puerto HTTP local del modo servidor (serve)")
+            ("api-origin", po::value<std::string>()->default_value("http://localhost:9542"),
+                "Unico origen del navegador al que el modo servidor responde con CORS (vacio: ninguno)")
             ("jwt-secret", po::value<std::string>(),
                 "Secreto JWT para autenticacion")
+            ("plantillas", po::value<std::string>(),
+                "Directorio con plantillas .tpl que reemplazan a las embebidas")
+            ("profile",
+                "Muestra al finalizar el tiempo y los contadores de cada fase")
+            ("trace", po::value<std::string>(),
+                "Con --profile, escribe una traza JSON para chrome://tracing o Perfetto")
             ("driver", po::value<std::string>(),
                 "Driver ODBC especifico (para SQL Server)");
 
@@ -126,10 +162,20 @@ int main(int argc, char* argv[]) {
 
         po::notify(vm);
 
+        if (vm.count("plantillas")) {
+            GestorPlantillas::instancia().establecerDirectorioPersonalizado(vm["plantillas"].as<std::string>());
+        }
+        if (vm.count("profile")) {
+            Perfilador::activar(vm.count("trace") ? vm["trace"].as<std::string>() : "");
+        }
+
         std::string accion = boost::to_lower_copy(vm["accion"].as<std::string>());
 
-        if (accion != "scaffolding" && accion != "auditoria" &&
-            accion != "encriptado" && accion != "sql") {
+        if (accion != "scaffolding" && accion != "auditoria" && accion != "reconstruir-auditoria" &&
+            accion != "capturar-auditoria" &&
+            accion != "encriptado" && accion != "rekey" && accion != "sql" &&
+            accion != "respaldo" && accion != "restaurar" && accion != "exportar-auditoria" &&
+            accion != "serve") {
             throw std::runtime_error("Accion no valida: " + accion);
         }
 
@@ -146,19 +192,49 @@ int main(int argc, char* argv[]) {
             std::cout << "Iniciando proceso de auditoria..." << std::endl;
             manejarAuditoria(vm, motor, info_conexion);
         }
+        else if (accion == "reconstruir-auditoria") {
+            std::cout << "Reconstruyendo versiones de auditoria..." << std::endl;
+            manejarReconstruccionAuditoria(vm, motor, info_conexion);
+        }
+        else if (accion == "capturar-auditoria") {
+            std::cout << "Iniciando captura de auditoria por replicacion logica..." << std::endl;
+            manejarCapturaAuditoria(vm, motor, info_conexion);
+        }
         else if (accion == "encriptado") {
             std::cout << "Iniciando proceso de encriptado..." << std::endl;
             manejarEncriptado(vm, motor, info_conexion);
         }
+        else if (accion == "rekey") {
+            std::cout << "Iniciando rotacion de la clave de cifrado..." << std::endl;
+            manejarRotacionClave(vm, motor, info_conexion);
+        }
         else if (accion == "sql") {
             std::cout << "Ejecutando consulta SQL..." << std::endl;
             manejarConsultaSql(vm, motor, info_conexion);
         }
+        else if (accion == "respaldo") {
+            std::cout << "Iniciando respaldo de datos..." << std::endl;
+            manejarRespaldo(vm, motor, info_conexion);
+        }
+        else if (accion == "restaurar") {
+            std::cout << "Iniciando restauracion de datos..." << std::endl;
+            manejarRestauracion(vm, motor, info_conexion);
+        }
+        else if (accion == "exportar-auditoria") {
+            std::cout << "Iniciando exportacion incremental de auditoria..." << std::endl;
+            manejarExportacionAuditoria(vm, motor, info_conexion);
+        }
+        else if (accion == "serve") {
+            std::cout << "Iniciando modo servidor..." << std::endl;
+            manejarServidor(vm, motor, info_conexion);
+        }
 
+        Perfilador::finalizar();
         std::cout << "\nProceso completado exitosamente." << std::endl;
         return 0;
     }
     catch (const std::exception& e) {
+        Perfilador::finalizar();
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }